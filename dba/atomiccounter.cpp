@@ -0,0 +1,53 @@
+// File: atomiccounter.cpp
+// Purpose: Integer counter with atomic increment and decrement
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#include "dba/atomiccounter.h"
+
+#ifndef DBA_ATOMIC_GCC_BUILTINS
+
+#ifdef _WIN32
+  #include <windows.h>
+#endif
+
+namespace dba {
+
+#ifdef _WIN32
+long
+AtomicCounter::inc() {
+  return InterlockedIncrement((LONG*)&mValue);
+};
+
+long
+AtomicCounter::dec() {
+  return InterlockedDecrement((LONG*)&mValue);
+};
+
+void
+AtomicCounter::fence() {
+  MemoryBarrier();
+};
+#else
+//no atomic primitives known for this compiler,
+//counter is safe only for single threaded usage
+long
+AtomicCounter::inc() {
+  return ++mValue;
+};
+
+long
+AtomicCounter::dec() {
+  return --mValue;
+};
+
+void
+AtomicCounter::fence() {
+};
+#endif
+
+};//namespace
+
+#endif
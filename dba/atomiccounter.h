@@ -0,0 +1,72 @@
+// File: atomiccounter.h
+// Purpose: Integer counter with atomic increment and decrement
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBAATOMICCOUNTER_H
+#define DBAATOMICCOUNTER_H
+
+#include "dba/defs.h"
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 1)))
+  #define DBA_ATOMIC_GCC_BUILTINS 1
+#endif
+
+namespace dba {
+
+/**
+  Integer counter that can be safely incremented and decremented
+  from many threads at once. Used as reference counter by shared_ptr.
+*/
+class dbaDLLEXPORT AtomicCounter {
+  public:
+    /**
+      Constructor
+      @param pValue initial value
+    */
+    AtomicCounter(long pValue = 0) : mValue(pValue) {};
+    /**
+      Increment counter
+      @return value after increment
+    */
+    long inc();
+    /**
+      Decrement counter
+      @return value after decrement
+    */
+    long dec();
+    /**
+      Get current value
+    */
+    long get() const { return mValue; };
+    /**
+      Memory barrier. Memory operations are not moved across it by
+      compiler or processor.
+    */
+    static void fence();
+  private:
+    volatile long mValue;
+};
+
+#ifdef DBA_ATOMIC_GCC_BUILTINS
+inline long
+AtomicCounter::inc() {
+  return __sync_add_and_fetch(&mValue, 1);
+};
+
+inline long
+AtomicCounter::dec() {
+  return __sync_sub_and_fetch(&mValue, 1);
+};
+
+inline void
+AtomicCounter::fence() {
+  __sync_synchronize();
+};
+#endif
+
+};//namespace
+
+#endif
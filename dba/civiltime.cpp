@@ -0,0 +1,227 @@
+// File: civiltime.cpp
+// Purpose: Calendar calculations on struct tm without C library time zone calls
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#include "dba/civiltime.h"
+#include "dba/thread.h"
+#include "dba/atomiccounter.h"
+
+namespace dba {
+
+static const long SECONDS_PER_DAY = 24 * 60 * 60;
+//offsets of local time zone are cached for periods of this length,
+//all time zones change offsets at full quarter of hour
+static const long CACHE_PERIOD = 15 * 60;
+static const int CACHE_SIZE = 1024;
+
+//division rounded towards negative infinity
+template<class T> static inline T
+floorDiv(T pValue, T pDivisor) {
+  T ret = pValue / pDivisor;
+  if (pValue % pDivisor < 0)
+    ret--;
+  return ret;
+};
+
+//days in 400 year era have the same pattern, so years are counted
+//from March 1st of era start, leap day is last day of such year
+long
+daysFromCivil(long pYear, long pMonth, long pDay) {
+  pYear += floorDiv(pMonth - 1,12L);
+  pMonth -= floorDiv(pMonth - 1,12L) * 12;
+  if (pMonth <= 2)
+    pYear--;
+  long era = floorDiv(pYear,400L);
+  long yoe = pYear - era * 400;
+  long doy = (153 * (pMonth > 2 ? pMonth - 3 : pMonth + 9) + 2) / 5 + pDay - 1;
+  long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+};
+
+void
+civilFromDays(long pDays, long& pYear, long& pMonth, long& pDay) {
+  pDays += 719468;
+  long era = floorDiv(pDays,146097L);
+  long doe = pDays - era * 146097;
+  long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  long mp = (5 * doy + 2) / 153;
+  pDay = doy - (153 * mp + 2) / 5 + 1;
+  pMonth = mp < 10 ? mp + 3 : mp - 9;
+  pYear = yoe + era * 400 + (pMonth <= 2 ? 1 : 0);
+};
+
+time_t
+civilToTime(const tm& pDate) {
+  time_t days = daysFromCivil(pDate.tm_year + 1900L,pDate.tm_mon + 1L,pDate.tm_mday);
+  return days * SECONDS_PER_DAY + pDate.tm_hour * 3600L + pDate.tm_min * 60L + pDate.tm_sec;
+};
+
+void
+timeToCivil(time_t pTime, tm& pDate) {
+  long days = floorDiv(pTime,(time_t)SECONDS_PER_DAY);
+  long secs = pTime - (time_t)days * SECONDS_PER_DAY;
+  long year, month, day;
+  civilFromDays(days,year,month,day);
+  pDate.tm_year = year - 1900;
+  pDate.tm_mon = month - 1;
+  pDate.tm_mday = day;
+  pDate.tm_hour = secs / 3600;
+  pDate.tm_min = secs % 3600 / 60;
+  pDate.tm_sec = secs % 60;
+  //1970-01-01 was thursday
+  pDate.tm_wday = days - floorDiv(days + 4,7L) * 7 + 4;
+  pDate.tm_yday = days - daysFromCivil(year,1,1);
+  pDate.tm_isdst = 0;
+};
+
+void
+addSeconds(tm& pDate, long pSeconds) {
+  timeToCivil(civilToTime(pDate) + pSeconds,pDate);
+  pDate.tm_isdst = -1;
+};
+
+struct OffsetValue {
+  bool valid;
+  //index of cached period
+  time_t period;
+  int isdst;
+  long offset;
+#ifdef HAVE_GTMOFF_IN_TM
+  const char* zone;
+#endif
+};
+
+//entry is read without lock. Sequence is odd while entry is written,
+//so reader can detect that value it copied was changed
+struct OffsetCacheEntry {
+  AtomicCounter seq;
+  OffsetValue value;
+};
+
+//writers are serialized by mutex of cache
+static void
+writeEntry(OffsetCacheEntry& pEntry, const OffsetValue& pValue) {
+  pEntry.seq.inc();
+  pEntry.value = pValue;
+  pEntry.seq.inc();
+};
+
+static bool
+readEntry(const OffsetCacheEntry& pEntry, time_t pPeriod, OffsetValue& pValue) {
+  long seq = pEntry.seq.get();
+  if (seq % 2 != 0)
+    return false;
+  AtomicCounter::fence();
+  pValue = pEntry.value;
+  AtomicCounter::fence();
+  return pEntry.seq.get() == seq && pValue.valid && pValue.period == pPeriod;
+};
+
+struct LocalTimeCache {
+  LocalTimeCache() { clear(); };
+  void clear() {
+    OffsetValue invalid;
+    invalid.valid = false;
+    for(int i = 0; i < CACHE_SIZE; i++) {
+      writeEntry(toLocal[i],invalid);
+      //three entries for every value of tm_isdst
+      for(int j = 0; j < 3; j++)
+        writeEntry(fromLocal[i][j],invalid);
+    };
+  };
+  OffsetCacheEntry toLocal[CACHE_SIZE];
+  OffsetCacheEntry fromLocal[CACHE_SIZE][3];
+  Mutex mutex;
+};
+
+static LocalTimeCache&
+getLocalTimeCache() {
+  static LocalTimeCache cache;
+  return cache;
+};
+
+static inline int
+getCacheIndex(time_t pPeriod) {
+  long idx = pPeriod % CACHE_SIZE;
+  return idx < 0 ? idx + CACHE_SIZE : idx;
+};
+
+time_t
+localToTime(const tm& pDate) {
+  time_t local = civilToTime(pDate);
+  time_t period = floorDiv(local,(time_t)CACHE_PERIOD);
+  int isdst = pDate.tm_isdst < 0 ? 0 : (pDate.tm_isdst == 0 ? 1 : 2);
+  LocalTimeCache& cache(getLocalTimeCache());
+  OffsetCacheEntry& entry(cache.fromLocal[getCacheIndex(period)][isdst]);
+  OffsetValue value;
+  if (readEntry(entry,period,value))
+    return local - value.offset;
+  //offset is cached only if it is the same at start and end of period,
+  //so dates in daylight saving time gaps get the same result as from mktime()
+  time_t start = period * CACHE_PERIOD;
+  tm first;
+  tm last;
+  timeToCivil(start,first);
+  timeToCivil(start + CACHE_PERIOD - 1,last);
+  first.tm_isdst = last.tm_isdst = pDate.tm_isdst;
+  time_t firstTime = mktime(&first);
+  time_t lastTime = mktime(&last);
+  if (firstTime != -1 && lastTime != -1 && start - firstTime == start + CACHE_PERIOD - 1 - lastTime) {
+    value.valid = true;
+    value.period = period;
+    value.offset = start - firstTime;
+    MutexLocker lock(cache.mutex);
+    writeEntry(entry,value);
+  };
+  tm date(pDate);
+  return mktime(&date);
+};
+
+void
+timeToLocal(time_t pTime, tm& pDate) {
+  time_t period = floorDiv(pTime,(time_t)CACHE_PERIOD);
+  LocalTimeCache& cache(getLocalTimeCache());
+  OffsetCacheEntry& entry(cache.toLocal[getCacheIndex(period)]);
+  OffsetValue value;
+  if (readEntry(entry,period,value)) {
+    timeToCivil(pTime + value.offset,pDate);
+    pDate.tm_isdst = value.isdst;
+#ifdef HAVE_GTMOFF_IN_TM
+    pDate.tm_gmtoff = value.offset;
+    pDate.tm_zone = value.zone;
+#endif
+    return;
+  };
+  time_t start = period * CACHE_PERIOD;
+  time_t end = start + CACHE_PERIOD - 1;
+  tm first;
+  tm last;
+  dba_localtime(&start,&first);
+  dba_localtime(&end,&last);
+  long offset = civilToTime(first) - start;
+  if (offset == civilToTime(last) - end && first.tm_isdst == last.tm_isdst) {
+    value.valid = true;
+    value.period = period;
+    value.offset = offset;
+    value.isdst = first.tm_isdst;
+#ifdef HAVE_GTMOFF_IN_TM
+    value.zone = first.tm_zone;
+#endif
+    MutexLocker lock(cache.mutex);
+    writeEntry(entry,value);
+  };
+  dba_localtime(&pTime,&pDate);
+};
+
+void
+clearLocalTimeCache() {
+  LocalTimeCache& cache(getLocalTimeCache());
+  MutexLocker lock(cache.mutex);
+  cache.clear();
+};
+
+};//namespace
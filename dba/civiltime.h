@@ -0,0 +1,109 @@
+// File: civiltime.h
+// Purpose: Calendar calculations on struct tm without C library time zone calls
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBACIVILTIME_H
+#define DBACIVILTIME_H
+
+#include <time.h>
+#include "dba/defs.h"
+
+namespace dba {
+
+/**
+  Julian day number of 1970-01-01 00:00:00 UTC
+*/
+const double JULIAN_DAY_OF_EPOCH = 2440587.5;
+
+/**
+  Number of days since 1970-01-01 in proleptic Gregorian calendar.
+  Month and day do not have to be normalized: month 13 is January of next
+  year and day 0 is last day of previous month.
+  @param pYear year (e.g. 2010)
+  @param pMonth month 1-12
+  @param pDay day of month 1-31
+*/
+dbaDLLEXPORT long
+daysFromCivil(long pYear, long pMonth, long pDay);
+
+/**
+  Inverse of daysFromCivil()
+  @param pDays number of days since 1970-01-01
+  @param pYear year (e.g. 2010)
+  @param pMonth month 1-12
+  @param pDay day of month 1-31
+*/
+dbaDLLEXPORT void
+civilFromDays(long pDays, long& pYear, long& pMonth, long& pDay);
+
+/**
+  Number of seconds since epoch of broken down time treated as UTC time.
+  Same as timegm() but fields of pDate are not modified and do not have to
+  be normalized. tm_isdst, tm_wday and tm_yday are ignored.
+*/
+dbaDLLEXPORT time_t
+civilToTime(const tm& pDate);
+
+/**
+  Fill broken down time for number of seconds since epoch treated as UTC time.
+  Same as gmtime_r(), tm_isdst is set to 0.
+*/
+dbaDLLEXPORT void
+timeToCivil(time_t pTime, tm& pDate);
+
+/**
+  Convert seconds since epoch to Julian day number
+*/
+inline double
+timeToJulianDay(time_t pTime) {
+  return pTime / 86400.0 + JULIAN_DAY_OF_EPOCH;
+};
+
+/**
+  Convert Julian day number to seconds since epoch, rounded to nearest second
+*/
+inline time_t
+julianDayToTime(double pJulianDay) {
+  double secs = (pJulianDay - JULIAN_DAY_OF_EPOCH) * 86400.0;
+  return (time_t)(secs < 0 ? secs - 0.5 : secs + 0.5);
+};
+
+/**
+  Add seconds to broken down time and normalize all fields including tm_wday
+  and tm_yday. Time zone is not used, so result does not depend on daylight
+  saving time changes. tm_isdst is set to -1.
+  @param pDate date to change
+  @param pSeconds number of seconds to add, may be negative
+*/
+dbaDLLEXPORT void
+addSeconds(tm& pDate, long pSeconds);
+
+/**
+  mktime() replacement. Offsets of local time zone are cached for every 15 minute
+  period of local time, mktime() is called only when period is not in cache.
+  Unlike mktime() pDate is not modified.
+  @return seconds since epoch or -1 if date cannot be represented
+*/
+dbaDLLEXPORT time_t
+localToTime(const tm& pDate);
+
+/**
+  localtime_r() replacement. Offsets of local time zone are cached for every
+  15 minute period, localtime is called only when period is not in cache.
+*/
+dbaDLLEXPORT void
+timeToLocal(time_t pTime, tm& pDate);
+
+/**
+  Drop cached offsets of local time zone. Call it after changing time zone of
+  process (TZ environment variable and tzset())
+*/
+dbaDLLEXPORT void
+clearLocalTimeCache();
+
+};//namespace
+
+#endif
@@ -82,7 +82,9 @@ See postgres documentation for meaning of those parameters.
 @subsection conn_str_driver_notes_sqlite3 Sqlite3
 
 Sqlite3 driver accepts dbname parameter and treats it as full path to database file name. If "dbname" is not found then
-connect string contents is iterpreted as database file name.
+connect string contents is iterpreted as database file name. Optional "timeout" parameter sets time in miliseconds
+that connection waits for database locked by other connections before it reports error. Transactions of such
+connection are started with BEGIN IMMEDIATE, so connections that write at the same time do not deadlock.
 
 @ingroup api
 */
@@ -10,7 +10,18 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <ctype.h>
+#include <limits.h>
 #include <cstdio>
+#include <limits>
+#include <locale>
+#include <sstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define DBA_HAVE_SSE2 1
+  #include <emmintrin.h>
+#endif
 
 using namespace std;
 
@@ -42,110 +53,116 @@ trim(string& s) {
 static const std::string err_begin = "Conversion of '";
 static const std::string err_end = "' to date failed: ";
 
-char* 
-parseISODatePart(const char* pStr, tm* pRet) {
-  char* it = (char*)pStr;
-
-  if (it == NULL)
-    throw ConversionException(err_begin + pStr + err_end + "parse error (null string)");
-
-  //omit all trailing whitespaces 
-  if (isspace(*it) && (*it != '\0'))
+//reads decimal number in the same way as strtol(), pIt is not moved
+//if there are no digits
+static bool
+readDateNumber(const char*& pIt, long& pValue) {
+  const char* it = pIt;
+  while(isspace(*it))
     it++;
-  
-  errno = 0;
-  pRet->tm_year = strtol(it,&it,10);
-  if ((*it == '\0')||(errno)) {
-    throw ConversionException(err_begin + pStr + err_end + "parse error (year) " + string(strerror(errno)));
+  bool negative = false;
+  if (*it == '-' || *it == '+')
+    negative = *it++ == '-';
+  pValue = 0;
+  if (!isdigit(*it))
+    return true;
+  long val = 0;
+  for(; isdigit(*it); it++) {
+    if (val > (LONG_MAX - 9) / 10)
+      return false;
+    val = val * 10 + (*it - '0');
   };
-  pRet->tm_year -= 1900;
+  pValue = negative ? -val : val;
+  pIt = it;
+  return true;
+};
+
+static void
+throwDateError(const char* pDate, const char* pPart) {
+  throw ConversionException(err_begin + pDate + err_end + "parse error (" + pPart + ")");
+};
+
+static const char*
+parseISODatePart(const char* pStr, tm* pRet) {
+  if (pStr == NULL)
+    throw ConversionException(err_begin + err_end + "parse error (null string)");
+  const char* it = pStr;
+  long val;
+
+  if (!readDateNumber(it,val) || *it == '\0')
+    throwDateError(pStr,"year");
+  pRet->tm_year = val - 1900;
   it++;
 
-  errno = 0;
-  pRet->tm_mon = strtol(it,&it,10);
-  if ((*it == '\0')||(errno)) {
-    throw ConversionException(err_begin + pStr + err_end + "parse error (month) " + string(strerror(errno)));
-  };
-  pRet->tm_mon -= 1;
+  if (!readDateNumber(it,val) || *it == '\0')
+    throwDateError(pStr,"month");
+  pRet->tm_mon = val - 1;
   it++;
 
-  errno = 0;
-  pRet->tm_mday = strtol(it,&it,10);
-  if (errno) {
-    throw ConversionException(err_begin + pStr + err_end + "parse error (day) " + string(strerror(errno)));
-  };
+  if (!readDateNumber(it,val))
+    throwDateError(pStr,"day");
+  pRet->tm_mday = val;
   return it;
 };
 
+static void
+initDate(tm& pRet) {
+#ifdef HAVE_GTMOFF_IN_TM
+  pRet.tm_gmtoff = 0;
+#endif
+  pRet.tm_hour = 0;
+  pRet.tm_isdst = -1;
+  pRet.tm_mday = 0;
+  pRet.tm_min = 0;
+  pRet.tm_mon = 0;
+  pRet.tm_sec = 0;
+  pRet.tm_wday = 0;
+  pRet.tm_yday = 0;
+  pRet.tm_year = 0;
+};
+
 struct tm
 parseISODateTime(const char* pDate) {
   struct tm ret;
-#ifdef HAVE_GTMOFF_IN_TM
-  ret.tm_gmtoff = 0;
-#endif
-  ret.tm_hour = 0;
-  ret.tm_isdst = -1;
-  ret.tm_mday = 0;
-  ret.tm_min = 0;
-  ret.tm_mon = 0;
-  ret.tm_sec = 0;
-  ret.tm_wday = 0;
-  ret.tm_yday = 0;
-  ret.tm_year = 0;
-  
-  char* it = parseISODatePart(pDate,&ret);
-  it++;
+  initDate(ret);
+  const char* it = parseISODatePart(pDate,&ret);
+  long val;
+  if (*it != '\0')
+    it++;
 
-  errno = 0;
-  ret.tm_hour = strtol(it,&it,10);
-  if ((*it == '\0')||(errno)) {
-    throw ConversionException(err_begin + pDate + err_end + "parse error (day): " + string(strerror(errno)));
-  };
+  if (!readDateNumber(it,val) || *it == '\0')
+    throwDateError(pDate,"hour");
+  ret.tm_hour = val;
   it++;
-  
-  errno = 0;
-  ret.tm_min = strtol(it,&it,10);
-  if ((*it == '\0')||(errno)) {
-    throw ConversionException(err_begin + pDate + err_end + "parse error (hour): " + string(strerror(errno)));
-  };
+
+  if (!readDateNumber(it,val) || *it == '\0')
+    throwDateError(pDate,"min");
+  ret.tm_min = val;
   it++;
 
-  errno = 0;
-  ret.tm_sec = strtol(it,&it,10);
-  if (errno) {
-    throw ConversionException(err_begin + pDate + err_end + "parse error (min): " + string(strerror(errno)));
-  };
-  if (*it == '\0') {
+  if (!readDateNumber(it,val))
+    throwDateError(pDate,"sec");
+  ret.tm_sec = val;
+  if (*it == '\0')
     return ret;
-  };
   //ignore miliseconds
   if (*it == '.') {
     it++;
-    errno = 0;
-    strtol(it,&it,10);
-    if (errno)
-      throw ConversionException(err_begin + pDate + err_end + "parse error (gmt): " + string(strerror(errno)));
-    if ((*it == '\0'))
+    while(isdigit(*it))
+      it++;
+    if (*it == '\0')
       return ret;
   };
 #if defined(HAVE_GTMOFF_IN_TM)
   //those are optional
-  ret.tm_gmtoff = 0;
-  errno = 0;
-  ret.tm_gmtoff = strtol(it,&it,10);
-  if (isspace(*it) && (*it != '\0'))
+  if (!readDateNumber(it,val))
+    throwDateError(pDate,"gmt");
+  if (isspace(*it))
     it++;
-  if ((*it != '\0')||(errno)) {
-    string err(err_begin + pDate + err_end + "parse error: ");
-    if (errno) {
-      err += string(strerror(errno));
-    } else {
-      err += "unparsed chars at end of valid input";
-    };
-    throw ConversionException(err);
-  };
-  ret.tm_gmtoff /= 100; // format in pDate: +0100 
-  ret.tm_gmtoff *= 60*60;
+  if (*it != '\0')
+    throw ConversionException(err_begin + pDate + err_end + "parse error: unparsed chars at end of valid input");
+  // format in pDate: +0100
+  ret.tm_gmtoff = val / 100 * 60 * 60;
 #endif
   return ret;
 };
@@ -153,23 +170,56 @@ parseISODateTime(const char* pDate) {
 struct tm
 parseISODate(const char* pDate) {
   struct tm ret;
-#if defined(HAVE_GTMOFF_IN_TM)
-  ret.tm_gmtoff = 0;
-#endif
-  ret.tm_hour = 0;
-  ret.tm_isdst = -1;
-  ret.tm_mday = 0;
-  ret.tm_min = 0;
-  ret.tm_mon = 0;
-  ret.tm_sec = 0;
-  ret.tm_wday = 0;
-  ret.tm_yday = 0;
-  ret.tm_year = 0;
-  
+  initDate(ret);
   parseISODatePart(pDate,&ret);
   return ret;
 };
 
+//two digits like in strftime(), numbers out of range are written as they are
+static inline int
+formatDatePart(int pValue, char* pBuf) {
+  if (pValue >= 0 && pValue < 100) {
+    pBuf[0] = '0' + pValue / 10;
+    pBuf[1] = '0' + pValue % 10;
+    return 2;
+  };
+  return formatInt(pValue,pBuf);
+};
+
+int
+formatISODate(const tm& pDate, char* pBuf) {
+  char* it = pBuf;
+  it += formatInt(pDate.tm_year + 1900L,it);
+  *it++ = '-';
+  it += formatDatePart(pDate.tm_mon + 1,it);
+  *it++ = '-';
+  it += formatDatePart(pDate.tm_mday,it);
+  *it = '\0';
+  return it - pBuf;
+};
+
+int
+formatISODateTime(const tm& pDate, char* pBuf) {
+  char* it = pBuf + formatISODate(pDate,pBuf);
+  *it++ = ' ';
+  it += formatDatePart(pDate.tm_hour,it);
+  *it++ = ':';
+  it += formatDatePart(pDate.tm_min,it);
+  *it++ = ':';
+  it += formatDatePart(pDate.tm_sec,it);
+  *it = '\0';
+  return it - pBuf;
+};
+
+int
+formatDateTime(const tm& pDate, const char* pFormat, char* pBuf, size_t pSize) {
+  if (!strcmp(pFormat,"%Y-%m-%d %H:%M:%S"))
+    return formatISODateTime(pDate,pBuf);
+  if (!strcmp(pFormat,"%Y-%m-%d"))
+    return formatISODate(pDate,pBuf);
+  return strftime(pBuf,pSize,pFormat,&pDate);
+};
+
 string
 strip(const string& s) {
   int start = s.find_first_not_of(" \t");
@@ -198,212 +248,745 @@ getWord(const string& str,unsigned int num) {
   return(string(""));
 };
 
-double
-mystrtod(const char* s) {
-  errno = 0;
+//Numbers are formatted and parsed without C library functions that depend
+//on C locale, so conversions are not affected by setlocale() in other threads.
+//Doubles are written using Grisu2 algorithm by Florian Loitsch, which gives
+//shortest string that reads back as the same value in almost all cases and
+//string that reads back as the same value always.
+
+#ifdef _MSC_VER
+typedef unsigned __int64 uint64;
+#define DBA_U64(x) x##ui64
+#else
+typedef unsigned long long uint64;
+#define DBA_U64(x) x##ULL
+#endif
+
+static const char sDigitPairs[] =
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+//writes digits backwards, returns pointer to first written char
+static char*
+formatDigits(unsigned long pValue, char* pEnd) {
+  while(pValue >= 100) {
+    unsigned long idx = (pValue % 100) * 2;
+    pValue /= 100;
+    *--pEnd = sDigitPairs[idx + 1];
+    *--pEnd = sDigitPairs[idx];
+  };
+  if (pValue >= 10) {
+    *--pEnd = sDigitPairs[pValue * 2 + 1];
+    *--pEnd = sDigitPairs[pValue * 2];
+  } else {
+    *--pEnd = (char)('0' + pValue);
+  };
+  return pEnd;
+};
+
+int
+formatInt(long pValue, char* pBuf) {
+  char tmp[NUMBER_BUFFER_SIZE];
+  char* end = tmp + NUMBER_BUFFER_SIZE;
+  unsigned long value = pValue < 0 ? 0UL - (unsigned long)pValue : (unsigned long)pValue;
+  char* begin = formatDigits(value,end);
+  if (pValue < 0)
+    *--begin = '-';
+  int len = end - begin;
+  memcpy(pBuf,begin,len);
+  pBuf[len] = '\0';
+  return len;
+};
+
+int
+formatUnsigned(unsigned long pValue, char* pBuf) {
+  char tmp[NUMBER_BUFFER_SIZE];
+  char* end = tmp + NUMBER_BUFFER_SIZE;
+  char* begin = formatDigits(pValue,end);
+  int len = end - begin;
+  memcpy(pBuf,begin,len);
+  pBuf[len] = '\0';
+  return len;
+};
+
+/**@internal
+  Floating point number f * 2^e used by Grisu2
+*/
+struct DiyFp {
+  DiyFp(uint64 pF, int pE) : f(pF), e(pE) {};
+  uint64 f;
+  int e;
+};
+
+static DiyFp
+diyMul(const DiyFp& x, const DiyFp& y) {
+  const uint64 mask = DBA_U64(0xFFFFFFFF);
+  uint64 a = x.f >> 32;
+  uint64 b = x.f & mask;
+  uint64 c = y.f >> 32;
+  uint64 d = y.f & mask;
+  uint64 ac = a * c;
+  uint64 bc = b * c;
+  uint64 ad = a * d;
+  uint64 bd = b * d;
+  uint64 tmp = (bd >> 32) + (ad & mask) + (bc & mask);
+  //round
+  tmp += DBA_U64(1) << 31;
+  return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64);
+};
+
+static DiyFp
+diyNormalize(DiyFp x) {
+  while((x.f >> 63) == 0) {
+    x.f <<= 1;
+    x.e--;
+  };
+  return x;
+};
+
+/**@internal
+  Normalized approximation of 10^k = f * 2^e
+*/
+struct CachedPower {
+  uint64 f;
+  int e;
+  int k;
+};
+
+//10^k for k = -300, -292, ..., 324
+static const CachedPower sCachedPowers[] = {
+  { DBA_U64(0xAB70FE17C79AC6CA), -1060, -300 },
+  { DBA_U64(0xFF77B1FCBEBCDC4F), -1034, -292 },
+  { DBA_U64(0xBE5691EF416BD60C), -1007, -284 },
+  { DBA_U64(0x8DD01FAD907FFC3C), -980, -276 },
+  { DBA_U64(0xD3515C2831559A83), -954, -268 },
+  { DBA_U64(0x9D71AC8FADA6C9B5), -927, -260 },
+  { DBA_U64(0xEA9C227723EE8BCB), -901, -252 },
+  { DBA_U64(0xAECC49914078536D), -874, -244 },
+  { DBA_U64(0x823C12795DB6CE57), -847, -236 },
+  { DBA_U64(0xC21094364DFB5637), -821, -228 },
+  { DBA_U64(0x9096EA6F3848984F), -794, -220 },
+  { DBA_U64(0xD77485CB25823AC7), -768, -212 },
+  { DBA_U64(0xA086CFCD97BF97F4), -741, -204 },
+  { DBA_U64(0xEF340A98172AACE5), -715, -196 },
+  { DBA_U64(0xB23867FB2A35B28E), -688, -188 },
+  { DBA_U64(0x84C8D4DFD2C63F3B), -661, -180 },
+  { DBA_U64(0xC5DD44271AD3CDBA), -635, -172 },
+  { DBA_U64(0x936B9FCEBB25C996), -608, -164 },
+  { DBA_U64(0xDBAC6C247D62A584), -582, -156 },
+  { DBA_U64(0xA3AB66580D5FDAF6), -555, -148 },
+  { DBA_U64(0xF3E2F893DEC3F126), -529, -140 },
+  { DBA_U64(0xB5B5ADA8AAFF80B8), -502, -132 },
+  { DBA_U64(0x87625F056C7C4A8B), -475, -124 },
+  { DBA_U64(0xC9BCFF6034C13053), -449, -116 },
+  { DBA_U64(0x964E858C91BA2655), -422, -108 },
+  { DBA_U64(0xDFF9772470297EBD), -396, -100 },
+  { DBA_U64(0xA6DFBD9FB8E5B88F), -369, -92 },
+  { DBA_U64(0xF8A95FCF88747D94), -343, -84 },
+  { DBA_U64(0xB94470938FA89BCF), -316, -76 },
+  { DBA_U64(0x8A08F0F8BF0F156B), -289, -68 },
+  { DBA_U64(0xCDB02555653131B6), -263, -60 },
+  { DBA_U64(0x993FE2C6D07B7FAC), -236, -52 },
+  { DBA_U64(0xE45C10C42A2B3B06), -210, -44 },
+  { DBA_U64(0xAA242499697392D3), -183, -36 },
+  { DBA_U64(0xFD87B5F28300CA0E), -157, -28 },
+  { DBA_U64(0xBCE5086492111AEB), -130, -20 },
+  { DBA_U64(0x8CBCCC096F5088CC), -103, -12 },
+  { DBA_U64(0xD1B71758E219652C), -77, -4 },
+  { DBA_U64(0x9C40000000000000), -50, 4 },
+  { DBA_U64(0xE8D4A51000000000), -24, 12 },
+  { DBA_U64(0xAD78EBC5AC620000), 3, 20 },
+  { DBA_U64(0x813F3978F8940984), 30, 28 },
+  { DBA_U64(0xC097CE7BC90715B3), 56, 36 },
+  { DBA_U64(0x8F7E32CE7BEA5C70), 83, 44 },
+  { DBA_U64(0xD5D238A4ABE98068), 109, 52 },
+  { DBA_U64(0x9F4F2726179A2245), 136, 60 },
+  { DBA_U64(0xED63A231D4C4FB27), 162, 68 },
+  { DBA_U64(0xB0DE65388CC8ADA8), 189, 76 },
+  { DBA_U64(0x83C7088E1AAB65DB), 216, 84 },
+  { DBA_U64(0xC45D1DF942711D9A), 242, 92 },
+  { DBA_U64(0x924D692CA61BE758), 269, 100 },
+  { DBA_U64(0xDA01EE641A708DEA), 295, 108 },
+  { DBA_U64(0xA26DA3999AEF774A), 322, 116 },
+  { DBA_U64(0xF209787BB47D6B85), 348, 124 },
+  { DBA_U64(0xB454E4A179DD1877), 375, 132 },
+  { DBA_U64(0x865B86925B9BC5C2), 402, 140 },
+  { DBA_U64(0xC83553C5C8965D3D), 428, 148 },
+  { DBA_U64(0x952AB45CFA97A0B3), 455, 156 },
+  { DBA_U64(0xDE469FBD99A05FE3), 481, 164 },
+  { DBA_U64(0xA59BC234DB398C25), 508, 172 },
+  { DBA_U64(0xF6C69A72A3989F5C), 534, 180 },
+  { DBA_U64(0xB7DCBF5354E9BECE), 561, 188 },
+  { DBA_U64(0x88FCF317F22241E2), 588, 196 },
+  { DBA_U64(0xCC20CE9BD35C78A5), 614, 204 },
+  { DBA_U64(0x98165AF37B2153DF), 641, 212 },
+  { DBA_U64(0xE2A0B5DC971F303A), 667, 220 },
+  { DBA_U64(0xA8D9D1535CE3B396), 694, 228 },
+  { DBA_U64(0xFB9B7CD9A4A7443C), 720, 236 },
+  { DBA_U64(0xBB764C4CA7A44410), 747, 244 },
+  { DBA_U64(0x8BAB8EEFB6409C1A), 774, 252 },
+  { DBA_U64(0xD01FEF10A657842C), 800, 260 },
+  { DBA_U64(0x9B10A4E5E9913129), 827, 268 },
+  { DBA_U64(0xE7109BFBA19C0C9D), 853, 276 },
+  { DBA_U64(0xAC2820D9623BF429), 880, 284 },
+  { DBA_U64(0x80444B5E7AA7CF85), 907, 292 },
+  { DBA_U64(0xBF21E44003ACDD2D), 933, 300 },
+  { DBA_U64(0x8E679C2F5E44FF8F), 960, 308 },
+  { DBA_U64(0xD433179D9C8CB841), 986, 316 },
+  { DBA_U64(0x9E19DB92B4E31BA9), 1013, 324 },
+};
+
+static int
+largestPow10(unsigned long pValue, unsigned long& pPow10) {
+  static const unsigned long pows[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+  int k = 9;
+  while(k > 0 && pValue < pows[k])
+    k--;
+  pPow10 = pows[k];
+  return k + 1;
+};
+
+static void
+grisuRound(char* pBuf, int pLen, uint64 pDist, uint64 pDelta, uint64 pRest, uint64 pTenK) {
+  //move last digit closer to exact value while result stays in boundaries
+  while(pRest < pDist && pDelta - pRest >= pTenK
+        && (pRest + pTenK < pDist || pDist - pRest > pRest + pTenK - pDist)) {
+    pBuf[pLen - 1]--;
+    pRest += pTenK;
+  };
+};
+
+static void
+grisuDigits(char* pBuf, int& pLen, int& pExp10, const DiyFp& pLow, const DiyFp& pW, const DiyFp& pHigh) {
+  uint64 delta = pHigh.f - pLow.f;
+  uint64 dist = pHigh.f - pW.f;
+  const int shift = -pHigh.e;
+  const uint64 one = DBA_U64(1) << shift;
+  //exponent of pHigh is in range [-60,-32] so integral part fits in 32 bits
+  unsigned long p1 = (unsigned long)(pHigh.f >> shift);
+  uint64 p2 = pHigh.f & (one - 1);
+  unsigned long pow10;
+  int n = largestPow10(p1,pow10);
+  while(n > 0) {
+    pBuf[pLen++] = (char)('0' + p1 / pow10);
+    p1 %= pow10;
+    n--;
+    uint64 rest = ((uint64)p1 << shift) + p2;
+    if (rest <= delta) {
+      pExp10 += n;
+      grisuRound(pBuf,pLen,dist,delta,rest,(uint64)pow10 << shift);
+      return;
+    };
+    pow10 /= 10;
+  };
+  for(;;) {
+    p2 *= 10;
+    pBuf[pLen++] = (char)('0' + (p2 >> shift));
+    p2 &= one - 1;
+    delta *= 10;
+    dist *= 10;
+    pExp10--;
+    if (p2 <= delta)
+      break;
+  };
+  grisuRound(pBuf,pLen,dist,delta,p2,one);
+};
+
+//writes digits of positive finite value given as fields of IEEE 754 number,
+//value = digits * 10^pExp10
+static void
+grisu2(uint64 pFraction, int pExponent, int pFractionBits, int pBias, char* pBuf, int& pLen, int& pExp10) {
+  const uint64 hidden = DBA_U64(1) << pFractionBits;
+  DiyFp w = pExponent == 0 ? DiyFp(pFraction,1 - pBias) : DiyFp(pFraction + hidden,pExponent - pBias);
+  //boundaries between value and its neighbours
+  bool lowerCloser = pFraction == 0 && pExponent > 1;
+  DiyFp plus(diyNormalize(DiyFp(2 * w.f + 1,w.e - 1)));
+  DiyFp minus = lowerCloser ? DiyFp(4 * w.f - 1,w.e - 2) : DiyFp(2 * w.f - 1,w.e - 1);
+  minus = DiyFp(minus.f << (minus.e - plus.e),plus.e);
+  w = diyNormalize(w);
+
+  //select 10^-k that moves exponent of upper boundary to [-60,-32]
+  int f = -60 - plus.e - 1;
+  int k = (f * 78913) / (1 << 18) + (f > 0);
+  const CachedPower& cached = sCachedPowers[(300 + k + 7) / 8];
+  DiyFp c(cached.f,cached.e);
+  DiyFp scaledW(diyMul(w,c));
+  DiyFp scaledMinus(diyMul(minus,c));
+  DiyFp scaledPlus(diyMul(plus,c));
+  //conservative boundaries because of multiplication error
+  DiyFp low(scaledMinus.f + 1,scaledMinus.e);
+  DiyFp high(scaledPlus.f - 1,scaledPlus.e);
+  pLen = 0;
+  pExp10 = -cached.k;
+  grisuDigits(pBuf,pLen,pExp10,low,scaledW,high);
+};
+
+static int
+formatBinary(bool pNegative, int pExponent, uint64 pFraction, int pFractionBits, int pMaxExponent, int pBias, char* pBuf, char pDecimalPoint) {
+  char* out = pBuf;
+  if (pExponent == pMaxExponent && pFraction != 0) {
+    memcpy(pBuf,"nan",4);
+    return 3;
+  };
+  if (pNegative)
+    *out++ = '-';
+  if (pExponent == pMaxExponent) {
+    memcpy(out,"inf",4);
+    return out + 3 - pBuf;
+  };
+  if (pExponent == 0 && pFraction == 0) {
+    *out++ = '0';
+    *out = '\0';
+    return out - pBuf;
+  };
+  char digits[20];
+  int len;
+  int exp10;
+  grisu2(pFraction,pExponent,pFractionBits,pBias,digits,len,exp10);
+  //position of decimal point relative to first digit
+  int point = len + exp10;
+  if (exp10 >= 0 && point <= 21) {
+    //integer, trailing zeros are written
+    memcpy(out,digits,len);
+    out += len;
+    memset(out,'0',exp10);
+    out += exp10;
+  } else if (point > 0 && point <= 21) {
+    memcpy(out,digits,point);
+    out += point;
+    *out++ = pDecimalPoint;
+    memcpy(out,digits + point,len - point);
+    out += len - point;
+  } else if (point > -6 && point <= 0) {
+    *out++ = '0';
+    *out++ = pDecimalPoint;
+    memset(out,'0',-point);
+    out += -point;
+    memcpy(out,digits,len);
+    out += len;
+  } else {
+    *out++ = digits[0];
+    if (len > 1) {
+      *out++ = pDecimalPoint;
+      memcpy(out,digits + 1,len - 1);
+      out += len - 1;
+    };
+    *out++ = 'e';
+    int e = point - 1;
+    *out++ = e < 0 ? '-' : '+';
+    char tmp[NUMBER_BUFFER_SIZE];
+    char* end = tmp + NUMBER_BUFFER_SIZE;
+    char* begin = formatDigits(e < 0 ? -e : e,end);
+    memcpy(out,begin,end - begin);
+    out += end - begin;
+  };
+  *out = '\0';
+  return out - pBuf;
+};
+
+int
+formatDouble(double pValue, char* pBuf, char pDecimalPoint) {
+  uint64 bits;
+  memcpy(&bits,&pValue,sizeof(bits));
+  return formatBinary((bits >> 63) != 0,(int)((bits >> 52) & 0x7FF),bits & ((DBA_U64(1) << 52) - 1),52,0x7FF,1075,pBuf,pDecimalPoint);
+};
+
+int
+formatFloat(float pValue, char* pBuf, char pDecimalPoint) {
+  unsigned int bits;
+  memcpy(&bits,&pValue,sizeof(bits));
+  return formatBinary((bits >> 31) != 0,(int)((bits >> 23) & 0xFF),bits & ((1U << 23) - 1),23,0xFF,150,pBuf,pDecimalPoint);
+};
+
+static bool
+isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+};
+
+static bool
+isDigit(char c) {
+  return c >= '0' && c <= '9';
+};
+
+static void
+trimRange(const char*& pBegin, const char*& pEnd) {
+  while(pBegin != pEnd && isSpace(*pBegin))
+    pBegin++;
+  while(pEnd != pBegin && isSpace(pEnd[-1]))
+    pEnd--;
+};
+
+static bool
+equalsNoCase(const char* pBegin, const char* pEnd, const char* pWord) {
+  for(; pBegin != pEnd; pBegin++, pWord++) {
+    if (*pWord == '\0' || tolower(*pBegin) != *pWord)
+      return false;
+  };
+  return *pWord == '\0';
+};
+
+bool
+parseInt(const char* pBegin, const char* pEnd, long& pValue) {
+  trimRange(pBegin,pEnd);
+  bool negative = false;
+  if (pBegin != pEnd && (*pBegin == '-' || *pBegin == '+')) {
+    negative = *pBegin == '-';
+    pBegin++;
+  };
+  if (pBegin == pEnd)
+    return false;
+  const unsigned long limit = negative ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+  unsigned long value = 0;
+  for(; pBegin != pEnd; pBegin++) {
+    if (!isDigit(*pBegin))
+      return false;
+    unsigned long digit = *pBegin - '0';
+    if (value > (limit - digit) / 10)
+      return false;
+    value = value * 10 + digit;
+  };
+  pValue = negative ? -(long)(value - 1) - 1 : (long)value;
+  return true;
+};
+
+static const double sPow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+bool
+parseDouble(const char* pBegin, const char* pEnd, double& pValue, char pDecimalPoint) {
+  trimRange(pBegin,pEnd);
+  const char* p = pBegin;
+  bool negative = false;
+  if (p != pEnd && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  };
+  if (p != pEnd && !isDigit(*p) && *p != '.' && *p != pDecimalPoint) {
+    if (equalsNoCase(p,pEnd,"nan")) {
+      pValue = std::numeric_limits<double>::quiet_NaN();
+      return true;
+    };
+    if (equalsNoCase(p,pEnd,"inf") || equalsNoCase(p,pEnd,"infinity")) {
+      pValue = negative ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+      return true;
+    };
+    return false;
+  };
+  //first 19 significant digits are collected in mantissa
+  uint64 mantissa = 0;
+  int digits = 0;
+  int exp10 = 0;
+  bool any = false;
+  bool truncated = false;
+  for(; p != pEnd && isDigit(*p); p++) {
+    any = true;
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa != 0)
+        digits++;
+    } else {
+      exp10++;
+      truncated = truncated || *p != '0';
+    };
+  };
+  if (p != pEnd && (*p == pDecimalPoint || *p == '.')) {
+    p++;
+    for(; p != pEnd && isDigit(*p); p++) {
+      any = true;
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa != 0)
+          digits++;
+        exp10--;
+      } else {
+        truncated = truncated || *p != '0';
+      };
+    };
+  };
+  if (!any)
+    return false;
+  if (p != pEnd && (*p == 'e' || *p == 'E')) {
+    p++;
+    bool negativeExp = false;
+    if (p != pEnd && (*p == '-' || *p == '+')) {
+      negativeExp = *p == '-';
+      p++;
+    };
+    if (p == pEnd || !isDigit(*p))
+      return false;
+    int e = 0;
+    for(; p != pEnd && isDigit(*p); p++) {
+      if (e < 100000)
+        e = e * 10 + (*p - '0');
+    };
+    exp10 += negativeExp ? -e : e;
+  };
+  if (p != pEnd)
+    return false;
+  if (mantissa == 0) {
+    pValue = negative ? -0.0 : 0.0;
+    return true;
+  };
+  //exact when mantissa and power of ten are exact doubles
+  if (!truncated && mantissa <= (DBA_U64(1) << 53) && exp10 >= -22 && exp10 <= 22) {
+    double value = (double)mantissa;
+    if (exp10 < 0)
+      value /= sPow10[-exp10];
+    else
+      value *= sPow10[exp10];
+    pValue = negative ? -value : value;
+    return true;
+  };
+  //rare case that needs exact arithmetic, classic locale reads
+  //decimal point the same way as "C" locale
+  std::string text(pBegin,pEnd);
+  if (pDecimalPoint != '.') {
+    std::string::size_type pos = text.find(pDecimalPoint);
+    if (pos != std::string::npos)
+      text[pos] = '.';
+  };
+  std::istringstream in(text);
+  in.imbue(std::locale::classic());
+  double value;
+  in >> value;
+  if (in.fail() || in.peek() != std::char_traits<char>::eof())
+    return false;
+  pValue = value;
+  return true;
+};
+
+//strtol is used only for numbers with base other than 10
+static bool
+parseLongBase(const char* s, long& i, int base) {
+  const char* begin = s;
+  while(isSpace(*begin))
+    begin++;
+  const char* digits = begin;
+  if (*digits == '-' || *digits == '+')
+    digits++;
+  //0x or 0 prefix selects hex or octal number when base is 0
+  if (base == 10 || (base == 0 && (*digits != '0' || (!isDigit(digits[1]) && digits[1] != 'x' && digits[1] != 'X'))))
+    return parseInt(begin,begin + strlen(begin),i);
   char* ptr = NULL;
-  double d = strtod(s,&ptr);
-  if ((*ptr != '\0')||(errno != 0))
-    throw ConversionException("cannot convert " + (string)s);
-  return d;
+  errno = 0;
+  i = strtol(begin,&ptr,base);
+  if (ptr == begin || errno != 0)
+    return false;
+  while(isSpace(*ptr))
+    ptr++;
+  return *ptr == '\0';
+};
+
+static bool
+parseIntBase(const char* s, int& i, int base) {
+  long l;
+  if (!parseLongBase(s,l,base) || l < INT_MIN || l > INT_MAX)
+    return false;
+  i = (int)l;
+  return true;
 };
 
 void
 convert(const string& s,long& i, int base) {
-  std::string toConvert(strip(s));
-  char *ptr = NULL;
-  if (*toConvert.c_str() == '\0')
-    throw ConversionException("cannot convert '" + s + "' to number");
-  errno = 0;
-  i = strtol(toConvert.c_str(),&ptr, base);
-  if ((*ptr != '\0')||(errno != 0))
+  if (!parseLongBase(s.c_str(),i,base))
     throw ConversionException("cannot convert '" + s + "' to number");
 }
 
 void
 convert(const string& s,int& i, int base) {
-  std::string toConvert(strip(s));
-  char *ptr = NULL;
-  if (*toConvert.c_str() == '\0')
-    throw ConversionException("cannot convert '" + s + "' to number");
-  errno = 0;
-  i = strtol(toConvert.c_str(),&ptr, base);
-  if ((*ptr != '\0')||(errno != 0))
+  if (!parseIntBase(s.c_str(),i,base))
     throw ConversionException("cannot convert '" + s + "' to number");
 }
 
 void
 convert(const string& s, double& d, const char* pDecPointRepl) {
-  std::string toConvert(strip(s));
-  if (pDecPointRepl != NULL) {
-    struct lconv* l = localeconv();
-    char* lptr = l->decimal_point;
-    if (*lptr != *pDecPointRepl) {
-      size_t pos = toConvert.find(*pDecPointRepl);
-      if (pos != std::string::npos) {
-        toConvert.replace(pos,1,1,*lptr);
-      };
-    };
-  };
-  if (*toConvert.c_str() == '\0')
+  if (!parseDouble(s.data(),s.data() + s.size(),d,pDecPointRepl != NULL ? *pDecPointRepl : '.'))
     throw ConversionException("cannot convert '" + s + "' to double");
-  errno = 0;
-  d = mystrtod(toConvert.c_str());
 };
 
-
 void
 convert(const char* s, int& i, int base) {
-  char *ptr = NULL;
-  while (isspace(*s) && *s != '\0')
-    s++;
-  if (*s == '\0')
-    throw ConversionException("cannot convert " + (string)s);
-  errno = 0;
-  i = strtol(s,&ptr, base);
-  if ((*ptr != '\0')||(errno != 0))
+  if (!parseIntBase(s,i,base))
     throw ConversionException("cannot convert " + (string)s);
 };
 
 void
 convert(const char* s, long& i, int base) {
-  char *ptr = NULL;
-  while (isspace(*s) && *s != '\0')
-    s++;
-  if (*s == '\0')
-    throw ConversionException("cannot convert " + (string)s);
-  errno = 0;
-  i = strtol(s,&ptr, base);
-  if ((*ptr != '\0')||(errno != 0))
+  if (!parseLongBase(s,i,base))
     throw ConversionException("cannot convert " + (string)s);
 };
 
-
 void
 convert(const char* s, double& d, const char* pDecPointRepl) {
-  while (isspace(*s) && *s != '\0')
-    s++;
-  if (*s == '\0')
+  if (!parseDouble(s,s + strlen(s),d,pDecPointRepl != NULL ? *pDecPointRepl : '.'))
     throw ConversionException("cannot convert " + (string)s);
-  errno = 0;
-  if (pDecPointRepl != NULL) {
-    struct lconv* l = localeconv();
-    char* lptr = l->decimal_point;
-    if (*lptr != *pDecPointRepl) {
-      char* s_dup = strdup(s);
-      char* to_repl = strchr(s_dup,*pDecPointRepl);
-      if (to_repl != NULL) {
-        *to_repl = *lptr;
-      };
-      d = mystrtod(s_dup);
-      free(s_dup);
-    } else {
-      d = mystrtod(s);
-    };
-  } else {
-    d = mystrtod(s);
-  };
 };
 
-
 void
 convert(int i, char* s) {
-  sprintf(s,"%d",i);
+  formatInt(i,s);
 }
 
 void
 convert(long l, char* s) {
-  sprintf(s,"%ld",l);
+  formatInt(l,s);
 }
 
 void
 convert(double d, char* s) {
-  sprintf(s,"%f",d);
+  formatDouble(d,s);
 };
 
 void
 convert(int i, string& s) {
-  const int size = 24;
-  char buf[size]; 
-  sprintf(buf,"%d",i);
-  s = string(buf);
+  char buf[NUMBER_BUFFER_SIZE];
+  s.assign(buf,formatInt(i,buf));
 }
 
 void
 convert(long l, string& s) {
-  const int size = 24;
-  char buf[size]; 
-  sprintf(buf,"%ld",l);
-  s = string(buf);
+  char buf[NUMBER_BUFFER_SIZE];
+  s.assign(buf,formatInt(l,buf));
 }
 
 void
 convert(double d, string& s) {
-  const int size = 24;
-  char buf[size]; 
-  int written = sprintf(buf,"%f",d);
-  if (written <= 0) {
-    throw ConversionException("Error converting double value to string");
-  };
-  //remove trailing zeroes
-  --written;
-  while(buf[written] == '0' && written != 0) {
-    buf[written] = 0x0;
-    written--;
-  };
-  //remove dot if there is no fractional part
-  const lconv* loc = localeconv();
-  
-  if (buf[written] == *(loc->decimal_point))
-    buf[written] = 0x0;
-   
-  s = string(buf);
+  char buf[NUMBER_BUFFER_SIZE];
+  s.assign(buf,formatDouble(d,buf));
 };
 
-
 string
 escape_sql(const string& s) {
-  string ret = s;
-  unsigned int pos = ret.find("'");
-  while((pos < ret.length())&&(pos != string::npos)) {
-    ret.insert(pos,"'");
-    pos += 2;
-    pos = ret.find("'",pos);
-  };
+  const char* end = s.data() + s.size();
+  const char* special = findFirstOf(s.data(),end,"'");
+  if (special == end)
+    return s;
+  string ret(s.data(),special);
+  appendEscaped(ret,special,end,"'","'");
   return ret;
 };
 
+//set of at most 8 chars searched in text, on SSE2 capable processors
+//16 chars of text are compared with all chars of set at once
+class CharSet {
+  public:
+    CharSet(const char* pChars) 
+      : mChars(pChars),
+        mCount(strlen(pChars))
+    {
+#ifdef DBA_HAVE_SSE2
+      for(size_t i = 0; i < mCount && i < 8; i++)
+        mNeedles[i] = _mm_set1_epi8(pChars[i]);
+#endif
+    };
+    const char* find(const char* pBegin, const char* pEnd) const {
+      const char* it = pBegin;
+#ifdef DBA_HAVE_SSE2
+      if (mCount <= 8) {
+        for(; pEnd - it >= 16; it += 16) {
+          __m128i block = _mm_loadu_si128((const __m128i*)it);
+          __m128i found = _mm_cmpeq_epi8(block,mNeedles[0]);
+          for(size_t i = 1; i < mCount; i++)
+            found = _mm_or_si128(found,_mm_cmpeq_epi8(block,mNeedles[i]));
+          int mask = _mm_movemask_epi8(found);
+          if (mask != 0) {
+            while(!(mask & 1)) {
+              mask >>= 1;
+              it++;
+            };
+            return it;
+          };
+        };
+      };
+#endif
+      for(; it != pEnd; it++) {
+        for(size_t i = 0; i < mCount; i++) {
+          if (*it == mChars[i])
+            return it;
+        };
+      };
+      return pEnd;
+    };
+  private:
+    const char* mChars;
+    size_t mCount;
+#ifdef DBA_HAVE_SSE2
+    __m128i mNeedles[8];
+#endif
+};
+
+const char*
+findFirstOf(const char* pBegin, const char* pEnd, const char* pChars) {
+  return CharSet(pChars).find(pBegin,pEnd);
+};
+
+int
+appendEscaped(string& pOut, const char* pBegin, const char* pEnd, const char* pChars, const char* pPrefixes) {
+  CharSet chars(pChars);
+  int count = 0;
+  //most of texts have no special chars or only few of them
+  pOut.reserve(pOut.size() + (pEnd - pBegin) + 2);
+  for(const char* it = pBegin;;) {
+    const char* special = chars.find(it,pEnd);
+    pOut.append(it,special - it);
+    if (special == pEnd)
+      break;
+    pOut += pPrefixes[strchr(pChars,*special) - pChars];
+    pOut += *special;
+    it = special + 1;
+    count++;
+  };
+  return count;
+};
+
+
 string
 toStr(double d,const char* format) {
+  char buf[NUMBER_BUFFER_SIZE];
+  if (format == NULL)
+    return string(buf,formatDouble(d,buf));
   const int size = 24;
-  char buf[size]; 
-  sprintf(buf,format,d);
-  return string(buf);
+  char fbuf[size]; 
+  sprintf(fbuf,format,d);
+  return string(fbuf);
 };
 
 string
 toStr(long i,const char* format) {
+  char buf[NUMBER_BUFFER_SIZE];
+  if (!strcmp(format,"%d") || !strcmp(format,"%ld"))
+    return string(buf,formatInt(i,buf));
   const int size = 24;
-  char buf[size]; 
-  sprintf(buf,format,i);
-  return string(buf);
+  char fbuf[size]; 
+  sprintf(fbuf,format,i);
+  return string(fbuf);
 };
 
 string
 toStr(int i,const char* format) {
+  char buf[NUMBER_BUFFER_SIZE];
+  if (!strcmp(format,"%d"))
+    return string(buf,formatInt(i,buf));
   const int size = 24;
-  char buf[size]; 
-  sprintf(buf,format,i);
-  return string(buf);
+  char fbuf[size]; 
+  sprintf(fbuf,format,i);
+  return string(fbuf);
 };
 
 string
 toStr(unsigned i,const char* format) {
+  char buf[NUMBER_BUFFER_SIZE];
+  if (!strcmp(format,"%u"))
+    return string(buf,formatUnsigned(i,buf));
   const int size = 24;
-  char buf[size];
-  sprintf(buf,format,i);
-  return string(buf);
+  char fbuf[size];
+  sprintf(fbuf,format,i);
+  return string(fbuf);
 };
 
 };//namespace
-
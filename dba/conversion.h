@@ -44,12 +44,60 @@ dbaDLLEXPORT int replaceAll(std::string &s, const std::string &to_find, const st
 */
 dbaDLLEXPORT void trim(std::string& s);
 
+/**
+  Parse date and time in "YYYY-MM-DD HH:MM:SS[.fraction][+ZZZZ]" format.
+  Any single character can be used as separator. Does not depend on C locale.
+  @throw ConversionException on parse error
+*/
 dbaDLLEXPORT struct tm
 parseISODateTime(const char* pDate);
 
+/**
+  Parse date in "YYYY-MM-DD" format
+  @throw ConversionException on parse error
+*/
 dbaDLLEXPORT struct tm
 parseISODate(const char* pDate);
 
+/**
+  Size of buffer that is large enough for any date written by formatISODateTime()
+  and formatISODate() including terminating zero
+*/
+const int DATE_BUFFER_SIZE = 64;
+
+/**
+  Write date and time in "YYYY-MM-DD HH:MM:SS" format. Output is the same as
+  from strftime() with ConvSpec default timestamp format, but C locale and time
+  zone are not used. Fields of pDate are written without normalization.
+  @param pDate date to write
+  @param pBuf buffer of at least DATE_BUFFER_SIZE chars
+  @return number of chars written without terminating zero
+*/
+dbaDLLEXPORT int
+formatISODateTime(const tm& pDate, char* pBuf);
+
+/**
+  Write date in "YYYY-MM-DD" format.
+  @param pDate date to write
+  @param pBuf buffer of at least DATE_BUFFER_SIZE chars
+  @return number of chars written without terminating zero
+*/
+dbaDLLEXPORT int
+formatISODate(const tm& pDate, char* pBuf);
+
+/**
+  strftime() replacement used by date filters. Formats "%Y-%m-%d %H:%M:%S" and
+  "%Y-%m-%d" are written by formatISODateTime() and formatISODate(), other
+  formats are passed to strftime().
+  @param pDate date to write
+  @param pFormat strftime() compatible format
+  @param pBuf output buffer
+  @param pSize size of pBuf, at least DATE_BUFFER_SIZE
+  @return number of chars written without terminating zero, 0 on error
+*/
+dbaDLLEXPORT int
+formatDateTime(const tm& pDate, const char* pFormat, char* pBuf, size_t pSize);
+
 /*removes isspace() chars from end and beginning of string*/
 dbaDLLEXPORT std::string
 strip(const std::string& s);
@@ -58,7 +106,103 @@ strip(const std::string& s);
 dbaDLLEXPORT std::string
 escape_sql(const std::string& s);
 
-/*in-place conversions*/
+/**
+  Find first char in range that is one of chars from pChars. On x86 processors
+  with SSE2 16 chars are checked at once.
+  @param pBegin first char of text
+  @param pEnd char after last char of text
+  @param pChars zero terminated list of at most 8 chars to find
+  @return pointer to found char or pEnd if text does not contain any of pChars
+*/
+dbaDLLEXPORT const char*
+findFirstOf(const char* pBegin, const char* pEnd, const char* pChars);
+
+/**
+  Append text to pOut and write escape prefix before every special char.
+  Text is scanned once and parts without special chars are appended as they are.
+  @param pOut output string
+  @param pBegin first char of text
+  @param pEnd char after last char of text
+  @param pChars zero terminated list of at most 8 special chars
+  @param pPrefixes prefix char for each of pChars
+  @return number of escaped chars
+*/
+dbaDLLEXPORT int
+appendEscaped(std::string& pOut, const char* pBegin, const char* pEnd, const char* pChars, const char* pPrefixes);
+
+/**
+  Size of buffer that is large enough for any number written by formatInt(),
+  formatUnsigned() and formatDouble() including terminating zero
+*/
+const int NUMBER_BUFFER_SIZE = 32;
+
+/**
+  Write decimal representation of integer. Does not depend on C locale.
+  @param pValue number to write
+  @param pBuf buffer of at least NUMBER_BUFFER_SIZE chars
+  @return number of chars written without terminating zero
+*/
+dbaDLLEXPORT int
+formatInt(long pValue, char* pBuf);
+
+/**
+  Write decimal representation of unsigned integer. Does not depend on C locale.
+  @param pValue number to write
+  @param pBuf buffer of at least NUMBER_BUFFER_SIZE chars
+  @return number of chars written without terminating zero
+*/
+dbaDLLEXPORT int
+formatUnsigned(unsigned long pValue, char* pBuf);
+
+/**
+  Write shortest representation of double that is read back by parseDouble()
+  as the same value. Fixed notation is used if decimal point is placed at most
+  21 digits after and 6 digits before first digit, scientific notation
+  (1.5e+30) otherwise. NaN and infinity are written as "nan", "inf" and "-inf".
+  Does not depend on C locale.
+  @param pValue number to write
+  @param pBuf buffer of at least NUMBER_BUFFER_SIZE chars
+  @param pDecimalPoint character written as decimal point
+  @return number of chars written without terminating zero
+*/
+dbaDLLEXPORT int
+formatDouble(double pValue, char* pBuf, char pDecimalPoint = '.');
+
+/**
+  Write shortest representation of float that is read back as the same float
+  value. Format is the same as in formatDouble().
+  @param pValue number to write
+  @param pBuf buffer of at least NUMBER_BUFFER_SIZE chars
+  @param pDecimalPoint character written as decimal point
+  @return number of chars written without terminating zero
+*/
+dbaDLLEXPORT int
+formatFloat(float pValue, char* pBuf, char pDecimalPoint = '.');
+
+/**
+  Parse decimal integer. Leading and trailing whitespaces are skipped.
+  Does not depend on C locale.
+  @param pBegin first char of number
+  @param pEnd char after last char of number
+  @param pValue parsed value
+  @return false if text is not a number or number does not fit in long
+*/
+dbaDLLEXPORT bool
+parseInt(const char* pBegin, const char* pEnd, long& pValue);
+
+/**
+  Parse double written in fixed or scientific notation. Leading and trailing
+  whitespaces are skipped. Result is correctly rounded. Does not depend on C locale.
+  @param pBegin first char of number
+  @param pEnd char after last char of number
+  @param pValue parsed value
+  @param pDecimalPoint character used as decimal point, '.' is always accepted
+  @return false if text is not a number or number is out of range of double
+*/
+dbaDLLEXPORT bool
+parseDouble(const char* pBegin, const char* pEnd, double& pValue, char pDecimalPoint = '.');
+
+/*in-place conversions, C locale is not used*/
 dbaDLLEXPORT void
 convert(const std::string& s,long& i, int base = 0);
 
@@ -95,11 +239,12 @@ convert(long l, char* s);
 dbaDLLEXPORT void
 convert(double d, char* s);
 
-/*basic datatypes to string*/
+/*basic datatypes to string, default formats do not use C locale,
+  double without format is written by formatDouble()*/
 dbaDLLEXPORT std::string toStr(long i,const char* format = "%d");
 dbaDLLEXPORT std::string toStr(unsigned i,const char* format = "%u");
 dbaDLLEXPORT std::string toStr(int i,const char* format = "%d");
-dbaDLLEXPORT std::string toStr(double d,const char* format = "%f");
+dbaDLLEXPORT std::string toStr(double d,const char* format = NULL);
 
 //returns n-th word from string
 dbaDLLEXPORT std::string getWord(const std::string& str,unsigned int num);
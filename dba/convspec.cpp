@@ -19,6 +19,7 @@ ConvSpec::ConvSpec()
   //default values
   mTimestampFormat = "%Y-%m-%d %H:%M:%S";
   mDateFormat = "%Y-%m-%d";
+  mDateStorage = DATE_TEXT;
   mGMTOffset = 0;
   mDecimalPoint = '.';
   mDbCharset = UTF8;
@@ -66,6 +66,18 @@ class dbaDLLEXPORT ConvSpec {
       EUC_JP          // Extended Unix Codepage for Japanese
     } charset;
 
+    /**
+      How DateTime filter writes dates to database
+    */
+    typedef enum {
+      //!text in mTimestampFormat
+      DATE_TEXT,
+      //!integer number of seconds since 1970-01-01 00:00:00
+      DATE_UNIXTIME,
+      //!floating point Julian day number
+      DATE_JULIANDAY
+    } date_storage;
+
     ConvSpec();
     /**
       Char used for decimal point for floating point to string conversions 
@@ -94,6 +106,20 @@ class dbaDLLEXPORT ConvSpec {
       strftime compatibile format for date conversion to query value
     */
     const char* mDateFormat;
+    /**
+      Storage of dates written by DateTime filter. Numeric dates are supported
+      only by drivers that return true from DbConnection::hasNumericDates()
+      (SQLite3), SQLOStream throws DataException for other drivers. They are
+      smaller and faster to read and compare than text.
+      Numeric dates are always UTC: broken down time is converted without
+      time zone, like in SQLite date functions (strftime('%s',...) and
+      julianday()). DateTime filter uses UTC also for numbers read from
+      integer and float fields if numeric storage is set, with DATE_TEXT
+      such numbers are converted to local time.
+      Dates are not quoted in %SQL and should be compared using :d or :f
+      placeholders. Default is DATE_TEXT.
+    */
+    date_storage mDateStorage;
 #ifdef _WIN32
     /**
       Convert debea charset to MSW code page    
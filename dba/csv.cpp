@@ -6,13 +6,13 @@
 // This file is a part of debea library (http://debea.net)
 
 #include <algorithm>
-#include <map>
 #include <assert.h>
 #include <string.h>
 
 #include "dba/csv.h"
 #include "dba/exception.h"
 #include "dba/conversion.h"
+#include "dba/stdfilters.h"
 
 namespace dba {
 
@@ -21,12 +21,37 @@ using namespace dba;
 
 /*============================ CSV Parser =========================*/
 
+//number of bytes read from file at once
+static const size_t CSV_BLOCK_SIZE = 1024 * 1024;
+
 CSVParser::CSVParser(ifstream& pStream) 
-  : mStream(pStream),
-    mLine(0),
-    mChar(0),
-    mFieldSep(',')
+  : mStream(&pStream),
+    mData(NULL),
+    mPos(0),
+    mEnd(0),
+    mFinal(false),
+    mEof(false),
+    mValuesReady(false),
+    mValue(NULL),
+    mValueSize(0),
+    mValueOffset(string::npos)
+{
+  setFieldSeparator(',');
+};
+
+CSVParser::CSVParser(const char* pData, size_t pSize) 
+  : mStream(NULL),
+    mData(pData),
+    mPos(0),
+    mEnd(pSize),
+    mFinal(true),
+    mEof(false),
+    mValuesReady(false),
+    mValue(NULL),
+    mValueSize(0),
+    mValueOffset(string::npos)
 {
+  setFieldSeparator(',');
 };
 
 char 
@@ -37,233 +62,256 @@ CSVParser::getFieldSeparator() const {
 void
 CSVParser::setFieldSeparator(char pSep) {
   mFieldSep = pSep;
+  //chars that end unquoted part of field
+  mSpecial[0] = '"';
+  mSpecial[1] = '\r';
+  mSpecial[2] = '\n';
+  mSpecial[3] = pSep;
+  mSpecial[4] = '\0';
 };
 
 const list<string>&
 CSVParser::getValues() const {
+  if (!mValuesReady) {
+    mValues.clear();
+    for(vector<CSVField>::const_iterator it = mFields.begin(); it != mFields.end(); it++)
+      mValues.push_back(string(it->data,it->size));
+    mValuesReady = true;
+  };
   return mValues;
 };
 
-void 
-CSVParser::onField(int pNum, string* pData) {
-//  cerr << "adding " << *pData << " (" << pNum << ")" << endl;
-  mValues.push_back(*pData);
-  pData -> clear();
+void
+CSVParser::append(const char* pBegin, const char* pEnd) {
+  if (pBegin == pEnd)
+    return;
+  if (mValueOffset == string::npos) {
+    if (mValueSize == 0) {
+      mValue = pBegin;
+      mValueSize = pEnd - pBegin;
+      return;
+    };
+    if (mValue + mValueSize == pBegin) {
+      mValueSize += pEnd - pBegin;
+      return;
+    };
+    //value is not contiguous in buffer, it has to be copied
+    mValueOffset = mScratch.size();
+    mScratch.append(mValue,mValueSize);
+  };
+  mScratch.append(pBegin,pEnd - pBegin);
+  mValueSize += pEnd - pBegin;
 };
 
 void 
-CSVParser::onLine() {
+CSVParser::onField() {
+  CSVField field;
+  field.data = mValueSize == 0 ? "" : mValue;
+  field.size = mValueSize;
+  mFields.push_back(field);
+  mOffsets.push_back(mValueOffset);
+  mValueSize = 0;
+  mValueOffset = string::npos;
+};
 
+bool
+CSVParser::eof() {
+  return mEof;
 };
 
 void
-CSVParser::prepareList() {
-  mCurrent = mValues.begin();
-  for(list<string>::iterator it = mValues.begin(); it != mValues.end(); it++) {
-    it -> clear();
-  };
+CSVParser::fill() {
+  //keep unparsed part of buffer, grow buffer if line does not fit in it
+  size_t rest = mEnd - mPos;
+  if (mBuffer.size() < CSV_BLOCK_SIZE)
+    mBuffer.resize(CSV_BLOCK_SIZE);
+  else if (rest > mBuffer.size() / 2)
+    mBuffer.resize(mBuffer.size() * 2);
+  if (rest > 0 && mPos > 0)
+    memmove(&mBuffer[0],&mBuffer[mPos],rest);
+  mPos = 0;
+  mEnd = rest;
+  mStream->read(&mBuffer[mEnd],mBuffer.size() - mEnd);
+  if (mStream->bad())
+    throw CSVFileException("error reading file");
+  mEnd += mStream->gcount();
+  if (mStream->eof() || mStream->gcount() == 0)
+    mFinal = true;
+  mData = &mBuffer[0];
 };
 
 bool
-CSVParser::eof() {
-  return mStream.eof();
+CSVParser::parseLine() throw (CSVParseException) {
+  mValuesReady = false;
+  for(;;) {
+    switch(parseBuffer()) {
+      case LINE:
+        //scratch buffer is not reallocated any more
+        for(size_t i = 0; i < mOffsets.size(); i++) {
+          if (mOffsets[i] != string::npos)
+            mFields[i].data = mScratch.data() + mOffsets[i];
+        };
+        return true;
+      case NO_LINE:
+        return false;
+      case NEED_DATA:
+        fill();
+      break;
+    };
+  };
 };
 
-bool
-CSVParser::parseLine() throw (CSVParseException) {
-  string value;
-  
-  mValues.clear();
-  mState.clear();
-  mState.push_back(SCAN);
-  mState.push_back(FIELD);
-  prepareList();
-  int field = 0;
-      
-  char c;
-  bool stop = false;
-  mChar = 0;
-  while(!stop) {
-    mStream.get(c);
-    if (mStream.bad())
-      throw CSVFileException("error reading file");
-    if (mStream.eof()) {
+CSVParser::result
+CSVParser::parseBuffer() {
+  mFields.clear();
+  mOffsets.clear();
+  mScratch.clear();
+  mValueSize = 0;
+  mValueOffset = string::npos;
+  const char* begin = mData;
+  const char* p = begin + mPos;
+  const char* end = begin + mEnd;
+  state st = FIELD;
+  //true if line has any char except of carriage returns
+  bool chars = false;
+  while(true) {
+    if (st == FIELD) {
+      //skip to first char that can change state
+      const char* special = findFirstOf(p,end,mSpecial);
+      if (special != p) {
+        append(p,special);
+        chars = true;
+        p = special;
+      };
+    } else if (st == QUOTED_FIELD) {
+      const char* quote = (const char*)memchr(p,'"',end - p);
+      if (quote == NULL)
+        quote = end;
+      append(p,quote);
+      p = quote;
+    };
+    if (p == end) {
+      //line is not complete, read more data and parse it again
+      if (!mFinal)
+        return NEED_DATA;
       //end of file
-      if (mChar == 0)
-        return false;
-      switch(mState.back()) {
+      mEof = true;
+      mPos = mEnd;
+      if (!chars)
+        return NO_LINE;
+      switch(st) {
         case SCAN:
-          onLine();
-          return true;
         break;
         case FIELD:
-          mState.pop_back();
-          onField(field++,&value);
-          return true;
+        case QUOTE_TEST:
+          onField();
         break;
         case QUOTED_FIELD:
           throw CSVParseException("unterminated quoted field");
         break;
-        case QUOTE_TEST:
-          mState.pop_back();
-          mState.pop_back();
-          mState.pop_back();
-          onField(field++,&value);
-          return true;
-        break;
       };
+      return LINE;
     };
+    char c = *p++;
     switch (c) {
       case '"':
-        switch (mState.back()) {
+        chars = true;
+        switch (st) {
           case SCAN:
             throw CSVParseException("got quote char, expecting separator or newline");
           break;
           case FIELD:
-            mState.push_back(QUOTED_FIELD);
+            st = QUOTED_FIELD;
           break;
           case QUOTED_FIELD:
-            mState.push_back(QUOTE_TEST);
+            st = QUOTE_TEST;
           break;
           case QUOTE_TEST:
-            value += c;
-            mState.pop_back();
+            append(p - 1,p);
+            st = QUOTED_FIELD;
           break;
         };
       break;
       case '\r':
-        mChar--;
-        switch(mState.back()) {
+        switch(st) {
           case SCAN:
           case FIELD:
             //end of line is comming, wait for \n
           break;
           case QUOTED_FIELD:
-            value += c;
+            append(p - 1,p);
           break;
           case QUOTE_TEST:
-            //empty quoted field, end of line is comming
-            mState.pop_back();
-            mState.pop_back();
-            mState.pop_back();
-            onField(field++,&value);
+            //end of quoted field, end of line is comming
+            st = SCAN;
+            onField();
           break;
         };    
       break;
       case '\n':
-        switch(mState.back()) {
+        switch(st) {
           case SCAN:
-            //end of record
-            onLine();
-            stop = true;
           break;
           case FIELD:
-            mState.pop_back();
             //empty line is perfectly valid
-            if (mChar == 0) {
-              //no fields here
-            } else {
-              onField(field++,&value);
-            };
-            onLine();
-            stop = true;
+            if (chars)
+              onField();
           break;
           case QUOTED_FIELD:
-            value += c;
+            append(p - 1,p);
+            continue;
           break;
           case QUOTE_TEST:
-            //empty field, end of line
-            mState.pop_back();
-            mState.pop_back();
-            mState.pop_back();
-            onField(field++,&value);
-            onLine();
-            stop = true;
-          break;
-        };    
-        mChar = 0;
-        mLine++;
-      break;
-      case ' ':
-        switch (mState.back()) {
-          case SCAN:
-          case FIELD:
-          /*
-            If space is a separator, then do not treat it as part of field  
-          */
-            if (c == mFieldSep) {
-              processSeparator(field,value,c);
-              break;
-            };
-          /*
-            for compability with broken MS Excel CSV exproter - if 
-            separation chars are not used then string with whitespaces are not in double quotes
-          */
-          case QUOTED_FIELD:
-            value += c;
-          break;
-          case QUOTE_TEST:
-            mState.pop_back();
-            mState.pop_back();
-            //if space is a separator then we
-            //assume that next char (if not space) 
-            //is a part of next field 
-            //otherwise we ignore this space seeting state to SCAN
-            //and wait for next character
-            if (c != mFieldSep)
-              mState.pop_back();
-            onField(field++,&value);
+            onField();
           break;
         };
+        //end of record
+        mPos = p - begin;
+        return LINE;
       break;
       default:
+        chars = true;
         if (c == mFieldSep) {
-          processSeparator(field,value,c);
+          switch (st) {
+            case SCAN:
+              st = FIELD;
+            break;
+            case FIELD:
+              onField();
+            break;
+            case QUOTED_FIELD:
+              append(p - 1,p);
+            break;
+            case QUOTE_TEST:
+              st = FIELD;
+              onField();
+            break;
+          };
         } else {
-          switch (mState.back()) {
+          switch (st) {
             case SCAN:
-              throw CSVParseException("got char, expecting separator or newline");       
+              /*
+                for compability with broken MS Excel CSV exproter - if 
+                separation chars are not used then string with whitespaces are not in double quotes
+              */
+              if (c != ' ')
+                throw CSVParseException("got char, expecting separator or newline");
+              append(p - 1,p);
             break;
             case FIELD:
             case QUOTED_FIELD:
-              value += c;
+              append(p - 1,p);
             break;
             case QUOTE_TEST:
-              mState.pop_back();
-              mState.pop_back();
-              mState.pop_back();
-              onField(field++,&value);
+              //chars after closing quote are ignored
+              st = SCAN;
+              onField();
             break;
           };
         };
       break;
     };
-    mChar++;
   };
-//  for(list<string>::const_iterator it = mValues.begin(); it != mValues.end(); it++) cerr << "pval:" << *it << endl;
-  return true;
-};
-
-void
-CSVParser::processSeparator(int& field, std::string& value, char c) {
-  switch (mState.back()) {
-    case SCAN:
-      mState.push_back(FIELD);
-    break;
-    case FIELD:
-      //end field
-      onField(field++,&value);
-    break;
-    case QUOTED_FIELD:
-      value += c;
-    break;
-    case QUOTE_TEST:
-      //empty quoted field
-      mState.pop_back();
-      mState.pop_back();
-      onField(field++,&value);
-    break;
-  };    
 };
 
 CSVParser::~CSVParser() {
@@ -274,7 +322,11 @@ CSVParser::~CSVParser() {
 CSVArchive::CSVArchive() 
   : mHasColNames(true),
     mIgnoreEmptyLines(true),
-    mFieldSeparator(',')
+    mFieldSeparator(','),
+    mWriteBufferSize(1024 * 1024),
+    mCompression(CSVWriter::NO_COMPRESSION),
+    mCompressionLevel(-1),
+    mDropWrittenData(false)
 {
 
 };
@@ -315,6 +367,29 @@ CSVArchive::setFieldSeparator(char pSep) {
   mFieldSeparator = pSep;
 };
 
+void
+CSVArchive::setWriteBufferSize(size_t pSize) {
+  mWriteBufferSize = pSize;
+};
+
+void
+CSVArchive::setCompression(CSVWriter::compression pCompression, int pLevel) {
+  if (!CSVWriter::isSupported(pCompression))
+    throw APIException("Compression of csv files is not supported, library was built without zlib");
+  mCompression = pCompression;
+  mCompressionLevel = pLevel;
+};
+
+void
+CSVArchive::dropWrittenData(bool pFlag) {
+  mDropWrittenData = pFlag;
+};
+
+CSVWriter*
+CSVArchive::createWriter() const {
+  return new CSVWriter(mFilename.c_str(), mWriteBufferSize, mCompression, mCompressionLevel, mDropWrittenData);
+};
+
 #ifdef DBA_COMPAT_1_0
 CSVIStream* 
 CSVArchive::getOIStream() {
@@ -325,7 +400,7 @@ CSVArchive::getOIStream() {
 
 CSVOStream* 
 CSVArchive::getOOStream() {
-  CSVOStream* stream = new CSVOStream(mFilename.c_str(), mMappings, mHasColNames, mConvSpecs);
+  CSVOStream* stream = new CSVOStream(createWriter(), mMappings, mHasColNames, mConvSpecs);
   stream->setFieldSeparator(mFieldSeparator);
   return stream;
 };
@@ -354,7 +429,7 @@ CSVArchive::getIStream() {
 
 CSVOStream 
 CSVArchive::getOStream() {
-  CSVOStream stream(mFilename.c_str(), mMappings, mHasColNames, mConvSpecs);
+  CSVOStream stream(createWriter(), mMappings, mHasColNames, mConvSpecs);
   stream.setFieldSeparator(mFieldSeparator);
   return stream;
 };
@@ -362,7 +437,7 @@ CSVArchive::getOStream() {
 
 OStream*
 CSVArchive::getOutputStream() {
-  CSVOStream* stream = new CSVOStream(mFilename.c_str(), mMappings, mHasColNames, mConvSpecs);
+  CSVOStream* stream = new CSVOStream(createWriter(), mMappings, mHasColNames, mConvSpecs);
   stream->setFieldSeparator(mFieldSeparator);
   return stream;
 };
@@ -462,8 +537,25 @@ CSVIStream::CSVIStream(const char* pFilename, list<mapping>& pMappings, bool pHa
     mFilename(pFilename),
     mParser(NULL),
     mStream(new std::ifstream()),
-    mHasColNames(pHasColNames)
+    mHasColNames(pHasColNames),
+    mPlanTable(NULL),
+    mIdColumn(-1)
+{
+};
+
+CSVIStream::CSVIStream(const char* pData, size_t pSize, const list<mapping>& pMappings, bool pIgnoreEmptyLines, const ConvSpec& pSpecs, char pFieldSep)
+  : IStream(),
+    ConvSpecContainer(pSpecs),
+    mMappings(pMappings),
+    mHasColNames(false),
+    mRowFetched(false),
+    mIgnoreEmptyLines(pIgnoreEmptyLines),
+    mParser(new CSVParser(pData,pSize)),
+    mFieldSep(pFieldSep),
+    mPlanTable(NULL),
+    mIdColumn(-1)
 {
+  mParser->setFieldSeparator(pFieldSep);
 };
 
 mapping::mapping(int pCSVField, const char* pTable, const char* pField) 
@@ -564,7 +656,7 @@ CSVIStream::createMappings(Storeable& pObject) {
 const list<string>& 
 CSVIStream::getColumns() {
   //parse first line of csv file if file is not already open
-  if (!mStream->is_open()) {
+  if (mParser == NULL) {
     openFile();
     parseColumns();
   };
@@ -575,7 +667,7 @@ void
 CSVIStream::open(Storeable& pObject, const char* pTable) {
   IStream::open(pObject,pTable);
   
-  if (!mStream->is_open()) {
+  if (mParser == NULL) {
     openFile();
   };
   //discover column names
@@ -587,6 +679,54 @@ CSVIStream::open(Storeable& pObject, const char* pTable) {
     createMappings(pObject);
   };
   updateMappings(mColNames,&mMappings);
+  createPlan(Stream::getTable(pObject));
+  createBindingPlan();
+};
+
+void
+CSVIStream::createPlan(const StoreTable* pTable) {
+  mPlanTable = pTable;
+  mMemberColumns.clear();
+  mIdColumn = -1;
+  if (pTable == NULL)
+    return;
+  const char* current_table_name = pTable->getTableName();
+  if (current_table_name == NULL)
+    throw APIException("Root table has no name");
+  for(const StoreTable* tbl = pTable; tbl != NULL; tbl = tbl->getNextTable()) {
+    if (tbl->getTableName() != NULL)
+      current_table_name = tbl->getTableName();
+    for(StoreTableMember* member = tbl->getMembers(); member != NULL; member = member->getNextMember())
+      mMemberColumns.push_back(getMappingPosByName(mMappings, current_table_name, member->getMemberName()));
+  };
+  list<mapping>::iterator mit = find_if(mMappings.begin(), mMappings.end(), mappingMatcher("id"));
+  if (mit != mMappings.end())
+    mIdColumn = mit->fnumber;
+};
+
+bool
+CSVIStream::isBindingPlanValid() const {
+  if (mBindingColumns.size() != mBindings.size())
+    return false;
+  std::vector<std::pair<StoreableFilterBase*,int> >::const_iterator column = mBindingColumns.begin();
+  for(VarMap::const_iterator it = mBindings.begin(); it != mBindings.end(); it++, column++) {
+    if (!(it->mFilter == column->first))
+      return false;
+  };
+  return true;
+};
+
+void
+CSVIStream::createBindingPlan() {
+  //many vars can be binded to the same field, each one takes next mapping
+  list<mapping> m(mMappings);
+  mBindingColumns.clear();
+  for(VarMap::iterator it = mBindings.begin(); it != mBindings.end(); it++) {
+    int pos = getMappingPosByName(m, it->mTable, it->mField);
+    if (pos != -1)
+      removeMappingByIndex(pos,&m);
+    mBindingColumns.push_back(std::make_pair(&(*it->mFilter),pos));
+  };
 };
 
 void
@@ -621,16 +761,56 @@ CSVIStream::fetchRow() {
   if (!mParser->parseLine())
     return false;
   if (mIgnoreEmptyLines) {
-    while(mParser->getValues().size() == 0) {
+    while(mParser->getFieldCount() == 0) {
 //      cerr << "ignoring empty line" << endl;
       if (!mParser->parseLine())
         return false;
     };
   };
-  mValues = mParser->getValues();
   return true;
 };
 
+template <typename F, typename T> static void
+applyValue(T& pMember, const ConvSpec& pSpecs, const std::string* pValue) {
+  F filter(pMember);
+  if (pValue != NULL)
+    filter.fromString(pSpecs,*pValue);
+  else
+    filter.fromNull();
+};
+
+//builtin filters are created on stack instead of using filter instance
+//shared by all objects of class, so many streams can read objects at once
+static void
+applyMember(StoreTableMember& pMember, void* pData, const ConvSpec& pSpecs, const std::string* pValue) {
+  switch(pMember.getFilterKind()) {
+    case StoreTableMember::INT_FILTER:
+      applyValue<Int>(*(int*)pData,pSpecs,pValue);
+    break;
+    case StoreTableMember::BOOL_FILTER:
+      applyValue<Bool>(*(bool*)pData,pSpecs,pValue);
+    break;
+    case StoreTableMember::DOUBLE_FILTER:
+      applyValue<Double>(*(double*)pData,pSpecs,pValue);
+    break;
+    case StoreTableMember::FLOAT_FILTER:
+      applyValue<Float>(*(float*)pData,pSpecs,pValue);
+    break;
+    case StoreTableMember::STRING_FILTER:
+      applyValue<String>(*(std::string*)pData,pSpecs,pValue);
+    break;
+    default: {
+      StoreableFilterBase* filter = pMember.getFilter();
+      filter->updateRef(pData);
+      if (pValue != NULL)
+        filter->fromString(pSpecs,*pValue);
+      else
+        filter->fromNull();
+    };
+    break;
+  };
+};
+
 bool 
 CSVIStream::getNext(Storeable* pObject) {
   if (!isOpen()) {
@@ -643,46 +823,37 @@ CSVIStream::getNext(Storeable* pObject) {
 //  for(list<string>::const_iterator it = mValues.begin(); it != mValues.end(); it++) cerr << "val:" << *it << endl;
   const StoreTable* tbl = Stream::getTable(*pObject);
   if (tbl != NULL) {
+    if (tbl != mPlanTable)
+      createPlan(tbl);
     std::string data;
     const char* current_table_name = tbl->getTableName();
-    if (current_table_name == NULL)
-      throw APIException("Root table has no name");
-    while(tbl != NULL) {
+    std::vector<int>::const_iterator column = mMemberColumns.begin();
+    for(; tbl != NULL; tbl = tbl->getNextTable()) {
       if (tbl->getTableName() != NULL)
         current_table_name = tbl->getTableName();
-      StoreTableMember* member = tbl->getMembers();
-      while (member != NULL) {
-  //      cerr << "setting member " << member -> name << " binded to " << member << endl;
-        unsigned int pos = getMappingPosByName(mMappings, current_table_name, member->getMemberName());
-        dba::StoreableFilterBase* filter(member->getFilter());
-        filter->updateRef((char*)pObject + (int)(member->getMemberOffset() + tbl->getClassOffset()));
-        if (pos != (unsigned)-1) {
+      for(StoreTableMember* member = tbl->getMembers(); member != NULL; member = member->getNextMember(), column++) {
+        void* memberData = (char*)pObject + (int)(member->getMemberOffset() + tbl->getClassOffset());
+        if (*column != -1) {
           //we got mapping for column but we cannot find 
           //that column data in csv file
-          if (mValues.size() <= pos) {
+          if (mParser->getFieldCount() <= (size_t)*column) {
             string s;
-            s += "Column " + dba::toStr(pos) + " for mapping " +  current_table_name + "." + member->getMemberName() + " not found ";
+            s += "Column " + dba::toStr(*column) + " for mapping " +  current_table_name + "." + member->getMemberName() + " not found ";
             throw DataException(s);
           };
-          data = getValueByIndex(mValues, pos);
-          filter->fromString(mConvSpecs, data);
+          getValueByIndex(*column,data);
+          applyMember(*member,memberData,mConvSpecs,&data);
         } else {
-          data.erase();
-          filter->fromNull();
+          applyMember(*member,memberData,mConvSpecs,NULL);
         };
-        member = member->getNextMember();
       };
-      tbl = tbl->getNextTable();
     };
-    list<mapping>::iterator mit = find_if(mMappings.begin(), mMappings.end(), mappingMatcher("id"));
-    if (mit != mMappings.end()) {
-      if (mit -> fnumber != -1) {
-        data = getValueByIndex(mValues, mit -> fnumber);
-        int id;
-        dba::convert(data,id);
-        Stream::alterId(pObject,id);
-        Stream::makeOk(pObject);
-      };
+    if (mIdColumn != -1) {
+      getValueByIndex(mIdColumn,data);
+      int id;
+      dba::convert(data,id);
+      Stream::alterId(pObject,id);
+      Stream::makeOk(pObject);
     };
   };
   fillBindedVars();
@@ -703,45 +874,39 @@ CSVIStream::updateVars() {
 
 void
 CSVIStream::fillBindedVars() {
+  if (mBindings.empty())
+    return;
+  //vars can be binded or unbinded after open()
+  if (!isBindingPlanValid())
+    createBindingPlan();
   std::string data;
-  list<mapping> m(mMappings);
-  for(VarMap::iterator it = mBindings.begin(); it != mBindings.end(); it++) {
-    int pos = getMappingPosByName(m, it->mTable, it->mField);
-    if (pos != -1) {
-      data = getValueByIndex(mValues, pos);
-//      cerr << "removing mapping for member " << it->mField << " table " << it->mTable << " index "<< pos << " from local mapping (size " << m.size() << ")" <<  endl;
-      removeMappingByIndex(pos,&m);
-//        cerr << *data << endl;
-    } else {
+  std::vector<std::pair<StoreableFilterBase*,int> >::const_iterator column = mBindingColumns.begin();
+  for(; column != mBindingColumns.end(); column++) {
+    if (column->second != -1)
+      getValueByIndex(column->second,data);
+    else
       data.erase();
-    };
-    dba::StoreableFilterBase& filter(*(it->mFilter));
-    filter.fromString(mConvSpecs, data);
+    column->first->fromString(mConvSpecs, data);
   };  
 };
 
 void
 CSVIStream::close() {
   mParser = NULL;
-  mStream->close();
-};
-
-std::string
-CSVIStream::getValueByIndex(const list<std::string>& pValue, int pPos) {
-  list<string>::const_iterator it = pValue.begin();
-  int i = 0;
-  while(it != pValue.end()) {
-    if (i == pPos)
-      return *it;
-    i++;
-    it++;
+  if (mStream != NULL)
+    mStream->close();
+};
+
+void
+CSVIStream::getValueByIndex(int pPos, std::string& pValue) {
+  if (pPos < 0 || (size_t)pPos >= mParser->getFieldCount()) {
+    std::string err("Field index ");
+    err += toStr(pPos);
+    err += " is out of bounds";
+    throw DataException(err);
   };
-  std::string err("Field index");
-  err += pPos;
-  err += " is out of bounds";
-  throw DataException(err.c_str());
-  //unreachable code
-  return std::string();
+  const CSVField& field(mParser->getField(pPos));
+  pValue.assign(field.data,field.size);
 };
 
 void
@@ -760,9 +925,18 @@ CSVOStream::CSVOStream(const char* pFilename, list<mapping>& pMappings, bool pHa
     ConvSpecContainer(pSpecs),
     mMappings(pMappings),
     mHasColNames(pHasColNames),
-    mStream(new std::ofstream)
+    mWriter(new CSVWriter(pFilename))
+{
+  mNoWriteYet = true;
+};
+
+CSVOStream::CSVOStream(CSVWriter* pWriter, list<mapping>& pMappings, bool pHasColNames, const ConvSpec& pSpecs)
+  : OStream(),
+    ConvSpecContainer(pSpecs),
+    mMappings(pMappings),
+    mHasColNames(pHasColNames),
+    mWriter(pWriter)
 {
-  mStream->open(pFilename);
   mNoWriteYet = true;
 };
 
@@ -773,8 +947,13 @@ CSVOStream::open(const char* pRootTable) {
 
 void 
 CSVOStream::close() {
-  mStream->close();
   mIsOpen = false;
+  mWriter->close();
+};
+
+void
+CSVOStream::flush() {
+  mWriter->flush();
 };
 
 bool 
@@ -799,16 +978,11 @@ CSVOStream::update(Storeable* pObject) {
 void
 CSVOStream::createMappings() {
   int index = 0;
-  mt_class* current = mMemberList->mFirst;
-  while(current->name != NULL) {
-    mt_member* member = current->firstField;
-    while(member->name != NULL) {
+  for(const mt_class* current = mMemberList->begin(); current != mMemberList->end(); current++) {
+    for(const mt_member* member = current->first; member != current->last; member++) {
       mapping m(index++,current->name,member->name);
       m.fname = strdup(member->name);
       mMappings.push_back(m);
-      member = member->next;
-      if (member == NULL)
-        break;
     };
     
     VarMap bmap(mBindings);
@@ -822,11 +996,7 @@ CSVOStream::createMappings() {
       };
       it++;
     };
-    
-    current = current->next;
-    if (current == NULL)
-      break;
-  };  
+  };
 };
 
 void
@@ -852,14 +1022,66 @@ CSVOStream::writeColumns() {
     index++;
   };
   csvline += '\n';
-  mStream->write(csvline.c_str(),csvline.size());
-  if (!mStream->good())
-    throw CSVFileException("write to file failed");
+  mWriter->write(csvline);
+};
+
+bool
+CSVOStream::isPlanValid() const {
+  if (!(mPlanList == mMemberList))
+    return false;
+  if (mPlanBindings.size() != mBindings.size())
+    return false;
+  std::vector<StoreableFilterBase*>::const_iterator filter = mPlanBindings.begin();
+  for(VarMap::const_iterator it = mBindings.begin(); it != mBindings.end(); it++, filter++) {
+    if (!(it->mFilter == *filter))
+      return false;
+  };
+  return true;
+};
+
+void
+CSVOStream::createPlan() {
+  mPlanList = mMemberList;
+  mPlanBindings.clear();
+  mColumns.clear();
+  column empty = { NULL, NULL };
+  for(const mt_class* current = mMemberList->begin(); current != mMemberList->end(); current++) {
+    for(const mt_member* member = current->first; member != current->last; member++) {
+      int pos = getMappingPosByName(mMappings,current->name, member->name);
+      if (pos == -1)
+        continue;
+      if ((size_t)pos >= mColumns.size())
+        mColumns.resize(pos + 1,empty);
+      mColumns[pos].member = member;
+      mColumns[pos].filter = (StoreableFilterBase*)member->func;
+    };
+  };
+  //binded vars are written after members, each one takes next mapping
+  list<mapping> m(mMappings);
+  for (VarMap::iterator it = mBindings.begin(); it != mBindings.end(); it++) {
+    mPlanBindings.push_back(&(*it->mFilter));
+    if (mMemberList->empty())
+      continue;
+    int pos = getMappingPosByName(m,it->mTable,it->mField);
+    if (pos == -1)
+      continue;
+    removeMappingByIndex(pos,&m);
+    if ((size_t)pos >= mColumns.size())
+      mColumns.resize(pos + 1,empty);
+    mColumns[pos].member = NULL;
+    mColumns[pos].filter = NULL;
+    //vars binded to tables that are not in object are empty
+    for(const mt_class* current = mMemberList->begin(); current != mMemberList->end(); current++) {
+      if (!strcmp(it->mTable,current->name)) {
+        mColumns[pos].filter = &(*it->mFilter);
+        break;
+      };
+    };
+  };
 };
 
 bool 
 CSVOStream::store(Storeable* pObject) {
-  std::map<int,string> outmap;
   createTree(Stream::getTable(*pObject));
   if (mNoWriteYet) {
     if (mHasColNames) {
@@ -869,90 +1091,54 @@ CSVOStream::store(Storeable* pObject) {
     };
     mNoWriteYet = false;
   };
-  mt_class* current = mMemberList->mFirst;
-  while(current -> name != NULL) {
-    mt_member* member = current -> firstField;
-    while(member -> name != NULL) {
-//        (*((st_to_db)member -> func))((char*)pObject + (int)(member -> offset),&data,Database::STRING,true);
-      //std::string data(applyFilter((st_to_db)member->func,(char*)pObject + (int)(member -> offset),(Database::StoreType)member->type));
-      dba::StoreableFilterBase* filter = (StoreableFilterBase*)member->func;
-      filter->updateRef((char*)pObject + (int)(member -> offset));
-      std::string data;
-      if (!filter->isNull())
-        data = filter->toString(mConvSpecs);
-      int pos = getMappingPosByName(mMappings,current->name, member->name);
-      if (pos != -1) {
-        outmap[pos] = data;
-      };
-    
-      member = member -> next;
-      if (member == NULL)
-        break;
-    };
-
-    VarMap bmap(mBindings);
-    list<mapping> m(mMappings);
-    //binded vars in object tables
-    for (VarMap::iterator it = bmap.begin(); it != bmap.end(); it++) {
-      std::string data;
-      if (!strcmp(it->mTable,current -> name)) {
-        dba::StoreableFilterBase& filter = *(it->mFilter);
-        data = filter.toString(mConvSpecs);
-      };
-
-      int pos = getMappingPosByName(m,it->mTable,it->mField);
-      if (pos != -1) {
-        removeMappingByIndex(pos,&m);
-        outmap[pos] = data;
-      };
-    };
-  
-    current = current -> next;
-    if (current == NULL)
-      break;
-  };
-  string csvline;
-  int index = 0;
-  //got data on outlist, make line and save it
-  for(map<int,string>::iterator it = outmap.begin(); it != outmap.end(); it++) {
-    if (it != outmap.begin())
-      csvline += mFieldSep;
-    csvline += escapeString(it->second);
-    //fill holes in mappings
-    while(index < it->first) {
-      csvline += mFieldSep;
-      index++;
+  if (!isPlanValid())
+    createPlan();
+  mLine.erase();
+  for(std::vector<column>::const_iterator it = mColumns.begin(); it != mColumns.end(); it++) {
+    if (it != mColumns.begin())
+      mLine += mFieldSep;
+    if (it->filter == NULL)
+      continue;
+    if (it->member != NULL) {
+      it->filter->updateRef((char*)pObject + (int)(it->member->offset));
+      if (it->filter->isNull())
+        continue;
     };
-    index++;
+    appendField(mLine,it->filter->toString(mConvSpecs));
   };
-  csvline += '\n';
-  mStream->write(csvline.c_str(),csvline.size());
-  if (!mStream->good())
-    throw CSVFileException("write to file failed");
+  mLine += '\n';
+  mWriter->write(mLine);
   return true;
 };
 
 string
 CSVOStream::escapeString(const string& pInput) {
-  if (pInput.empty())
-    return pInput;
-  string s(pInput);
-  int i = replaceAll(s,"\"","\"\"");
-  if (i == 0)
-    if (!isspace((int)(unsigned char)pInput[0]))
-      if (!isspace((int)(unsigned char)pInput[pInput.size()-1]))
-        if (pInput.find("\n") == string::npos)
-          if (pInput.find("\r") == string::npos)
-            if (pInput.find(mFieldSep) == string::npos)
-              return s;
-  s.insert(0,"\"");
-  s.append("\"");
+  string s;
+  appendField(s,pInput);
   return s;
 };
 
+void
+CSVOStream::appendField(string& pLine, const string& pData) {
+  if (pData.empty())
+    return;
+  const char* begin = pData.data();
+  const char* end = begin + pData.size();
+  const char special[] = { '"', '\n', '\r', mFieldSep, '\0' };
+  if (!isspace((int)(unsigned char)pData[0]))
+    if (!isspace((int)(unsigned char)pData[pData.size()-1]))
+      if (findFirstOf(begin,end,special) == end) {
+        pLine += pData;
+        return;
+      };
+  pLine += '"';
+  appendEscaped(pLine,begin,end,"\"","\"");
+  pLine += '"';
+};
+
 void
 CSVOStream::destroy() {
-  mStream = NULL;
+  mWriter = NULL;
 };
 
 
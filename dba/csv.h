@@ -8,9 +8,9 @@
 #ifndef CSVCSV_H
 #define CSVCSV_H
 
-#include <deque>
 #include <list>
 #include <string>
+#include <vector>
 #include <fstream>
 #include "dba/storeablefilter.h"
 #include "dba/convspec.h"
@@ -18,6 +18,7 @@
 #include "dba/istream.h"
 #include "dba/ostream.h"
 #include "dba/shared_ptr.h"
+#include "dba/csvwriter.h"
 
 namespace dba {
 
@@ -55,7 +56,26 @@ typedef CSVParseException CSVParserException;
 #endif
 
 /**
-  CSV file parser
+  Field of csv row parsed by CSVParser. Field data is not zero terminated and
+  points into buffer of parser, so it is valid only until next call to
+  CSVParser::parseLine()
+  @ingroup api
+*/
+struct dbaDLLEXPORT CSVField {
+  //!first char of field
+  const char* data;
+  //!number of chars in field
+  size_t size;
+};
+
+/**
+  CSV file parser.
+
+  Parser reads file in large blocks and splits lines in place. Fields that
+  do not need unescaping point directly into read buffer, only fields with
+  doubled quotes or broken by carriage return are copied to scratch buffer
+  of current line. After first lines parser does not allocate memory unless
+  line longer than half of buffer is found.
   @ingroup api
 */
 class dbaDLLEXPORT CSVParser {
@@ -65,6 +85,13 @@ class dbaDLLEXPORT CSVParser {
       @param pStream file stream to read
     */
     CSVParser(std::ifstream& pStream);
+    /**
+      Constructor for parsing csv data that is already in memory. Data is
+      not copied and must be valid until parser is destroyed.
+      @param pData first char of csv data
+      @param pSize number of chars in data
+    */
+    CSVParser(const char* pData, size_t pSize);
     /**
       Parse one line from csv file.
       @return true if line was parsed, false if line was empty.
@@ -72,7 +99,17 @@ class dbaDLLEXPORT CSVParser {
     */
     bool parseLine() throw (CSVParseException);
     /**
-      Get values readed by parseLine()
+      Get number of fields readed by parseLine()
+    */
+    size_t getFieldCount() const { return mFields.size(); };
+    /**
+      Get field readed by parseLine() without copying it.
+      @param pIndex index of field, must be less than getFieldCount()
+    */
+    const CSVField& getField(size_t pIndex) const { return mFields[pIndex]; };
+    /**
+      Get values readed by parseLine(). List is created from fields on
+      first call after parseLine()
     */
     const std::list<std::string>& getValues() const;
     /**
@@ -100,19 +137,35 @@ class dbaDLLEXPORT CSVParser {
       QUOTED_FIELD,
       QUOTE_TEST
     } state;
+    typedef enum {
+      LINE,
+      NO_LINE,
+      NEED_DATA
+    } result;
     
-    std::ifstream& mStream;
-    int mLine;
-    int mChar;
-    std::list<std::string> mValues;
-    std::list<std::string>::iterator mCurrent;
-    std::deque<state> mState;
+    std::ifstream* mStream;
+    std::vector<char> mBuffer;
+    const char* mData;
+    size_t mPos;
+    size_t mEnd;
+    bool mFinal;
+    bool mEof;
+    std::vector<CSVField> mFields;
+    std::vector<size_t> mOffsets;
+    std::string mScratch;
+    mutable std::list<std::string> mValues;
+    mutable bool mValuesReady;
     char mFieldSep;
-        
-    void onField(int pNum, std::string* pData);
-    void onLine();
-    void prepareList();
-    void processSeparator(int& field, std::string& value, char c);
+    char mSpecial[5];
+    //value of field that is currently parsed
+    const char* mValue;
+    size_t mValueSize;
+    size_t mValueOffset;
+
+    result parseBuffer();
+    void fill();
+    void append(const char* pBegin, const char* pEnd);
+    void onField();
 };
 
 /**@internal 
@@ -178,6 +231,7 @@ simultaneously is not a good idea and can give weird results
 @ingroup api
 */
 class dbaDLLEXPORT CSVArchive : public Archive, public ConvSpecContainer {
+    friend class CSVImport;
   public:
     CSVArchive();
     /**
@@ -223,6 +277,27 @@ class dbaDLLEXPORT CSVArchive : public Archive, public ConvSpecContainer {
       @param pSep new field separator char
     */
     void setFieldSeparator(char pSep);
+    /**
+      Set size of memory buffer of output streams. Data is written to file
+      when buffer is full or when stream is closed. Default is 1MB
+      @param pSize size in bytes
+    */
+    void setWriteBufferSize(size_t pSize);
+    /**
+      Compress files written by output streams. Input streams cannot read
+      compressed files.
+      @param pCompression compression type
+      @param pLevel compression level from 1 (fastest) to 9 (best), -1 for default
+      @throw APIException if library was built without support for compression
+    */
+    void setCompression(CSVWriter::compression pCompression, int pLevel = -1);
+    /**
+      Tell operating system that data written by output streams will not be
+      read soon, so it does not fill page cache during large exports.
+      Does nothing on systems without posix_fadvise().
+      @param pFlag true to drop written data from cache
+    */
+    void dropWrittenData(bool pFlag);
 #ifdef DBA_COMPAT_1_0    
     CSVIStream* getOIStream();
     CSVOStream* getOOStream();
@@ -255,6 +330,12 @@ class dbaDLLEXPORT CSVArchive : public Archive, public ConvSpecContainer {
     std::string mFilename;
     bool mIgnoreEmptyLines;
     char mFieldSeparator;
+    size_t mWriteBufferSize;
+    CSVWriter::compression mCompression;
+    int mCompressionLevel;
+    bool mDropWrittenData;
+
+    CSVWriter* createWriter() const;
 };
 
 /** 
@@ -264,6 +345,7 @@ class dbaDLLEXPORT CSVArchive : public Archive, public ConvSpecContainer {
   @ingroup api
 */
 class dbaDLLEXPORT CSVIStream : public dba::IStream, public ConvSpecContainer {
+    friend class CSVImport;
   public:
     /**
       Constructor used by CSVArchive.
@@ -293,16 +375,24 @@ class dbaDLLEXPORT CSVIStream : public dba::IStream, public ConvSpecContainer {
     shared_ptr<std::ifstream> mStream;
     std::list<mapping> mMappings;
     std::list<std::string> mColNames;
-    std::list<std::string> mValues;
     bool mHasColNames;
     bool mRowFetched;
     bool mIgnoreEmptyLines;
     std::string mFilename;
     shared_ptr<CSVParser> mParser;
     char mFieldSep;
+    //mappings resolved at open(), columns are -1 for members without mapping
+    const StoreTable* mPlanTable;
+    std::vector<int> mMemberColumns;
+    std::vector<std::pair<StoreableFilterBase*,int> > mBindingColumns;
+    int mIdColumn;
 
+    CSVIStream(const char* pData, size_t pSize, const std::list<mapping>& pMappings, bool pIgnoreEmptyLines, const ConvSpec& pSpecs, char pFieldSep);
     void createMappings(dba::Storeable& pObject);
-    std::string getValueByIndex(const std::list<std::string>& pValue, int pPos);
+    void createPlan(const StoreTable* pTable);
+    bool isBindingPlanValid() const;
+    void createBindingPlan();
+    void getValueByIndex(int pPos, std::string& pValue);
     bool fetchRow();
     void fillBindedVars();    
     void openFile();
@@ -323,6 +413,14 @@ class dbaDLLEXPORT CSVOStream : public dba::OStream, public ConvSpecContainer {
       @param pSpecs conversion specification from archive
     */
     CSVOStream(const char* pFilename, std::list<mapping>& pMappings, bool pHasColNames, const dba::ConvSpec& pSpecs);
+    /**
+      Constructor used by CSVArchive.
+      @param pWriter output file, stream takes ownership of it
+      @param pMappings mappings set in archive
+      @param pHasColNames if true first row contains names of colunms
+      @param pSpecs conversion specification from archive
+    */
+    CSVOStream(CSVWriter* pWriter, std::list<mapping>& pMappings, bool pHasColNames, const dba::ConvSpec& pSpecs);
     virtual void open(const char* pRootTable = NULL);
     virtual void close();
     virtual void destroy();
@@ -339,6 +437,11 @@ class dbaDLLEXPORT CSVOStream : public dba::OStream, public ConvSpecContainer {
       For CSV file format this method does nothing
     */
     virtual void rollback() {};
+    /**
+      Write buffered lines to file
+      @throw CSVFileException if write failed
+    */
+    void flush();
     /**
       Overrider field separator set from CSVArchive
       @param pSep new field separator cha
@@ -348,16 +451,28 @@ class dbaDLLEXPORT CSVOStream : public dba::OStream, public ConvSpecContainer {
     std::list<mapping> mMappings;
     bool mHasColNames;
     bool mNoWriteYet;
-    shared_ptr<std::ofstream> mStream;
+    shared_ptr<CSVWriter> mWriter;
     char mFieldSep;
+    //source of data for each column of csv line, field is empty if filter is NULL
+    struct column {
+      const mt_member* member;
+      StoreableFilterBase* filter;
+    };
+    shared_ptr<mt_mlist> mPlanList;
+    std::vector<column> mColumns;
+    std::vector<StoreableFilterBase*> mPlanBindings;
+    std::string mLine;
     
     virtual bool erase(dba::Storeable* pObject);
     virtual bool update(dba::Storeable* pObject);
     virtual bool store(dba::Storeable* pObject);
     virtual void assignId(dba::Storeable* pObject) throw (dba::Exception) {};
     std::string escapeString(const std::string& pInput);
+    void appendField(std::string& pLine, const std::string& pData);
     void writeColumns();
     void createMappings();
+    bool isPlanValid() const;
+    void createPlan();
     std::string createOutVal(const std::string& pData);
     std::string createOutVal(const tm& pData);
     std::string createOutVal(int pData);
@@ -0,0 +1,411 @@
+// File: csvimport.cpp
+// Purpose: Parallel import of csv files into SQL database
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#include <fstream>
+#include <memory>
+#include "dba/csvimport.h"
+#include "dba/sqlarchive.h"
+#include "dba/conversion.h"
+#include "dba/exception.h"
+
+namespace dba {
+
+//locks mutex for lifetime of object if lock is needed
+class OptionalLocker {
+  public:
+    OptionalLocker(Mutex& pMutex, bool pLock) : mMutex(pMutex), mLock(pLock) { if (mLock) mMutex.lock(); };
+    ~OptionalLocker() { if (mLock) mMutex.unlock(); };
+  private:
+    OptionalLocker(const OptionalLocker&);
+    OptionalLocker& operator=(const OptionalLocker&);
+    Mutex& mMutex;
+    bool mLock;
+};
+
+CSVImport::Chunk::~Chunk() {
+  for(std::vector<Storeable*>::iterator it = mObjects.begin(); it != mObjects.end(); it++)
+    delete *it;
+};
+
+void
+CSVImport::Worker::run() {
+  mOwner.parse();
+};
+
+void
+CSVImport::Writer::run() {
+  mOwner.write(mStream);
+};
+
+CSVImport::CSVImport(CSVArchive& pSource, SQLArchive& pTarget)
+  : mSource(pSource),
+    mTarget(pTarget),
+    mWorkers(2),
+    mWriters(1),
+    mChunkSize(4 * 1024 * 1024),
+    mBatchSize(1000),
+    mQueueSize(8),
+    mPreserveOrder(false),
+    mFactory(NULL),
+    mRootTable(NULL),
+    mLockFilters(false),
+    mLockPut(false),
+    mInFlight(0),
+    mActiveWorkers(0),
+    mNextWrite(0),
+    mStored(0),
+    mReadDone(false)
+{
+};
+
+void
+CSVImport::setWorkers(unsigned int pCount) {
+  mWorkers = pCount == 0 ? 1 : pCount;
+};
+
+void
+CSVImport::setWriters(unsigned int pCount) {
+  mWriters = pCount == 0 ? 1 : pCount;
+};
+
+void
+CSVImport::setChunkSize(unsigned int pSize) {
+  mChunkSize = pSize == 0 ? 1 : pSize;
+};
+
+void
+CSVImport::setBatchSize(unsigned int pSize) {
+  mBatchSize = pSize == 0 ? 1 : pSize;
+};
+
+void
+CSVImport::setQueueSize(unsigned int pSize) {
+  mQueueSize = pSize == 0 ? 1 : pSize;
+};
+
+void
+CSVImport::preserveOrder(bool pFlag) {
+  mPreserveOrder = pFlag;
+};
+
+void
+CSVImport::prepare(const Factory& pFactory) {
+  //resolve mappings once using header of file, chunks do not have column names
+  std::auto_ptr<Storeable> object(pFactory.create());
+  CSVIStream probe(mSource.getIStream());
+  probe.open(*object,mRootTable);
+  mMappings = probe.mMappings;
+  mLockFilters = false;
+  mLockPut = probe.getColTable(*object) != NULL;
+  for(const StoreTable* tbl = probe.getTable(*object); tbl != NULL; tbl = tbl->getNextTable()) {
+    for(StoreTableMember* member = tbl->getMembers(); member != NULL; member = member->getNextMember()) {
+      //builtin filters are created on stack by CSVIStream and SQLOStream
+      if (member->getFilterKind() == StoreTableMember::CUSTOM_FILTER)
+        mLockFilters = true;
+    };
+  };
+  probe.close();
+};
+
+unsigned long
+CSVImport::execute(const Factory& pFactory, const char* pRootTable) {
+  clear();
+  mFactory = &pFactory;
+  mRootTable = pRootTable;
+  prepare(pFactory);
+
+  //connections are taken from archive before threads are started,
+  //connection pool is not thread safe
+  std::vector<Writer*> writers;
+  std::vector<Worker*> workers;
+  std::string error;
+  try {
+    for(unsigned int i = 0; i < mWriters; i++) {
+      writers.push_back(new Writer(*this,mTarget.getOStream()));
+      writers.back()->getStream().open(pRootTable);
+      //whole put() is locked if class has collections
+      if (mLockFilters && !mLockPut)
+        writers.back()->getStream().setFilterLock(&mFilterMutex);
+    };
+    mActiveWorkers = mWorkers;
+    for(unsigned int i = 0; i < mWorkers; i++) {
+      workers.push_back(new Worker(*this));
+      workers.back()->start();
+    };
+    for(std::vector<Writer*>::iterator it = writers.begin(); it != writers.end(); it++)
+      (*it)->start();
+    readFile();
+  } catch(const std::exception& pEx) {
+    error = pEx.what();
+  } catch(...) {
+    error = "unknown error";
+  };
+  {
+    MutexLocker lock(mMutex);
+    if (!error.empty())
+      setError(error);
+    mReadDone = true;
+    //workers that were not started never finish
+    mActiveWorkers -= mWorkers - workers.size();
+    mParseCond.broadcast();
+    mWriteCond.broadcast();
+  };
+  for(std::vector<Worker*>::iterator it = workers.begin(); it != workers.end(); it++) {
+    (*it)->join();
+    delete *it;
+  };
+  for(std::vector<Writer*>::iterator it = writers.begin(); it != writers.end(); it++) {
+    (*it)->join();
+    (*it)->getStream().destroy();
+    delete *it;
+  };
+  error = mError;
+  unsigned long stored = mStored;
+  clear();
+  if (!error.empty())
+    throw DatabaseException("CSV import failed: " + error);
+  return stored;
+};
+
+void
+CSVImport::readFile() {
+  std::ifstream file(mSource.mFilename.c_str(), std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    std::string err("cannot open file ");
+    err += mSource.mFilename;
+    throw CSVFileException(err.c_str());
+  };
+  std::string data;
+  //all chars before scanned were checked for quotes and line ends
+  size_t scanned = 0;
+  //end of last complete line in data
+  size_t boundary = 0;
+  size_t header = mSource.mHasColNames ? std::string::npos : 0;
+  bool quoted = false;
+  unsigned long seq = 0;
+  bool eof = false;
+  while(!eof) {
+    size_t size = data.size();
+    data.resize(size + mChunkSize);
+    file.read(&data[size],mChunkSize);
+    if (file.bad())
+      throw CSVFileException("error reading file");
+    data.resize(size + file.gcount());
+    eof = file.eof() || file.gcount() == 0;
+
+    //quotes are counted from beginning of file, line end is a boundary
+    //only outside of quoted field
+    const char* begin = data.data();
+    const char* end = begin + data.size();
+    for(const char* it = begin + scanned; ; it++) {
+      it = findFirstOf(it,end,quoted ? "\"" : "\"\n");
+      if (it == end)
+        break;
+      if (*it == '"') {
+        quoted = !quoted;
+      } else {
+        boundary = it + 1 - begin;
+        if (header == std::string::npos)
+          header = boundary;
+      };
+    };
+    scanned = data.size();
+    if (eof) {
+      boundary = data.size();
+      if (header == std::string::npos)
+        header = boundary;
+    };
+
+    //first line contains column names
+    if (header != std::string::npos && header > 0) {
+      data.erase(0,header);
+      scanned -= header;
+      boundary -= header;
+      header = 0;
+    };
+    if (boundary == 0)
+      continue;
+    std::auto_ptr<Chunk> chunk(new Chunk(seq++));
+    chunk->mData.swap(data);
+    data.assign(chunk->mData,boundary,std::string::npos);
+    chunk->mData.resize(boundary);
+    scanned -= boundary;
+    boundary = 0;
+    if (!enqueue(chunk.release()))
+      return;
+  };
+};
+
+bool
+CSVImport::enqueue(Chunk* pChunk) {
+  MutexLocker lock(mMutex);
+  while(mInFlight >= mQueueSize && mError.empty())
+    mSpaceCond.wait(mMutex);
+  if (!mError.empty()) {
+    delete pChunk;
+    return false;
+  };
+  mParseQueue.push_back(pChunk);
+  mInFlight++;
+  mParseCond.signal();
+  return true;
+};
+
+void
+CSVImport::parse() {
+  MutexLocker lock(mMutex);
+  while(true) {
+    while(mParseQueue.empty() && !mReadDone && mError.empty())
+      mParseCond.wait(mMutex);
+    if (mParseQueue.empty() || !mError.empty())
+      break;
+    Chunk* chunk = mParseQueue.front();
+    mParseQueue.pop_front();
+
+    mMutex.unlock();
+    std::string error;
+    try {
+      convert(*chunk);
+    } catch(const std::exception& pEx) {
+      error = pEx.what();
+    } catch(...) {
+      error = "unknown error";
+    };
+    mMutex.lock();
+
+    if (!error.empty()) {
+      delete chunk;
+      setError(error);
+      break;
+    };
+    mWriteQueue[chunk->mSeq] = chunk;
+    mWriteCond.broadcast();
+  };
+  mActiveWorkers--;
+  //writers finish when last worker is done
+  mWriteCond.broadcast();
+};
+
+void
+CSVImport::convert(Chunk& pChunk) {
+  CSVIStream stream(pChunk.mData.data(),pChunk.mData.size(),mMappings,mSource.mIgnoreEmptyLines,mSource.getConversionSpecs(),mSource.mFieldSeparator);
+  std::auto_ptr<Storeable> object(mFactory->create());
+  stream.open(*object,mRootTable);
+  //line is parsed without lock, updateVars() only fetches it
+  while(stream.updateVars()) {
+    {
+      OptionalLocker lock(mFilterMutex,mLockFilters);
+      stream.getNext(object.get());
+    };
+    pChunk.mObjects.push_back(object.get());
+    object.release();
+    object.reset(mFactory->create());
+  };
+  stream.close();
+};
+
+void
+CSVImport::write(SQLOStream& pStream) {
+  MutexLocker lock(mMutex);
+  while(true) {
+    Chunk* chunk = NULL;
+    while(mError.empty()) {
+      if (!mWriteQueue.empty()) {
+        ChunkMap::iterator it = mWriteQueue.begin();
+        if (!mPreserveOrder || it->first == mNextWrite) {
+          chunk = it->second;
+          mWriteQueue.erase(it);
+          mNextWrite++;
+          break;
+        };
+      };
+      if (mActiveWorkers == 0)
+        break;
+      mWriteCond.wait(mMutex);
+    };
+    if (chunk == NULL)
+      break;
+    //next chunk in order can be available for other writers
+    mWriteCond.broadcast();
+
+    mMutex.unlock();
+    std::string error;
+    try {
+      store(pStream,*chunk);
+    } catch(const std::exception& pEx) {
+      error = pEx.what();
+    } catch(...) {
+      error = "unknown error";
+    };
+    size_t count = chunk->mObjects.size();
+    delete chunk;
+    mMutex.lock();
+
+    mInFlight--;
+    mSpaceCond.signal();
+    if (!error.empty()) {
+      setError(error);
+      break;
+    };
+    mStored += count;
+  };
+};
+
+void
+CSVImport::store(SQLOStream& pStream, Chunk& pChunk) {
+  std::vector<Storeable*>::iterator it = pChunk.mObjects.begin();
+  while(it != pChunk.mObjects.end()) {
+    try {
+      pStream.begin();
+      for(unsigned int i = 0; i < mBatchSize && it != pChunk.mObjects.end(); i++, it++) {
+        OptionalLocker lock(mFilterMutex,mLockPut);
+        pStream.put(*it);
+      };
+      pStream.commit();
+    } catch(...) {
+      try {
+        pStream.rollback();
+      } catch(...) {};
+      throw;
+    };
+  };
+};
+
+void
+CSVImport::setError(const std::string& pError) {
+  //called with mMutex locked, first error is reported
+  if (mError.empty())
+    mError = pError;
+  mParseCond.broadcast();
+  mWriteCond.broadcast();
+  mSpaceCond.broadcast();
+};
+
+void
+CSVImport::clear() {
+  for(std::deque<Chunk*>::iterator it = mParseQueue.begin(); it != mParseQueue.end(); it++)
+    delete *it;
+  mParseQueue.clear();
+  for(ChunkMap::iterator it = mWriteQueue.begin(); it != mWriteQueue.end(); it++)
+    delete it->second;
+  mWriteQueue.clear();
+  mMappings.clear();
+  mFactory = NULL;
+  mRootTable = NULL;
+  mInFlight = 0;
+  mActiveWorkers = 0;
+  mNextWrite = 0;
+  mStored = 0;
+  mReadDone = false;
+  mError.clear();
+};
+
+CSVImport::~CSVImport() {
+  clear();
+};
+
+};//namespace
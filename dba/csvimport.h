@@ -0,0 +1,206 @@
+// File: csvimport.h
+// Purpose: Parallel import of csv files into SQL database
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBACSVIMPORT_H
+#define DBACSVIMPORT_H
+
+#include <deque>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include "dba/csv.h"
+#include "dba/sqlostream.h"
+#include "dba/thread.h"
+
+namespace dba {
+
+class SQLArchive;
+
+/**
+  Imports objects from csv file to %SQL database using many threads.
+
+  File is read by calling thread and split into chunks of complete csv lines.
+  Line ends inside quoted fields are not treated as chunk boundaries. Chunks
+  are parsed by worker threads into Storeable objects using mappings set in
+  CSVArchive, the same way as CSVIStream::getNext() does. Objects are stored
+  by writer threads, each writer has its own SQLOStream with connection from
+  %SQL archive and stores objects in transactions of batch size objects.
+
+  Number of chunks that are read from file but not yet stored is limited by
+  queue size, so memory usage does not depend on size of file.
+
+  @code
+  dba::CSVArchive csv;
+  csv.open("persons.csv");
+  dba::SharedSQLArchive db;
+  db.open("dbpgsql","dbname=test");
+  dba::CSVImport import(csv,db);
+  import.setWorkers(4);
+  import.setWriters(2);
+  unsigned long count = import.run<Person>();
+  @endcode
+
+  @note Builtin filters (Int, Bool, Double, Float and String used with their
+  native database types) are applied by workers and writers in parallel. Other
+  filters are shared by all objects of class, so members that use them are
+  converted with lock held (see SQLOStream::setFilterLock()). Filters of
+  collections are used during whole put() of object, so objects with
+  collections are stored one at a time.
+  @note Each batch is commited separately. If import fails then batches that
+  were stored before error are not rolled back.
+  @note With more than one writer id fetcher of %SQL archive is called from
+  many connections at once, so it has to allocate unique ids in concurrent
+  transactions (GenericFetcher does not). Binded variables are not supported.
+  @ingroup api
+*/
+class dbaDLLEXPORT CSVImport {
+  public:
+    /**
+      Constructor
+      @param pSource csv archive with file name and mappings
+      @param pTarget open %SQL archive that gives connections to writers
+    */
+    CSVImport(CSVArchive& pSource, SQLArchive& pTarget);
+    /**
+      Set number of threads that parse chunks. Default is 2
+      @param pCount number of threads
+    */
+    void setWorkers(unsigned int pCount);
+    /**
+      Set number of threads that store objects, each writer takes
+      one connection from archive. Default is 1
+      @param pCount number of threads
+    */
+    void setWriters(unsigned int pCount);
+    /**
+      Set size of chunk read from file. Chunks are extended to end of csv line.
+      Default is 4MB
+      @param pSize size in bytes
+    */
+    void setChunkSize(unsigned int pSize);
+    /**
+      Set number of objects stored in one transaction. Default is 1000
+      @param pSize number of objects
+    */
+    void setBatchSize(unsigned int pSize);
+    /**
+      Set maximum number of chunks that are read and not yet stored. Reading
+      of file is suspended when limit is reached. Default is 8
+      @param pSize number of chunks
+    */
+    void setQueueSize(unsigned int pSize);
+    /**
+      Pass chunks to writers in order of file. With one writer objects are
+      stored in the same order as they appear in file. Default is false
+      @param pFlag true to preserve order
+    */
+    void preserveOrder(bool pFlag = true);
+    /**
+      Import all lines of file as objects of class T
+      @param pRootTable custom root table name
+      @return number of stored objects
+      @throw DatabaseException if reading, parsing or storing of objects failed
+    */
+    template <typename T> unsigned long run(const char* pRootTable = NULL);
+    ~CSVImport();
+  private:
+    class Factory {
+      public:
+        virtual Storeable* create() const = 0;
+        virtual ~Factory() {};
+    };
+    template <typename T> class TypedFactory : public Factory {
+      public:
+        virtual Storeable* create() const { return new T(); };
+    };
+    class Chunk {
+      public:
+        Chunk(unsigned long pSeq) : mSeq(pSeq) {};
+        ~Chunk();
+        unsigned long mSeq;
+        std::string mData;
+        std::vector<Storeable*> mObjects;
+    };
+    class Worker : public Thread {
+      public:
+        Worker(CSVImport& pOwner) : mOwner(pOwner) {};
+      protected:
+        virtual void run();
+      private:
+        CSVImport& mOwner;
+    };
+    class Writer : public Thread {
+      public:
+        Writer(CSVImport& pOwner, const SQLOStream& pStream) : mOwner(pOwner), mStream(pStream) {};
+        SQLOStream& getStream() { return mStream; };
+      protected:
+        virtual void run();
+      private:
+        CSVImport& mOwner;
+        SQLOStream mStream;
+    };
+    friend class Worker;
+    friend class Writer;
+    typedef std::map<unsigned long, Chunk*> ChunkMap;
+
+    CSVImport(const CSVImport&);
+    CSVImport& operator=(const CSVImport&);
+
+    unsigned long execute(const Factory& pFactory, const char* pRootTable);
+    void prepare(const Factory& pFactory);
+    void readFile();
+    bool enqueue(Chunk* pChunk);
+    void parse();
+    void convert(Chunk& pChunk);
+    void write(SQLOStream& pStream);
+    void store(SQLOStream& pStream, Chunk& pChunk);
+    void setError(const std::string& pError);
+    void clear();
+
+    CSVArchive& mSource;
+    SQLArchive& mTarget;
+    unsigned int mWorkers;
+    unsigned int mWriters;
+    unsigned int mChunkSize;
+    unsigned int mBatchSize;
+    unsigned int mQueueSize;
+    bool mPreserveOrder;
+
+    //state of current run
+    const Factory* mFactory;
+    const char* mRootTable;
+    std::list<mapping> mMappings;
+    //!class has members with shared filters
+    bool mLockFilters;
+    //!class has collections, put() of object is locked
+    bool mLockPut;
+    Mutex mFilterMutex;
+    Mutex mMutex;
+    Condition mParseCond;
+    Condition mWriteCond;
+    Condition mSpaceCond;
+    std::deque<Chunk*> mParseQueue;
+    ChunkMap mWriteQueue;
+    unsigned int mInFlight;
+    unsigned int mActiveWorkers;
+    unsigned long mNextWrite;
+    unsigned long mStored;
+    bool mReadDone;
+    std::string mError;
+};
+
+template <typename T>
+unsigned long
+CSVImport::run(const char* pRootTable) {
+  TypedFactory<T> factory;
+  return execute(factory,pRootTable);
+};
+
+};//namespace
+
+#endif
@@ -0,0 +1,167 @@
+// File: csvwriter.cpp
+// Purpose: Buffered and optionally compressed output file for csv archive
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#include <string.h>
+#include "dba/csvwriter.h"
+#include "dba/csv.h"
+#include "dba/exception.h"
+
+#ifdef DBA_ZLIB
+#include <zlib.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+namespace dba {
+
+CSVWriter::CSVWriter(const char* pFilename, size_t pBufferSize, compression pCompression, int pLevel, bool pDropCache)
+  : mFilename(pFilename),
+    mFile(NULL),
+    mBuffer(pBufferSize == 0 ? 1 : pBufferSize),
+    mUsed(0),
+    mCompression(pCompression),
+    mDropCache(pDropCache),
+    mZStream(NULL)
+{
+  if (!isSupported(pCompression))
+    throw APIException("Compression of csv files is not supported, library was built without zlib");
+  //text mode is not used for compressed data
+  mFile = fopen(pFilename,pCompression == NO_COMPRESSION ? "w" : "wb");
+  if (mFile == NULL) {
+    std::string err("cannot open file ");
+    err += pFilename;
+    throw CSVFileException(err.c_str());
+  };
+  //buffer of CSVWriter is written in one call
+  setvbuf(mFile,NULL,_IONBF,0);
+#ifdef DBA_ZLIB
+  if (pCompression == GZIP) {
+    z_stream* zs = new z_stream;
+    memset(zs,0,sizeof(z_stream));
+    //windowBits + 16 writes gzip header and trailer
+    if (deflateInit2(zs,pLevel < 0 ? Z_DEFAULT_COMPRESSION : pLevel,Z_DEFLATED,15 + 16,8,Z_DEFAULT_STRATEGY) != Z_OK) {
+      delete zs;
+      fclose(mFile);
+      throw CSVFileException("cannot initialize gzip compression");
+    };
+    mZStream = zs;
+    mOut.resize(mBuffer.size() < 65536 ? 65536 : mBuffer.size());
+  };
+#endif
+};
+
+bool
+CSVWriter::isSupported(compression pCompression) {
+#ifdef DBA_ZLIB
+  return true;
+#else
+  return pCompression == NO_COMPRESSION;
+#endif
+};
+
+void
+CSVWriter::write(const char* pData, size_t pSize) {
+  if (mFile == NULL)
+    throw CSVFileException("write to closed file");
+  while(pSize > 0) {
+    size_t size = mBuffer.size() - mUsed;
+    if (size > pSize)
+      size = pSize;
+    memcpy(&mBuffer[mUsed],pData,size);
+    mUsed += size;
+    pData += size;
+    pSize -= size;
+    if (mUsed == mBuffer.size())
+      writeBuffer(BLOCK);
+  };
+};
+
+void
+CSVWriter::flush() {
+  if (mFile == NULL)
+    return;
+  writeBuffer(SYNC);
+};
+
+void
+CSVWriter::close() {
+  if (mFile == NULL)
+    return;
+  FILE* file = mFile;
+  try {
+    writeBuffer(FINISH);
+  } catch(...) {
+    release();
+    fclose(file);
+    throw;
+  };
+  release();
+  if (fclose(file) != 0)
+    throw CSVFileException("write to file failed");
+};
+
+void
+CSVWriter::writeBuffer(flush_mode pMode) {
+  if (mCompression == NO_COMPRESSION) {
+    writeFile(&mBuffer[0],mUsed);
+    mUsed = 0;
+    return;
+  };
+#ifdef DBA_ZLIB
+  z_stream* zs = static_cast<z_stream*>(mZStream);
+  zs->next_in = reinterpret_cast<Bytef*>(&mBuffer[0]);
+  zs->avail_in = mUsed;
+  int flush = pMode == FINISH ? Z_FINISH : (pMode == SYNC ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+  int ret;
+  do {
+    zs->next_out = reinterpret_cast<Bytef*>(&mOut[0]);
+    zs->avail_out = mOut.size();
+    ret = deflate(zs,flush);
+    if (ret == Z_STREAM_ERROR)
+      throw CSVFileException("gzip compression failed");
+    writeFile(&mOut[0],mOut.size() - zs->avail_out);
+  } while(pMode == FINISH ? ret != Z_STREAM_END : zs->avail_out == 0);
+  mUsed = 0;
+#endif
+};
+
+void
+CSVWriter::writeFile(const char* pData, size_t pSize) {
+  if (pSize == 0)
+    return;
+  if (fwrite(pData,1,pSize,mFile) != pSize)
+    throw CSVFileException("write to file failed");
+#if defined(POSIX_FADV_DONTNEED)
+  //starts writeback of dirty pages and drops clean ones
+  if (mDropCache)
+    posix_fadvise(fileno(mFile),0,0,POSIX_FADV_DONTNEED);
+#endif
+};
+
+void
+CSVWriter::release() {
+#ifdef DBA_ZLIB
+  if (mZStream != NULL) {
+    z_stream* zs = static_cast<z_stream*>(mZStream);
+    deflateEnd(zs);
+    delete zs;
+    mZStream = NULL;
+  };
+#endif
+  mFile = NULL;
+  mUsed = 0;
+};
+
+CSVWriter::~CSVWriter() {
+  try {
+    close();
+  } catch(...) {};
+};
+
+};//namespace
@@ -0,0 +1,105 @@
+// File: csvwriter.h
+// Purpose: Buffered and optionally compressed output file for csv archive
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBACSVWRITER_H
+#define DBACSVWRITER_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "dba/defs.h"
+
+namespace dba {
+
+/**
+  Output file used by CSVOStream. Data is collected in memory buffer and
+  written to file in one block when buffer is full, when flush() is called
+  or when file is closed, so there is one system call for many csv lines.
+
+  Output can be compressed with gzip if library was built with zlib support
+  (configure --with-zlib).
+  @ingroup api
+*/
+class dbaDLLEXPORT CSVWriter {
+  public:
+    /**
+      Compression of output file
+    */
+    typedef enum {
+      //!plain text file
+      NO_COMPRESSION,
+      //!gzip file, needs zlib support
+      GZIP
+    } compression;
+    /**
+      Create new file or truncate existing one.
+      @param pFilename file name
+      @param pBufferSize size of memory buffer, data is written to file when buffer is full
+      @param pCompression compression of output file
+      @param pLevel compression level from 1 (fastest) to 9 (best), -1 for default
+      @param pDropCache if true then operating system is told that written
+             data will not be read soon and can be dropped from page cache
+      @throw APIException if compression is not supported
+      @throw CSVFileException if file cannot be created
+    */
+    CSVWriter(const char* pFilename, size_t pBufferSize = 1024 * 1024, compression pCompression = NO_COMPRESSION, int pLevel = -1, bool pDropCache = false);
+    /**
+      Append data to buffer
+      @throw CSVFileException if write to file failed
+    */
+    void write(const char* pData, size_t pSize);
+    /**
+      Append data to buffer
+      @throw CSVFileException if write to file failed
+    */
+    void write(const std::string& pData) { write(pData.data(),pData.size()); };
+    /**
+      Write buffered data to file. Compressed data is flushed on byte boundary
+      so it can be decompressed up to this point.
+      @throw CSVFileException if write to file failed
+    */
+    void flush();
+    /**
+      Write buffered data, finish compressed stream and close file.
+      @throw CSVFileException if write to file failed
+    */
+    void close();
+    /**
+      @return true if compression is supported by library
+    */
+    static bool isSupported(compression pCompression);
+    /**
+      Destructor. Closes file, errors are ignored.
+    */
+    ~CSVWriter();
+  private:
+    typedef enum {
+      BLOCK,
+      SYNC,
+      FINISH
+    } flush_mode;
+
+    CSVWriter(const CSVWriter&);
+    CSVWriter& operator=(const CSVWriter&);
+    void writeBuffer(flush_mode pMode);
+    void writeFile(const char* pData, size_t pSize);
+    void release();
+
+    std::string mFilename;
+    FILE* mFile;
+    std::vector<char> mBuffer;
+    size_t mUsed;
+    compression mCompression;
+    bool mDropCache;
+    //z_stream, zlib.h is not included in public header
+    void* mZStream;
+    std::vector<char> mOut;
+};
+
+};//namespace
+
+#endif
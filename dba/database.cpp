@@ -9,6 +9,7 @@
 #include "dba/database.h"
 #include "dba/plugininfo.h"
 #include "dba/exception.h"
+#include "dba/watchdog.h"
 
 #include <iostream>
 
@@ -84,7 +85,16 @@ DbBase::handleError(int pErrorType, const char* pMsg) const {
 
 
 DbConnection::DbConnection() 
-  : mUseCount(0)
+  : mUseCount(0),
+    mPipelining(false),
+    mPipelinedCount(0),
+    mRoundTrips(0),
+    mChangedAll(false),
+    mTimeout(0),
+    mDeadline(0),
+    mStatementCacheSize(64),
+    mStatementHits(0),
+    mStatementMisses(0)
 {
 };
 
@@ -105,32 +115,281 @@ DbConnection::decUsed() {
 
 DbResult* 
 DbConnection::sendQuery(const char* pSql) {
+  Watchdog::Guard guard(this, Watchdog::getTimeout(mTimeout, mDeadline));
+  if (!mPipelined.empty())
+    syncUpdates();
+  mRoundTrips++;
   try {
     #ifdef DBA_QUERY_DEBUG
       std::cerr << this << ":" << pSql << std::endl;
     #endif
     return execQuery(pSql);
   } catch (const SQLException& pEx) {
+    if (guard.isExpired())
+      throw TimeoutException(std::string("Query cancelled after timeout: ") + pEx.what());
     SQLException ex(pEx);
     ex.setQuery(pSql);
     throw ex;
+  } catch (const Exception& pEx) {
+    if (guard.isExpired())
+      throw TimeoutException(std::string("Query cancelled after timeout: ") + pEx.what());
+    throw;
   };
 };
 
 int 
 DbConnection::sendUpdate(const char* pSql) {
+  Watchdog::Guard guard(this, Watchdog::getTimeout(mTimeout, mDeadline));
+  if (!mPipelined.empty())
+    syncUpdates();
+  mRoundTrips++;
   try {
     #ifdef DBA_QUERY_DEBUG
       std::cerr << this << ":" << pSql << std::endl;
     #endif
     return execUpdate(pSql);
   } catch (const SQLException& pEx) {
+    if (guard.isExpired())
+      throw TimeoutException(std::string("Command cancelled after timeout: ") + pEx.what());
     SQLException ex(pEx);
     ex.setQuery(pSql);
     throw ex;
+  } catch (const Exception& pEx) {
+    if (guard.isExpired())
+      throw TimeoutException(std::string("Command cancelled after timeout: ") + pEx.what());
+    throw;
   };
 };
 
+DbResult* 
+DbConnection::sendQuery(const char* pSql, const DbParams& pParams) {
+  Watchdog::Guard guard(this, Watchdog::getTimeout(mTimeout, mDeadline));
+  if (!mPipelined.empty())
+    syncUpdates();
+  mRoundTrips++;
+  try {
+    #ifdef DBA_QUERY_DEBUG
+      std::cerr << this << ": (prepared) " << pSql << std::endl;
+    #endif
+    return execPreparedQuery(getStatement(pSql), pParams);
+  } catch (const SQLException& pEx) {
+    if (guard.isExpired())
+      throw TimeoutException(std::string("Query cancelled after timeout: ") + pEx.what());
+    SQLException ex(pEx);
+    ex.setQuery(pSql);
+    throw ex;
+  } catch (const Exception& pEx) {
+    if (guard.isExpired())
+      throw TimeoutException(std::string("Query cancelled after timeout: ") + pEx.what());
+    throw;
+  };
+};
+
+int 
+DbConnection::sendUpdate(const char* pSql, const DbParams& pParams) {
+  Watchdog::Guard guard(this, Watchdog::getTimeout(mTimeout, mDeadline));
+  if (!mPipelined.empty())
+    syncUpdates();
+  mRoundTrips++;
+  try {
+    #ifdef DBA_QUERY_DEBUG
+      std::cerr << this << ": (prepared) " << pSql << std::endl;
+    #endif
+    return execPreparedUpdate(getStatement(pSql), pParams);
+  } catch (const SQLException& pEx) {
+    if (guard.isExpired())
+      throw TimeoutException(std::string("Command cancelled after timeout: ") + pEx.what());
+    SQLException ex(pEx);
+    ex.setQuery(pSql);
+    throw ex;
+  } catch (const Exception& pEx) {
+    if (guard.isExpired())
+      throw TimeoutException(std::string("Command cancelled after timeout: ") + pEx.what());
+    throw;
+  };
+};
+
+shared_ptr<DbStatement>
+DbConnection::getStatement(const char* pSql) {
+  std::string sql(pSql);
+  StatementIndex::iterator it = mStatementIndex.find(sql);
+  if (it != mStatementIndex.end()) {
+    shared_ptr<DbStatement> stmt(it->second->second);
+    //statement is used by open result, prepare private copy
+    if (stmt->isBusy()) {
+      mStatementMisses++;
+      return shared_ptr<DbStatement>(prepare(pSql));
+    };
+    mStatementHits++;
+    mStatements.splice(mStatements.begin(), mStatements, it->second);
+    return stmt;
+  };
+  mStatementMisses++;
+  shared_ptr<DbStatement> stmt(prepare(pSql));
+  if (mStatementCacheSize == 0)
+    return stmt;
+  while(mStatements.size() >= mStatementCacheSize) {
+    //statement used by open result is freed when result is destroyed
+    mStatementIndex.erase(mStatements.back().first);
+    mStatements.pop_back();
+  };
+  mStatements.push_front(std::make_pair(sql, stmt));
+  mStatementIndex[sql] = mStatements.begin();
+  return stmt;
+};
+
+void
+DbConnection::setStatementCacheSize(size_t pSize) {
+  mStatementCacheSize = pSize;
+  while(mStatements.size() > mStatementCacheSize) {
+    mStatementIndex.erase(mStatements.back().first);
+    mStatements.pop_back();
+  };
+};
+
+void
+DbConnection::clearStatementCache() {
+  mStatementIndex.clear();
+  mStatements.clear();
+};
+
+DbStatement*
+DbConnection::prepare(const char* pSql) {
+  throw APIException("Driver does not support prepared statements");
+};
+
+DbResult*
+DbConnection::execPreparedQuery(const shared_ptr<DbStatement>& pStmt, const DbParams& pParams) {
+  throw APIException("Driver does not support prepared statements");
+};
+
+int
+DbConnection::execPreparedUpdate(const shared_ptr<DbStatement>& pStmt, const DbParams& pParams) {
+  throw APIException("Driver does not support prepared statements");
+};
+
+int
+DbConnection::queueUpdate(const char* pSql, const std::string& pContext, bool pCheckRows) {
+  if (mPipelining) {
+    #ifdef DBA_QUERY_DEBUG
+      std::cerr << this << ": (pipelined) " << pSql << std::endl;
+    #endif
+    if (execPipelined(pSql)) {
+      mPipelined.push_back(PipelinedUpdate(pSql, pContext, pCheckRows));
+      mPipelinedCount++;
+      return -1;
+    };
+  };
+  return sendUpdate(pSql);
+};
+
+void
+DbConnection::syncUpdates() {
+  std::vector<PipelinedUpdate> pipelined;
+  pipelined.swap(mPipelined);
+  if (pipelined.empty())
+    return;
+  mRoundTrips++;
+  pipelineSync();
+  int failed = -1;
+  std::string error;
+  for(size_t i = 0; i < pipelined.size(); i++) {
+    std::string cmdError;
+    int rows = pipelineResult(cmdError);
+    if (failed != -1)
+      continue;
+    if (rows == -1) {
+      failed = i;
+      error = cmdError;
+    } else if (rows == 0 && pipelined[i].mCheckRows) {
+      failed = i;
+    };
+  };
+  pipelineEnd();
+  if (failed == -1)
+    return;
+  const PipelinedUpdate& cmd(pipelined[failed]);
+  if (error.empty())
+    throw DataException("Failed to " + cmd.mContext + ": SQL command returned 0 rows affected");
+  try {
+    handleError(DBA_SQL_ERROR, (error + " (failed to " + cmd.mContext + ")").c_str());
+  } catch (const SQLException& pEx) {
+    SQLException ex(pEx);
+    ex.setQuery(cmd.mSql.c_str());
+    throw ex;
+  };
+};
+
+void
+DbConnection::discardUpdates() {
+  std::vector<PipelinedUpdate> pipelined;
+  pipelined.swap(mPipelined);
+  if (pipelined.empty())
+    return;
+  pipelineSync();
+  std::string error;
+  for(size_t i = 0; i < pipelined.size(); i++)
+    pipelineResult(error);
+  pipelineEnd();
+};
+
+void
+DbConnection::setPipelining(bool pFlag) {
+  //pipelining is disabled even if pipelined commands failed
+  mPipelining = pFlag;
+  if (!pFlag)
+    syncUpdates();
+};
+
+void
+DbConnection::reserveIds(const char* pTable, const std::vector<int>& pIds) {
+  std::vector<int>& ids(mReservedIds[pTable]);
+  ids.insert(ids.begin(), pIds.rbegin(), pIds.rend());
+};
+
+bool
+DbConnection::takeReservedId(const char* pTable, int& pId) {
+  std::map<std::string, std::vector<int> >::iterator it = mReservedIds.find(pTable);
+  if (it == mReservedIds.end() || it->second.empty())
+    return false;
+  pId = it->second.back();
+  it->second.pop_back();
+  return true;
+};
+
+void
+DbConnection::clearReservedIds() {
+  mReservedIds.clear();
+};
+
+void
+DbConnection::addChangedTable(const char* pTable) {
+  if (pTable == NULL)
+    mChangedAll = true;
+  else if (!mChangedAll)
+    mChangedTables.insert(pTable);
+};
+
+bool
+DbConnection::takeChangedTables(std::set<std::string>& pTables) {
+  bool ret = !mChangedAll;
+  pTables.swap(mChangedTables);
+  mChangedTables.clear();
+  mChangedAll = false;
+  return ret;
+};
+
+void
+DbConnection::addChangedObject(const std::string& pTable, int pId) {
+  mChangedObjects.insert(std::pair<std::string, int>(pTable,pId));
+};
+
+void
+DbConnection::takeChangedObjects(std::set<std::pair<std::string, int> >& pObjects) {
+  pObjects.swap(mChangedObjects);
+  mChangedObjects.clear();
+};
+
 //static
 const struct ::tm DbResult::sInvalidTm = {-1,-1,-1,-1,-1,-1};
 
@@ -12,8 +12,11 @@
 #include <string>
 #include <set>
 #include <list>
+#include <vector>
+#include <map>
 #include "dba/defs.h"
 #include "dba/convspec.h"
+#include "dba/shared_ptr.h"
 
 namespace dba {
 
@@ -169,8 +172,74 @@ class dbaDLLEXPORT Database : public DbBase {
 */
 //FIXME add flag or switch to indicate that use wants to process multiple queries on one connection \
 //throw exception if database does not support it.
+/**
+  Value of parameter sent to database using native parameter binding.
+  Value is always kept as text, drivers convert it to type of parameter
+  if they can.
+  @ingroup api
+*/
+class dbaDLLEXPORT DbParam {
+  public:
+    typedef enum {
+      TEXT,
+      INTEGER,
+      FLOAT
+    } param_type;
+    DbParam(param_type pType = TEXT)
+      : mType(pType),
+        mIsNull(true)
+    {};
+    //!type of placeholder that parameter was created for
+    param_type mType;
+    //!parameter value converted to string
+    std::string mValue;
+    //!true if parameter value is NULL
+    bool mIsNull;
+};
+
+typedef std::vector<DbParam> DbParams;
+
+/**
+  Base class for %SQL statement prepared by driver. Prepared statements are
+  kept in cache of DbConnection and executed many times with different parameters.
+  @ingroup api
+*/
+class dbaDLLEXPORT DbStatement : public RefCounted {
+  public:
+    /**
+      Check if statement is used by open result and cannot be executed again
+      until result is destroyed.
+    */
+    bool isBusy() const { return mBusy; };
+    /**
+      Mark statement as used by open result.
+    */
+    void setBusy(bool pFlag) { mBusy = pFlag; };
+    /**
+      Destructor. Drivers free prepared statement here.
+    */
+    virtual ~DbStatement() {};
+  protected:
+    DbStatement() : mBusy(false) {};
+  private:
+    DbStatement(const DbStatement&);
+    DbStatement& operator=(const DbStatement&);
+    bool mBusy;
+};
+
 class dbaDLLEXPORT DbConnection : public DbBase {
   public:
+    /**
+      Parameter markers used by driver for native parameter binding
+    */
+    typedef enum {
+      //!driver does not support parameter binding
+      PARAMS_NONE,
+      //!parameters are marked with "?"
+      PARAMS_QUESTION_MARK,
+      //!parameters are marked with "$1", "$2" ...
+      PARAMS_NUMBERED
+    } param_style;
     /**
       Should driver use UNICODE capability 
     */
@@ -203,6 +272,164 @@ class dbaDLLEXPORT DbConnection : public DbBase {
     int sendUpdate(const std::string& pSql) {
       return sendUpdate(pSql.c_str());
     };
+    /**
+      Send %SQL query with parameters bound natively by driver. Query should use
+      parameter markers returned by getParamStyle(). Prepared statement is taken
+      from statement cache or prepared and put into cache.
+      @param pSql %SQL query with parameter markers
+      @param pParams values of parameters
+    */
+    DbResult* sendQuery(const char* pSql, const DbParams& pParams);
+    /**
+      Send %SQL command with parameters bound natively by driver.
+      @param pSql %SQL command with parameter markers
+      @param pParams values of parameters
+      @return number of affected rows
+    */
+    int sendUpdate(const char* pSql, const DbParams& pParams);
+    /**
+      Get parameter markers supported by driver.
+      Default implementation returns PARAMS_NONE.
+    */
+    virtual param_style getParamStyle() const { return PARAMS_NONE; };
+    /**
+      Check if driver can store and read dates as numbers
+      (see ConvSpec::mDateStorage). Default implementation returns false.
+    */
+    virtual bool hasNumericDates() const { return false; };
+    /**
+      Set maximum number of prepared statements kept in cache. Least recently used
+      statements are freed when cache is full.
+      @param pSize number of statements or 0 to disable cache
+    */
+    void setStatementCacheSize(size_t pSize);
+    /**
+      Get maximum number of prepared statements kept in cache
+    */
+    size_t getStatementCacheSize() const { return mStatementCacheSize; };
+    /**
+      Get number of prepared statements in cache
+    */
+    size_t getCachedStatements() const { return mStatements.size(); };
+    /**
+      Get number of queries that reused statement from cache
+    */
+    unsigned long getStatementHits() const { return mStatementHits; };
+    /**
+      Get number of queries that had to prepare new statement
+    */
+    unsigned long getStatementMisses() const { return mStatementMisses; };
+    /**
+      Free all prepared statements that are not used by open results.
+      Drivers call it before connection handle is closed.
+    */
+    void clearStatementCache();
+    /**
+      Send %SQL command to database without waiting for its result. Command is pipelined
+      only if pipelining was enabled using setPipelining() and driver can pipeline
+      it (for example postgres driver pipelines commands only inside transactions).
+      Otherwise command is executed immediately, like with sendUpdate().
+      Results of pipelined commands are checked by syncUpdates(), which is called
+      automatically before next query or command, including commit.
+      @param pSql %SQL command to send
+      @param pContext description of command, for example object that is stored. Used in error messages
+      @param pCheckRows if true then pipelined command that does not affect any row is reported as error
+      @return number of affected rows or -1 if command was pipelined
+    */
+    int queueUpdate(const char* pSql, const std::string& pContext, bool pCheckRows = false);
+    /**
+      Wait for results of all pipelined commands. Error is reported for first
+      command that failed, with its context and query.
+    */
+    void syncUpdates();
+    /**
+      Enable or disable pipelining of commands sent using queueUpdate()
+      @param pFlag true if commands should be pipelined
+    */
+    void setPipelining(bool pFlag);
+    /**
+      Check if pipelining is enabled
+    */
+    bool isPipelining() const { return mPipelining; };
+    /**
+      Get number of commands sent using pipelining since connection was created
+    */
+    unsigned long getPipelinedCount() const { return mPipelinedCount; };
+    /**
+      Get number of times connection waited for reply from database since it was created.
+      Every query or command counts as one round trip and reading results of all
+      pipelined commands counts as one round trip.
+    */
+    unsigned long getRoundTrips() const { return mRoundTrips; };
+    /**
+      Store ids allocated in advance by SQLIdFetcher for objects of root table
+      @param pTable root table name
+      @param pIds ids that can be used for new objects
+    */
+    void reserveIds(const char* pTable, const std::vector<int>& pIds);
+    /**
+      Take next id stored by reserveIds()
+      @param pTable root table name
+      @param pId set to reserved id
+      @return false if there is no reserved id for pTable
+    */
+    bool takeReservedId(const char* pTable, int& pId);
+    /**
+      Forget all reserved ids. Called when transaction that allocated them is rolled back.
+    */
+    void clearReservedIds();
+    /**
+      Remember table changed in current transaction. Used by SQLOStream to invalidate
+      QueryCache again when changes are commited.
+      @param pTable name of table or NULL if any table could be changed
+    */
+    void addChangedTable(const char* pTable);
+    /**
+      Get and forget tables remembered by addChangedTable()
+      @param pTables set filled with names of changed tables
+      @return false if any table could be changed
+    */
+    bool takeChangedTables(std::set<std::string>& pTables);
+    /**
+      Remember object changed in current transaction. Used by SQLOStream to remove
+      object from ObjectCache again when changes are commited.
+      @param pTable root table name of object
+      @param pId id of object
+    */
+    void addChangedObject(const std::string& pTable, int pId);
+    /**
+      Get and forget objects remembered by addChangedObject()
+      @param pObjects set filled with root table names and ids of changed objects
+    */
+    void takeChangedObjects(std::set<std::pair<std::string, int> >& pObjects);
+    /**
+      Set timeout for queries and commands sent using this connection. If query runs
+      longer then it is cancelled using cancel() and TimeoutException is thrown.
+      @param pMillis timeout in miliseconds or 0 to disable timeout
+    */
+    void setTimeout(unsigned long pMillis) { mTimeout = pMillis; };
+    /**
+      Get query timeout set by setTimeout()
+    */
+    unsigned long getTimeout() const { return mTimeout; };
+    /**
+      Set deadline for queries and commands sent using this connection. Timeout of every
+      query is shortened so query is cancelled when deadline passes, and queries sent after
+      deadline throw TimeoutException.
+      @param pDeadline deadline as returned from Watchdog::now() or 0 to disable deadline
+    */
+    void setDeadline(unsigned long pDeadline) { mDeadline = pDeadline; };
+    /**
+      Get deadline set by setDeadline()
+    */
+    unsigned long getDeadline() const { return mDeadline; };
+    /**
+      Cancel query or command that is currently executed on this connection.
+      This method can be called from other thread than one that is executing query.
+      Default implementation does nothing.
+      @return true if driver supports cancellation
+    */
+    virtual bool cancel() { return false; };
     /**
       Start transaction
     */
@@ -262,10 +489,94 @@ class dbaDLLEXPORT DbConnection : public DbBase {
       @param pSql %SQL command to send
     */
     virtual int execUpdate(const char* pSql) = 0;
+    /**
+      Override with database specific implementation of command pipelining.
+      Default implementation does not pipeline commands.
+      @param pSql %SQL command to send
+      @return true if command was sent, false if command should be executed immediately
+    */
+    virtual bool execPipelined(const char* pSql) { return false; };
+    /**
+      Called by syncUpdates() before results of pipelined commands are read
+    */
+    virtual void pipelineSync() {};
+    /**
+      Get result of next pipelined command. Called by syncUpdates() for every
+      command in order in which commands were sent.
+      @param pError set to error message if command failed
+      @return number of affected rows or -1 if command failed
+    */
+    virtual int pipelineResult(std::string& pError) { return -1; };
+    /**
+      Called by syncUpdates() after results of all pipelined commands were read
+    */
+    virtual void pipelineEnd() {};
+    /**
+      Override with database specific implementation of statement preparation.
+      Default implementation throws APIException.
+      @param pSql %SQL statement with parameter markers
+      @return new prepared statement
+    */
+    virtual DbStatement* prepare(const char* pSql);
+    /**
+      Override with database specific implementation of prepared query execution.
+      Driver should mark statement as busy until returned result is destroyed
+      if statement cannot be executed while result is open.
+      Default implementation throws APIException.
+      @param pStmt statement created by prepare()
+      @param pParams values of parameters
+    */
+    virtual DbResult* execPreparedQuery(const shared_ptr<DbStatement>& pStmt, const DbParams& pParams);
+    /**
+      Override with database specific implementation of prepared command execution.
+      Default implementation throws APIException.
+      @param pStmt statement created by prepare()
+      @param pParams values of parameters
+      @return number of affected rows
+    */
+    virtual int execPreparedUpdate(const shared_ptr<DbStatement>& pStmt, const DbParams& pParams);
+    /**
+      Read and ignore results of all pipelined commands. Drivers should call it
+      before rollback.
+    */
+    void discardUpdates();
     /**
       Usage counter used by streams.
     */
     int mUseCount;
+  private:
+    class PipelinedUpdate {
+      public:
+        PipelinedUpdate(const char* pSql, const std::string& pContext, bool pCheckRows)
+          : mSql(pSql), mContext(pContext), mCheckRows(pCheckRows) {};
+        std::string mSql;
+        std::string mContext;
+        bool mCheckRows;
+    };
+    typedef std::list<std::pair<std::string, shared_ptr<DbStatement> > > StatementList;
+    typedef std::map<std::string, StatementList::iterator> StatementIndex;
+
+    shared_ptr<DbStatement> getStatement(const char* pSql);
+
+    std::vector<PipelinedUpdate> mPipelined;
+    bool mPipelining;
+    unsigned long mPipelinedCount;
+    unsigned long mRoundTrips;
+    //!ids reserved for root tables, next id is last in vector
+    std::map<std::string, std::vector<int> > mReservedIds;
+    //!tables changed in current transaction
+    std::set<std::string> mChangedTables;
+    bool mChangedAll;
+    //!objects changed in current transaction
+    std::set<std::pair<std::string, int> > mChangedObjects;
+    unsigned long mTimeout;
+    unsigned long mDeadline;
+    //!prepared statements, most recently used first
+    StatementList mStatements;
+    StatementIndex mStatementIndex;
+    size_t mStatementCacheSize;
+    unsigned long mStatementHits;
+    unsigned long mStatementMisses;
 };
 
 
@@ -302,7 +613,9 @@ class dbaDLLEXPORT DbResult : public DbBase {
     */
     virtual int getColumnIndex(const char* pColumnName) const = 0;
     /**
-      Cancel query processing. This operation can be one only once for DbResult and currently is supported for ODBC driver only.
+      Cancel query processing. After call to this method fetchRow() returns false.
+      This operation can be done only once for DbResult. To cancel query that is
+      executed by other thread use DbConnection::cancel().
     */
     virtual void cancel() {};
     /**
@@ -327,7 +640,9 @@ class dbaDLLEXPORT DbResult : public DbBase {
     */
     const char* getString(const char* pField) const { return getString(getColumnIndex(pField)); }
     /**
-      Get field as string value
+      Get field as string value. Returned buffer is owned by result. It is valid
+      until next call of getString for the same field, fetchRow or until result
+      is destroyed, so value that has to be kept longer must be copied.
       @param pField field index
     */
     const char* getString(int pField) const;
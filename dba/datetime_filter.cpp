@@ -6,11 +6,24 @@
 // This file is a part of debea library (http://debea.net)
 
 #include "conversion.h"
+#include "civiltime.h"
 #include "datetime_filter.h"
 #include "archive.h"
 
 namespace dba {
 
+//numeric dates are UTC, see ConvSpec::mDateStorage
+static void
+numberToCivil(const ConvSpec& pSpec, double pData, tm& pDate) {
+  if (pSpec.mDateStorage == ConvSpec::DATE_JULIANDAY)
+    timeToCivil(julianDayToTime(pData),pDate);
+  else
+    timeToCivil((time_t)pData,pDate);
+  pDate.tm_isdst = -1;
+  if (pSpec.mGMTOffset != 0)
+    addSeconds(pDate,-pSpec.mGMTOffset);
+};
+
 DateTime::DateTime(::tm& pDate)
   : StoreableFilter<tm>(pDate)
 {
@@ -18,34 +31,28 @@ DateTime::DateTime(::tm& pDate)
 
 std::string 
 DateTime::toString(const ConvSpec& pSpec) const throw (StoreableFilterException) {
-  char buffer[64];
+  char buffer[DATE_BUFFER_SIZE];
   int size;
   tm moved_tm(*mMember);
-  //we use mktime to add or substract gmt offset to broken down
-  //structure.
-  if (pSpec.mGMTOffset != 0) {
-    //on unix machines mktime sets time zone and 
-    //treats argument as UTC date if time zone was not set
-    //this causes date change, so we reassign original date values
-    //after that change and add GMT offset to that values
-    if (mktime(&moved_tm) == -1) {
-      throw StoreableFilterException("Cannot normalize struct tm for printing");
-    };
-    moved_tm.tm_sec = mMember->tm_sec + pSpec.mGMTOffset;
-    moved_tm.tm_min = mMember->tm_min;
-    moved_tm.tm_hour = mMember->tm_hour;
-    moved_tm.tm_mday = mMember->tm_mday;
-    moved_tm.tm_mon = mMember->tm_mon;
-    moved_tm.tm_year = mMember->tm_year;
-    if (mktime(&moved_tm) == -1) {
-      throw StoreableFilterException("Cannot normalize struct tm for printing");
-    };
+  //gmt offset is added to broken down structure without
+  //time zone, so daylight saving time changes do not move date
+  if (pSpec.mGMTOffset != 0)
+    addSeconds(moved_tm,pSpec.mGMTOffset);
+  switch(pSpec.mDateStorage) {
+    case ConvSpec::DATE_UNIXTIME:
+      size = formatInt(civilToTime(moved_tm),buffer);
+      return std::string(buffer,size);
+    case ConvSpec::DATE_JULIANDAY:
+      size = formatDouble(timeToJulianDay(civilToTime(moved_tm)),buffer);
+      return std::string(buffer,size);
+    default:
+    break;
   };
   #ifdef _WIN32
   if (moved_tm.tm_year < 0)
     throw StoreableFilterException("Cannot convert struct tm with year < 1970 to string");
   #endif
-  size = strftime(buffer,64,pSpec.mTimestampFormat,&moved_tm);
+  size = formatDateTime(moved_tm,pSpec.mTimestampFormat,buffer,DATE_BUFFER_SIZE);
   if (size == 0)
     throw StoreableFilterException("DateTime::toString: strftime failed");
   return std::string(buffer,size);
@@ -64,40 +71,55 @@ DateTime::isNull() const {
 
 void 
 DateTime::fromInt(const ConvSpec& pSpec, int pData) throw (StoreableFilterException) {
+  if (pSpec.mDateStorage != ConvSpec::DATE_TEXT) {
+    numberToCivil(pSpec,pData,*mMember);
+    return;
+  };
   time_t data(pData);
   data -= pSpec.mGMTOffset;
-  dba_localtime(&data,mMember);
+  timeToLocal(data,*mMember);
 };
 
 void
 DateTime::fromDouble(const ConvSpec& pSpec, double pData) throw (StoreableFilterException) {
+  if (pSpec.mDateStorage != ConvSpec::DATE_TEXT) {
+    numberToCivil(pSpec,pData,*mMember);
+    return;
+  };
   time_t data((time_t)pData);
   data -= pSpec.mGMTOffset;
-  dba_localtime(&data,mMember);
+  timeToLocal(data,*mMember);
 };
 
 void 
 DateTime::fromString(const ConvSpec& pSpec, const std::string& pData) throw (StoreableFilterException) {
-  *mMember = parseISODateTime(pData.c_str());
-  if (pSpec.mGMTOffset == 0)
-    return;
-  time_t data = mktime(mMember);
-  if (data == -1) {
-    throw StoreableFilterException("Date is out of mktime() range");
+  const char* data = pData.c_str();
+  switch(pSpec.mDateStorage) {
+    case ConvSpec::DATE_UNIXTIME: {
+      long val;
+      if (!parseInt(data,data + pData.size(),val))
+        throw StoreableFilterException(("Cannot convert '" + pData + "' to date").c_str());
+      numberToCivil(pSpec,val,*mMember);
+    } return;
+    case ConvSpec::DATE_JULIANDAY: {
+      double val;
+      if (!parseDouble(data,data + pData.size(),val,pSpec.mDecimalPoint))
+        throw StoreableFilterException(("Cannot convert '" + pData + "' to date").c_str());
+      numberToCivil(pSpec,val,*mMember);
+    } return;
+    default:
+      *mMember = parseISODateTime(data);
+    break;
   };
-  data -= pSpec.mGMTOffset;
-  dba_localtime(&data,mMember);
+  if (pSpec.mGMTOffset != 0)
+    addSeconds(*mMember,-pSpec.mGMTOffset);
 };
 
 void 
 DateTime::fromDate(const ConvSpec& pSpec, const tm& pDate) throw (StoreableFilterException) {
-  if (pSpec.mGMTOffset != 0) {
-    time_t data = mktime((tm*)&pDate);
-    data -= pSpec.mGMTOffset;
-    dba_localtime(&data,mMember);
-  } else {
-    *mMember = pDate;
-  };
+  *mMember = pDate;
+  if (pSpec.mGMTOffset != 0)
+    addSeconds(*mMember,-pSpec.mGMTOffset);
 };
 
 void 
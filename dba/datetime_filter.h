@@ -13,9 +13,9 @@
 namespace dba {
 
 /**
-  Class for converting date and time. GMT offsets are calculated using mktime() call.
-  This means that if you set ConvSpec::mGMTOffset to value different from 0
-  you can use this filter for range 1970 +/- 68 years on 32-bit machines.
+  Class for converting date and time. GMT offsets are added to broken down time
+  without time zone calls (see addSeconds()), dates in default ConvSpec formats
+  are written and parsed without strftime() and C locale.
   @ingroup filters
 */
 class dbaDLLEXPORT DateTime : public StoreableFilter<tm> {
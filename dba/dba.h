@@ -11,6 +11,7 @@
 #include "dba/sharedsqlarchive.h"
 #include "dba/exception.h"
 #include "dba/storeable.h"
+#include "dba/storemember.h"
 #include "dba/string_filter.h"
 #include "dba/stdlist.h"
 #include "dba/int_filter.h"
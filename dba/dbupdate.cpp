@@ -40,8 +40,11 @@ DbUpdate::update(const std::string& pToVersion) {
     setCurrentVersion(mFileParser.getToVersion());
   } catch (std::exception&) {
     t.rollback();
+    mArchive.refreshSchema();
     throw;
   }
+  //scripts changed schema, snapshot will be read again by next getSchema()
+  mArchive.refreshSchema();
 };
 
 int
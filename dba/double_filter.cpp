@@ -7,10 +7,9 @@
 
 
 #include "dba/conversion.h"
+#include "dba/civiltime.h"
 #include "dba/double_filter.h"
 #include <string.h>
-#include <locale.h>
-#include <limits.h>
 
 namespace dba {
 
@@ -21,33 +20,8 @@ Double::Double(double& pDouble)
 
 std::string 
 Double::toString(const ConvSpec& pSpec) const throw (StoreableFilterException) {
-  try {
-    std::string dest;
-    convert(*mMember,dest);
-    struct lconv* l = localeconv();
-    //locale hack
-    char* lptr = l->decimal_point;
-    while((*lptr != '\0')&&(*lptr != CHAR_MAX)) {
-      if (*lptr != pSpec.mDecimalPoint) {
-        std::string::size_type pos = 0;
-        while( (pos = dest.find(*lptr, pos)) != std::string::npos ) {
-          dest[pos] = pSpec.mDecimalPoint;
-        };
-      };
-      lptr++;
-    };
-    lptr = l->thousands_sep;
-    while((*lptr != '\0')&&(*lptr != CHAR_MAX)) {
-      std::string::size_type pos = 0;
-      while( (pos = dest.find(*lptr, pos)) != std::string::npos ) {
-        dest.erase(pos);
-      };
-      lptr++;
-    };
-    return dest;
-  } catch (ConversionException& pEx) {
-    throw StoreableFilterException(pEx.what());
-  };
+  char buf[NUMBER_BUFFER_SIZE];
+  return std::string(buf,formatDouble(*mMember,buf,pSpec.mDecimalPoint));
 };
 
 bool 
@@ -76,7 +50,7 @@ Double::fromString(const ConvSpec& pSpec, const std::string& pData) throw (Store
 
 void 
 Double::fromDate(const ConvSpec& pSpec, const tm& pDate) throw (StoreableFilterException) {
-  time_t val = mktime((tm*)&pDate);
+  time_t val = localToTime(pDate);
   *mMember = static_cast<double>(val);
 };
 
@@ -97,9 +71,8 @@ Float::Float(float& pFloat)
 
 std::string 
 Float::toString(const ConvSpec& pSpec) const throw (StoreableFilterException) {
-  double d = *mMember;
-  Double f(d);
-  return f.toString(pSpec);
+  char buf[NUMBER_BUFFER_SIZE];
+  return std::string(buf,formatFloat(*mMember,buf,pSpec.mDecimalPoint));
 };
 
 bool 
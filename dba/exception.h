@@ -58,6 +58,19 @@ class dbaDLLEXPORT DatabaseException : public Exception {
     DatabaseException(const std::string& pText) : Exception(pText.c_str()) {};
 };
 
+/**
+  Thrown when query was cancelled because its timeout or stream deadline expired
+  @ingroup api
+*/
+class dbaDLLEXPORT TimeoutException : public DatabaseException {
+  public:
+    /**
+      Constructor
+      @param pText error text
+    */
+    TimeoutException(const std::string& pText) : DatabaseException(pText) {};
+};
+
 /**
   Database exception related to plugin operations
 */
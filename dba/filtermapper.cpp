@@ -10,6 +10,7 @@
 //
 //
 #include "dba/filtermapper.h"
+#include "dba/thread.h"
 
 #include <iostream>
 #include <sstream>
@@ -23,6 +24,20 @@
 
 namespace dba {
 
+typedef std::map<std::string, size_t> TypeKeys;
+
+static Mutex&
+getTypeKeysMutex() {
+  static Mutex mutex;
+  return mutex;
+}
+
+static TypeKeys&
+getTypeKeys() {
+  static TypeKeys keys;
+  return keys;
+}
+
 FilterMapper::FilterMapper()
 {
   initDefaultMappings();
@@ -31,10 +46,17 @@ FilterMapper::FilterMapper()
 FilterMapper::~FilterMapper()
 {
   for(FilterMap::iterator it = mMap.begin(); it != mMap.end(); it++) {
-    delete it->second;
+    delete *it;
   }
 }
 
+size_t
+FilterMapper::getTypeKey(const char* pTypeName) {
+  MutexLocker lock(getTypeKeysMutex());
+  TypeKeys& keys(getTypeKeys());
+  return keys.insert(std::make_pair(std::string(pTypeName),keys.size())).first->second;
+}
+
 void 
 FilterMapper::initDefaultMappings() {
   mapType(typeid(id), new dba::Int());
@@ -48,23 +70,33 @@ FilterMapper::initDefaultMappings() {
 
 void 
 FilterMapper::mapType(const std::type_info& pType, StoreableFilterBase* pFilter) {
-  std::pair<FilterMap::iterator,bool> ret(mMap.insert(std::make_pair(pType.name(),pFilter)));
-  if(!ret.second) {
-    delete ret.first->second;
-    ret.first->second = pFilter;
-  }
+  size_t key = getTypeKey(pType.name());
+  if (key >= mMap.size())
+    mMap.resize(key + 1, NULL);
+  delete mMap[key];
+  mMap[key] = pFilter;
   //std::cerr << "Added filter for [" << pType.name() << "] to list of default filters map" << std::endl;
 }
 
 dba::StoreableFilterBase& 
 FilterMapper::findFilter(const char* pTypeName) const throw (FilterNotFoundException) {
-  FilterMap::const_iterator it = mMap.find(pTypeName);
-  if (it == mMap.end()) {
+  size_t key = getTypeKey(pTypeName);
+  if (key >= mMap.size() || mMap[key] == NULL) {
     std::stringstream error;
     error << "Default filter for type " << pTypeName << " not found ";
     throw FilterNotFoundException(error.str());
   }
-  return *(it->second);
+  return *(mMap[key]);
+}
+
+dba::StoreableFilterBase& 
+FilterMapper::findFilter(size_t pTypeKey) const throw (FilterNotFoundException) {
+  if (pTypeKey >= mMap.size() || mMap[pTypeKey] == NULL) {
+    std::stringstream error;
+    error << "Default filter for type key " << pTypeKey << " not found ";
+    throw FilterNotFoundException(error.str());
+  }
+  return *(mMap[pTypeKey]);
 }
 
 } //namepspace
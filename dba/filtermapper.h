@@ -14,6 +14,7 @@
 
 #include "dba/exception.h"
 #include <map>
+#include <vector>
 #include <typeinfo>
 
 namespace dba {
@@ -22,11 +23,26 @@ class StoreableFilterBase;
 
 /**
 Global static database of filter to type maps. Used by SQL class to get proper filter for C++ type when converting C++ data to %SQL representation. This database is initialized at program startup. Rading from this database should be thread safe.
+
+Every C++ type gets process wide type key - small integer assigned on first use of type. Mappings
+are kept in array indexed by type key, so finding filter for type with known key costs one array access.
 */
-class FilterMapper {
+class dbaDLLEXPORT FilterMapper {
   public:
     FilterMapper();
     ~FilterMapper();
+    /**
+      Get type key for type name returned by std::type_info::name().
+      New key is assigned if type was not seen before.
+    */
+    static size_t getTypeKey(const char* pTypeName);
+    /**
+      Get type key for C++ type. Key is computed once per type.
+    */
+    template <typename T> static size_t getTypeKey() {
+      static const size_t key = getTypeKey(typeid(T).name());
+      return key;
+    };
     /**
       Add new mapping for C++ data type
     */
@@ -35,12 +51,18 @@ class FilterMapper {
       Find filter for given type
     */
     dba::StoreableFilterBase& findFilter(const char* pTypeName) const throw (FilterNotFoundException);
+    /**
+      Find filter for type key returned by getTypeKey()
+    */
+    dba::StoreableFilterBase& findFilter(size_t pTypeKey) const throw (FilterNotFoundException);
     /**
       Add all mappings for default filters
     */
     void initDefaultMappings();
   private:
-    typedef std::map<std::string, StoreableFilterBase*> FilterMap;
+    FilterMapper(const FilterMapper&);
+    FilterMapper& operator=(const FilterMapper&);
+    typedef std::vector<StoreableFilterBase*> FilterMap;
     FilterMap mMap;
 };
 
@@ -11,6 +11,7 @@
 
 #include "dba/sqlidfetcher.h"
 #include "dba/sqlarchive.h"
+#include "dba/conversion.h"
 #include <memory>
 
 namespace dba {
@@ -32,6 +33,17 @@ class dbaDLLEXPORT GenericFetcher : public dba::SQLIdFetcher {
       pConn.sendUpdate("UPDATE debea_object_count SET id = id + 1");
       return id;
     };
+    //!reserves whole range of ids with one query and one update
+    virtual void getNextIds(dba::DbConnection& pConn, const char*, int pCount, std::vector<int>& pIds) {
+      std::auto_ptr<dba::DbResult> res(pConn.sendQuery("SELECT id FROM debea_object_count"));
+      if (!res->fetchRow())
+        throw dba::DataException("Unable to allocate next object id");
+      int id = res->getInt(0);
+      res.reset();
+      pConn.sendUpdate(("UPDATE debea_object_count SET id = id + " + dba::toStr(pCount)).c_str());
+      for(int i = 0; i < pCount; i++)
+        pIds.push_back(id + i);
+    };
     virtual ~GenericFetcher();
 };
 
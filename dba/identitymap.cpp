@@ -0,0 +1,74 @@
+// File: identitymap.cpp
+// Purpose: Cache of objects loaded in one transaction
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#include "dba/identitymap.h"
+
+namespace dba {
+
+IdentityMap::IdentityMap()
+  : mEnabled(false),
+    mHits(0),
+    mMisses(0)
+{
+};
+
+void
+IdentityMap::setEnabled(bool pFlag) {
+  mEnabled = pFlag;
+  if (!mEnabled)
+    clear();
+};
+
+void
+IdentityMap::put(const std::string& pTable, id pId, Storeable* pObject, bool pComposite) {
+  Key key(pTable, pId);
+  ObjectMap::iterator it = mObjects.find(key);
+  if (it != mObjects.end()) {
+    delete it->second;
+    it->second = pObject;
+  } else {
+    mObjects[key] = pObject;
+  };
+  if (pComposite)
+    mComposite.insert(key);
+  else
+    mComposite.erase(key);
+};
+
+void
+IdentityMap::erase(const std::string& pTable, id pId) {
+  ObjectMap::iterator it = mObjects.find(Key(pTable, pId));
+  if (it != mObjects.end()) {
+    delete it->second;
+    mObjects.erase(it);
+    mComposite.erase(Key(pTable, pId));
+  };
+};
+
+void
+IdentityMap::eraseComposite() {
+  for(KeySet::iterator it = mComposite.begin(); it != mComposite.end(); it++) {
+    ObjectMap::iterator ot = mObjects.find(*it);
+    delete ot->second;
+    mObjects.erase(ot);
+  };
+  mComposite.clear();
+};
+
+void
+IdentityMap::clear() {
+  for(ObjectMap::iterator it = mObjects.begin(); it != mObjects.end(); it++)
+    delete it->second;
+  mObjects.clear();
+  mComposite.clear();
+};
+
+IdentityMap::~IdentityMap() {
+  clear();
+};
+
+};//namespace
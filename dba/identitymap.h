@@ -0,0 +1,133 @@
+// File: identitymap.h
+// Purpose: Cache of objects loaded in one transaction
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBAIDENTITYMAP_H
+#define DBAIDENTITYMAP_H
+
+#include <map>
+#include <set>
+#include <string>
+#include "dba/storeable.h"
+
+namespace dba {
+
+/**
+  Map of objects loaded in one transaction context, keyed by root table name and id.
+  IdentityMap is created by SharedSQLArchive for every transaction context and is 
+  shared by all Transaction instances and all streams that belong to this context.
+  It is disabled by default, see Transaction::setIdentityMap().
+
+  Objects are inserted by SQLIStream::load() and removed when Transaction::getOStream()
+  stores, updates or deletes them. Objects that were loaded with their collections are
+  removed on every write, because written object can be a member of their collection.
+  Map is cleared by SQLOStream::sendUpdate() and when transaction is commited or rolled back.
+  @ingroup api
+*/
+class dbaDLLEXPORT IdentityMap {
+  public:
+    /**
+      Constructor. Creates disabled map
+    */
+    IdentityMap();
+    /**
+      Enable or disable map. Disabled map is cleared and does not store objects.
+      @param pFlag true to enable map
+    */
+    void setEnabled(bool pFlag);
+    /**
+      Check if map is enabled
+    */
+    bool isEnabled() const { return mEnabled; };
+    /**
+      Find object instance in map. Counts hit or miss.
+      @param pTable name of root table of object
+      @param pId id of object
+      @return pointer to object owned by map or NULL if object of type T is not in map
+    */
+    template <typename T> const T* find(const std::string& pTable, id pId);
+    /**
+      Store copy of object in map. Does nothing if map is disabled.
+      @param pTable name of root table of object
+      @param pObject object to copy
+      @param pComposite true if object was loaded with its collections
+    */
+    template <typename T> void insert(const std::string& pTable, const T& pObject, bool pComposite = false);
+    /**
+      Remove object from map
+      @param pTable name of root table of object
+      @param pId id of object
+    */
+    void erase(const std::string& pTable, id pId);
+    /**
+      Remove all objects that were inserted with their collections
+    */
+    void eraseComposite();
+    /**
+      Remove all objects from map
+    */
+    void clear();
+    /**
+      Get number of objects in map
+    */
+    unsigned int size() const { return mObjects.size(); };
+    /**
+      Get number of lookups that found object in map
+    */
+    unsigned long getHits() const { return mHits; };
+    /**
+      Get number of lookups that did not find object in map
+    */
+    unsigned long getMisses() const { return mMisses; };
+    /**
+      Destructor. Deletes all objects
+    */
+    ~IdentityMap();
+  private:
+    typedef std::pair<std::string, id> Key;
+    typedef std::map<Key, Storeable*> ObjectMap;
+    typedef std::set<Key> KeySet;
+
+    IdentityMap(const IdentityMap&);
+    IdentityMap& operator=(const IdentityMap&);
+    void put(const std::string& pTable, id pId, Storeable* pObject, bool pComposite);
+
+    ObjectMap mObjects;
+    //!keys of objects loaded with collections
+    KeySet mComposite;
+    bool mEnabled;
+    unsigned long mHits;
+    unsigned long mMisses;
+};
+
+template <typename T>
+const T*
+IdentityMap::find(const std::string& pTable, id pId) {
+  if (mEnabled) {
+    ObjectMap::const_iterator it = mObjects.find(Key(pTable, pId));
+    if (it != mObjects.end()) {
+      //the same table can be root table for different classes
+      const T* ret = dynamic_cast<const T*>(it->second);
+      if (ret != NULL) {
+        mHits++;
+        return ret;
+      };
+    };
+  };
+  mMisses++;
+  return NULL;
+};
+
+template <typename T>
+void
+IdentityMap::insert(const std::string& pTable, const T& pObject, bool pComposite) {
+  if (mEnabled)
+    put(pTable, pObject.getId(), new T(pObject), pComposite);
+};
+
+};//namespace
+
+#endif
@@ -6,6 +6,7 @@
 // This file is a part of debea library (http://debea.net)
 
 #include "dba/conversion.h"
+#include "dba/civiltime.h"
 #include "dba/int_filter.h"
 
 namespace dba {
@@ -59,7 +60,7 @@ Int::fromString(const ConvSpec& pSpec, const std::string& pData) throw (Storeabl
 void 
 Int::fromDate(const ConvSpec& pSpec, const tm& pDate) throw (StoreableFilterException) {
   try {
-    time_t val = mktime(&(tm&)pDate);
+    time_t val = localToTime(pDate);
     *mMember = static_cast<int>(val);
   } catch (ConversionException& pEx) {
     throw StoreableFilterException(pEx.what());
@@ -1,185 +1,144 @@
 // File: membertree.cpp
-// Purpose: Utilities for class member tables 
+// Purpose: Utilities for class member tables
 // Author: Lukasz Michalski <lm at zork.pl>, Copyright 2002
 // License: See COPYING file that comes with this distribution
 
 #include "dba/membertree.h"
+#include "dba/storeable.h"
+#include "dba/exception.h"
+#include "dba/thread.h"
 
-#include <iostream>
+#include <map>
 #include <string.h>
 
 namespace dba {
 
-mt_mlist::mt_mlist() {
-  mFirst = new mt_class;
-  mFirst -> firstField = new mt_member;
-  mFirst -> firstField -> name = NULL;
-  mFirst -> firstField -> next = NULL;
-  mFirst -> name = NULL;
-  mFirst -> next = NULL;
+typedef std::map<std::pair<const StoreTable*, std::string>, shared_ptr<mt_mlist> > MemberListCache;
+
+static Mutex&
+getMemberListCacheMutex() {
+  static Mutex mutex;
+  return mutex;
 };
 
-mt_mlist::~mt_mlist() {
-  mt_class* next;
-  mt_member* nf;
-  while(mFirst != NULL) {
-    next = mFirst -> next;
-    while(mFirst -> firstField != NULL) {
-      nf = mFirst -> firstField -> next;
-      delete mFirst -> firstField;
-      mFirst -> firstField = nf;
-    };
-    delete mFirst;
-    mFirst = next;
-  };
+static MemberListCache&
+getMemberListCache() {
+  static MemberListCache cache;
+  return cache;
 };
 
-void
-mt_mlist::add(const char* table,const char* field,int offset,void* f, int type) {
-  mt_class* first = mFirst;
-  while(first != NULL) {
-    if (first -> name == NULL) {
-      first -> name = table;
-      add(first,field,offset,f,type);
-      return;
+mt_mlist::mt_mlist()
+  : mBegin(NULL),
+    mEnd(NULL)
+{
+};
+
+mt_mlist::mt_mlist(const StoreTable* pRootTable, const char* pRootTableName)
+  : mBegin(NULL),
+    mEnd(NULL)
+{
+  if (pRootTableName != NULL)
+    mRootTableName = pRootTableName;
+  //tables in order of appearance, tables with the same name are merged
+  std::vector<const char*> names;
+  std::vector<std::vector<mt_member> > members;
+  const char* tableName = NULL;
+  for(const StoreTable* tbl = pRootTable; tbl != NULL; tbl = tbl->getNextTable()) {
+    //replace root table name with user supilled (if any)
+    if (tbl == pRootTable) {
+      tableName = pRootTableName != NULL ? mRootTableName.c_str() : tbl->getTableName();
+      if (tableName == NULL)
+        throw APIException("Root table cannot be NULL");
+    } else if (tbl->getTableName() != NULL) {
+      //if store table defines table name then
+      //use it as name of table, if not then use parent name
+      tableName = tbl->getTableName();
+    };
+    size_t pos = 0;
+    while(pos < names.size() && strcmp(names[pos],tableName))
+      pos++;
+    if (pos == names.size()) {
+      names.push_back(tableName);
+      members.push_back(std::vector<mt_member>());
     };
-    if (!strcmp(first -> name,table)) {
-      add(first,field,offset,f,type);
-      return;
+    for(StoreTableMember* member = tbl->getMembers(); member != NULL; member = member->getNextMember()) {
+      mt_member m;
+      m.offset = member->getMemberOffset() + tbl->getClassOffset();
+      m.name = member->getMemberName();
+      m.func = member->getFilter();
+      m.type = member->getDatabaseType();
+      m.kind = member->getFilterKind();
+      m.typed = member->getTypedMember();
+      members[pos].push_back(m);
     };
-    first = first -> next;
   };
-  mt_class* n = new mt_class;
-  n -> name = table;
-  n -> firstField = new mt_member;
-  n -> firstField -> name = NULL;
-  n -> firstField -> next = NULL;
-  add(n,field,offset,f,type);
-  n -> next = mFirst;
-  mFirst = n;
-};
 
-void
-mt_mlist::clear() {
-  mt_class* first = mFirst;
-  while(first -> name != NULL) {
-    clear(first);
-    first = first -> next;    
-    if (first == NULL)
-      break;
+  //keep order of linked list that was used before: parent tables
+  //first and members from last to first
+  std::vector<size_t> firsts;
+  for(size_t i = names.size(); i > 0; i--) {
+    firsts.push_back(mMembers.size());
+    mMembers.insert(mMembers.end(),members[i-1].rbegin(),members[i-1].rend());
+  };
+  firsts.push_back(mMembers.size());
+  const mt_member* data = mMembers.empty() ? NULL : &mMembers[0];
+  for(size_t i = 0; i < names.size(); i++) {
+    mt_class c;
+    c.name = names[names.size() - i - 1];
+    c.first = data + firsts[i];
+    c.last = data + firsts[i+1];
+    mClasses.push_back(c);
+  };
+  if (!mClasses.empty()) {
+    mBegin = &mClasses[0];
+    mEnd = mBegin + mClasses.size();
   };
 };
 
-void
-mt_mlist::clear(mt_class* t) {
-  t -> name = NULL;
-  mt_member* f = t -> firstField;
-  while(f != NULL) {
-    f -> name = NULL;
-    f = f -> next;
+shared_ptr<mt_mlist>
+mt_mlist::get(const StoreTable* pRootTable, const char* pRootTableName) {
+  //empty name cannot be distinguished from no name in cache key
+  if (pRootTableName != NULL && *pRootTableName == 0)
+    return shared_ptr<mt_mlist>(new mt_mlist(pRootTable,pRootTableName));
+  std::pair<const StoreTable*, std::string> key(pRootTable,pRootTableName != NULL ? pRootTableName : "");
+  {
+    MutexLocker lock(getMemberListCacheMutex());
+    MemberListCache::const_iterator it = getMemberListCache().find(key);
+    if (it != getMemberListCache().end())
+      return it->second;
   };
+  //store tables are never changed after creation, so two threads
+  //building the same list get identical copies
+  shared_ptr<mt_mlist> list(new mt_mlist(pRootTable,pRootTableName));
+  MutexLocker lock(getMemberListCacheMutex());
+  return getMemberListCache().insert(std::make_pair(key,list)).first->second;
 };
 
 void
-mt_mlist::add(mt_class* t, const char* name, int offset,void* f,int type) {
-  mt_member* n = t -> firstField;
-  while(n != NULL) {
-    if (n -> name == NULL) {
-      n -> name = name;
-      n -> offset = offset;
-      n -> func = f;
-      n -> type = type;
-      return;
-    };
-    n = n -> next;
-  };
-  n = new mt_member;
-  n -> name = name;
-  n -> offset = offset;
-  n -> type = type;
-  n -> next = t -> firstField;
-  n -> func = f;
-  t -> firstField = n;    
+mt_mlist::clearCache() {
+  MutexLocker lock(getMemberListCacheMutex());
+  getMemberListCache().clear();
 };
 
-mt_member*
+const mt_member*
 mt_mlist::findMember(const char* pClassName, const char* pFieldName) const {
-  mt_class* first = mFirst;
-  while(first != NULL) {
-    if (first -> name == NULL)
-      return NULL;      
-    if (!strcmp(first -> name,pClassName))
-      return findMember(first,pFieldName);
-    first = first -> next;
-  };
-  return NULL;
-};
-
-mt_member*
-mt_mlist::findMember(mt_class* pTable, const char* pField) const {
-  mt_member* n = pTable -> firstField;
-  while(n != NULL) {
-    if (n -> name == NULL)
-      return NULL;
-    if (!strcmp(n -> name,pField))
-      return n;
-    n = n -> next;
+  for(const mt_class* c = mBegin; c != mEnd; c++) {
+    if (!strcmp(c->name,pClassName))
+      return findMember(*c,pFieldName);
   };
   return NULL;
 };
 
-
-
-void
-mt_mlist::addClass(const char* table) {
-  mt_class* first = mFirst;
-  while(first != NULL) {
-    if (first -> name == NULL) {
-      //FIXME fill data here instead replacing mFirst.
-      break;
-    };
-    if (!strcmp(first -> name,table)) {
-      return;
-    };
-    first = first -> next;
-  };
-  mt_class* n = new mt_class;
-  n -> name = table;
-  n -> firstField = new mt_member;
-  n -> firstField -> name = NULL;
-  n -> firstField -> next = NULL;
-  n -> next = mFirst;
-  mFirst = n;
-};
-
-void*
-mt_mlist::findFuncByOffset(int pOffset) const {
-  mt_class* first = mFirst;
-  while(first != NULL) {
-    if (first -> name == NULL) {
-      break;      
-    } else {
-      void* func = findFuncByOffset(first,pOffset);
-      if (func != NULL) {
-        return func;
-      };
-    };
-    first = first -> next;
+const mt_member*
+mt_mlist::findMember(const mt_class& pTable, const char* pField) {
+  for(const mt_member* m = pTable.first; m != pTable.last; m++) {
+    if (!strcmp(m->name,pField))
+      return m;
   };
   return NULL;
 };
 
-void*
-mt_mlist::findFuncByOffset(mt_class* pTable, int pOffset) const {
-  mt_member* n = pTable -> firstField;
-  while(n != NULL) {
-    if (n -> name != NULL) {
-      if (n -> offset == pOffset)
-        return n -> func;
-    };
-    n = n -> next;
-  };
-  return NULL;
+mt_mlist::~mt_mlist() {
 };
 
 };//namespace
@@ -1,15 +1,21 @@
 // File: membertree.h
-// Purpose: Utilities for class member tables 
+// Purpose: Utilities for class member tables
 // Author: Lukasz Michalski <lm at zork.pl>, Copyright 2002
 // License: See COPYING file that comes with this distribution
 
 #ifndef DBAMEMBERTREE_H
 #define DBAMEMBERTREE_H
 
+#include <string>
+#include <vector>
 #include "dba/defs.h"
+#include "dba/shared_ptr.h"
 
 namespace dba {
 
+class StoreTable;
+struct TypedMemberEntry;
+
 /**
   This struct descrbes class member.
   */
@@ -18,9 +24,7 @@ struct dbaDLLEXPORT mt_member {
   //!Offset from address of object to member
   int offset;
   //!name of coresponding field in %SQL table
-  const char* name; 
-  //!list pointer
-  mt_member* next;
+  const char* name;
 
   //Data members.
   /**
@@ -30,80 +34,88 @@ struct dbaDLLEXPORT mt_member {
   //Database::type enum, that tells DbResult object, that we will get field from it as String, Int,
   //Date or double. \see Database class
   int type;
+  //StoreTableMember::filter_kind enum, builtin filters are applied without virtual calls
+  int kind;
+  //load and store functions of member declared by BIND_MEMBER or NULL
+  const TypedMemberEntry* typed;
 };
 
 /**
-  This struct describes class entry in mlist. Every class in inheritance hierarchy has one mt_table entry
-  in mt_list structure.
+  This struct describes class entry in mlist. Every table in inheritance hierarchy has one mt_class entry
+  in mt_list structure. Members of table are stored in range [first, last)
 */
 struct dbaDLLEXPORT mt_class {
   const char* name;
-  mt_class* next;
-  mt_member* firstField;
+  const mt_member* first;
+  const mt_member* last;
 };
 
 /**structure for representing offsets to members of classes
 inside parent hierarhy tree.
-This class is mainly created for implementing EVENT, MESSAGE and DBSTORAGE tables
 <pre>
 mt_list
-  ^
   |
-mt_class -> mt_class -> mt_class -> NULL
-               ^
-               |
-            mt_member -> mt_member -> mt_member -> NULL
-
+mt_class[] = { mt_class, mt_class, mt_class }
+                   |
+mt_member[] = { ..., mt_member, mt_member, ... }
 </pre>
 
-Leafs (mt_class and mt_member objects) of this structure are allocated only once. Each leaf can be full, or empty.
-Leaf is empty if his name points to NULL, and full if its name points to something
-
-
-If leaf is empty it can be filled by add() methods.
-If leaf is full it can be cleared by clear() methods.
-
-Destructor frees memory allocated for structure.
+Member list is built once for each pair of store table and overridden root table name,
+all mt_class and mt_member entries are kept in contiguous arrays. Built list
+is never modified, so it is shared by all streams and threads.
 
+Tables are ordered from topmost parent to class that owns store table, members
+of each table are ordered from last to first defined in store table.
 */
-class dbaDLLEXPORT mt_mlist {
+class dbaDLLEXPORT mt_mlist : public RefCounted {
   public:
+    /**
+      Creates empty list
+    */
     mt_mlist();
     /**
-      Adds class entry for table if it is not already in
+      Get member list for store table
+      @param pRootTable store table of object
+      @param pRootTableName overridden name of root table or NULL
+      @return cached member list
+      @throw APIException if root table has no name
     */
-    void addClass(const char* table);
+    static shared_ptr<mt_mlist> get(const StoreTable* pRootTable, const char* pRootTableName);
     /**
-      Adds new member to structure. Class entry is created if needed.
+      Drop all cached member lists. Lists used by streams are freed when streams release them
     */
-    void add(const char* table, const char* field,int offset,void* f,int type);
-    void add(mt_class* t, const char* name, int offset,void* f, int type);
+    static void clearCache();
     /**
-      @return func pointer for first offset found or NULL if offset was not in structure
-      */
-    void* findFuncByOffset(int pOffset) const;
+      @return first class entry
+    */
+    const mt_class* begin() const { return mBegin; };
     /**
-      @return func pointer for first offset found or NULL if offset was not in single class list
-      */
-    void* findFuncByOffset(mt_class* pTable, int pOffset) const;
+      @return entry after last class entry
+    */
+    const mt_class* end() const { return mEnd; };
+    /**
+      @return true if list has no class entries
+    */
+    bool empty() const { return mBegin == mEnd; };
     /**
       @return pointer to member or NULL if member is not in structure
     */
-    mt_member* findMember(const char* pClassName, const char* pFieldName) const;
+    const mt_member* findMember(const char* pClassName, const char* pFieldName) const;
     /**
       @return pointer to member or NULL if member is not in single class list
     */
-    mt_member* findMember(mt_class* pTable, const char* pField) const;
-    int getSize() const;
-    void clear();
-    void clear(mt_class* t);
+    static const mt_member* findMember(const mt_class& pTable, const char* pField);
     ~mt_mlist();
-
-    mt_class* mFirst;
-    int qb_size;
   private:
+    mt_mlist(const StoreTable* pRootTable, const char* pRootTableName);
     mt_mlist(mt_mlist& pList);
     void operator=(const mt_mlist& pList);
+
+    std::string mRootTableName;
+    std::vector<mt_class> mClasses;
+    std::vector<mt_member> mMembers;
+    const mt_class* mBegin;
+    const mt_class* mEnd;
 };
 
 };//namespace
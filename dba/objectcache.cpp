@@ -0,0 +1,179 @@
+// File: objectcache.cpp
+// Purpose: Process wide cache of objects loaded from SQL database
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#include <string.h>
+#include "dba/objectcache.h"
+#include "dba/watchdog.h"
+
+namespace dba {
+
+ObjectCache::ObjectCache(unsigned int pMaxSize)
+  : mMaxSize(pMaxSize == 0 ? 1 : pMaxSize),
+    mHits(0),
+    mMisses(0),
+    mEvictions(0)
+{
+};
+
+void
+ObjectCache::addClass(const std::type_info& pType, const ClassPolicy& pPolicy) {
+  MutexLocker lock(mMutex);
+  mPolicies[pType.name()] = pPolicy;
+};
+
+void
+ObjectCache::disableClass(const std::type_info& pType) {
+  MutexLocker lock(mMutex);
+  mPolicies.erase(pType.name());
+  EntryMap::iterator it = mEntries.begin();
+  while(it != mEntries.end()) {
+    EntryMap::iterator current = it++;
+    if (!strcmp(current->second.mClass,pType.name()))
+      remove(current);
+  };
+};
+
+bool
+ObjectCache::hasClasses() {
+  MutexLocker lock(mMutex);
+  return !mPolicies.empty();
+};
+
+void
+ObjectCache::remove(EntryMap::iterator pEntry) {
+  //called with mMutex locked
+  delete pEntry->second.mObject;
+  mLru.erase(pEntry->second.mLru);
+  mEntries.erase(pEntry);
+};
+
+void
+ObjectCache::evict() {
+  //called with mMutex locked
+  while(mEntries.size() > mMaxSize) {
+    remove(mEntries.find(mLru.back()));
+    mEvictions++;
+  };
+};
+
+bool
+ObjectCache::get(Storeable& pObject, const std::string& pTable, id pId) {
+  const char* cls = typeid(pObject).name();
+  MutexLocker lock(mMutex);
+  PolicyMap::const_iterator policy = mPolicies.find(cls);
+  if (policy == mPolicies.end())
+    return false;
+  EntryMap::iterator it = mEntries.find(Key(pTable, pId));
+  if (it == mEntries.end()) {
+    mMisses++;
+    return false;
+  };
+  Entry& entry = it->second;
+  if (entry.mExpires != 0 && (long)(entry.mExpires - Watchdog::now()) <= 0) {
+    remove(it);
+    mEvictions++;
+    mMisses++;
+    return false;
+  };
+  //the same table can be root table for different classes
+  if (strcmp(entry.mClass,cls)) {
+    mMisses++;
+    return false;
+  };
+  policy->second.mAssign(pObject, *entry.mObject);
+  mLru.splice(mLru.begin(), mLru, entry.mLru);
+  mHits++;
+  return true;
+};
+
+unsigned long
+ObjectCache::getGeneration(const std::string& pTable) {
+  MutexLocker lock(mMutex);
+  return mGenerations[pTable];
+};
+
+void
+ObjectCache::put(const Storeable& pObject, const std::string& pTable, unsigned long pGeneration) {
+  const char* cls = typeid(pObject).name();
+  MutexLocker lock(mMutex);
+  PolicyMap::const_iterator policy = mPolicies.find(cls);
+  if (policy == mPolicies.end())
+    return;
+  //object was changed during read
+  if (mGenerations[pTable] != pGeneration)
+    return;
+  Key key(pTable, pObject.getId());
+  EntryMap::iterator it = mEntries.find(key);
+  if (it != mEntries.end())
+    remove(it);
+  Entry& entry = mEntries[key];
+  entry.mObject = policy->second.mClone(pObject);
+  entry.mClass = cls;
+  entry.mExpires = policy->second.mTtl == 0 ? 0 : Watchdog::now() + policy->second.mTtl;
+  //0 means that entry does not expire
+  if (policy->second.mTtl != 0 && entry.mExpires == 0)
+    entry.mExpires = 1;
+  entry.mLru = mLru.insert(mLru.begin(), key);
+  evict();
+};
+
+void
+ObjectCache::erase(const std::string& pTable, id pId) {
+  MutexLocker lock(mMutex);
+  mGenerations[pTable]++;
+  EntryMap::iterator it = mEntries.find(Key(pTable, pId));
+  if (it != mEntries.end())
+    remove(it);
+};
+
+void
+ObjectCache::clear() {
+  MutexLocker lock(mMutex);
+  for(EntryMap::iterator it = mEntries.begin(); it != mEntries.end(); it++)
+    delete it->second.mObject;
+  mEntries.clear();
+  mLru.clear();
+  for(GenerationMap::iterator it = mGenerations.begin(); it != mGenerations.end(); it++)
+    it->second++;
+};
+
+void
+ObjectCache::setMaxSize(unsigned int pMaxSize) {
+  MutexLocker lock(mMutex);
+  mMaxSize = pMaxSize == 0 ? 1 : pMaxSize;
+  evict();
+};
+
+unsigned int
+ObjectCache::size() {
+  MutexLocker lock(mMutex);
+  return mEntries.size();
+};
+
+unsigned long
+ObjectCache::getHits() {
+  MutexLocker lock(mMutex);
+  return mHits;
+};
+
+unsigned long
+ObjectCache::getMisses() {
+  MutexLocker lock(mMutex);
+  return mMisses;
+};
+
+unsigned long
+ObjectCache::getEvictions() {
+  MutexLocker lock(mMutex);
+  return mEvictions;
+};
+
+ObjectCache::~ObjectCache() {
+  clear();
+};
+
+};//namespace
@@ -0,0 +1,183 @@
+// File: objectcache.h
+// Purpose: Process wide cache of objects loaded from SQL database
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBAOBJECTCACHE_H
+#define DBAOBJECTCACHE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <typeinfo>
+#include "dba/storeable.h"
+#include "dba/thread.h"
+
+namespace dba {
+
+/**
+  Thread safe cache of objects shared by all streams of SharedSQLArchive.
+  Cache holds copies of objects of classes enabled using enableClass().
+  Objects are keyed by root table name and id. Cache is bounded by number of
+  objects, least recently used objects are removed first.
+
+  Objects are put into cache by SQLIStream::getNext() and returned by
+  SQLIStream::get() (and SQLIStream::load()) when stream has WHERE set
+  by SQLIStream::setWhereId(). Objects are removed from cache when they are stored,
+  updated or erased using SQLOStream from the same archive. If objects are changed 
+  by other processes then time to live should be set for class.
+
+  Every erase changes generation of table. Streams take generation of table before
+  query is sent and objects read by query are not put into cache if it changed, so
+  object erased by writer during read is not cached again with old data.
+
+  Objects changed in Transaction are removed from cache when they are written and
+  again after transaction is commited, because other threads can cache them with
+  old data before commit.
+
+  @note Classes that have BIND_COL collections are not cached
+  @ingroup api
+*/
+class dbaDLLEXPORT ObjectCache {
+  public:
+    /**
+      Constructor
+      @param pMaxSize maximum number of objects in cache
+    */
+    ObjectCache(unsigned int pMaxSize = 10000);
+    /**
+      Enable caching of objects of class T. Class must have copy constructor 
+      and assigment operator.
+      @param pTtl time to live of cached object in miliseconds or 0 if object does not expire
+    */
+    template <typename T> void enableClass(unsigned long pTtl = 0);
+    /**
+      Disable caching of objects of class T and remove them from cache.
+    */
+    template <typename T> void disableClass() { disableClass(typeid(T)); };
+    /**
+      Disable caching of objects of given class and remove them from cache.
+      @param pType class returned by typeid()
+    */
+    void disableClass(const std::type_info& pType);
+    /**
+      Check if there are classes enabled for caching
+    */
+    bool hasClasses();
+    /**
+      Copy object from cache.
+      @param pObject object to fill, class of object is used to find cached copy
+      @param pTable root table name of object
+      @param pId id of object
+      @return true if object was found in cache
+    */
+    bool get(Storeable& pObject, const std::string& pTable, id pId);
+    /**
+      Get generation of table. Generation is changed when object is removed from table
+      or cache is cleared.
+      @param pTable root table name
+    */
+    unsigned long getGeneration(const std::string& pTable);
+    /**
+      Put copy of object into cache. Does nothing if class of object is not enabled
+      or if generation of table changed.
+      @param pObject object to copy
+      @param pTable root table name of object
+      @param pGeneration generation of table taken before object was read from database
+    */
+    void put(const Storeable& pObject, const std::string& pTable, unsigned long pGeneration);
+    /**
+      Remove object from cache
+      @param pTable root table name of object
+      @param pId id of object
+    */
+    void erase(const std::string& pTable, id pId);
+    /**
+      Remove all objects from cache
+    */
+    void clear();
+    /**
+      Change maximum number of objects in cache
+      @param pMaxSize maximum number of objects
+    */
+    void setMaxSize(unsigned int pMaxSize);
+    /**
+      Get number of objects in cache
+    */
+    unsigned int size();
+    /**
+      Get number of lookups that found object in cache
+    */
+    unsigned long getHits();
+    /**
+      Get number of lookups for enabled classes that did not find object in cache
+    */
+    unsigned long getMisses();
+    /**
+      Get number of objects removed from cache because cache was full or object expired
+    */
+    unsigned long getEvictions();
+    /**
+      Destructor. Deletes all objects
+    */
+    ~ObjectCache();
+  private:
+    typedef Storeable* (*cloneFunc)(const Storeable&);
+    typedef void (*assignFunc)(Storeable&, const Storeable&);
+    class ClassPolicy {
+      public:
+        ClassPolicy() : mTtl(0), mClone(NULL), mAssign(NULL) {};
+        ClassPolicy(unsigned long pTtl, cloneFunc pClone, assignFunc pAssign) 
+          : mTtl(pTtl), mClone(pClone), mAssign(pAssign) {};
+        unsigned long mTtl;
+        cloneFunc mClone;
+        assignFunc mAssign;
+    };
+    typedef std::pair<std::string, id> Key;
+    typedef std::list<Key> LruList;
+    class Entry {
+      public:
+        Storeable* mObject;
+        const char* mClass;
+        unsigned long mExpires;
+        LruList::iterator mLru;
+    };
+    typedef std::map<std::string, ClassPolicy> PolicyMap;
+    typedef std::map<Key, Entry> EntryMap;
+    typedef std::map<std::string, unsigned long> GenerationMap;
+
+    template <typename T> static Storeable* cloneObject(const Storeable& pObject) {
+      return new T(static_cast<const T&>(pObject));
+    };
+    template <typename T> static void assignObject(Storeable& pTo, const Storeable& pFrom) {
+      static_cast<T&>(pTo) = static_cast<const T&>(pFrom);
+    };
+
+    ObjectCache(const ObjectCache&);
+    ObjectCache& operator=(const ObjectCache&);
+    void addClass(const std::type_info& pType, const ClassPolicy& pPolicy);
+    void remove(EntryMap::iterator pEntry);
+    void evict();
+
+    Mutex mMutex;
+    PolicyMap mPolicies;
+    EntryMap mEntries;
+    LruList mLru;
+    GenerationMap mGenerations;
+    unsigned int mMaxSize;
+    unsigned long mHits;
+    unsigned long mMisses;
+    unsigned long mEvictions;
+};
+
+template <typename T>
+void
+ObjectCache::enableClass(unsigned long pTtl) {
+  addClass(typeid(T), ClassPolicy(pTtl, &cloneObject<T>, &assignObject<T>));
+};
+
+};//namespace
+
+#endif
@@ -204,6 +204,7 @@ OdbcColumn::~OdbcColumn() {
 
 OdbcConnection::OdbcConnection(OdbcDb* pDb, HDBC pHandle, unicode_flag_t pUseUnicode) 
   : DbConnection(),
+    mRunningStmt(SQL_NULL_HSTMT),
     mHdbc(pHandle),
     mUseUnicode(pUseUnicode)
 {
@@ -243,43 +244,171 @@ OdbcConnection::execUpdate(const char* pSql) {
   return rowcnt;
 }
 
+OdbcConnection::param_style
+OdbcConnection::getParamStyle() const {
+  return PARAMS_QUESTION_MARK;
+};
+
+bool
+OdbcConnection::useWideChars() const {
+  switch(mUseUnicode) {
+    case DEBEA_UNICODE_ON:
+      return true;
+    case DEBEA_UNICODE_DEFAULT:
+      return mConvSpecs.mDbCharset == dba::ConvSpec::UTF8;
+    default:
+      return false;
+  };
+};
+
+dba::DbStatement*
+OdbcConnection::prepare(const char* pSql) {
+  dba::CHandle<HSTMT,HSTMTDealloc> hstmt(createHstmt());
+  if (hstmt.ptr() == SQL_NULL_HSTMT)
+    return NULL;
+  SQLRETURN ret;
+  if (useWideChars()) {
+    wchar_t* wquery = CPToWideChar(pSql);
+    ret = SQLPrepareW(hstmt, wquery, SQL_NTS);
+    delete [] wquery;
+  } else {
+    ret = SQLPrepare(hstmt, (SQLCHAR*)pSql, SQL_NTS);
+  };
+  if (!SQL_SUCCEEDED(ret)) {
+    handleStatementError(hstmt.ptr(), "SQLPrepare", this);
+    return NULL;
+  };
+  return new OdbcStatement(hstmt.release());
+};
+
+bool
+OdbcConnection::doSQLExecute(HSTMT pHstmt, const dba::DbParams& pParams) {
+  bool wide = useWideChars();
+  //buffers have to be valid until SQLExecute returns
+  std::vector<SQLLEN> lengths(pParams.size(), SQL_NTS);
+  std::vector<wchar_t*> wvalues(pParams.size(), (wchar_t*)NULL);
+  SQLRETURN ret = SQL_SUCCESS;
+  for(size_t i = 0; i < pParams.size() && SQL_SUCCEEDED(ret); i++) {
+    const dba::DbParam& param(pParams[i]);
+    SQLSMALLINT sqlType;
+    switch(param.mType) {
+      case dba::DbParam::INTEGER:
+        sqlType = SQL_INTEGER;
+      break;
+      case dba::DbParam::FLOAT:
+        sqlType = SQL_DOUBLE;
+      break;
+      default:
+        sqlType = wide ? SQL_WVARCHAR : SQL_VARCHAR;
+      break;
+    };
+    SQLULEN size = param.mValue.size() == 0 ? 1 : param.mValue.size();
+    if (param.mIsNull) {
+      lengths[i] = SQL_NULL_DATA;
+      ret = SQLBindParameter(pHstmt, i + 1, SQL_PARAM_INPUT, SQL_C_CHAR, sqlType, 1, 0, NULL, 0, &lengths[i]);
+    } else if (wide && param.mType == dba::DbParam::TEXT) {
+      wvalues[i] = CPToWideChar(param.mValue.c_str());
+      ret = SQLBindParameter(pHstmt, i + 1, SQL_PARAM_INPUT, SQL_C_WCHAR, sqlType, size, 0, wvalues[i], 0, &lengths[i]);
+    } else {
+      ret = SQLBindParameter(pHstmt, i + 1, SQL_PARAM_INPUT, SQL_C_CHAR, sqlType, size, 0, (SQLPOINTER)param.mValue.c_str(), 0, &lengths[i]);
+    };
+  };
+  if (SQL_SUCCEEDED(ret)) {
+    setRunningStmt(pHstmt);
+    ret = SQLExecute(pHstmt);
+    setRunningStmt(SQL_NULL_HSTMT);
+  };
+  for(size_t i = 0; i < wvalues.size(); i++)
+    delete [] wvalues[i];
+  if (!SQL_SUCCEEDED(ret) && ret != SQL_NO_DATA) {
+    std::string err(getDiagnosticMessages(SQL_HANDLE_STMT, pHstmt, "SQLExecute"));
+    SQLFreeStmt(pHstmt, SQL_RESET_PARAMS);
+    SQLFreeStmt(pHstmt, SQL_CLOSE);
+    handleError(dba::DBA_SQL_ERROR, err.c_str());
+    return false;
+  };
+  SQLFreeStmt(pHstmt, SQL_RESET_PARAMS);
+  return true;
+};
+
+dba::DbResult*
+OdbcConnection::execPreparedQuery(const dba::shared_ptr<dba::DbStatement>& pStmt, const dba::DbParams& pParams) {
+  HSTMT hstmt = ((OdbcStatement*)pStmt.ptr())->mHstmt;
+  if (!doSQLExecute(hstmt, pParams))
+    return NULL;
+  return new OdbcResult(this, hstmt, pStmt);
+};
+
+int
+OdbcConnection::execPreparedUpdate(const dba::shared_ptr<dba::DbStatement>& pStmt, const dba::DbParams& pParams) {
+  HSTMT hstmt = ((OdbcStatement*)pStmt.ptr())->mHstmt;
+  if (!doSQLExecute(hstmt, pParams))
+    return -1;
+  SQLLEN rowcnt = -1;
+  SQLRETURN ret = SQLRowCount(hstmt, &rowcnt);
+  SQLFreeStmt(hstmt, SQL_CLOSE);
+  if (!SQL_SUCCEEDED(ret))
+    handleStatementError(hstmt, "execPreparedUpdate (get affected rows)", this);
+  return rowcnt;
+};
+
+void
+OdbcConnection::setRunningStmt(HSTMT pStmt) {
+  dba::MutexLocker lock(mCancelMutex);
+  mRunningStmt = pStmt;
+};
+
+bool
+OdbcConnection::cancel() {
+  dba::MutexLocker lock(mCancelMutex);
+  if (mRunningStmt != SQL_NULL_HSTMT)
+    SQLCancel(mRunningStmt);
+  return true;
+};
 
 HSTMT 
 OdbcConnection::doSQLExec(const char* pSql) {
   dba::CHandle<HSTMT,HSTMTDealloc> hstmt(createHstmt());
   SQLRETURN ret;
   wchar_t* wquery = NULL;
-  switch(mUseUnicode) {
-    case DEBEA_UNICODE_DEFAULT:
-      if (mConvSpecs.mDbCharset == dba::ConvSpec::UTF8) {
-        wchar_t* wquery = CPToWideChar(pSql);
-        ret = SQLExecDirectW(hstmt, wquery, SQL_NTS);
-        delete [] wquery;
-      } else {
-        //it is always better to use unicode version of 
-        //SQLExcecDirect if we are able to convert 
-        //multibyte data ourselfs
-        DbBase* parent = getParentErrorHandler();
-        setParentErrorHandler(NULL);
-        wchar_t* wquery = CPToWideChar(pSql);
-        setParentErrorHandler(parent);
-        if (wquery != NULL) {
+  setRunningStmt(hstmt.ptr());
+  try {
+    switch(mUseUnicode) {
+      case DEBEA_UNICODE_DEFAULT:
+        if (mConvSpecs.mDbCharset == dba::ConvSpec::UTF8) {
+          wchar_t* wquery = CPToWideChar(pSql);
           ret = SQLExecDirectW(hstmt, wquery, SQL_NTS);
-        } else  {
-          ret = SQLExecDirect(hstmt, (SQLCHAR*)pSql, SQL_NTS);
+          delete [] wquery;
+        } else {
+          //it is always better to use unicode version of 
+          //SQLExcecDirect if we are able to convert 
+          //multibyte data ourselfs
+          DbBase* parent = getParentErrorHandler();
+          setParentErrorHandler(NULL);
+          wchar_t* wquery = CPToWideChar(pSql);
+          setParentErrorHandler(parent);
+          if (wquery != NULL) {
+            ret = SQLExecDirectW(hstmt, wquery, SQL_NTS);
+          } else  {
+            ret = SQLExecDirect(hstmt, (SQLCHAR*)pSql, SQL_NTS);
+          };
+          delete [] wquery;
         };
+      break;
+      case DEBEA_UNICODE_ON: {
+        wchar_t* wquery = CPToWideChar(pSql);
+        ret = SQLExecDirectW(hstmt, wquery, SQL_NTS);
         delete [] wquery;
-      };
-    break;
-    case DEBEA_UNICODE_ON: {
-      wchar_t* wquery = CPToWideChar(pSql);
-      ret = SQLExecDirectW(hstmt, wquery, SQL_NTS);
-      delete [] wquery;
-    } break;
-    case DEBEA_UNICODE_OFF:
-      ret = SQLExecDirect(hstmt, (SQLCHAR*)pSql, SQL_NTS);
-    break;
+      } break;
+      case DEBEA_UNICODE_OFF:
+        ret = SQLExecDirect(hstmt, (SQLCHAR*)pSql, SQL_NTS);
+      break;
+    };
+  } catch(...) {
+    setRunningStmt(SQL_NULL_HSTMT);
+    throw;
   };
+  setRunningStmt(SQL_NULL_HSTMT);
   if (ret != SQL_SUCCESS && ret != SQL_NO_DATA) {
     if (ret != SQL_SUCCESS_WITH_INFO) {
       handleStatementError(hstmt.ptr(), "SQLExec", this);
@@ -486,6 +615,8 @@ OdbcConnection::setAutoCommit(bool pFlag) {
 
 void 
 OdbcConnection::disconnect() {
+  //statement handles have to be freed before SQLDisconnect
+  clearStatementCache();
   //do nothing if already disconnected
   if (!isValid())
     return;
@@ -743,6 +874,12 @@ OdbcResult::fetchRow() {
 
 OdbcResult::~OdbcResult() {
   delete[] mColumns;
+  if (mStatement.ptr() != NULL) {
+    //handle is owned by cached statement
+    SQLFreeStmt(mHstmt.ptr(), SQL_CLOSE);
+    mHstmt.release();
+    mStatement->setBusy(false);
+  };
 }
 
 void 
@@ -982,15 +1119,22 @@ OdbcResult::ColumnData::~ColumnData() {
   cleanup();
 };
 
-OdbcResult::OdbcResult(OdbcConnection* pConn, HSTMT pHstmt) 
+OdbcResult::OdbcResult(OdbcConnection* pConn, HSTMT pHstmt, const dba::shared_ptr<dba::DbStatement>& pStmt) 
   : mHstmt(pHstmt),
+    mStatement(pStmt),
     mColumns(0)
 {
   setParentErrorHandler(pConn);
   setConversionSpecs(pConn->getConversionSpecs());
   SQLSMALLINT num_cols;
   if (SQLNumResultCols(mHstmt, &num_cols) != SQL_SUCCESS) {
-    handleStatementError(mHstmt, "SQLNumResultCols",this);
+    if (mStatement.ptr() != NULL) {
+      //handle is still owned by cached statement
+      SQLFreeStmt(pHstmt, SQL_CLOSE);
+      mHstmt.release();
+      mStatement = dba::shared_ptr<dba::DbStatement>();
+    };
+    handleStatementError(pHstmt, "SQLNumResultCols",this);
     return;
   }
   mNumCols = num_cols;
@@ -998,6 +1142,8 @@ OdbcResult::OdbcResult(OdbcConnection* pConn, HSTMT pHstmt)
   for (UWORD i = 0; i < num_cols; i++) {
     initColumnsData();
   }
+  if (mStatement.ptr() != NULL)
+    mStatement->setBusy(true);
 }
 
 
@@ -24,6 +24,7 @@
 #include "dba/convspec.h"
 #include "dba/database.h"
 #include "dba/chandle.h"
+#include "dba/thread.h"
 
 namespace odbc {
 
@@ -60,6 +61,18 @@ class HENVDealloc {
 };
 
 
+/**
+  Statement handle prepared with SQLPrepare and kept in statement cache
+*/
+class OdbcStatement : public dba::DbStatement {
+  public:
+    OdbcStatement(HSTMT pHstmt) : mHstmt(pHstmt) {};
+    virtual ~OdbcStatement() {
+      SQLFreeHandle(SQL_HANDLE_STMT, mHstmt);
+    };
+    HSTMT mHstmt;
+};
+
 class OdbcDb : public dba::Database  {
   public:
     /**
@@ -111,9 +124,15 @@ class OdbcConnection : public dba::DbConnection {
     virtual void disconnect();
     virtual bool isValid() const;
     virtual std::list<std::string> getRelationNames();
+    virtual bool cancel();
+    virtual param_style getParamStyle() const;
     virtual ~OdbcConnection();
   private:
     HSTMT createHstmt();
+    //!statement executed by doSQLExec, protected by mCancelMutex
+    HSTMT mRunningStmt;
+    dba::Mutex mCancelMutex;
+    void setRunningStmt(HSTMT pStmt);
     HSTMT doSQLExec(const char* pSql);
     void setAutoCommit(bool pFlag);
     //!ODBC handle
@@ -130,6 +149,18 @@ class OdbcConnection : public dba::DbConnection {
     @returns affected rows
     */
     virtual int execUpdate(const char* pSql);
+    virtual dba::DbStatement* prepare(const char* pSql);
+    virtual dba::DbResult* execPreparedQuery(const dba::shared_ptr<dba::DbStatement>& pStmt, const dba::DbParams& pParams);
+    virtual int execPreparedUpdate(const dba::shared_ptr<dba::DbStatement>& pStmt, const dba::DbParams& pParams);
+    /**
+      Bind parameters and execute prepared statement
+      @return false if execution failed and error handler did not throw
+    */
+    bool doSQLExecute(HSTMT pHstmt, const dba::DbParams& pParams);
+    /**
+      Check if strings should be sent to driver as wide chars
+    */
+    bool useWideChars() const;
     /**
       Perform conversion from UTF8 to wide char for odbc
     */
@@ -258,6 +289,9 @@ class OdbcResult : public dba::DbResult {
     
     //!ODBC handle wrapped in exception-safe pointer
     dba::CHandle<HSTMT,HSTMTDealloc> mHstmt;
+
+    //!cached statement that owns mHstmt, handle is not freed by result
+    dba::shared_ptr<dba::DbStatement> mStatement;
     
     //!description of columns and buffers for retrieved data
     ColumnData* mColumns;
@@ -274,7 +308,7 @@ class OdbcResult : public dba::DbResult {
     /**
       Constructor.    
     */
-    OdbcResult(OdbcConnection* pConn, HSTMT pHstmt);
+    OdbcResult(OdbcConnection* pConn, HSTMT pHstmt, const dba::shared_ptr<dba::DbStatement>& pStmt = dba::shared_ptr<dba::DbStatement>());
     /**
       Perform conversion from wide char to UTF8 for dba
     */
@@ -12,6 +12,7 @@
 
 #include "dba/postgres.h"
 #include "dba/conversion.h"
+#include "dba/civiltime.h"
 
 using namespace std;
 using namespace dba;
@@ -23,6 +24,101 @@ parseDate(const char* pDate) {
     return parseISODateTime(pDate);
 };
 
+#ifdef _MSC_VER
+typedef __int64 pg_int64;
+typedef unsigned __int64 pg_uint64;
+#else
+typedef long long pg_int64;
+typedef unsigned long long pg_uint64;
+#endif
+
+//oids of builtin types from server pg_type.h that are decoded from binary format
+enum {
+  PG_BOOL = 16,
+  PG_NAME = 19,
+  PG_INT8 = 20,
+  PG_INT2 = 21,
+  PG_INT4 = 23,
+  PG_TEXT = 25,
+  PG_OID = 26,
+  PG_FLOAT4 = 700,
+  PG_FLOAT8 = 701,
+  PG_BPCHAR = 1042,
+  PG_VARCHAR = 1043,
+  PG_DATE = 1082,
+  PG_TIMESTAMP = 1114
+};
+
+//dates and timestamps are counted from 2000-01-01
+static const long PG_EPOCH_DAYS = 10957;
+static const pg_int64 USECS_PER_SEC = 1000000;
+
+//binary values are sent in network byte order
+static pg_uint64
+readBinary(const char* pData, int pSize) {
+  pg_uint64 val = 0;
+  for(int i = 0; i < pSize; i++)
+    val = (val << 8) | (unsigned char)pData[i];
+  return val;
+};
+
+static pg_int64
+readBinaryInt(const char* pData, Oid pType) {
+  switch(pType) {
+    case PG_INT2: return (short)readBinary(pData,2);
+    case PG_INT4: return (int)readBinary(pData,4);
+    case PG_OID: return (unsigned int)readBinary(pData,4);
+    default: return (pg_int64)readBinary(pData,8);
+  };
+};
+
+static double
+readBinaryDouble(const char* pData, Oid pType) {
+  if (pType == PG_FLOAT4) {
+    unsigned int bits = (unsigned int)readBinary(pData,4);
+    float val;
+    memcpy(&val,&bits,sizeof(val));
+    return val;
+  };
+  pg_uint64 bits = readBinary(pData,8);
+  double val;
+  memcpy(&val,&bits,sizeof(val));
+  return val;
+};
+
+//returns microseconds part of timestamp
+static long
+readBinaryDate(const char* pData, Oid pType, tm& pDate) {
+  long usecs = 0;
+  time_t secs;
+  if (pType == PG_DATE) {
+    int days = (int)readBinary(pData,4);
+    //infinity and -infinity
+    if (days == 0x7fffffff || days == -0x7fffffff - 1)
+      throw ConversionException("Cannot convert infinite date");
+    secs = (time_t)(days + PG_EPOCH_DAYS) * 86400;
+  } else {
+    pg_uint64 bits = readBinary(pData,8);
+    //infinity and -infinity are stored as largest and smallest 64-bit values
+    if (bits == (~(pg_uint64)0 >> 1) || bits == ~(~(pg_uint64)0 >> 1))
+      throw ConversionException("Cannot convert infinite timestamp");
+    pg_int64 val = (pg_int64)bits;
+    pg_int64 sec = val / USECS_PER_SEC;
+    usecs = (long)(val % USECS_PER_SEC);
+    if (usecs < 0) {
+      sec--;
+      usecs += USECS_PER_SEC;
+    };
+    secs = (time_t)(sec + PG_EPOCH_DAYS * 86400L);
+  };
+  timeToCivil(secs,pDate);
+  //the same as from parseISODateTime
+  pDate.tm_isdst = -1;
+  pDate.tm_wday = 0;
+  pDate.tm_yday = 0;
+  return usecs;
+};
+
 /*-----------------------------------------------------------*/
 
 const char*
@@ -36,7 +132,11 @@ getError(PGconn* pConn) {
 
 PgResult*
 PgConn::sendPgQuery(PGconn* conn,const char* sql) {
-  PGresult* res = PQexec(conn,sql);
+  return queryResult(PQexec(conn,sql));
+}
+
+PgResult*
+PgConn::queryResult(PGresult* res) {
   if (!res) {
     handleError(DBA_DB_ERROR,"Failed to create query result object");
     return NULL;
@@ -69,7 +169,11 @@ PgConn::sendPgQuery(PGconn* conn,const char* sql) {
 
 int
 PgConn::execUpdate(const char* sql) {
-  PGresult* res = PQexec(connHandle,sql);
+  return updateResult(PQexec(connHandle,sql));
+}
+
+int
+PgConn::updateResult(PGresult* res) {
   if (!res) {
     handleError(DBA_DB_ERROR,"Failed to create query result object");
     return -1;
@@ -103,6 +207,107 @@ PgConn::execUpdate(const char* sql) {
   return -1;
 }
 
+PgConn::param_style
+PgConn::getParamStyle() const {
+  return PARAMS_NUMBERED;
+};
+
+DbStatement*
+PgConn::prepare(const char* pSql) {
+  std::string name("dba_stmt_" + toStr(++mStatementCounter));
+  //parameter types are inferred by server
+  PGresult* res = PQprepare(connHandle,name.c_str(),pSql,0,NULL);
+  if (!res) {
+    handleError(DBA_DB_ERROR,"Failed to create query result object");
+    return NULL;
+  };
+  if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+    string s(PQresultErrorMessage(res));
+    PQclear(res);
+    if (PQstatus(connHandle) == CONNECTION_OK)
+      handleError(DBA_SQL_ERROR,s.c_str());
+    handleError(DBA_DB_ERROR,s.c_str());
+    return NULL;
+  };
+  PQclear(res);
+  bool binary = false;
+#ifdef DBA_PGSQL_BINARY
+  //result columns are decoded from binary format if all of them have known types.
+  //Decoders are experimental and not covered by tests, so binary results
+  //have to be enabled at compile time
+  res = PQdescribePrepared(connHandle,name.c_str());
+  if (res != NULL) {
+    binary = PQresultStatus(res) == PGRES_COMMAND_OK && hasBinaryResult(res);
+    PQclear(res);
+  };
+#endif
+  return new PgStatement(this,name,binary);
+};
+
+bool
+PgConn::hasBinaryResult(PGresult* pDescription) const {
+  int fields = PQnfields(pDescription);
+  if (fields == 0)
+    return false;
+  for(int i = 0; i < fields; i++) {
+    switch(PQftype(pDescription,i)) {
+      case PG_BOOL:
+      case PG_NAME:
+      case PG_INT8:
+      case PG_INT2:
+      case PG_INT4:
+      case PG_TEXT:
+      case PG_OID:
+      case PG_FLOAT4:
+      case PG_FLOAT8:
+      case PG_BPCHAR:
+      case PG_VARCHAR:
+      case PG_DATE:
+      break;
+      //old servers send timestamps as doubles
+      case PG_TIMESTAMP:
+        if (!mIntegerDatetimes)
+          return false;
+      break;
+      default:
+        return false;
+    };
+  };
+  return true;
+};
+
+PGresult*
+PgConn::execPgPrepared(const dba::shared_ptr<DbStatement>& pStmt, const DbParams& pParams) {
+  std::vector<const char*> values(pParams.size());
+  for(size_t i = 0; i < pParams.size(); i++)
+    values[i] = pParams[i].mIsNull ? NULL : pParams[i].mValue.c_str();
+  const PgStatement* stmt = (const PgStatement*)pStmt.ptr();
+  return PQexecPrepared(connHandle,stmt->mName.c_str(),values.size(),values.empty() ? NULL : &values[0],NULL,NULL,stmt->mBinary ? 1 : 0);
+};
+
+DbResult*
+PgConn::execPreparedQuery(const dba::shared_ptr<DbStatement>& pStmt, const DbParams& pParams) {
+  return queryResult(execPgPrepared(pStmt,pParams));
+};
+
+int
+PgConn::execPreparedUpdate(const dba::shared_ptr<DbStatement>& pStmt, const DbParams& pParams) {
+  return updateResult(execPgPrepared(pStmt,pParams));
+};
+
+void
+PgConn::deallocate(const std::string& pName) {
+  //statements are freed by server when connection is closed
+  if (connHandle.ptr() == NULL || PQstatus(connHandle) != CONNECTION_OK)
+    return;
+  PGresult* res = PQexec(connHandle,("DEALLOCATE " + pName).c_str());
+  if (res != NULL)
+    PQclear(res);
+};
+
+PgStatement::~PgStatement() {
+  mOwner->deallocate(mName);
+};
 
 DbConnection*
 Db::getConnection(const char* pParams) {
@@ -134,10 +339,156 @@ Db::getConnection(const char* pParams) {
 };
 
 PgConn::PgConn(PGconn* pConn) 
-  : connHandle(pConn) 
+  : connHandle(pConn),
+    mCancel(PQgetCancel(pConn)),
+    mStatementCounter(0),
+    mIntegerDatetimes(false),
+    mInTransaction(false),
+    mPipelined(0)
+#ifdef LIBPQ_HAS_PIPELINING
+    ,mPipelineMode(false)
+#endif
 {
+  const char* datetimes = PQparameterStatus(pConn,"integer_datetimes");
+  mIntegerDatetimes = datetimes != NULL && !strcmp(datetimes,"on");
 };
 
+//Maximum number of commands sent without reading results. libpq connection is
+//blocking, so we cannot let server fill socket buffers with results while
+//we are still sending commands.
+static const int sMaxPipelined = 512;
+
+#ifdef LIBPQ_HAS_PIPELINING
+
+bool
+PgConn::execPipelined(const char* pSql) {
+  if (!mInTransaction || mPipelined >= sMaxPipelined)
+    return false;
+  if (!mPipelineMode) {
+    if (PQenterPipelineMode(connHandle) != 1)
+      return false;
+    mPipelineMode = true;
+  };
+  if (PQsendQueryParams(connHandle,pSql,0,NULL,NULL,NULL,NULL,0) != 1) {
+    if (mPipelined == 0) {
+      PQexitPipelineMode(connHandle);
+      mPipelineMode = false;
+    };
+    handleError(DBA_DB_ERROR,getError(connHandle));
+    return false;
+  };
+  mPipelined++;
+  return true;
+};
+
+void
+PgConn::pipelineSync() {
+  if (PQpipelineSync(connHandle) != 1)
+    handleError(DBA_DB_ERROR,getError(connHandle));
+};
+
+int
+PgConn::pipelineResult(std::string& pError) {
+  PGresult* res = PQgetResult(connHandle);
+  if (res == NULL) {
+    pError = getError(connHandle);
+    return -1;
+  };
+  int ret = -1;
+  switch(PQresultStatus(res)) {
+    case PGRES_COMMAND_OK:
+      convert(PQcmdTuples(res),ret);
+    break;
+    case PGRES_TUPLES_OK:
+      ret = PQntuples(res);
+    break;
+    case PGRES_PIPELINE_ABORTED:
+      pError = "command not executed because previous command failed";
+    break;
+    default:
+      pError = PQresultErrorMessage(res);
+    break;
+  };
+  PQclear(res);
+  //end of results for this command
+  res = PQgetResult(connHandle);
+  if (res != NULL)
+    PQclear(res);
+  return ret;
+};
+
+void
+PgConn::pipelineEnd() {
+  mPipelined = 0;
+  //PGRES_PIPELINE_SYNC
+  PGresult* res = PQgetResult(connHandle);
+  while(res != NULL && PQresultStatus(res) != PGRES_PIPELINE_SYNC) {
+    PQclear(res);
+    res = PQgetResult(connHandle);
+  };
+  if (res != NULL)
+    PQclear(res);
+  mPipelineMode = false;
+  if (PQexitPipelineMode(connHandle) != 1 || PQstatus(connHandle) != CONNECTION_OK)
+    handleError(DBA_DB_ERROR,getError(connHandle));
+};
+
+#else
+
+bool
+PgConn::execPipelined(const char* pSql) {
+  if (!mInTransaction || mPipelined >= sMaxPipelined)
+    return false;
+  mBatch += pSql;
+  mBatch += ";\n";
+  mPipelined++;
+  return true;
+};
+
+void
+PgConn::pipelineSync() {
+  std::string batch;
+  batch.swap(mBatch);
+  if (PQsendQuery(connHandle,batch.c_str()) != 1)
+    handleError(DBA_DB_ERROR,getError(connHandle));
+};
+
+int
+PgConn::pipelineResult(std::string& pError) {
+  //server stops executing multi statement query on first error
+  PGresult* res = PQgetResult(connHandle);
+  if (res == NULL) {
+    pError = "command not executed because previous command failed";
+    return -1;
+  };
+  int ret = -1;
+  switch(PQresultStatus(res)) {
+    case PGRES_COMMAND_OK:
+      convert(PQcmdTuples(res),ret);
+    break;
+    case PGRES_TUPLES_OK:
+      ret = PQntuples(res);
+    break;
+    default:
+      pError = PQresultErrorMessage(res);
+    break;
+  };
+  PQclear(res);
+  return ret;
+};
+
+void
+PgConn::pipelineEnd() {
+  mPipelined = 0;
+  PGresult* res;
+  while((res = PQgetResult(connHandle)) != NULL)
+    PQclear(res);
+  if (PQstatus(connHandle) != CONNECTION_OK)
+    handleError(DBA_DB_ERROR,getError(connHandle));
+};
+
+#endif
+
 DbResult*
 PgConn::execQuery(const char* sql) {
   PgResult* r = sendPgQuery(connHandle,sql);
@@ -146,7 +497,22 @@ PgConn::execQuery(const char* sql) {
 
 void
 PgConn::disconnect() {
+  if (mCancel != NULL) {
+    PQfreeCancel(mCancel);
+    mCancel = NULL;
+  };
   connHandle.reset();
+  clearStatementCache();
+};
+
+bool
+PgConn::cancel() {
+  if (mCancel == NULL)
+    return false;
+  char error[256];
+  //result is ignored, it is possible that query already finished
+  PQcancel(mCancel,error,sizeof(error));
+  return true;
 };
 
 bool
@@ -174,7 +540,8 @@ PgResult::discover_size(PGresult* res, int col) {
 };
 
 PgResult::PgResult(PgConn* pOwner, PGresult* res) 
-  : mvRes(res) 
+  : mvRes(res),
+    mBinary(PQbinaryTuples(res) == 1)
 {
   setConversionSpecs(pOwner->getConversionSpecs());
   setParentErrorHandler(pOwner);
@@ -185,27 +552,100 @@ PgResult::PgResult(PgConn* pOwner, PGresult* res)
   for(int i = 0; i < fields;i++) {
     PgColumn* col = new PgColumn(PQfname(res,i),PQftype(res,i),PQfmod(res,i),mConvSpecs.mDbCharset);
     PgColumns.insert(make_pair(i,col));
+    if (mBinary)
+      mTypes.push_back(PQftype(res,i));
+  };
+  if (mBinary)
+    mText.resize(fields);
+};
+
+const char*
+PgResult::getText(int pField) const {
+  const char* data = PQgetvalue(mvRes,currentRow,pField);
+  if (!mBinary)
+    return data;
+  //text of binary values is the same as sent by server in text format
+  char buf[DATE_BUFFER_SIZE];
+  int len = 0;
+  switch(mTypes[pField]) {
+    case PG_BOOL:
+      return *data ? "t" : "f";
+    case PG_INT2:
+    case PG_INT4:
+    case PG_INT8:
+    case PG_OID:
+      len = formatInt((long)readBinaryInt(data,mTypes[pField]),buf);
+    break;
+    case PG_FLOAT4:
+      len = formatFloat((float)readBinaryDouble(data,PG_FLOAT4),buf);
+    break;
+    case PG_FLOAT8:
+      len = formatDouble(readBinaryDouble(data,PG_FLOAT8),buf);
+    break;
+    case PG_DATE:
+    case PG_TIMESTAMP: {
+      tm date;
+      long usecs = readBinaryDate(data,mTypes[pField],date);
+      if (mTypes[pField] == PG_DATE) {
+        len = formatISODate(date,buf);
+        break;
+      };
+      len = formatISODateTime(date,buf);
+      if (usecs != 0) {
+        //fraction without trailing zeros
+        buf[len++] = '.';
+        for(long div = USECS_PER_SEC / 10; usecs != 0; div /= 10) {
+          buf[len++] = '0' + usecs / div;
+          usecs %= div;
+        };
+      };
+    } break;
+    default:
+      return data;
   };
+  mText[pField].assign(buf,len);
+  return mText[pField].c_str();
 };
 
 const char*
 PgResult::doGetString(int pField) const {
-  const char* ptr = PQgetvalue(mvRes,currentRow,pField);
-  return ptr;
+  try {
+    return getText(pField);
+  } catch (const ConversionException& pEx) {
+    handleError(DBA_DB_ERROR,pEx.what());
+  };
+  return NULL;
 };
 
 long
 PgResult::doGetInt(int pField) const {
   long val;
   try {
-    const char* ptr = PQgetvalue(mvRes,currentRow,pField);
-    struct lconv* l = localeconv();
-    char* lptr = l->decimal_point;
-    char* pos = strchr((char*)ptr,*lptr);
-    if (pos != NULL) {
-      *pos = '\0';    
+    if (mBinary) {
+      const char* data = PQgetvalue(mvRes,currentRow,pField);
+      switch(mTypes[pField]) {
+        case PG_BOOL:
+          return *data ? 1 : 0;
+        case PG_INT2:
+        case PG_INT4:
+        case PG_INT8:
+        case PG_OID:
+          return (long)readBinaryInt(data,mTypes[pField]);
+        //fraction is truncated like in text format
+        case PG_FLOAT4:
+        case PG_FLOAT8:
+          return (long)readBinaryDouble(data,mTypes[pField]);
+        default:
+        break;
+      };
     };
-    convert(ptr,val);
+    const char* ptr = getText(pField);
+    //fraction is truncated, value owned by libpq is not modified
+    const char* end = ptr;
+    while(*end != '\0' && *end != '.' && *end != mConvSpecs.mDecimalPoint)
+      end++;
+    if (!parseInt(ptr,end,val))
+      throw ConversionException(std::string("cannot convert ") + ptr);
   } catch (const ConversionException& pEx) {
     handleError(DBA_DB_ERROR,pEx.what());
   };
@@ -214,11 +654,24 @@ PgResult::doGetInt(int pField) const {
 
 double
 PgResult::doGetDouble(int pField) const {
-  char* ptr = NULL;
   double val;
   try {
-    ptr = PQgetvalue(mvRes,currentRow,pField);
-    convert(ptr,val,&mConvSpecs.mDecimalPoint);
+    if (mBinary) {
+      const char* data = PQgetvalue(mvRes,currentRow,pField);
+      switch(mTypes[pField]) {
+        case PG_INT2:
+        case PG_INT4:
+        case PG_INT8:
+        case PG_OID:
+          return (double)readBinaryInt(data,mTypes[pField]);
+        case PG_FLOAT4:
+        case PG_FLOAT8:
+          return readBinaryDouble(data,mTypes[pField]);
+        default:
+        break;
+      };
+    };
+    convert(getText(pField),val,&mConvSpecs.mDecimalPoint);
   } catch (const ConversionException& pEx) {
     handleError(DBA_DB_ERROR,pEx.what());
   };
@@ -228,7 +681,12 @@ PgResult::doGetDouble(int pField) const {
 struct tm
 PgResult::doGetDate(int pField) const {
   try {
-    return parseDate(PQgetvalue(mvRes,currentRow,pField));
+    if (mBinary && (mTypes[pField] == PG_DATE || mTypes[pField] == PG_TIMESTAMP)) {
+      tm date;
+      readBinaryDate(PQgetvalue(mvRes,currentRow,pField),mTypes[pField],date);
+      return date;
+    };
+    return parseDate(getText(pField));
   } catch (const ConversionException& pEx) {
     handleError(DBA_DB_ERROR,pEx.what());
     //cannot use static DbResult::sInvalidTm in dll
@@ -270,16 +728,21 @@ PgConn::getRelationNames() {
 
 void
 PgConn::commit() {
+  //sendUpdate synchronizes pipelined commands first
+  mInTransaction = false;
   sendUpdate("COMMIT");
 };
 
 void
 PgConn::begin() {
   sendUpdate("BEGIN");
+  mInTransaction = true;
 };
 
 void
 PgConn::rollback() {
+  mInTransaction = false;
+  discardUpdates();
   sendUpdate("ROLLBACK");
 };
 
@@ -304,6 +767,12 @@ PgResult::fetchRow() {
   return true;
 };
 
+void
+PgResult::cancel() {
+  //all rows are already transferred by PQexec
+  currentRow = mvRows;
+};
+
 PgResult::~PgResult() {
   for(PgColsType::iterator it = PgColumns.begin(); it != PgColumns.end(); it++)
     delete (*it).second;
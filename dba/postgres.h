@@ -14,6 +14,7 @@
 #include "dba/plugininfo.h"
 #include "dba/chandle.h"
 #include <map>
+#include <vector>
 
 extern "C" {
   #include <libpq-fe.h>
@@ -21,6 +22,12 @@ extern "C" {
 
 /**
   PosgtreSQL driver for dba library
+
+  @warning Binary results of prepared statements (DBA_PGSQL_BINARY, configure
+  --enable-pgsql-binary) are experimental. Decoders of binary integer, float and
+  date/time values are not covered by tests and were not checked against all
+  server versions and integer_datetimes settings. Without DBA_PGSQL_BINARY all
+  results are transferred in text format.
 */
 
 namespace postgres {
@@ -53,6 +60,23 @@ class PgColumn : public dba::DbColumn {
 };
 
 
+class PgConn;
+
+/**
+  Named prepared statement. Statement is deallocated on server
+  when it is removed from statement cache.
+*/
+class PgStatement : public dba::DbStatement {
+  public:
+    PgStatement(PgConn* pOwner, const std::string& pName, bool pBinary) : mOwner(pOwner), mName(pName), mBinary(pBinary) {};
+    virtual ~PgStatement();
+    PgConn* mOwner;
+    std::string mName;
+    //!true if all result columns are decoded from binary format. Binary results
+    //!are experimental and requested only if library is compiled with DBA_PGSQL_BINARY
+    bool mBinary;
+};
+
 class Db : public dba::Database  {
   public:
     virtual dba::DbConnection* getConnection(const char* pParams);
@@ -61,6 +85,7 @@ class Db : public dba::Database  {
 
 class PgConn : public dba::DbConnection {
   friend class Db;
+  friend class PgStatement;
   public:
     virtual std::list<std::string> getRelationNames();
     /**
@@ -73,11 +98,20 @@ class PgConn : public dba::DbConnection {
     virtual void rollback();
     virtual void disconnect();
     virtual bool isValid() const;
+    virtual bool cancel();
+    virtual param_style getParamStyle() const;
     virtual ~PgConn();
   private:
     PgConn(PGconn* pConn);
     dba::CHandle<PGconn*,PgConnFree> connHandle;
+    //!created with connection because PQgetCancel is not thread safe
+    PGcancel* mCancel;
     PgResult* sendPgQuery(PGconn* conn,const char* sql);
+    PgResult* queryResult(PGresult* pRes);
+    int updateResult(PGresult* pRes);
+    PGresult* execPgPrepared(const dba::shared_ptr<dba::DbStatement>& pStmt, const dba::DbParams& pParams);
+    bool hasBinaryResult(PGresult* pDescription) const;
+    void deallocate(const std::string& pName);
 
     /**
     Send query to server.
@@ -89,6 +123,28 @@ class PgConn : public dba::DbConnection {
     @returns affected rows
     */
     virtual int execUpdate(const char* pSql);
+    virtual bool execPipelined(const char* pSql);
+    virtual void pipelineSync();
+    virtual int pipelineResult(std::string& pError);
+    virtual void pipelineEnd();
+    virtual dba::DbStatement* prepare(const char* pSql);
+    virtual dba::DbResult* execPreparedQuery(const dba::shared_ptr<dba::DbStatement>& pStmt, const dba::DbParams& pParams);
+    virtual int execPreparedUpdate(const dba::shared_ptr<dba::DbStatement>& pStmt, const dba::DbParams& pParams);
+    //!used to create unique names of prepared statements
+    unsigned mStatementCounter;
+    //!true if server sends timestamps as 64-bit integers
+    bool mIntegerDatetimes;
+    //!true between begin() and commit() or rollback()
+    bool mInTransaction;
+    //!number of commands sent but not synchronized
+    int mPipelined;
+#ifdef LIBPQ_HAS_PIPELINING
+    //!true if connection is in libpq pipeline mode
+    bool mPipelineMode;
+#else
+    //!commands joined into one multi statement query sent by pipelineSync()
+    std::string mBatch;
+#endif
 };
 
 
@@ -109,6 +165,7 @@ class PgResult : public dba::DbResult {
     virtual int columns() const;
     virtual const dba::DbColumn& getColumn(int i) const;
     virtual bool fetchRow();
+    virtual void cancel();
     virtual ~PgResult();
   private:
     PgResult(PgConn* pOwner, PGresult*);
@@ -121,8 +178,17 @@ class PgResult : public dba::DbResult {
     virtual int getColumnIndex(const char* pField) const;
     virtual bool doCheckNull(int pField) const;
 
+    const char* getText(int pField) const;
+
     typedef std::map<int,PgColumn*> PgColsType;
     dba::CHandle<PGresult*,PgResFree> mvRes;
+    //!true if values are in binary format
+    bool mBinary;
+    //!types of columns, used to decode binary values
+    std::vector<Oid> mTypes;
+    //!binary values converted to text by doGetString. There is one buffer for
+    //!every column, so getString overwrites previous value of the same column
+    mutable std::vector<std::string> mText;
     int currentRow;
     int mvRows;
     PgColsType PgColumns;
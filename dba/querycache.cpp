@@ -0,0 +1,369 @@
+// File: querycache.cpp
+// Purpose: Cache of SQL query results
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#include <ctype.h>
+#include <string.h>
+#include "dba/querycache.h"
+#include "dba/conversion.h"
+#include "dba/exception.h"
+
+namespace dba {
+
+/**
+  Materialized query result. All strings are stored in one memory block,
+  fields are offsets to this block.
+*/
+class QueryCache::Entry : public RefCounted {
+  public:
+    static const unsigned int NullField = 0xffffffff;
+    Entry(const std::string& pQuery) : mQuery(pQuery), mColumns(0), mRows(0) {};
+    unsigned int add(const char* pStr) {
+      unsigned int pos = mData.size();
+      mData.insert(mData.end(), pStr, pStr + strlen(pStr) + 1);
+      return pos;
+    };
+    unsigned int getField(unsigned int pRow, int pColumn) const {
+      return mFields[pRow * mColumns + pColumn];
+    };
+    unsigned long getBytes() const {
+      return sizeof(Entry) + mQuery.size() + mData.size() 
+        + mFields.size() * sizeof(unsigned int) 
+        + mDates.size() * sizeof(int) 
+        + mDateValues.size() * sizeof(struct tm);
+    };
+    std::string mQuery;
+    std::vector<std::string> mTables;
+    std::vector<char> mData;
+    std::vector<unsigned int> mColumnNames;
+    std::vector<ConvSpec::charset> mColumnCharsets;
+    std::vector<unsigned int> mFields;
+    //index to mDateValues for every field or empty if there are no dates
+    std::vector<int> mDates;
+    std::vector<struct tm> mDateValues;
+    ConvSpec mSpecs;
+    int mColumns;
+    unsigned int mRows;
+    LruList::iterator mLru;
+};
+
+const unsigned int QueryCache::Entry::NullField;
+
+class QueryCache::CachedColumn : public DbColumn {
+  public:
+    CachedColumn(const char* pName, ConvSpec::charset pCharset) : DbColumn(pCharset), mName(pName) {};
+    virtual const char* getName() const { return mName; };
+  private:
+    const char* mName;
+};
+
+/**
+  DbResult that replays rows of cached result
+*/
+class QueryCache::CachedResult : public DbResult {
+  public:
+    CachedResult(const shared_ptr<Entry>& pEntry)
+      : mEntry(pEntry),
+        mRow(-1)
+    {
+      setConversionSpecs(mEntry->mSpecs);
+      for(int i = 0; i < mEntry->mColumns; i++)
+        mColumns.push_back(CachedColumn(&mEntry->mData[mEntry->mColumnNames[i]], mEntry->mColumnCharsets[i]));
+    };
+    virtual int columns() const { return mEntry->mColumns; };
+    virtual const DbColumn& getColumn(int pIndex) const { return mColumns[pIndex]; };
+    virtual int getColumnIndex(const char* pColumnName) const {
+      for(int i = 0; i < mEntry->mColumns; i++) {
+        if (!strcmp(mColumns[i].getName(), pColumnName))
+          return i;
+      };
+      throw DatabaseException(std::string("Column ") + pColumnName + " not found in cached result");
+    };
+    virtual void cancel() { mRow = mEntry->mRows; };
+    virtual bool fetchRow() {
+      if (mRow < (long)mEntry->mRows)
+        mRow++;
+      return mRow < (long)mEntry->mRows;
+    };
+  protected:
+    const char* field(int pField) const {
+      if (mRow < 0 || mRow >= (long)mEntry->mRows)
+        throw DatabaseException("row not fetched. Call fetchRow() first.");
+      return &mEntry->mData[mEntry->getField(mRow, pField)];
+    };
+    virtual long doGetInt(int pField) const {
+      const char* val = field(pField);
+      //the same as postgres driver - fraction is truncated
+      const char* end = val + strcspn(val,".,");
+      long ret;
+      if (!parseInt(val,end,ret))
+        throw DatabaseException(std::string("cannot convert ") + val);
+      return ret;
+    };
+    virtual const char* doGetString(int pField) const { return field(pField); };
+    virtual double doGetDouble(int pField) const {
+      double ret;
+      try {
+        convert(field(pField), ret, &mConvSpecs.mDecimalPoint);
+      } catch (const ConversionException& pEx) {
+        throw DatabaseException(pEx.what());
+      };
+      return ret;
+    };
+    virtual struct tm doGetDate(int pField) const {
+      const char* val = field(pField);
+      if (!mEntry->mDates.empty()) {
+        int idx = mEntry->mDates[mRow * mEntry->mColumns + pField];
+        if (idx >= 0)
+          return mEntry->mDateValues[idx];
+      };
+      try {
+        return parseISODateTime(val);
+      } catch (const ConversionException& pEx) {
+        throw DatabaseException(pEx.what());
+      };
+    };
+    virtual bool doCheckNull(int pField) const {
+      if (mRow < 0 || mRow >= (long)mEntry->mRows)
+        throw DatabaseException("row not fetched. Call fetchRow() first.");
+      return mEntry->getField(mRow, pField) == Entry::NullField;
+    };
+  private:
+    shared_ptr<Entry> mEntry;
+    std::vector<CachedColumn> mColumns;
+    long mRow;
+};
+
+//date is converted by driver when result is stored, because 
+//format of date in string depends on driver
+static bool
+looksLikeDate(const char* pStr) {
+  return strlen(pStr) >= 10 && isdigit(pStr[0]) && pStr[4] == '-' && pStr[7] == '-';
+};
+
+static std::string
+tableKey(const std::string& pTable) {
+  std::string ret(strip(pTable));
+  for(std::string::iterator it = ret.begin(); it != ret.end(); it++)
+    *it = tolower(*it);
+  return ret;
+};
+
+static void
+splitTables(const char* pTables, std::vector<std::string>& pList) {
+  std::string tables(pTables != NULL ? pTables : "");
+  std::string::size_type start = 0;
+  while(start <= tables.size()) {
+    std::string::size_type end = tables.find(',', start);
+    if (end == std::string::npos)
+      end = tables.size();
+    std::string table(tableKey(tables.substr(start, end - start)));
+    if (!table.empty())
+      pList.push_back(table);
+    start = end + 1;
+  };
+};
+
+QueryCache::QueryCache(unsigned long pMaxBytes)
+  : mMaxBytes(pMaxBytes),
+    mBytes(0),
+    mClears(0),
+    mHits(0),
+    mMisses(0),
+    mEvictions(0),
+    mInvalidations(0)
+{
+};
+
+unsigned long
+QueryCache::generation(const std::vector<std::string>& pTables) {
+  //called with mMutex locked. Counters only grow, so sum changes
+  //when any of them is increased
+  unsigned long ret = mClears;
+  for(std::vector<std::string>::const_iterator it = pTables.begin(); it != pTables.end(); it++) {
+    GenerationMap::const_iterator gen = mGenerations.find(*it);
+    if (gen != mGenerations.end())
+      ret += gen->second;
+  };
+  return ret;
+};
+
+unsigned long
+QueryCache::getGeneration(const char* pTables) {
+  std::vector<std::string> tables;
+  splitTables(pTables, tables);
+  MutexLocker lock(mMutex);
+  return generation(tables);
+};
+
+DbResult*
+QueryCache::find(const std::string& pQuery) {
+  MutexLocker lock(mMutex);
+  EntryMap::iterator it = mEntries.find(pQuery);
+  if (it == mEntries.end()) {
+    mMisses++;
+    return NULL;
+  };
+  mHits++;
+  mLru.splice(mLru.begin(), mLru, it->second->mLru);
+  return new CachedResult(it->second);
+};
+
+DbResult*
+QueryCache::store(const std::string& pQuery, const char* pTables, unsigned long pGeneration, DbResult& pResult) {
+  shared_ptr<Entry> entry(new Entry(pQuery));
+  entry->mSpecs = pResult.getConversionSpecs();
+  entry->mColumns = pResult.columns();
+  for(int i = 0; i < entry->mColumns; i++) {
+    const DbColumn& column(pResult.getColumn(i));
+    entry->mColumnNames.push_back(entry->add(column.getName()));
+    entry->mColumnCharsets.push_back(column.getDbCharset());
+  };
+  while(pResult.fetchRow()) {
+    for(int i = 0; i < entry->mColumns; i++) {
+      if (pResult.isNull(i)) {
+        entry->mFields.push_back(Entry::NullField);
+        continue;
+      };
+      const char* val = pResult.getString(i);
+      entry->mFields.push_back(entry->add(val));
+      if (looksLikeDate(val)) {
+        try {
+          struct tm date = pResult.getDate(i);
+          entry->mDates.resize(entry->mFields.size(), -1);
+          entry->mDates.back() = entry->mDateValues.size();
+          entry->mDateValues.push_back(date);
+        } catch (const Exception&) {
+          //not a date column
+        };
+      };
+    };
+    entry->mRows++;
+  };
+  if (!entry->mDates.empty())
+    entry->mDates.resize(entry->mFields.size(), -1);
+  splitTables(pTables, entry->mTables);
+
+  MutexLocker lock(mMutex);
+  unsigned long bytes = entry->getBytes();
+  //tables of query could be changed before result was read
+  if (pGeneration == generation(entry->mTables) && bytes <= mMaxBytes) {
+    EntryMap::iterator it = mEntries.find(pQuery);
+    if (it != mEntries.end())
+      remove(it);
+    mEntries[pQuery] = entry;
+    for(std::vector<std::string>::const_iterator t = entry->mTables.begin(); t != entry->mTables.end(); t++)
+      mTables.insert(std::make_pair(*t, pQuery));
+    entry->mLru = mLru.insert(mLru.begin(), pQuery);
+    mBytes += bytes;
+    evict();
+  };
+  return new CachedResult(entry);
+};
+
+void
+QueryCache::remove(EntryMap::iterator pEntry) {
+  //called with mMutex locked
+  const Entry& entry(*pEntry->second);
+  for(std::vector<std::string>::const_iterator t = entry.mTables.begin(); t != entry.mTables.end(); t++) {
+    std::pair<TableMap::iterator, TableMap::iterator> range(mTables.equal_range(*t));
+    for(TableMap::iterator it = range.first; it != range.second; it++) {
+      if (it->second == entry.mQuery) {
+        mTables.erase(it);
+        break;
+      };
+    };
+  };
+  mLru.erase(entry.mLru);
+  mBytes -= entry.getBytes();
+  //result can still be replayed by CachedResult that shares entry
+  mEntries.erase(pEntry);
+};
+
+void
+QueryCache::evict() {
+  //called with mMutex locked
+  while(mBytes > mMaxBytes && !mLru.empty()) {
+    remove(mEntries.find(mLru.back()));
+    mEvictions++;
+  };
+};
+
+void
+QueryCache::invalidate(const std::string& pTable) {
+  std::string table(tableKey(pTable));
+  MutexLocker lock(mMutex);
+  mGenerations[table]++;
+  std::pair<TableMap::iterator, TableMap::iterator> range(mTables.equal_range(table));
+  std::vector<std::string> queries;
+  for(TableMap::iterator it = range.first; it != range.second; it++)
+    queries.push_back(it->second);
+  for(std::vector<std::string>::const_iterator it = queries.begin(); it != queries.end(); it++) {
+    EntryMap::iterator entry = mEntries.find(*it);
+    if (entry != mEntries.end()) {
+      remove(entry);
+      mInvalidations++;
+    };
+  };
+};
+
+void
+QueryCache::clear() {
+  MutexLocker lock(mMutex);
+  mClears++;
+  mEntries.clear();
+  mTables.clear();
+  mLru.clear();
+  mBytes = 0;
+};
+
+void
+QueryCache::setMaxBytes(unsigned long pMaxBytes) {
+  MutexLocker lock(mMutex);
+  mMaxBytes = pMaxBytes;
+  evict();
+};
+
+unsigned long
+QueryCache::getBytes() {
+  MutexLocker lock(mMutex);
+  return mBytes;
+};
+
+unsigned int
+QueryCache::size() {
+  MutexLocker lock(mMutex);
+  return mEntries.size();
+};
+
+unsigned long
+QueryCache::getHits() {
+  MutexLocker lock(mMutex);
+  return mHits;
+};
+
+unsigned long
+QueryCache::getMisses() {
+  MutexLocker lock(mMutex);
+  return mMisses;
+};
+
+unsigned long
+QueryCache::getEvictions() {
+  MutexLocker lock(mMutex);
+  return mEvictions;
+};
+
+unsigned long
+QueryCache::getInvalidations() {
+  MutexLocker lock(mMutex);
+  return mInvalidations;
+};
+
+QueryCache::~QueryCache() {
+};
+
+};//namespace
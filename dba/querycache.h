@@ -0,0 +1,141 @@
+// File: querycache.h
+// Purpose: Cache of SQL query results
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBAQUERYCACHE_H
+#define DBAQUERYCACHE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include "dba/database.h"
+#include "dba/shared_ptr.h"
+#include "dba/thread.h"
+
+namespace dba {
+
+/**
+  Thread safe cache of %SQL query results shared by all streams of SharedSQLArchive.
+  Results are keyed by query text after parameters are substituted. Rows of result
+  are stored as strings in one memory block and replayed by DbResult
+  implementation returned from find(). Each cached query declares list of tables
+  it depends on, and query result is removed from cache when SQLOStream 
+  writes object to one of those tables. Tables are invalidated again when
+  changes are commited, so results read before commit are not kept.
+  SQLOStream::sendUpdate() clears whole cache. Cache is bounded by memory used
+  by results, least recently used results are removed first.
+
+  Used by SQLIStream::sendCachedQuery().
+  @note Changes done by other processes do not invalidate cache. Call invalidate() 
+  or clear() for such changes.
+  @ingroup api
+*/
+class dbaDLLEXPORT QueryCache {
+  public:
+    /**
+      Constructor
+      @param pMaxBytes maximum memory used by cached results
+    */
+    QueryCache(unsigned long pMaxBytes = 16 * 1024 * 1024);
+    /**
+      Get counter that is increased by every invalidation of listed tables and by clear(). 
+      Used to detect invalidation between sending query and storing its result.
+      @param pTables comma separated list of tables
+    */
+    unsigned long getGeneration(const char* pTables);
+    /**
+      Find result of query in cache.
+      @param pQuery query text
+      @return result that replays cached rows (caller takes ownership) or NULL if query is not cached
+    */
+    DbResult* find(const std::string& pQuery);
+    /**
+      Read all rows from result and put them into cache.
+      Result is not cached if it is larger than cache or any table was invalidated
+      after pGeneration was taken.
+      @param pQuery query text
+      @param pTables comma separated list of tables that query depends on
+      @param pGeneration value of getGeneration() for pTables taken before query was sent
+      @param pResult result of query, all rows are fetched
+      @return result that replays rows read from pResult (caller takes ownership)
+    */
+    DbResult* store(const std::string& pQuery, const char* pTables, unsigned long pGeneration, DbResult& pResult);
+    /**
+      Remove all results that depend on table
+      @param pTable name of table
+    */
+    void invalidate(const std::string& pTable);
+    /**
+      Remove all results from cache
+    */
+    void clear();
+    /**
+      Change maximum memory used by cached results
+      @param pMaxBytes maximum memory in bytes
+    */
+    void setMaxBytes(unsigned long pMaxBytes);
+    /**
+      Get memory used by cached results
+    */
+    unsigned long getBytes();
+    /**
+      Get number of cached results
+    */
+    unsigned int size();
+    /**
+      Get number of queries found in cache
+    */
+    unsigned long getHits();
+    /**
+      Get number of queries not found in cache
+    */
+    unsigned long getMisses();
+    /**
+      Get number of results removed to make space for new results
+    */
+    unsigned long getEvictions();
+    /**
+      Get number of results removed because table was changed
+    */
+    unsigned long getInvalidations();
+    /**
+      Destructor
+    */
+    ~QueryCache();
+  private:
+    class Entry;
+    class CachedColumn;
+    class CachedResult;
+    typedef std::list<std::string> LruList;
+    typedef std::map<std::string, shared_ptr<Entry> > EntryMap;
+    typedef std::multimap<std::string, std::string> TableMap;
+    typedef std::map<std::string, unsigned long> GenerationMap;
+
+    QueryCache(const QueryCache&);
+    QueryCache& operator=(const QueryCache&);
+    void remove(EntryMap::iterator pEntry);
+    void evict();
+    unsigned long generation(const std::vector<std::string>& pTables);
+
+    Mutex mMutex;
+    EntryMap mEntries;
+    TableMap mTables;
+    LruList mLru;
+    unsigned long mMaxBytes;
+    unsigned long mBytes;
+    //!generations of tables, without clears
+    GenerationMap mGenerations;
+    unsigned long mClears;
+    unsigned long mHits;
+    unsigned long mMisses;
+    unsigned long mEvictions;
+    unsigned long mInvalidations;
+};
+
+};//namespace
+
+#endif
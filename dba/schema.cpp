@@ -0,0 +1,162 @@
+// File: schema.cpp
+// Purpose: Snapshot of relations and columns in SQL database
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#include "dba/schema.h"
+#include "dba/database.h"
+#include "dba/membertree.h"
+#include "dba/exception.h"
+#include "dba/sqlarchive.h"
+
+#include <ctype.h>
+#include <memory>
+
+namespace dba {
+
+AtomicCounter Schema::sVersion;
+
+Schema::Schema(SQLArchive& pArchive)
+  : mArchive(&pArchive),
+    mVersion(sVersion.get())
+{
+  mRelationNames = mArchive->getFreeConnection(false)->getRelationNames();
+  for(std::list<std::string>::const_iterator it = mRelationNames.begin(); it != mRelationNames.end(); it++)
+    mRelations[getKey(*it)].mName = *it;
+};
+
+std::string
+Schema::getKey(const std::string& pName) {
+  std::string key(pName);
+  for(std::string::iterator it = key.begin(); it != key.end(); it++)
+    *it = tolower(*it);
+  return key;
+};
+
+void
+Schema::load(Relation& pRelation) const {
+  //called with mMutex locked
+  pRelation.mLoaded = true;
+  if (mArchive == NULL)
+    return;
+  //names from catalog keep case, so they are quoted first
+  std::string quoted("\"");
+  for(std::string::const_iterator it = pRelation.mName.begin(); it != pRelation.mName.end(); it++) {
+    if (*it == '"')
+      quoted += '"';
+    quoted += *it;
+  };
+  quoted += '"';
+  const std::string names[] = { quoted, pRelation.mName };
+  for(int i = 0; i < 2 && !pRelation.mKnown; i++) {
+    try {
+      //empty result describes columns in all plugins. Free connection is not 
+      //in transaction, so failed query does not affect other queries
+      DbConnection* conn = mArchive->getFreeConnection(false);
+      std::auto_ptr<DbResult> res(conn->sendQuery("SELECT * FROM " + names[i] + " WHERE 1=0"));
+      for(int c = 0; c < res->columns(); c++)
+        pRelation.mColumns.push_back(res->getColumn(c).getName());
+      pRelation.mKnown = true;
+    } catch (const Exception&) {
+      pRelation.mColumns.clear();
+    };
+  };
+};
+
+const Schema::Relation*
+Schema::getRelation(const std::string& pRelation) const {
+  MutexLocker lock(mMutex);
+  RelationMap::iterator rel = mRelations.find(getKey(pRelation));
+  if (rel == mRelations.end())
+    return NULL;
+  if (!rel->second.mLoaded)
+    load(rel->second);
+  //relation is not changed after it is loaded
+  return &rel->second;
+};
+
+void
+Schema::detach() {
+  MutexLocker lock(mMutex);
+  mArchive = NULL;
+};
+
+bool
+Schema::isOutdated() const {
+  return mVersion != sVersion.get();
+};
+
+void
+Schema::changed() {
+  sVersion.inc();
+};
+
+bool
+Schema::hasRelation(const std::string& pRelation) const {
+  return mRelations.find(getKey(pRelation)) != mRelations.end();
+};
+
+bool
+Schema::hasColumnInfo(const std::string& pRelation) const {
+  const Relation* rel = getRelation(pRelation);
+  return rel != NULL && rel->mKnown;
+};
+
+bool
+Schema::hasColumn(const std::string& pRelation, const std::string& pColumn) const {
+  const Relation* rel = getRelation(pRelation);
+  if (rel == NULL)
+    return false;
+  std::string key(getKey(pColumn));
+  for(std::vector<std::string>::const_iterator it = rel->mColumns.begin(); it != rel->mColumns.end(); it++) {
+    if (getKey(*it) == key)
+      return true;
+  };
+  return false;
+};
+
+const std::vector<std::string>&
+Schema::getColumns(const std::string& pRelation) const {
+  static const std::vector<std::string> empty;
+  const Relation* rel = getRelation(pRelation);
+  if (rel == NULL)
+    return empty;
+  return rel->mColumns;
+};
+
+std::list<std::string>
+Schema::getMissing(const StoreTable* pTable, const char* pRootTableName) const {
+  std::list<std::string> missing;
+  shared_ptr<mt_mlist> list(mt_mlist::get(pTable,pRootTableName));
+  for(const mt_class* c = list->begin(); c != list->end(); c++) {
+    if (!hasRelation(c->name)) {
+      missing.push_back(c->name);
+      continue;
+    };
+    if (!hasColumnInfo(c->name))
+      continue;
+    for(const mt_member* m = c->first; m != c->last; m++) {
+      if (!hasColumn(c->name,m->name))
+        missing.push_back(std::string(c->name) + "." + m->name);
+    };
+  };
+  return missing;
+};
+
+void
+Schema::check(const StoreTable* pTable, const char* pRootTableName) const {
+  std::list<std::string> missing(getMissing(pTable,pRootTableName));
+  if (missing.empty())
+    return;
+  std::string msg("Database schema does not match store table, missing: ");
+  for(std::list<std::string>::const_iterator it = missing.begin(); it != missing.end(); it++) {
+    if (it != missing.begin())
+      msg += ", ";
+    msg += *it;
+  };
+  throw DataException(msg);
+};
+
+};//namespace
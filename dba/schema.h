@@ -0,0 +1,132 @@
+// File: schema.h
+// Purpose: Snapshot of relations and columns in SQL database
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBASCHEMA_H
+#define DBASCHEMA_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include "dba/defs.h"
+#include "dba/shared_ptr.h"
+#include "dba/thread.h"
+
+namespace dba {
+
+class SQLArchive;
+class StoreTable;
+
+/**
+  Snapshot of %SQL database schema: names of relations and names of their columns.
+  Names of relations are read from database catalog when snapshot is created. Columns
+  of relation are read on first use by empty query on free connection of archive, so
+  relations that are not used are never queried. Relations that cannot be queried,
+  for example relations without select privilege, have no column information and
+  their columns are not checked. Snapshot can be shared by many streams. Names are
+  compared case insensitive because most databases fold unquoted identifiers.
+
+  Snapshot becomes outdated when %SQL command that changes schema is sent using 
+  SQLOStream::sendUpdate(). SQLArchive::getSchema() reads new snapshot then.
+
+  Used by SQLArchive::getSchema() to check STORE_TABLE definitions before first
+  query is sent.
+  @note Column types are not available from all database plugins, so only names
+  of columns are stored.
+  @ingroup api
+*/
+class dbaDLLEXPORT Schema : public RefCounted {
+    friend class SQLArchive;
+  public:
+    /**
+      Read names of relations using free connection of archive
+      @param pArchive open archive
+    */
+    Schema(SQLArchive& pArchive);
+    /**
+      Get list of relation names in order returned by database
+    */
+    const std::list<std::string>& getRelationNames() const { return mRelationNames; };
+    /**
+      Check if relation exists in database
+      @param pRelation name of relation
+    */
+    bool hasRelation(const std::string& pRelation) const;
+    /**
+      Check if relation exists and has column
+      @param pRelation name of relation
+      @param pColumn name of column
+    */
+    bool hasColumn(const std::string& pRelation, const std::string& pColumn) const;
+    /**
+      Get names of columns of relation
+      @param pRelation name of relation
+      @return list of column names, empty if relation does not exist
+    */
+    const std::vector<std::string>& getColumns(const std::string& pRelation) const;
+    /**
+      Check if columns of relation are known
+      @param pRelation name of relation
+      @return false if relation does not exist or it could not be queried
+    */
+    bool hasColumnInfo(const std::string& pRelation) const;
+    /**
+      Check if schema was changed after snapshot was read
+    */
+    bool isOutdated() const;
+    /**
+      Mark all snapshots as outdated. Called by SQLOStream::sendUpdate() for
+      commands that create, alter or drop database objects.
+    */
+    static void changed();
+    /**
+      Find relations and columns used by store table that are not in database.
+      Columns of relations without column information are not reported.
+      @param pTable store table of object
+      @param pRootTableName overridden name of root table or NULL
+      @return list of missing relations ("relation") and columns ("relation.column")
+    */
+    std::list<std::string> getMissing(const StoreTable* pTable, const char* pRootTableName = NULL) const;
+    /**
+      Check if database has all relations and columns used by store table
+      @param pTable store table of object
+      @param pRootTableName overridden name of root table or NULL
+      @throw DataException with list of missing relations and columns
+    */
+    void check(const StoreTable* pTable, const char* pRootTableName = NULL) const;
+  private:
+    class Relation {
+      public:
+        Relation() : mLoaded(false), mKnown(false) {};
+        std::string mName;
+        std::vector<std::string> mColumns;
+        //!true if columns were queried
+        bool mLoaded;
+        //!true if query succeeded
+        bool mKnown;
+    };
+    typedef std::map<std::string, Relation> RelationMap;
+
+    Schema(const Schema&);
+    Schema& operator=(const Schema&);
+    static std::string getKey(const std::string& pName);
+    const Relation* getRelation(const std::string& pRelation) const;
+    void load(Relation& pRelation) const;
+    void detach();
+
+    std::list<std::string> mRelationNames;
+    mutable RelationMap mRelations;
+    mutable Mutex mMutex;
+    //!archive used to load columns or NULL if archive dropped snapshot
+    SQLArchive* mArchive;
+    long mVersion;
+    static AtomicCounter sVersion;
+};
+
+};//namespace
+
+#endif
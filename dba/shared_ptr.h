@@ -7,71 +7,102 @@
 #ifndef DBASHARED_PTR_H
 #define DBASHARED_PTR_H
 
+#include "dba/defs.h"
+#include "dba/atomiccounter.h"
+
 namespace dba {
 
-/**
-  shared_ptr implementation for streams
+class RefCounted;
+
+/**@internal
+  Get counter embedded in object. Overload for classes that
+  derive from RefCounted
 */
+inline AtomicCounter* shared_ptr_counter(const RefCounted* pObj);
+
+/**@internal
+  Get counter embedded in object. Overload for all other classes,
+  returns NULL so separate counter is allocated by shared_ptr
+*/
+inline AtomicCounter* shared_ptr_counter(const void*) {
+  return NULL;
+};
 
-class dbaDLLEXPORT Counter {
+/**
+  Base class for objects that keep their own reference counter.
+  When shared_ptr takes ownership of RefCounted derived object it does not
+  allocate separate counter, so sharing object costs no additional allocation.
+  Copies of RefCounted object start with zero references.
+*/
+class dbaDLLEXPORT RefCounted {
+    friend AtomicCounter* shared_ptr_counter(const RefCounted* pObj);
   public:
-    Counter() : mCount(1) {};
-    unsigned mCount;
+    RefCounted() : mRefs(0) {};
+    RefCounted(const RefCounted&) : mRefs(0) {};
+    RefCounted& operator=(const RefCounted&) { return *this; };
+  protected:
+    ~RefCounted() {};
+  private:
+    AtomicCounter mRefs;
 };
 
+inline AtomicCounter*
+shared_ptr_counter(const RefCounted* pObj) {
+  return const_cast<AtomicCounter*>(&pObj->mRefs);
+};
+
+/**
+  shared_ptr implementation for streams.
+
+  Reference counter is updated atomically, so copies of one shared_ptr
+  can be created and destroyed in different threads. If T derives from
+  RefCounted then counter embedded in object is used.
+*/
 template <class T> class shared_ptr {
   public:
-    shared_ptr(T* pObj) : obj(pObj) {
+    shared_ptr() : obj(NULL),mCounter(NULL) {};
+
+    shared_ptr(T* pObj) : obj(NULL),mCounter(NULL) {
+      acquire(pObj);
+    };
+
+    shared_ptr(const shared_ptr& src)
+      : obj(src.obj),
+        mCounter(src.mCounter)
+    {
       if (obj)
-        mCounter = new Counter();
-      else
-        mCounter = NULL;
+        mCounter->inc();
     };
 
     unsigned getCount() const {
-      return mCounter->mCount;
+      return mCounter == NULL ? 0 : mCounter->get();
     };
 
     shared_ptr<T>& operator= (T* pObj) {
-      if (obj) {
-        mCounter -> mCount--;
-        if (!mCounter->mCount) {
-          delete obj;
-          delete mCounter;
-        };
-      };
-      obj = pObj;
-      if (obj) {
-        mCounter = new Counter();
-      };
+      shared_ptr<T> tmp(pObj);
+      swap(tmp);
       return *this;
     };
 
-    shared_ptr() : obj(NULL),mCounter(NULL) {};
-
-    shared_ptr(const shared_ptr& src) {
-//      cout << "copy constructor of C" << endl;
-      mCounter = src.mCounter;
-      obj = src.obj;
-      if (obj)
-        mCounter -> mCount++;
-    };
-
     shared_ptr<T>& operator= (const shared_ptr<T>& src) {
-      if (obj) {
-        mCounter -> mCount--;
-          if (!mCounter->mCount) {
-            delete obj;
-            delete mCounter;
-          };
-      };
-      mCounter = src.mCounter;
-      obj = src.obj;
-      if (obj)
-        mCounter -> mCount++;
+      shared_ptr<T> tmp(src);
+      swap(tmp);
       return *this;
     };
 
+    /**
+      Exchange pointers with other shared_ptr without touching reference counters.
+      Use it to move pointer instead of copying it.
+    */
+    void swap(shared_ptr<T>& pOther) {
+      T* o = obj;
+      AtomicCounter* c = mCounter;
+      obj = pOther.obj;
+      mCounter = pOther.mCounter;
+      pOther.obj = o;
+      pOther.mCounter = c;
+    };
+
     T& operator*() const {
       return *obj;
     };
@@ -108,19 +139,31 @@ template <class T> class shared_ptr {
     T* ptr() const { return obj; }
 
     ~shared_ptr() {
-//      cerr << "pointer destructor" << endl;
+      release();
+    };
+  private:
+    void acquire(T* pObj) {
+      obj = pObj;
       if (obj) {
-        mCounter -> mCount--;
-        if (!mCounter -> mCount) {
-          delete(obj);
-          delete mCounter;
+        mCounter = shared_ptr_counter(obj);
+        if (mCounter == NULL)
+          mCounter = new AtomicCounter();
+        mCounter->inc();
+      };
+    };
+
+    void release() {
+      if (obj) {
+        if (!mCounter->dec()) {
+          if (mCounter != shared_ptr_counter(obj))
+            delete mCounter;
+          delete obj;
         };
       };
     };
-  private:
 
     T* obj;
-    Counter* mCounter;
+    AtomicCounter* mCounter;
 };
 
 };//namespace
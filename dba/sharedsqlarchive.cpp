@@ -7,15 +7,21 @@
 
 #include "dba/sharedsqlarchive.h"
 #include "dba/shared_ptr.h"
+#include "dba/database.h"
+#include "dba/exception.h"
 #include <iostream>
 
 namespace dba {
 
-Transaction::Transaction(DbConnection* pConn, SQLIdFetcher* pFetcher, FilterMapper* pMapper, const shared_ptr<bool>& pRollbackFlag) 
+Transaction::Transaction(DbConnection* pConn, SQLIdFetcher* pFetcher, FilterMapper* pMapper, const shared_ptr<bool>& pRollbackFlag, const shared_ptr<IdentityMap>& pIdentityMap, ObjectCache* pObjectCache, QueryCache* pQueryCache, bool pReadOnly) 
   : mConn(pConn),
     mFetcher(pFetcher),
     mFilterMapper(pMapper),
-    mRollbackFlag(pRollbackFlag)
+    mRollbackFlag(pRollbackFlag),
+    mIdentityMap(pIdentityMap),
+    mObjectCache(pObjectCache),
+    mQueryCache(pQueryCache),
+    mReadOnly(pReadOnly)
 {
   mConn->incUsed();
 };
@@ -24,7 +30,11 @@ Transaction::Transaction(const Transaction& pTransaction)
   : mConn(pTransaction.mConn),
     mFetcher(pTransaction.mFetcher),
     mFilterMapper(pTransaction.mFilterMapper),
-    mRollbackFlag(pTransaction.mRollbackFlag)
+    mRollbackFlag(pTransaction.mRollbackFlag),
+    mIdentityMap(pTransaction.mIdentityMap),
+    mObjectCache(pTransaction.mObjectCache),
+    mQueryCache(pTransaction.mQueryCache),
+    mReadOnly(pTransaction.mReadOnly)
 {
   mConn->incUsed();
 };
@@ -36,6 +46,10 @@ Transaction::operator=(const Transaction& pTransaction) {
   mFetcher = pTransaction.mFetcher;
   mFilterMapper = pTransaction.mFilterMapper;
   mRollbackFlag = pTransaction.mRollbackFlag;
+  mIdentityMap = pTransaction.mIdentityMap;
+  mObjectCache = pTransaction.mObjectCache;
+  mQueryCache = pTransaction.mQueryCache;
+  mReadOnly = pTransaction.mReadOnly;
   mConn->incUsed();
   return *this;
 };
@@ -43,6 +57,8 @@ Transaction::operator=(const Transaction& pTransaction) {
 #ifdef DBA_COMPAT_1_0    
 shared_ptr<SQLOStream> 
 Transaction::getOOStream() {
+  if (mReadOnly)
+    throw APIException("Cannot create output stream for read only transaction");
   SQLOStream* ret = new SQLOStream(mConn,mFetcher,mFilterMapper);
   ret->open();
   return ret;
@@ -58,19 +74,40 @@ Transaction::getOIStream() {
 SQLIStream
 Transaction::getIStream() {
   SQLIStream s(mConn,mFilterMapper);
+  s.mIdentityMap = mIdentityMap;
   return s;
 };
 
 SQLOStream
 Transaction::getOStream() {
+  if (mReadOnly)
+    throw APIException("Cannot create output stream for read only transaction");
+  return createOStream();
+};
+
+SQLOStream
+Transaction::createOStream() {
   SQLOStream ret(mConn,mFetcher,mFilterMapper);
+  ret.mIdentityMap = mIdentityMap;
+  ret.mObjectCache = mObjectCache;
+  ret.mQueryCache = mQueryCache;
+  //changes are visible to other connections after commit
+  ret.mDeferInvalidation = true;
   ret.open();
   return ret;
 };
 
 void
 Transaction::commit() {
-  SQLOStream stream(getOStream());
+  mIdentityMap->clear();
+  SQLOStream stream(createOStream());
+  try {
+    //COMMIT is sent only if all pipelined commands succeeded
+    mConn->syncUpdates();
+  } catch(...) {
+    *mRollbackFlag = true;
+    throw;
+  };
   stream.commit();
   stream.begin();
 };
@@ -85,12 +122,54 @@ Transaction::isRolledback() const {
   return *mRollbackFlag == true;
 };
 
+bool
+Transaction::isReadOnly() const {
+  return mReadOnly;
+};
+
+void
+Transaction::setIdentityMap(bool pFlag) {
+  mIdentityMap->setEnabled(pFlag);
+};
+
+IdentityMap&
+Transaction::getIdentityMap() {
+  return *mIdentityMap;
+};
+
+/**
+  Disables pipelining on connection that returns to pool,
+  also when transaction end failed.
+*/
+class PipeliningReset {
+  public:
+    PipeliningReset(DbConnection* pConn) : mConn(pConn) {};
+    ~PipeliningReset() {
+      try {
+        mConn->setPipelining(false);
+      } catch(...) {};
+    };
+  private:
+    DbConnection* mConn;
+};
+
 void
 Transaction::cleanStreams() {
-  SQLOStream stream(getOStream());
-  if (*mRollbackFlag == false)
+  mIdentityMap->clear();
+  PipeliningReset reset(mConn);
+  SQLOStream stream(createOStream());
+  if (*mRollbackFlag == false) {
+    try {
+      //COMMIT is sent only if all pipelined commands succeeded
+      mConn->syncUpdates();
+    } catch(...) {
+      try {
+        stream.rollback();
+      } catch(...) {};
+      throw;
+    };
     stream.commit();
-  else
+  } else
     stream.rollback();
 };
 
@@ -117,18 +196,30 @@ Transaction::~Transaction() throw() {
 
 SharedSQLArchive::SharedSQLArchive(Database* pDatabase)
   : SQLArchive(pDatabase),
-    mLastTransConnection(NULL)
+    mLastTransConnection(NULL),
+    mReplicaSelection(REPLICA_ROUND_ROBIN),
+    mNextReplica(0)
 {
 }
 
 Transaction
 SharedSQLArchive::createTransaction(Transaction::creationType pType) {
+  if (pType == Transaction::TRANS_READ_ONLY) {
+    //read only transaction is never reused by TRANS_USE_LAST
+    shared_ptr<bool> rollbackFlag(new bool);
+    *rollbackFlag = false;
+    Transaction t(getReadConnection(),mFetcher,&mFilterMapper,rollbackFlag,new IdentityMap(),mObjectCache,mQueryCache,true);
+    SQLOStream stream(t.createOStream());
+    stream.begin();
+    return t;
+  };
   if (pType == Transaction::TRANS_USE_LAST) {
     //if there is no rollback set connections are NULL too.
     if (mLastTransConnection == NULL) {
       mLastTransConnection = getFreeConnection();
       mRollbackFlag = new bool;
       *mRollbackFlag = false;
+      mIdentityMap = new IdentityMap();
     };
   } else {
     //create always new transaction using new connection no matter what.
@@ -137,26 +228,129 @@ SharedSQLArchive::createTransaction(Transaction::creationType pType) {
     mLastTransConnection = getFreeConnection();
     mRollbackFlag = new bool;
     *mRollbackFlag = false;
+    mIdentityMap = new IdentityMap();
   };
   //we use stream begin() method to start transaction
   //using stream from Transaction instance that will be returned
   //need_begin have to be before transaction constructor
   //because this constructor will increment connection usage
   bool need_begin = !mLastTransConnection->isUsed();
-  Transaction t(mLastTransConnection,mFetcher,&mFilterMapper,mRollbackFlag);
+  Transaction t(mLastTransConnection,mFetcher,&mFilterMapper,mRollbackFlag,mIdentityMap,mObjectCache,mQueryCache);
   if (need_begin) {
     *mRollbackFlag = false;
+    mIdentityMap->setEnabled(false);
     SQLOStream stream(t.getOStream());
     stream.begin();
   };
   return t; 
 };
 
+int
+SharedSQLArchive::Replica::getUsed() const {
+  int used = 0;
+  for(std::list<DbConnection*>::const_iterator it = mConnections.begin(); it != mConnections.end(); it++) {
+    if ((*it)->isUsed())
+      used++;
+  };
+  return used;
+};
+
+void
+SharedSQLArchive::addReplica(const char* pConnectString) {
+  mReplicas.push_back(new Replica(pConnectString));
+};
+
+void
+SharedSQLArchive::setReplicaSelection(replicaSelection pSelection) {
+  mReplicaSelection = pSelection;
+};
+
+int
+SharedSQLArchive::getReplicaCount() const {
+  return mReplicas.size();
+};
+
+int
+SharedSQLArchive::getUsedReplicaConnections() const {
+  int used = 0;
+  for(std::vector<Replica*>::const_iterator it = mReplicas.begin(); it != mReplicas.end(); it++)
+    used += (*it)->getUsed();
+  return used;
+};
+
+DbConnection*
+SharedSQLArchive::getReadConnection() {
+  if (mReplicas.empty())
+    return getFreeConnection();
+  Replica* replica = NULL;
+  switch(mReplicaSelection) {
+    case REPLICA_ROUND_ROBIN:
+      replica = mReplicas[mNextReplica++ % mReplicas.size()];
+    break;
+    case REPLICA_LEAST_USED:
+      for(std::vector<Replica*>::iterator it = mReplicas.begin(); it != mReplicas.end(); it++) {
+        if (replica == NULL || (*it)->getUsed() < replica->getUsed())
+          replica = *it;
+      };
+    break;
+  };
+  return getFreeConnection(replica->mConnections,replica->mConnectStr,false);
+};
+
+ObjectCache&
+SharedSQLArchive::getObjectCache() {
+  if (mObjectCache == NULL)
+    mObjectCache = new ObjectCache();
+  return *mObjectCache;
+};
+
+QueryCache&
+SharedSQLArchive::getQueryCache() {
+  if (mQueryCache == NULL)
+    mQueryCache = new QueryCache();
+  return *mQueryCache;
+};
+
+void
+SharedSQLArchive::setConversionSpecs(const ConvSpec& pSpecs) {
+  SQLArchive::setConversionSpecs(pSpecs);
+  for(std::vector<Replica*>::iterator it = mReplicas.begin(); it != mReplicas.end(); it++) {
+    std::list<DbConnection*>& conns((*it)->mConnections);
+    for(std::list<DbConnection*>::iterator conn = conns.begin(); conn != conns.end(); conn++)
+      (*conn)->setConversionSpecs(pSpecs);
+  };
+};
+
+void
+SharedSQLArchive::closeReplicas() {
+  for(std::vector<Replica*>::iterator it = mReplicas.begin(); it != mReplicas.end(); it++) {
+    std::list<DbConnection*>& conns((*it)->mConnections);
+    for(std::list<DbConnection*>::iterator conn = conns.begin(); conn != conns.end(); conn++)
+      delete *conn;
+    conns.clear();
+  };
+};
+
+void
+SharedSQLArchive::closeAllConnections() {
+  closeReplicas();
+  SQLArchive::closeAllConnections();
+};
+
 
 SharedSQLArchive::~SharedSQLArchive() throw()
 {
   try {
     mLastTransConnection = NULL;
+    //base class destructor cannot reach replicas, connections
+    //have to be closed before database is destroyed
+    closeReplicas();
+    for(std::vector<Replica*>::iterator it = mReplicas.begin(); it != mReplicas.end(); it++)
+      delete *it;
+    delete mObjectCache;
+    mObjectCache = NULL;
+    delete mQueryCache;
+    mQueryCache = NULL;
   } catch (...) {
   
   };
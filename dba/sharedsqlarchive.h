@@ -8,6 +8,7 @@
 #ifndef DBASHAREDSQLARCHIVE_H
 #define DBASHAREDSQLARCHIVE_H
 
+#include <vector>
 #include "dba/sqlarchive.h"
 #include "dba/shared_ptr.h"
 
@@ -52,6 +53,11 @@ Second mode, TRANS_NEW will break exisiting transaction context and create new o
 if in above example "local" would be created using TRANS_NEW mode then new DbConnection would 
 be assigned to it and new transaction would be started on that connection.
 
+Third mode, TRANS_READ_ONLY creates new transaction that can only read objects. If read replicas
+were added to archive using SharedSQLArchive::addReplica() then connection for this transaction
+is taken from replica pool. Read only transaction does not change transaction context used by 
+TRANS_USE_LAST mode.
+
 All streams returned by Transaction object shares one internal DbConnection and all operations 
 on that streams are done in transaction context. You should not close or destroy returned streams
 Transaction destructor will take care of it.
@@ -72,7 +78,8 @@ class dbaDLLEXPORT Transaction {
     */
     typedef enum {
       TRANS_USE_LAST, //!<create child of last existing transaction
-      TRANS_NEW //!<create new transaction
+      TRANS_NEW, //!<create new transaction
+      TRANS_READ_ONLY //!<create new read only transaction, using read replica if available
     } creationType;
     /**
       Copy constructor
@@ -92,6 +99,7 @@ class dbaDLLEXPORT Transaction {
       Get SQLOStream related to Transaction
       @warning this stream should not be closed - To close streams delete Transaction instance
       @returns SQLOStream instance 
+      @throw APIException if transaction is read only
     */
     SQLOStream getOStream();
     /**
@@ -113,28 +121,70 @@ class dbaDLLEXPORT Transaction {
       Check if transaction is rolled back
     */
     bool isRolledback() const;
+    /**
+      Check if transaction was created using TRANS_READ_ONLY mode
+    */
+    bool isReadOnly() const;
+    /**
+      Enable or disable identity map for transaction context. When identity map is enabled
+      then SQLIStream::load() called on streams from getIStream() returns copies of objects
+      already loaded in this transaction without sending query to database. Objects are removed
+      from map when they are stored or erased using getOStream(). Map is cleared when transaction
+      is commited or rolled back.
+      @param pFlag true to enable identity map
+    */
+    void setIdentityMap(bool pFlag = true);
+    /**
+      Get identity map of transaction context
+    */
+    IdentityMap& getIdentityMap();
+    /**
+      Get connection used by this transaction. Connection is owned by archive.
+      @returns DbConnection instance
+    */
+    DbConnection* getConnection() { return mConn; };
     /**
       Destructor
     */
     ~Transaction() throw();
   private:
-    Transaction(DbConnection* pConn, SQLIdFetcher* pFetcher, FilterMapper* pMapper, const shared_ptr<bool>& pRollbackFlag);
+    Transaction(DbConnection* pConn, SQLIdFetcher* pFetcher, FilterMapper* pMapper, const shared_ptr<bool>& pRollbackFlag, const shared_ptr<IdentityMap>& pIdentityMap, ObjectCache* pObjectCache, QueryCache* pQueryCache, bool pReadOnly = false);
 
     DbConnection* mConn;
     SQLIdFetcher* mFetcher;
     FilterMapper* mFilterMapper;
     shared_ptr<bool> mRollbackFlag;
+    shared_ptr<IdentityMap> mIdentityMap;
+    ObjectCache* mObjectCache;
+    QueryCache* mQueryCache;
+    bool mReadOnly;
     
+    SQLOStream createOStream();
     void cleanStreams();
 };
 
 /**
-SQLArchive that supports transactions on object level
+SQLArchive that supports transactions on object level.
+
+Archive can route reads to read replicas of database. Replicas are added using addReplica()
+after archive is opened. Each replica has its own connection pool. Input streams returned by 
+getIStream() and getInputStream() and transactions created with Transaction::TRANS_READ_ONLY 
+use connections from replica selected using replicaSelection policy. Output streams and 
+other transactions always use primary database.
+@note Objects loaded from replica can be older than objects stored on primary if replication 
+is asynchronous. Use Transaction::getIStream() to read own writes.
 @ingroup api
 */
 class dbaDLLEXPORT SharedSQLArchive : public SQLArchive {
     friend class Transaction;
   public:
+    /**
+      Policy for selecting read replica
+    */
+    typedef enum {
+      REPLICA_ROUND_ROBIN, //!<use replicas in turn
+      REPLICA_LEAST_USED //!<use replica with smallest number of used connections
+    } replicaSelection;
     /**
       Constructor.
       @see SQLArchive constructor for explanations
@@ -149,13 +199,67 @@ class dbaDLLEXPORT SharedSQLArchive : public SQLArchive {
       @param pType of transaction. See Transaction::creationType for explanations
     */
     Transaction createTransaction(Transaction::creationType pType = Transaction::TRANS_USE_LAST);
+    /**
+      Add read only database that is used by input streams and read only transactions.
+      Connections are created when needed using the same database plugin as primary database.
+      @param pConnectString connect string of replica database
+    */
+    void addReplica(const char* pConnectString);
+    /**
+      Set policy for selecting replica. Default is REPLICA_ROUND_ROBIN
+      @param pSelection new policy
+    */
+    void setReplicaSelection(replicaSelection pSelection);
+    /**
+      Get number of read replicas added to archive
+    */
+    int getReplicaCount() const;
+    /**
+      Get number of currently used connections to read replicas
+    */
+    int getUsedReplicaConnections() const;
+    /**
+      Get cache of objects shared by all streams created from archive. Cache is created on 
+      first call and it is used only by streams created after that call. Input streams from 
+      Transaction do not use cache, output streams from Transaction remove stored objects from it.
+      @sa ObjectCache
+    */
+    ObjectCache& getObjectCache();
+    /**
+      Get cache of query results used by SQLIStream::sendCachedQuery(). Cache is created on 
+      first call and it is used only by streams created after that call. Input streams from 
+      Transaction do not use cache, output streams from Transaction invalidate it.
+      @sa QueryCache
+    */
+    QueryCache& getQueryCache();
+    virtual void setConversionSpecs(const ConvSpec& pSpecs);
     /**
       Destructor.
     */
     virtual ~SharedSQLArchive() throw();
+  protected:
+    /**
+      Get connection from replica selected using replicaSelection policy
+      or from primary database if there are no replicas.
+    */
+    virtual DbConnection* getReadConnection();
+    virtual void closeAllConnections();
   private:
+    class Replica {
+      public:
+        Replica(const char* pConnectStr) : mConnectStr(pConnectStr) {};
+        int getUsed() const;
+        std::string mConnectStr;
+        std::list<DbConnection*> mConnections;
+    };
+    void closeReplicas();
+
     DbConnection* mLastTransConnection;
     shared_ptr<bool> mRollbackFlag;
+    shared_ptr<IdentityMap> mIdentityMap;
+    std::vector<Replica*> mReplicas;
+    replicaSelection mReplicaSelection;
+    unsigned int mNextReplica;
 };
 
 };//namespace
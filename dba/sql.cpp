@@ -19,10 +19,28 @@
 #include "dba/storeablefilter.h"
 #include "dba/database.h"
 #include "dba/sqlutils.h"
+#include "dba/conversion.h"
+#include "dba/thread.h"
 
 namespace dba {
 
+/** parsed templates are dropped when cache grows over this size */
+static const size_t TEMPLATE_CACHE_LIMIT = 1000;
+
+static Mutex&
+getTemplateCacheMutex() {
+  static Mutex mutex;
+  return mutex;
+};
+
+SQL::TemplateCache&
+SQL::getTemplateCache() {
+  static TemplateCache cache;
+  return cache;
+};
+
 SQL::SQL()
+  : mTemplate(getTemplate(std::string()))
 {
 }
 
@@ -40,13 +58,99 @@ SQL::SQL(const std::string& pData)
 
 void
 SQL::parseQuery() {
-  SQLParamParser p(mSQLQuery,mPlaceholders);
+  mTemplate = getTemplate(mSQLQuery);
+}
+
+shared_ptr<SQL::QueryTemplate>
+SQL::getTemplate(const std::string& pSQLQuery) {
+  {
+    MutexLocker lock(getTemplateCacheMutex());
+    TemplateCache::const_iterator it = getTemplateCache().find(pSQLQuery);
+    if (it != getTemplateCache().end())
+      return it->second;
+  };
+  //parse without lock, parser throws on invalid query
+  shared_ptr<QueryTemplate> t(new QueryTemplate());
+  SQLParamParser p(pSQLQuery,t->mPlaceholders);
   p.parse();
+  t->split(pSQLQuery);
+
+  MutexLocker lock(getTemplateCacheMutex());
+  TemplateCache& cache(getTemplateCache());
+  //queries with data pasted into string would fill cache forever
+  if (cache.size() >= TEMPLATE_CACHE_LIMIT)
+    cache.clear();
+  cache.insert(std::make_pair(pSQLQuery,t));
+  return t;
+}
+
+void
+SQL::clearTemplateCache() {
+  MutexLocker lock(getTemplateCacheMutex());
+  getTemplateCache().clear();
+}
+
+size_t
+SQL::getTemplateCacheSize() {
+  MutexLocker lock(getTemplateCacheMutex());
+  return getTemplateCache().size();
+}
+
+void
+SQL::QueryTemplate::split(const std::string& pSQLQuery) {
+  mSegments.clear();
+  mSegments.reserve(mPlaceholders.size() + 1);
+  size_t pos = 0;
+  for(Placeholders::const_iterator it = mPlaceholders.begin(); it != mPlaceholders.end(); it++) {
+    mSegments.push_back(pSQLQuery.substr(pos,it->mIndex - pos));
+    //ESCAPE clause is inserted after LIKE pattern, all other placeholders take two chars
+    pos = it->mIndex;
+    if (it->mConvertType != PARAM_ESCAPE_CHAR)
+      pos += 2;
+  }
+  mSegments.push_back(pSQLQuery.substr(std::min(pos,pSQLQuery.size())));
+  mParamCount = getCountWithoutEscapes(mPlaceholders);
+
+  //native markers could clash with query text, params inside quotes are part of literal
+  mNative = pSQLQuery.find_first_of("?$") == std::string::npos;
+  mNativeSegments = mSegments;
+  size_t quotes = 0;
+  for(size_t i = 0; i < mPlaceholders.size() && mNative; i++) {
+    quotes += std::count(mSegments[i].begin(),mSegments[i].end(),'\'');
+    switch(mPlaceholders[i].mConvertType) {
+      case PARAM_ESCAPED:
+      break;
+      case PARAM_ESCAPE_CHAR:
+        mNative = false;
+      break;
+      default:
+        if (quotes % 2 == 0)
+          break;
+        //literal that holds only placeholder is replaced by marker
+        mNative = isWholeLiteral(mSegments[i],mSegments[i + 1]);
+        if (mNative) {
+          mNativeSegments[i].erase(mNativeSegments[i].size() - 1);
+          mNativeSegments[i + 1].erase(0,1);
+        }
+      break;
+    }
+  }
+}
+
+bool
+SQL::QueryTemplate::isWholeLiteral(const std::string& pBefore, const std::string& pAfter) {
+  //opening and closing quote cannot be part of escaped quote
+  size_t b = pBefore.size();
+  if (b == 0 || pBefore[b - 1] != '\'' || (b > 1 && pBefore[b - 2] == '\''))
+    return false;
+  if (pAfter.empty() || pAfter[0] != '\'' || (pAfter.size() > 1 && pAfter[1] == '\''))
+    return false;
+  return true;
 }
 
 void 
-SQL::setFilterDataForNextParam(DataContainerBase* pData, const char* pTypeName) {
-  mParams.push_back(ParamData(pData,pTypeName));
+SQL::setFilterDataForNextParam(DataContainerBase* pData, const char* pTypeName, size_t pTypeKey) {
+  mParams.push_back(ParamData(pData,pTypeName,pTypeKey));
   //std::cerr << "added " << mParams.size() << " param " << pTypeName << " [" << pData << "]" << std::endl;
 }
 
@@ -57,8 +161,8 @@ SQL::setFilterDataForNextParam(StoreableFilterBase* pFilter) {
 }
 
 void 
-SQL::setFilterDataForNextVar(void* pData, const char* pTypeName, const char* pSQLName, int pSQLPos) {
-  mVars.push_back(VarData(pData,pTypeName, pSQLName, pSQLPos));
+SQL::setFilterDataForNextVar(void* pData, const char* pTypeName, size_t pTypeKey, const char* pSQLName, int pSQLPos) {
+  mVars.push_back(VarData(pData,pTypeName,pTypeKey,pSQLName,pSQLPos));
   //std::cerr << "added " << mParams.size() << " param " << pTypeName << " [" << pData << "]" << std::endl;
 }
 
@@ -74,9 +178,9 @@ SQL::cstring(const FilterMapper& pMapper, const ConvSpec& pSpecs) const {
   return query;
 }
 
-int 
-SQL::getCountWithoutEscapes(const Placeholders& pPh) const {
-  int ret = 0;
+size_t
+SQL::getCountWithoutEscapes(const Placeholders& pPh) {
+  size_t ret = 0;
   for(Placeholders::const_iterator it = pPh.begin(); it != pPh.end(); it++) {
     switch(it->mConvertType) {
       case PARAM_ESCAPED:
@@ -97,7 +201,7 @@ SQL::convertParam(const FilterMapper& pMapper, const ConvSpec& pSpecs, const Par
     if (pData.mFilter != NULL) {
       filter = pData.mFilter.ptr();
     } else {
-      filter = &pMapper.findFilter(pData.mTypeName);
+      filter = &pMapper.findFilter(pData.mTypeKey);
       filter->updateRef(pData.mData->getPtr());
     }
     if (!filter->hasRef())
@@ -126,58 +230,119 @@ SQL::fillQueryParams(const FilterMapper& pMapper, const ConvSpec& pSpecs) const
   //this allows user to pass std::string queries with colons to streams 
   if (mParams.size() == 0) return mSQLQuery;
 
-  if (mParams.size() != getCountWithoutEscapes(mPlaceholders)) {
+  const Placeholders& placeholders(mTemplate->mPlaceholders);
+  if (mParams.size() != mTemplate->mParamCount) {
     std::stringstream error;
-    error << "Got " << mPlaceholders.size() << " placeholders but " << mParams.size() << " params was passed";
+    error << "Got " << placeholders.size() << " placeholders but " << mParams.size() << " params was passed";
     throw APIException(error.str());
   }
-  std::string ret(mSQLQuery);
-  if (mPlaceholders.size() != 0) {
-    Placeholders::const_iterator ph = mPlaceholders.end();
-    Params::const_iterator pa = mParams.end();
-    do {
-      ph--;
-      ParamVal rep;
-      switch(ph->mConvertType) {
-        case PARAM_STR_VALUE:
-          pa--;
-          rep = convertParam(pMapper,pSpecs,*pa);
-          if (!rep.mIsNull) rep.mValue = SQLUtils::escapeSQLData(rep.mValue);
-        break;
-        case PARAM_STR_LIKE:
-          pa--;
-          rep = convertParam(pMapper,pSpecs,*pa);
-          if (!rep.mIsNull) rep.mValue = SQLUtils::escapeSQLLike(rep.mValue);
-        break;
-        case PARAM_ESCAPED:
-          rep = ":";
-        break;
-        case PARAM_ESCAPE_CHAR:
-          rep = " ESCAPE '!'";
-        break;
-        default:
-          pa--;
-          rep = convertParam(pMapper,pSpecs,*pa);
-        break;
-      }
-      if (ph->mShouldQuote && !rep.mIsNull) {
-        rep.mValue.insert(0,"'");
-        rep.mValue.append("'");
-      };
-      ret.replace(ph->mIndex,2,rep.mValue);
-    } while(ph != mPlaceholders.begin());
-  };
+  std::string ret;
+  ret.reserve(mSQLQuery.size() + mParams.size() * 16);
+  std::vector<std::string>::const_iterator seg = mTemplate->mSegments.begin();
+  Params::const_iterator pa = mParams.begin();
+  for(Placeholders::const_iterator ph = placeholders.begin(); ph != placeholders.end(); ph++, seg++) {
+    ret.append(*seg);
+    ParamVal rep;
+    switch(ph->mConvertType) {
+      case PARAM_STR_VALUE:
+        rep = convertParam(pMapper,pSpecs,*pa++);
+        if (!rep.mIsNull) rep.mValue = SQLUtils::escapeSQLData(rep.mValue);
+      break;
+      case PARAM_STR_LIKE:
+        rep = convertParam(pMapper,pSpecs,*pa++);
+        if (!rep.mIsNull) rep.mValue = SQLUtils::escapeSQLLike(rep.mValue);
+      break;
+      case PARAM_ESCAPED:
+        ret.append(1,':');
+        continue;
+      case PARAM_ESCAPE_CHAR:
+        ret.append(" ESCAPE '!'");
+        continue;
+      default:
+        rep = convertParam(pMapper,pSpecs,*pa++);
+      break;
+    }
+    if (ph->mShouldQuote && !rep.mIsNull) {
+      ret.append(1,'\'');
+      ret.append(rep.mValue);
+      ret.append(1,'\'');
+    } else {
+      ret.append(rep.mValue);
+    }
+  }
+  ret.append(*seg);
   //std::cerr << "Full query: [" << ret.c_str() << "]" << std::endl;
   return ret;
 }
 
+bool
+SQL::prepare(const FilterMapper& pMapper, const ConvSpec& pSpecs, DbConnection::param_style pStyle, std::string& pStatement, DbParams& pParams) const {
+  if (pStyle == DbConnection::PARAMS_NONE || mParams.size() == 0 || !mTemplate->mNative)
+    return false;
+
+  const Placeholders& placeholders(mTemplate->mPlaceholders);
+  if (mParams.size() != mTemplate->mParamCount) {
+    std::stringstream error;
+    error << "Got " << placeholders.size() << " placeholders but " << mParams.size() << " params was passed";
+    throw APIException(error.str());
+  }
+  pStatement.clear();
+  pStatement.reserve(mSQLQuery.size() + mParams.size() * 2);
+  pParams.clear();
+  pParams.reserve(mParams.size());
+  std::vector<std::string>::const_iterator seg = mTemplate->mNativeSegments.begin();
+  Params::const_iterator pa = mParams.begin();
+  for(Placeholders::const_iterator ph = placeholders.begin(); ph != placeholders.end(); ph++, seg++) {
+    pStatement.append(*seg);
+    if (ph->mConvertType == PARAM_ESCAPED) {
+      pStatement.append(1,':');
+      continue;
+    }
+    DbParam param;
+    switch(ph->mConvertType) {
+      case PARAM_INT:
+        param.mType = DbParam::INTEGER;
+      break;
+      case PARAM_FLOAT:
+        param.mType = DbParam::FLOAT;
+      break;
+      default:
+        param.mType = DbParam::TEXT;
+      break;
+    }
+    ParamVal val(convertParam(pMapper,pSpecs,*pa++));
+    param.mIsNull = val.mIsNull;
+    if (!val.mIsNull)
+      param.mValue.swap(val.mValue);
+    pParams.push_back(param);
+    if (pStyle == DbConnection::PARAMS_NUMBERED) {
+      pStatement.append(1,'$');
+      pStatement.append(toStr((int)pParams.size()));
+    } else {
+      pStatement.append(1,'?');
+    }
+  }
+  pStatement.append(*seg);
+  return true;
+}
+
 void 
 SQL::appendData(const SQL& pQuery) {
   appendFilterData(pQuery);
-  Placeholders h(pQuery.mPlaceholders);
-  for(Placeholders::iterator it = h.begin(); it != h.end(); it++)
-    it->mIndex += mSQLQuery.length();
-  mPlaceholders.insert(mPlaceholders.end(),h.begin(),h.end());
+  //merged query is not put into template cache
+  shared_ptr<QueryTemplate> t(new QueryTemplate(*mTemplate));
+  const QueryTemplate& from(*pQuery.mTemplate);
+  for(Placeholders::const_iterator it = from.mPlaceholders.begin(); it != from.mPlaceholders.end(); it++) {
+    t->mPlaceholders.push_back(*it);
+    t->mPlaceholders.back().mIndex += mSQLQuery.length();
+  }
+  t->mSegments.back() += from.mSegments.front();
+  t->mSegments.insert(t->mSegments.end(),from.mSegments.begin() + 1,from.mSegments.end());
+  t->mNativeSegments.back() += from.mNativeSegments.front();
+  t->mNativeSegments.insert(t->mNativeSegments.end(),from.mNativeSegments.begin() + 1,from.mNativeSegments.end());
+  t->mParamCount += from.mParamCount;
+  t->mNative = t->mNative && from.mNative && std::count(mSQLQuery.begin(),mSQLQuery.end(),'\'') % 2 == 0;
+  mTemplate = t;
   mSQLQuery += pQuery.mSQLQuery;
 }
 
@@ -211,7 +376,7 @@ SQL::updateVars(DbResult& pRes, const FilterMapper& pMapper, const ConvSpec& pSp
     if (it->mFilter != NULL) {
       filter = it->mFilter;
     } else {
-      filter = &pMapper.findFilter(it->mTypeName);
+      filter = &pMapper.findFilter(it->mTypeKey);
       filter->updateRef(it->mData);
     }
 
@@ -15,14 +15,15 @@
 #include <typeinfo>
 #include <vector>
 #include <deque>
+#include <map>
 #include <string>
 #include "dba/database.h"
 #include "dba/storeablefilter.h"
 #include "dba/shared_ptr.h"
+#include "dba/filtermapper.h"
 
 namespace dba {
 
-class FilterMapper;
 class ConvSpec;
 
 /**
@@ -37,6 +38,10 @@ class ConvSpec;
 
   You can escape ":" by putting double "::" in query.
 
+  Query string is parsed only once per process - parsed placeholders are kept in
+  thread safe cache keyed by query text and shared by all SQL objects created from
+  the same string, so use placeholders instead of pasting data into query.
+
   Conversion between database type and C++ type is done using StoreableFilter instances. dba::SQLArchive has 
   default mappings for all C++ types for which Debea provides filters. You can change those mappings using
   SQLArchive::mapType(). You can add new filters for other C++ types in the same way.
@@ -56,7 +61,7 @@ class ConvSpec;
 */
 class dbaDLLEXPORT SQL {
   private:
-    class DataContainerBase {
+    class DataContainerBase : public RefCounted {
       public:
         virtual void* getPtr() const = 0;
         virtual ~DataContainerBase(){};
@@ -65,15 +70,16 @@ class dbaDLLEXPORT SQL {
     };
 
     /**
-      Owns variable of any type
+      Owns copy of variable of any type. Copy is stored in container
+      to create parameter with one allocation.
     */
     template <typename T> class DataContainer : public DataContainerBase {
       public:
-        DataContainer(T* pData) { mData = pData; }
-        virtual void* getPtr() const { return mData; }
-        virtual ~DataContainer() { delete mData; }
+        DataContainer(const T& pData) : mData(pData) {}
+        virtual void* getPtr() const { return const_cast<T*>(&mData); }
+        virtual ~DataContainer() {}
       private:
-        T* mData;
+        T mData;
     };
   public:
     /** Next position in sql SELECT*/
@@ -90,15 +96,29 @@ class dbaDLLEXPORT SQL {
       @param pData %SQL query data
     */
     SQL(const std::string& pData);
-    void setFilterDataForNextParam(DataContainerBase* pData, const char* pTypeName);
+    void setFilterDataForNextParam(DataContainerBase* pData, const char* pTypeName, size_t pTypeKey);
     void setFilterDataForNextParam(StoreableFilterBase* pFilter);
-    void setFilterDataForNextVar(void* pData, const char* pTypeName, const char* pSQLName = NULL, int pSQLPos = VAR_INDEX_UNDEFINED);
+    void setFilterDataForNextVar(void* pData, const char* pTypeName, size_t pTypeKey, const char* pSQLName = NULL, int pSQLPos = VAR_INDEX_UNDEFINED);
     void setFilterDataForNextVar(StoreableFilterBase* pFilter, const char* pSQLName = NULL, int pSQLPos = VAR_INDEX_UNDEFINED);
     /**
       Create %SQL query string replacing parameter specifiers with data using pMapper as
       filter database and pSpecs for conversion specification
     */
     virtual std::string cstring(const FilterMapper& pMapper, const ConvSpec& pSpecs) const; 
+    /**
+      Create %SQL statement for native parameter binding. Placeholders are replaced
+      with parameter markers of connection and param data is converted into pParams.
+      @param pMapper filter database
+      @param pSpecs conversion specification
+      @param pStyle parameter markers used by connection
+      @param pStatement set to %SQL statement with parameter markers
+      @param pParams filled with values of parameters
+      Placeholder that is the whole quoted string, like <tt>':s'</tt>, is replaced by parameter marker
+      without quotes.
+      @return false if query has no params or cannot be sent with native parameters,
+      for example if placeholder is part of longer quoted string. Use cstring() in that case.
+    */
+    bool prepare(const FilterMapper& pMapper, const ConvSpec& pSpecs, DbConnection::param_style pStyle, std::string& pStatement, DbParams& pParams) const;
     /**
       update variables defined by into() from DbResult.
     */
@@ -116,8 +136,8 @@ class dbaDLLEXPORT SQL {
       Specify const char* data for query parameter
     */
     SQL& operator<< (const char* pData) {
-      DataContainerBase* data = new DataContainer<std::string>(new std::string(pData));
-      setFilterDataForNextParam(data,typeid(std::string).name());
+      DataContainerBase* data = new DataContainer<std::string>(std::string(pData));
+      setFilterDataForNextParam(data,typeid(std::string).name(),FilterMapper::getTypeKey<std::string>());
       return *this;
     }
 
@@ -135,8 +155,8 @@ class dbaDLLEXPORT SQL {
       @param pData C++ variable with data for query parameter
     */
     template <typename T> SQL& operator<<(const T& pData) {
-      DataContainerBase* data = new DataContainer<T>(new T(pData));
-      setFilterDataForNextParam(data,typeid(pData).name());
+      DataContainerBase* data = new DataContainer<T>(pData);
+      setFilterDataForNextParam(data,typeid(pData).name(),FilterMapper::getTypeKey<T>());
       return *this;
     }
 
@@ -145,7 +165,7 @@ class dbaDLLEXPORT SQL {
       @param pVar reference to output variable
     */
     template <typename T> SQL& into(T& pVar) {
-      setFilterDataForNextVar(&pVar,typeid(pVar).name());
+      setFilterDataForNextVar(&pVar,typeid(pVar).name(),FilterMapper::getTypeKey<T>());
       return *this;
     }
 
@@ -165,6 +185,15 @@ class dbaDLLEXPORT SQL {
     dba::SQL& operator+ (const SQL& pFrom);
     dba::SQL& operator+= (const SQL& pFrom);
 
+    /**
+      Remove all parsed queries from process wide template cache.
+    */
+    static void clearTemplateCache();
+    /**
+      Get number of parsed queries in process wide template cache.
+    */
+    static size_t getTemplateCacheSize();
+
     virtual ~SQL();
   protected:
     void parseQuery();
@@ -185,19 +214,23 @@ class dbaDLLEXPORT SQL {
     */
     class  ParamData {
       public:
-        ParamData(DataContainerBase* pData, const char* pTypeName)
+        ParamData(DataContainerBase* pData, const char* pTypeName, size_t pTypeKey)
           : mData(pData),
             mTypeName(pTypeName),
+            mTypeKey(pTypeKey),
             mFilter(NULL)
         {}
         ParamData(StoreableFilterBase* pFilter)
           : mData(NULL),
             mTypeName(NULL),
+            mTypeKey(0),
             mFilter(pFilter)
         {}
         ~ParamData() {}
         shared_ptr<DataContainerBase> mData;
         const char* mTypeName;
+        /** key of type in FilterMapper, resolved when param is added */
+        size_t mTypeKey;
         shared_ptr<StoreableFilterBase> mFilter;
     };
 
@@ -207,9 +240,10 @@ class dbaDLLEXPORT SQL {
     */
     class VarData {
       public:
-        VarData(void* pData, const char* pTypeName, const char* pSQLName, int pSQLIndex = VAR_INDEX_UNDEFINED)
+        VarData(void* pData, const char* pTypeName, size_t pTypeKey, const char* pSQLName, int pSQLIndex = VAR_INDEX_UNDEFINED)
           : mData(pData),
             mTypeName(pTypeName),
+            mTypeKey(pTypeKey),
             mFilter(NULL),
             mSQLName(pSQLName),
             mSQLIndex(pSQLIndex),
@@ -218,6 +252,7 @@ class dbaDLLEXPORT SQL {
         VarData(StoreableFilterBase* pFilter, const char* pSQLName, int pSQLIndex = VAR_INDEX_UNDEFINED)
           : mData(NULL),
             mTypeName(NULL),
+            mTypeKey(0),
             mFilter(pFilter),
             mSQLName(pSQLName),
             mSQLIndex(pSQLIndex),
@@ -227,6 +262,8 @@ class dbaDLLEXPORT SQL {
         bool hasIndex() const { return mSQLIndex != VAR_INDEX_UNDEFINED; }
         void* mData;
         const char* mTypeName;
+        /** key of type in FilterMapper, resolved when var is added */
+        size_t mTypeKey;
         const char* mSQLName;
         int mSQLIndex;
         Database::StoreType mStoreType;
@@ -281,6 +318,28 @@ class dbaDLLEXPORT SQL {
         void checkSQLLike(const std::string::iterator& pPos);
     };
 
+    /**
+      Result of parsing %SQL query string. Holds placeholders and
+      literal parts of query between them, so query with params can
+      be created by concatenation. Templates are shared between
+      all SQL objects created from the same query string.
+    */
+    class QueryTemplate : public RefCounted {
+      public:
+        QueryTemplate() : mParamCount(0), mNative(false) {};
+        void split(const std::string& pSQLQuery);
+        static bool isWholeLiteral(const std::string& pBefore, const std::string& pAfter);
+        Placeholders mPlaceholders;
+        /** literal parts of query, one more than placeholders */
+        std::vector<std::string> mSegments;
+        /** literal parts of query for native parameter markers, quotes of literals that hold only placeholder are removed */
+        std::vector<std::string> mNativeSegments;
+        /** number of placeholders that needs param */
+        size_t mParamCount;
+        /** true if all placeholders can be replaced by native parameter markers */
+        bool mNative;
+    };
+
     class ParamVal {
       public:
         ParamVal() {};
@@ -292,12 +351,17 @@ class dbaDLLEXPORT SQL {
 
     Params mParams;
     Vars mVars;
-    Placeholders mPlaceholders;
+    typedef std::map<std::string, shared_ptr<QueryTemplate> > TemplateCache;
+
+    shared_ptr<QueryTemplate> mTemplate;
     std::string mSQLQuery;
 
+    static TemplateCache& getTemplateCache();
+    static shared_ptr<QueryTemplate> getTemplate(const std::string& pSQLQuery);
+
     std::string fillQueryParams(const FilterMapper& pMapper, const ConvSpec& pSpecs) const;
     ParamVal convertParam(const FilterMapper& pMapper, const ConvSpec& pSpecs, const ParamData& pData) const;
-    int getCountWithoutEscapes(const Placeholders& pPh) const;
+    static size_t getCountWithoutEscapes(const Placeholders& pPh);
 };
 
 dba::SQL
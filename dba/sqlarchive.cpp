@@ -54,7 +54,9 @@ SQLArchive::mapType(const std::type_info& pType, StoreableFilterBase* pFilter) {
 
 SQLArchive::SQLArchive(Database* pDb)
   : mDb(pDb),
-    mPlugin(NULL)
+    mPlugin(NULL),
+    mObjectCache(NULL),
+    mQueryCache(NULL)
 {
   mFetcher = NULL;
   setDatabase(pDb);
@@ -64,6 +66,7 @@ void
 SQLArchive::open(const char* pConnectStr) {
 //  cerr << "SQL archvie: creating connection" << endl;
   mConnectStr = pConnectStr;
+  refreshSchema();
   getFreeConnection();
 };
 
@@ -102,7 +105,7 @@ SQLArchive::getIdFetcher() const {
 #ifdef DBA_COMPAT_1_0
 SQLIStream*
 SQLArchive::getOIStream() {
-  DbConnection* conn = getFreeConnection();
+  DbConnection* conn = getReadConnection();
   SQLIStream* stream = new SQLIStream(conn,&mFilterMapper);
   return stream;
 };
@@ -117,8 +120,10 @@ SQLArchive::getOOStream() {
 
 IStream*
 SQLArchive::getInputStream() {
-  DbConnection* conn = getFreeConnection();
+  DbConnection* conn = getReadConnection();
   SQLIStream* stream = new SQLIStream(conn,&mFilterMapper);
+  stream->mObjectCache = mObjectCache;
+  stream->mQueryCache = mQueryCache;
   return stream;
 };
 
@@ -126,13 +131,17 @@ OStream*
 SQLArchive::getOutputStream() {
   DbConnection* conn = getFreeConnection();
   SQLOStream* stream = new SQLOStream(conn,mFetcher,&mFilterMapper);
+  stream->mObjectCache = mObjectCache;
+  stream->mQueryCache = mQueryCache;
   return stream;
 };
 
 SQLIStream
 SQLArchive::getIStream() {
-  DbConnection* conn = getFreeConnection();
+  DbConnection* conn = getReadConnection();
   SQLIStream stream(conn,&mFilterMapper);
+  stream.mObjectCache = mObjectCache;
+  stream.mQueryCache = mQueryCache;
   return stream;
 };
 
@@ -140,39 +149,51 @@ SQLOStream
 SQLArchive::getOStream() {
   DbConnection* conn = getFreeConnection();
   SQLOStream stream(conn,mFetcher,&mFilterMapper);
+  stream.mObjectCache = mObjectCache;
+  stream.mQueryCache = mQueryCache;
   return stream;
 };
 
 DbConnection*
 SQLArchive::getFreeConnection(bool pRelease) {
-  for(std::list<DbConnection*>::iterator it = mConnections.begin(); it != mConnections.end(); it++) {
+  return getFreeConnection(mConnections,mConnectStr,pRelease);
+};
+
+DbConnection*
+SQLArchive::getFreeConnection(std::list<DbConnection*>& pPool, const std::string& pConnectStr, bool pRelease) {
+  for(std::list<DbConnection*>::iterator it = pPool.begin(); it != pPool.end(); it++) {
     if (!(*it)->isUsed()) {
       if (!pRelease) {
         return *it;
       } else {
         DbConnection* ret(*it);
-        mConnections.erase(it);
+        pPool.erase(it);
         return ret;
       }
       break;
     };
   };
-  std::cerr << "creating new connection (params: [" << mConnectStr << "], currently open: " << mConnections.size() << ")" << std::endl;
+  std::cerr << "creating new connection (params: [" << pConnectStr << "], currently open: " << pPool.size() << ")" << std::endl;
   if (mDb == NULL) {
     throw APIException("Database not initialized, cannot create connection");
   };
-  DbConnection* ret = mDb->getConnection(mConnectStr.c_str());
+  DbConnection* ret = mDb->getConnection(pConnectStr.c_str());
   if (ret == NULL) {
     throw DatabaseException("Cannot initialize connection to database");
   };
   ret->setErrorHandler(this,&handleError);
   if (!pRelease) {
-    mConnections.push_front(ret);
+    pPool.push_front(ret);
   };
 //  cerr << "assigning connection" << endl;
   return ret;
 };
 
+DbConnection*
+SQLArchive::getReadConnection() {
+  return getFreeConnection();
+};
+
 int
 SQLArchive::getAvailableConnections() const {
   int avail = 0;
@@ -205,6 +226,28 @@ SQLArchive::getTableNames() {
   return conn->getRelationNames();
 };
 
+shared_ptr<Schema>
+SQLArchive::getSchema() {
+  if (!mSchema || mSchema->isOutdated()) {
+    refreshSchema();
+    mSchema = new Schema(*this);
+  };
+  return mSchema;
+};
+
+void
+SQLArchive::refreshSchema() {
+  //snapshot can be still used by others, but it cannot use our connections
+  if (mSchema.getCount() != 0)
+    mSchema->detach();
+  mSchema = shared_ptr<Schema>();
+};
+
+void
+SQLArchive::checkSchema(Storeable& pObject, const char* pRootTableName) {
+  getSchema()->check(pObject.st_getTable(),pRootTableName);
+};
+
 Database* 
 SQLArchive::getDatabase() {
   return mDb;
@@ -213,6 +256,7 @@ SQLArchive::getDatabase() {
 void 
 SQLArchive::setDatabase(Database* pDb) {
   destroyPlugin();
+  refreshSchema();
   mDb = pDb;
   if (mDb != NULL)
     mDb->setErrorHandler(this,&handleError);
@@ -13,10 +13,13 @@
 #include "dba/sqlistream.h"
 #include "dba/sqlostream.h"
 #include "dba/filtermapper.h"
+#include "dba/schema.h"
 
 namespace dba {
 
 class DbPlugin;
+class ObjectCache;
+class QueryCache;
 
 /**
   Archive of objects stored in %SQL database
@@ -26,6 +29,7 @@ class dbaDLLEXPORT SQLArchive : public Archive {
   //FIXME allow NULL table names in binded vars - this should store binded var in the youngest child table
   //FIXME add API for calling stored procedures
   //FIXME improve connection management by closing too many open connections.
+    friend class Schema;
   public:
     /**
       default error handler for archive. It throws SQLException or DatabaseException depends on error type.
@@ -127,10 +131,32 @@ class dbaDLLEXPORT SQLArchive : public Archive {
     */
     int getAvailableConnections() const;
     /**
-      Get list of available tables. Must be called after open()
+      Get list of available tables. Must be called after open().
+      Names are read from database catalog on every call.
       @return list of names of available %SQL tables
     */
     std::list<std::string> getTableNames();
+    /**
+      Get snapshot of database schema. Schema is read from database on first call
+      and cached until refreshSchema() is called or schema is changed using
+      SQLOStream::sendUpdate(). Must be called after open()
+      @return schema snapshot
+    */
+    shared_ptr<Schema> getSchema();
+    /**
+      Drop cached schema snapshot, next call to getSchema() will read schema from
+      database again. Call this after schema is changed by other processes.
+    */
+    void refreshSchema();
+    /**
+      Check if all relations and columns used by object store table exist in
+      database. Use it on startup to find errors in STORE_TABLE definitions before
+      first query is sent.
+      @param pObject object to check
+      @param pRootTableName overridden name of root table or NULL
+      @throw DataException with list of missing relations and columns
+    */
+    void checkSchema(Storeable& pObject, const char* pRootTableName = NULL);
     /**
       Set new conversion specification for archive. Call to this method will update
       conversion specification on internal database object and all 
@@ -163,6 +189,18 @@ class dbaDLLEXPORT SQLArchive : public Archive {
       @param pRelease if true then remove connection from connection pool
     */
     DbConnection* getFreeConnection(bool pRelease = false);
+    /**
+      Get or allocate new connection from given connection pool
+      @param pPool list of open connections
+      @param pConnectStr connect string used to create new connection
+      @param pRelease if true then remove connection from connection pool
+    */
+    DbConnection* getFreeConnection(std::list<DbConnection*>& pPool, const std::string& pConnectStr, bool pRelease);
+    /**
+      Get connection for input streams. Default implementation
+      returns getFreeConnection()
+    */
+    virtual DbConnection* getReadConnection();
     /**
       Pointer to internal database object 
     */
@@ -189,10 +227,22 @@ class dbaDLLEXPORT SQLArchive : public Archive {
       Mappings for creating %SQL queries from SQL object in streams
     */
     FilterMapper mFilterMapper;
+    /**
+      Cache of objects shared by streams created by archive or NULL if not used
+    */
+    ObjectCache* mObjectCache;
+    /**
+      Cache of query results shared by streams created by archive or NULL if not used
+    */
+    QueryCache* mQueryCache;
+    /**
+      Cached schema snapshot or NULL if not read yet
+    */
+    shared_ptr<Schema> mSchema;
     //!close all connnections and delete mPlugin and mDb (if owned, see mPlugin description)
     void destroyPlugin();
     //!close all connections to database
-    void closeAllConnections();
+    virtual void closeAllConnections();
   private:
 };
 
@@ -9,6 +9,7 @@
 #ifndef DBASQLIDFETCHER_H
 #define DBASQLIDFETCHER_H
 
+#include <vector>
 #include "dba/defs.h"
 
 namespace dba {
@@ -30,6 +31,22 @@ class dbaDLLEXPORT SQLIdFetcher {
       @param pRootTableName table name
     */
     virtual int getNextId(DbConnection& pConn, const char* pRootTableName) = 0;
+    /**
+      Get many object ids at once. Used by streams that pipeline commands, because
+      queries sent by fetcher have to wait for all pipelined commands.
+      Default implementation calls getNextId() pCount times, so every id still costs
+      a round trip to database and pipelined commands gain nothing. Fetchers that
+      can reserve range of ids with one query (like GenericFetcher, or postgres
+      sequence with large increment) should override this method.
+      @param pConn database connection
+      @param pRootTableName table name
+      @param pCount number of ids to get
+      @param pIds vector where ids are appended
+    */
+    virtual void getNextIds(DbConnection& pConn, const char* pRootTableName, int pCount, std::vector<int>& pIds) {
+      for(int i = 0; i < pCount; i++)
+        pIds.push_back(getNextId(pConn,pRootTableName));
+    };
 };
 
 };//namespace
@@ -11,31 +11,25 @@
 #include "dba/sqlutils.h"
 #include "dba/exception.h"
 #include "dba/storeablefilter.h"
+#include "dba/watchdog.h"
+#include "dba/storemember.h"
 
 namespace dba {
 
 using namespace std;
 
 string
-createSelectFields(mt_class* pFirst) {
+createSelectFields(const mt_mlist& pList) {
   string data;
   string table;
-  mt_class* current = pFirst;
-  if (current->name != NULL)
-    data += string(current->name) + ".id as id";
-  while(current->name != NULL) {
+  if (!pList.empty())
+    data += string(pList.begin()->name) + ".id as id";
+  for(const mt_class* current = pList.begin(); current != pList.end(); current++) {
     table = string(current->name) + ".";
-    mt_member* field = current->firstField;
-    while(field->name != NULL) {
+    for(const mt_member* field = current->first; field != current->last; field++) {
       data += ",";
       data += table + string(field->name) + " as " + field->name;
-      field = field->next;
-      if (field == NULL)
-        break;
     };
-    current = current->next;
-    if (current == NULL)
-      break;
   };
   //hack for proper comma with empty store table and some binded vars
   return data;
@@ -43,36 +37,31 @@ createSelectFields(mt_class* pFirst) {
 
 
 string
-createJoins(mt_class* pFirst) {
-  mt_class* current = pFirst;
+createJoins(const mt_mlist& pList) {
   string data;
-  if (current->name == NULL)
+  if (pList.empty())
     return data;
+  const mt_class* current = pList.begin();
   data = current->name;
-  while(current->name != NULL) {
-    std::string left_table = current->name;
-    current = current->next;
-    if (current == NULL)
-      break;
-    if (current->name == NULL)
-      break;
+  for(current++; current != pList.end(); current++) {
+    const char* left_table = (current - 1)->name;
     data += string(" INNER JOIN ") + string(current->name);
-    data += " ON " + left_table + ".id = " + string(current->name) + ".id";
+    data += " ON " + string(left_table) + ".id = " + string(current->name) + ".id";
   };
   return data;
 };
 
 
 string
-createSelect(int id, mt_class* pFirst) {
+createSelect(int id, const mt_mlist& pList) {
   string query = "SELECT ";
 //  cerr << "creating select fields " << endl;
-  query += createSelectFields(pFirst);
+  query += createSelectFields(pList);
   query += " FROM ";
 //  cerr << "creating joins " << endl;
-  query += createJoins(pFirst);
+  query += createJoins(pList);
   query += " WHERE ";
-  query += string(pFirst->name) + ".id = " + toStr(id);
+  query += string(pList.begin()->name) + ".id = " + toStr(id);
   return query;
 };
 
@@ -84,6 +73,13 @@ SQLIStream::SQLIStream(DbConnection* pConn, FilterMapper* pMapper)
   mConn->incUsed();
   mRowFetched = false;
   mWhereSet = WHERE_NOT_SET;
+  mQueryTimeout = 0;
+  mDeadline = 0;
+  mObjectCache = NULL;
+  mQueryCache = NULL;
+  mCacheable = false;
+  mCacheGeneration = 0;
+  mWhereId = Storeable::InvalidId;
 };
 
 SQLIStream::SQLIStream(const SQLIStream& pStream)
@@ -94,8 +90,17 @@ SQLIStream::SQLIStream(const SQLIStream& pStream)
     mWherePart(pStream.mWherePart),
     mFromPart(pStream.mFromPart),
     mQuery(pStream.mQuery),
+    mQueryParams(pStream.mQueryParams),
     mRowFetched(pStream.mRowFetched),
-    mWhereSet(pStream.mWhereSet)
+    mWhereSet(pStream.mWhereSet),
+    mQueryTimeout(pStream.mQueryTimeout),
+    mDeadline(pStream.mDeadline),
+    mIdentityMap(pStream.mIdentityMap),
+    mObjectCache(pStream.mObjectCache),
+    mQueryCache(pStream.mQueryCache),
+    mCacheable(pStream.mCacheable),
+    mCacheGeneration(pStream.mCacheGeneration),
+    mWhereId(pStream.mWhereId)
 {
   mConn->incUsed();
 };
@@ -109,8 +114,17 @@ SQLIStream::operator=(const SQLIStream& pStream) {
   mWherePart = pStream.mWherePart;
   mFromPart = pStream.mFromPart;
   mQuery = pStream.mQuery;
+  mQueryParams = pStream.mQueryParams;
   mRowFetched = pStream.mRowFetched;
   mWhereSet = pStream.mWhereSet;
+  mQueryTimeout = pStream.mQueryTimeout;
+  mDeadline = pStream.mDeadline;
+  mIdentityMap = pStream.mIdentityMap;
+  mObjectCache = pStream.mObjectCache;
+  mQueryCache = pStream.mQueryCache;
+  mCacheable = pStream.mCacheable;
+  mCacheGeneration = pStream.mCacheGeneration;
+  mWhereId = pStream.mWhereId;
 
   mConn->incUsed();
   return *this;
@@ -123,6 +137,13 @@ SQLIStream::open(Storeable& pClass, const char* pMainTable) {
     mWherePart = string();
   IStream::open(pClass,pMainTable);
   mResult = NULL;
+  //objects with collections would be cached without children
+  mCacheable = mObjectCache != NULL;
+  for(const ColTable* tbl = getColTable(pClass); tbl != NULL && mCacheable; tbl = tbl->getNextTable())
+    mCacheable = tbl->getMembers() == NULL;
+  //taken before query is sent, so objects erased during read are not cached
+  if (mCacheable)
+    mCacheGeneration = mObjectCache->getGeneration(getRootTableName(pClass));
   createSelect();
   doQuery();
   mWhereSet = WHERE_NOT_SET;
@@ -134,7 +155,12 @@ SQLIStream::openFromQuery(Storeable& pClass, const SQL& pQuery, const char* pMai
     mWherePart = string();
   IStream::open(pClass, pMainTable);
   mResult = NULL;
-  mQuery = pQuery.cstring(*mFilterMapper,getConversionSpecs());
+  //custom query may not return all members
+  mCacheable = false;
+  if (!pQuery.prepare(*mFilterMapper,getConversionSpecs(),mConn->getParamStyle(),mQuery,mQueryParams)) {
+    mQuery = pQuery.cstring(*mFilterMapper,getConversionSpecs());
+    mQueryParams.clear();
+  };
   doQuery();
   mWhereSet = WHERE_NOT_SET;
 };
@@ -154,6 +180,7 @@ void
 SQLIStream::setWhereId(int pId) {
   setWhere(SQL("id = :d") << pId);
   mWhereSet = WHERE_ID;
+  mWhereId = pId;
 };
 
 void
@@ -184,10 +211,11 @@ SQLIStream::createVarSelectFields() const {
 void
 SQLIStream::createSelect() {
   //No tables!
-  if (mMemberList->mFirst->name == NULL)
+  if (mMemberList->empty())
     throw APIException("No store tables for class");
+  mQueryParams.clear();
   mQuery = "SELECT ";
-  string sel = createSelectFields(mMemberList->mFirst);
+  string sel = createSelectFields(*mMemberList);
   string var = createVarSelectFields();
   if (sel.length()) {
     mQuery += sel;
@@ -197,11 +225,11 @@ SQLIStream::createSelect() {
   
   mQuery += " FROM ";
 //  cerr << "creating joins " << endl;
-  mQuery += createJoins(mMemberList->mFirst);
+  mQuery += createJoins(*mMemberList);
   mQuery += mFromPart;
   if (mWhereSet != WHERE_NOT_SET) {
     if (mWhereSet == WHERE_ID) {
-      mWherePart = mMemberList->mFirst->name + string(".") + mWherePart;
+      mWherePart = mMemberList->begin()->name + string(".") + mWherePart;
     };
     mQuery += + " WHERE " + mWherePart;
   };
@@ -209,14 +237,19 @@ SQLIStream::createSelect() {
 
 void
 SQLIStream::doQuery() {
-  mResult = mConn->sendQuery(mQuery);
+  TimeoutScope timeout(mConn,mQueryTimeout,mDeadline);
+  if (mQueryParams.empty())
+    mResult = mConn->sendQuery(mQuery);
+  else
+    mResult = mConn->sendQuery(mQuery.c_str(),mQueryParams);
   mIsOpen = true;
   mRowFetched = false;
 };
 
 bool
 SQLIStream::updateVars() {
-  if (!mResult->fetchRow())
+  TimeoutScope timeout(mConn,mQueryTimeout,mDeadline);
+  if (!timeout.fetchRow(*mResult))
     return false;
   mRowFetched = true;
   fillBindedVars();
@@ -225,19 +258,24 @@ SQLIStream::updateVars() {
 
 void
 SQLIStream::applyFilter(DbResult& pRes, StoreableFilterBase& pFilter, const char* pFieldName, Database::StoreType pFieldType) {
-  if (!pRes.isNull(pFieldName)) {
+  applyFilter(pRes,pFilter,pRes.getColumnIndex(pFieldName),pFieldType);
+};
+
+void
+SQLIStream::applyFilter(DbResult& pRes, StoreableFilterBase& pFilter, int pColumn, Database::StoreType pFieldType) {
+  if (!pRes.isNull(pColumn)) {
     switch(pFieldType) {
       case Database::STRING:
-        pFilter.fromString(getConversionSpecs(), pRes.getString(pFieldName));
+        pFilter.fromString(getConversionSpecs(), pRes.getString(pColumn));
       break;
       case Database::INTEGER:
-        pFilter.fromInt(getConversionSpecs(), pRes.getInt(pFieldName));
+        pFilter.fromInt(getConversionSpecs(), pRes.getInt(pColumn));
       break;
       case Database::FLOAT:
-        pFilter.fromDouble(getConversionSpecs(), pRes.getDouble(pFieldName));
+        pFilter.fromDouble(getConversionSpecs(), pRes.getDouble(pColumn));
       break;
       case Database::DATE:
-        pFilter.fromDate(getConversionSpecs(), pRes.getDate(pFieldName));
+        pFilter.fromDate(getConversionSpecs(), pRes.getDate(pColumn));
       break;
       default:
         throw StoreableFilterException("Internal error: unknown DbResult value type when fetching db record");
@@ -248,23 +286,61 @@ SQLIStream::applyFilter(DbResult& pRes, StoreableFilterBase& pFilter, const char
   };
 };
 
+void
+SQLIStream::applyMember(DbResult& pRes, StoreTableMember& pMember, void* pData) {
+  int column = pRes.getColumnIndex(pMember.getMemberName());
+  //builtin filters with native data type are inlined here,
+  //conversions are the same as in fromXXX() and fromNull() of filter
+  switch(pMember.getFilterKind()) {
+    case StoreTableMember::INT_FILTER:
+      *(int*)pData = pRes.isNull(column) ? 0 : pRes.getInt(column);
+    break;
+    case StoreTableMember::BOOL_FILTER:
+      *(bool*)pData = pRes.isNull(column) ? false : pRes.getInt(column) == 1;
+    break;
+    case StoreTableMember::DOUBLE_FILTER:
+      *(double*)pData = pRes.isNull(column) ? 0 : pRes.getDouble(column);
+    break;
+    case StoreTableMember::FLOAT_FILTER:
+      *(float*)pData = pRes.isNull(column) ? 0 : static_cast<float>(pRes.getDouble(column));
+    break;
+    case StoreTableMember::STRING_FILTER:
+      if (pRes.isNull(column))
+        ((std::string*)pData)->erase();
+      else
+        ((std::string*)pData)->assign(pRes.getString(column));
+    break;
+    default: {
+      StoreableFilterBase* filter = pMember.getFilter();
+      filter->updateRef(pData);
+      applyFilter(pRes,*filter,column,(Database::StoreType)pMember.getDatabaseType());
+    };
+    break;
+  };
+};
+
 bool
 SQLIStream::getNext(Storeable* pObject) {
   const StoreTable* tbl = Stream::getTable(*pObject);
   string sdata;
   void *data;
   //object data
-  if (!mRowFetched)
-    if (!mResult->fetchRow())
+  if (!mRowFetched) {
+    TimeoutScope timeout(mConn,mQueryTimeout,mDeadline);
+    if (!timeout.fetchRow(*mResult))
       return false;
+  };
   mRowFetched = false;
   while(tbl != NULL) {
     StoreTableMember* member = tbl->getMembers();
     while (member != NULL) {
 //      cerr << "setting member binded to " << member << endl;
-      StoreableFilterBase* filter = member->getFilter();
-      filter->updateRef((char*)pObject + (int)(member->getMemberOffset() + tbl->getClassOffset()));
-      applyFilter(*mResult,*filter,member->getMemberName(),(Database::StoreType)member->getDatabaseType());
+      const TypedMemberEntry* typed = member->getTypedMember();
+      //members declared by BIND_MEMBER are converted by code generated for their type
+      if (typed != NULL)
+        typed->mLoad(*pObject,*mResult,mResult->getColumnIndex(member->getMemberName()),getConversionSpecs());
+      else
+        applyMember(*mResult,*member,(char*)pObject + (int)(member->getMemberOffset() + tbl->getClassOffset()));
       member = member->getNextMember();
     };
     tbl = tbl->getNextTable();
@@ -279,9 +355,25 @@ SQLIStream::getNext(Storeable* pObject) {
   };
   //update stored tables count in Storeable class
   Stream::setStoredTables(pObject,Stream::countTables(pObject));
+  if (mCacheable && pObject->isOk())
+    mObjectCache->put(*pObject,getRootTableName(*pObject),mCacheGeneration);
   return true;
 };
 
+bool
+SQLIStream::get(Storeable* pObject, const char* pRootTable) {
+  if (mObjectCache != NULL && mWhereSet == WHERE_ID && pRootTable == NULL && mBindings.empty() && !isOpen()) {
+    if (mObjectCache->get(*pObject,getRootTableName(*pObject),mWhereId)) {
+      Stream::alterId(pObject,mWhereId);
+      Stream::makeOk(pObject);
+      Stream::setStoredTables(pObject,Stream::countTables(pObject));
+      mWhereSet = WHERE_NOT_SET;
+      return true;
+    };
+  };
+  return IStream::get(pObject,pRootTable);
+};
+
 void
 SQLIStream::fillBindedVars() {
   for(VarMap::iterator it = mBindings.begin(); it != mBindings.end(); it++) {
@@ -306,13 +398,44 @@ SQLIStream::setIdsCondition(const char* pFKeyName, id pRelationId, const std::ve
 
 DbResult*
 SQLIStream::sendQuery(const SQL& pQuery) const {
-  DbResult* res = mConn->sendQuery(pQuery.cstring(*mFilterMapper,getConversionSpecs()));
-  return new SQLDbResult(res,*mFilterMapper,pQuery);
+  TimeoutScope timeout(mConn,mQueryTimeout,mDeadline);
+  std::string query;
+  DbParams params;
+  DbResult* res;
+  if (pQuery.prepare(*mFilterMapper,getConversionSpecs(),mConn->getParamStyle(),query,params))
+    res = mConn->sendQuery(query.c_str(),params);
+  else
+    res = mConn->sendQuery(pQuery.cstring(*mFilterMapper,getConversionSpecs()));
+  return new SQLDbResult(res,*mFilterMapper,pQuery,mConn,mQueryTimeout,mDeadline);
+};
+
+DbResult*
+SQLIStream::sendCachedQuery(const SQL& pQuery, const char* pTables) const {
+  if (mQueryCache == NULL)
+    return sendQuery(pQuery);
+  std::string query(pQuery.cstring(*mFilterMapper,getConversionSpecs()));
+  DbResult* cached = mQueryCache->find(query);
+  if (cached != NULL)
+    return cached;
+  unsigned long generation = mQueryCache->getGeneration(pTables);
+  std::auto_ptr<DbResult> res(sendQuery(pQuery));
+  return mQueryCache->store(query,pTables,generation,*res);
+};
+
+void
+SQLIStream::setQueryTimeout(unsigned long pMillis) {
+  mQueryTimeout = pMillis;
+};
+
+void
+SQLIStream::setDeadline(unsigned long pMillis) {
+  mDeadline = pMillis == 0 ? 0 : Watchdog::now() + pMillis;
 };
 
 bool 
 SQLIStream::SQLDbResult::fetchRow() {
-  bool ret = mResult->fetchRow();
+  TimeoutScope timeout(mConn,mQueryTimeout,mDeadline);
+  bool ret = timeout.fetchRow(*mResult);
   if (ret) {
     mQuery.updateVars(*mResult,mFilterMapper,mResult->getConversionSpecs());
   }
@@ -340,10 +463,13 @@ SQLIStream::getConversionSpecs() const {
   return mConn->getConversionSpecs();
 };
 
-SQLIStream::SQLDbResult::SQLDbResult(DbResult* pRes, const FilterMapper& pMapper, const SQL& pSQL)
+SQLIStream::SQLDbResult::SQLDbResult(DbResult* pRes, const FilterMapper& pMapper, const SQL& pSQL, DbConnection* pConn, unsigned long pQueryTimeout, unsigned long pDeadline)
   : mResult(pRes),
     mFilterMapper(pMapper),
-    mQuery(pSQL)
+    mQuery(pSQL),
+    mConn(pConn),
+    mQueryTimeout(pQueryTimeout),
+    mDeadline(pDeadline)
 { 
   setConversionSpecs(mResult->getConversionSpecs()); 
 }
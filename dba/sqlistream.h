@@ -12,6 +12,9 @@
 #include "dba/istream.h"
 #include "dba/sql.h"
 #include "dba/shared_ptr.h"
+#include "dba/identitymap.h"
+#include "dba/objectcache.h"
+#include "dba/querycache.h"
 
 namespace dba {
 
@@ -36,6 +39,16 @@ class dbaDLLEXPORT SQLIStream : public IStream {
     */
     const std::string& getQuery() const;
     virtual bool getNext(Storeable* pObject);
+    using IStream::get;
+    /**
+      Get single object. If WHERE was set using setWhereId() and class of object is 
+      enabled in ObjectCache of SharedSQLArchive then object is copied from cache 
+      without sending query to database.
+      @param pObject object to retrieve
+      @param pRootTable ovverided name of relation to retrieve from 
+      @sa IStream::get(Storeable*, const char*)
+    */
+    virtual bool get(Storeable* pObject, const char* pRootTable = NULL);
     /**
       Open stream for Storeable object
       @param pObject object type for stream preparation
@@ -70,12 +83,48 @@ class dbaDLLEXPORT SQLIStream : public IStream {
       @param pId id of object to load
     */
     virtual void setWhereId(int pId);
+    /**
+      Load single object with given id using get() and close stream. If stream was created from Transaction 
+      with enabled identity map then copy of already loaded object is returned without
+      sending query to database. Identity map is not used if there are variables binded
+      to stream.
+      @param pObject object to load
+      @param pId id of object
+      @param pRootTable custom name of pObject root store table
+      @return true if object was found
+      @sa Transaction::setIdentityMap()
+    */
+    template <typename T> bool load(T& pObject, id pId, const char* pRootTable = NULL);
     /**
       Send SQL query to database and get results.
-      Must be called before open or openFromQuery
+      Must be called before open or openFromQuery. Query params are bound
+      natively if connection supports it.
       @param pQuery query to send.
     */
     DbResult* sendQuery(const SQL& pQuery) const;
+    /**
+      Send SQL query using QueryCache of SharedSQLArchive. If the same query was sent 
+      before and none of tables it depends on was changed by SQLOStream since then, 
+      rows are returned from cache. If stream does not use cache then it works like sendQuery().
+      @param pQuery query to send
+      @param pTables comma separated list of tables that query reads from
+      @return query result
+      @sa SharedSQLArchive::getQueryCache()
+    */
+    DbResult* sendCachedQuery(const SQL& pQuery, const char* pTables) const;
+    /**
+      Set timeout for every query sent by this stream, including fetching
+      of rows. Query that runs longer is cancelled and TimeoutException is thrown.
+      @param pMillis timeout in miliseconds or 0 to disable timeout
+    */
+    void setQueryTimeout(unsigned long pMillis);
+    /**
+      Set deadline for all operations of this stream. Query that runs after deadline
+      is cancelled and TimeoutException is thrown. Streams copied from this stream
+      share the same deadline.
+      @param pMillis time from now in miliseconds or 0 to disable deadline
+    */
+    void setDeadline(unsigned long pMillis);
     /**
       Get conversion specification used by this stream.
       @return conversion specifications
@@ -89,7 +138,7 @@ class dbaDLLEXPORT SQLIStream : public IStream {
     */
     class SQLDbResult : public DbResult {
       public:
-        SQLDbResult(DbResult* pRes, const FilterMapper& pMapper, const SQL& pSQL);
+        SQLDbResult(DbResult* pRes, const FilterMapper& pMapper, const SQL& pSQL, DbConnection* pConn, unsigned long pQueryTimeout, unsigned long pDeadline);
         virtual int columns() const { return mResult->columns(); }
         virtual const DbColumn& getColumn(int pIndex) const { return mResult->getColumn(pIndex); }
         virtual int getColumnIndex(const char* pColumnName) const { return mResult->getColumnIndex(pColumnName); }
@@ -105,6 +154,9 @@ class dbaDLLEXPORT SQLIStream : public IStream {
         DbResult* mResult;
         const FilterMapper& mFilterMapper;
         SQL mQuery;
+        DbConnection* mConn;
+        unsigned long mQueryTimeout;
+        unsigned long mDeadline;
     }; 
 
     typedef enum {
@@ -119,6 +171,8 @@ class dbaDLLEXPORT SQLIStream : public IStream {
     void doQuery();
     void fillBindedVars();
     void applyFilter(DbResult& pRes, StoreableFilterBase& pFilter, const char* pFieldName, Database::StoreType pFieldType);
+    void applyFilter(DbResult& pRes, StoreableFilterBase& pFilter, int pColumn, Database::StoreType pFieldType);
+    void applyMember(DbResult& pRes, StoreTableMember& pMember, void* pData);
     virtual void setIdsCondition(const char* pFKeyName, id pRelationId, const std::vector<id>& pIds);
 
     shared_ptr<DbResult> mResult;
@@ -127,8 +181,43 @@ class dbaDLLEXPORT SQLIStream : public IStream {
     std::string mWherePart;
     std::string mFromPart;
     std::string mQuery;
+    //!params for native parameter markers in mQuery
+    DbParams mQueryParams;
     bool mRowFetched;
     whereType mWhereSet;
+    unsigned long mQueryTimeout;
+    unsigned long mDeadline;
+    shared_ptr<IdentityMap> mIdentityMap;
+    ObjectCache* mObjectCache;
+    QueryCache* mQueryCache;
+    bool mCacheable;
+    //!generation of object cache table taken when query was sent
+    unsigned long mCacheGeneration;
+    id mWhereId;
+};
+
+template <typename T>
+bool
+SQLIStream::load(T& pObject, id pId, const char* pRootTable) {
+  if (!mIdentityMap || !mIdentityMap->isEnabled() || !mBindings.empty()) {
+    setWhereId(pId);
+    bool ret = get(&pObject, pRootTable);
+    close();
+    return ret;
+  };
+  std::string table(pRootTable != NULL ? pRootTable : getRootTableName(pObject));
+  const T* cached = mIdentityMap->find<T>(table, pId);
+  if (cached != NULL) {
+    pObject = *cached;
+    return true;
+  };
+  setWhereId(pId);
+  bool ret = get(&pObject, pRootTable);
+  close();
+  if (!ret)
+    return false;
+  mIdentityMap->insert(table, pObject, getColTable(pObject) != NULL);
+  return true;
 };
 
 };//namespace
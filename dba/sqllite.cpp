@@ -284,10 +284,7 @@ SLResult::getDouble(int pField) const {
   //row not fetched
   assert(it != mData.end());
   double res;
-  const char* old = setlocale(LC_NUMERIC,"C");
   convert(it -> second,res);
-  if (old)
-    setlocale(LC_NUMERIC,old);
   return res;
 };
 
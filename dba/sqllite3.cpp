@@ -9,10 +9,13 @@
 #include <memory>
 #include <string.h>
 #include <cstdio>
+#include <cstdlib>
+#include <errno.h>
 
 #include "dba/sqllite3.h"
 #include "dba/connectstringparser.h"
 #include "dba/conversion.h"
+#include "dba/civiltime.h"
 
 namespace sqllite3 {
 
@@ -42,7 +45,9 @@ Db::~Db()
 
 void
 SLConnection::begin() {
-  sendUpdate("BEGIN");
+  //deferred transactions that wait for each other to write are
+  //aborted by sqlite as deadlocks, so write lock is taken at once
+  sendUpdate(mBusyTimeout ? "BEGIN IMMEDIATE" : "BEGIN");
 };
 
 void
@@ -58,6 +63,8 @@ SLConnection::rollback() {
 
 void
 SLConnection::disconnect() {
+  //statements have to be finalized before database is closed
+  clearStatementCache();
   mConnHandle.reset();
 };
 
@@ -66,9 +73,115 @@ SLConnection::isValid() const {
   return (mConnHandle != NULL);
 };
 
+bool
+SLConnection::cancel() {
+  if (mConnHandle.ptr() == NULL)
+    return false;
+  //sqlite3_interrupt is safe to call from other thread
+  sqlite3_interrupt(mConnHandle);
+  return true;
+};
 
 
-SLConnection::SLConnection(Db* pOwner, const char* pParams, const map<const char*,collationFunc>& pCols) {
+
+SLConnection::param_style
+SLConnection::getParamStyle() const {
+  return PARAMS_QUESTION_MARK;
+};
+
+void
+SLConnection::checkError(int pCode, const char* pError) {
+  switch(pCode) {
+    case SQLITE_OK:
+    case SQLITE_ROW:
+    case SQLITE_DONE:
+    break;
+    //SQL related error (user caused)
+    case SQLITE_ERROR:
+    case SQLITE_SCHEMA:
+    case SQLITE_CONSTRAINT:
+    case SQLITE_MISMATCH:
+    case SQLITE_AUTH:
+    case SQLITE_RANGE:
+      handleError(DBA_SQL_ERROR,pError);
+    break;
+    //Database/library related error (system caused)
+    default:
+      handleError(DBA_DB_ERROR,pError);
+    break;
+  };
+};
+
+DbStatement*
+SLConnection::prepare(const char* pSql) {
+  sqlite3_stmt* stmt = NULL;
+  const char* tail;
+  //v2 interface prepares statement again after schema change
+  int error = sqlite3_prepare_v2(mConnHandle,pSql,strlen(pSql),&stmt,&tail);
+  if (error != SQLITE_OK) {
+    checkError(error,sqlite3_errmsg(mConnHandle));
+    return NULL;
+  };
+  return new SLStatement(stmt);
+};
+
+void
+SLConnection::bindParams(sqlite3_stmt* pStmt, const DbParams& pParams) {
+  for(size_t i = 0; i < pParams.size(); i++) {
+    const DbParam& param(pParams[i]);
+    int pos = i + 1;
+    int error;
+    const char* val = param.mValue.c_str();
+    if (param.mIsNull) {
+      error = sqlite3_bind_null(pStmt,pos);
+    } else if (param.mType == DbParam::INTEGER) {
+      long l;
+      if (parseInt(val,val + param.mValue.size(),l))
+        error = sqlite3_bind_int64(pStmt,pos,l);
+      else
+        error = sqlite3_bind_text(pStmt,pos,val,param.mValue.size(),SQLITE_TRANSIENT);
+    } else if (param.mType == DbParam::FLOAT) {
+      double d;
+      if (parseDouble(val,val + param.mValue.size(),d))
+        error = sqlite3_bind_double(pStmt,pos,d);
+      else
+        error = sqlite3_bind_text(pStmt,pos,val,param.mValue.size(),SQLITE_TRANSIENT);
+    } else {
+      error = sqlite3_bind_text(pStmt,pos,val,param.mValue.size(),SQLITE_TRANSIENT);
+    };
+    if (error != SQLITE_OK) {
+      sqlite3_clear_bindings(pStmt);
+      checkError(error,sqlite3_errmsg(mConnHandle));
+      return;
+    };
+  };
+};
+
+DbResult*
+SLConnection::execPreparedQuery(const dba::shared_ptr<DbStatement>& pStmt, const DbParams& pParams) {
+  bindParams(((SLStatement*)pStmt.ptr())->mStmt,pParams);
+  return new SLResult(this,mConnHandle,pStmt);
+};
+
+int
+SLConnection::execPreparedUpdate(const dba::shared_ptr<DbStatement>& pStmt, const DbParams& pParams) {
+  sqlite3_stmt* stmt = ((SLStatement*)pStmt.ptr())->mStmt;
+  bindParams(stmt,pParams);
+  int code;
+  while((code = sqlite3_step(stmt)) == SQLITE_ROW);
+  std::string error(sqlite3_errmsg(mConnHandle));
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+  if (code != SQLITE_DONE) {
+    checkError(code,error.c_str());
+    return -1;
+  };
+  return sqlite3_changes(mConnHandle);
+};
+
+SLConnection::SLConnection(Db* pOwner, const char* pParams, const map<const char*,collationFunc>& pCols)
+  : mBusyTimeout(false)
+{
   setConversionSpecs(pOwner->getConversionSpecs());
   setParentErrorHandler(pOwner);
   if (pParams == NULL) {
@@ -76,12 +189,19 @@ SLConnection::SLConnection(Db* pOwner, const char* pParams, const map<const char
     return;
   };
   dba::ConnectStringParser parser(pParams);
+  std::string timeout;
   try {
     std::map<std::string,std::string> parsed(parser.parse());
     mFileName = parsed["dbname"];
+    timeout = parsed["timeout"];
   } catch (const dba::ConnectStringParserException& pEx) {
     mFileName = pParams;    
   };
+  long busy = 0;
+  if (!timeout.empty() && (!parseInt(timeout.data(),timeout.data() + timeout.size(),busy) || busy < 0)) {
+    handleError(DBA_DB_ERROR,("invalid timeout: " + timeout).c_str());
+    return;
+  };
   
   if (mFileName.empty()) {
     handleError(DBA_DB_ERROR,"no database filename provided");
@@ -113,6 +233,11 @@ SLConnection::SLConnection(Db* pOwner, const char* pParams, const map<const char
   };
   
   mConnHandle.reset(db);
+  //wait for locks of other connections instead of returning SQLITE_BUSY
+  if (busy > 0) {
+    sqlite3_busy_timeout(db,busy);
+    mBusyTimeout = true;
+  };
   for(map<const char*,collationFunc>::const_iterator it = pCols.begin(); it != pCols.end(); it++) {
     int err = sqlite3_create_collation(db,it->first,SQLITE_UTF8,NULL,it->second);
     if (err != SQLITE_OK) {
@@ -175,6 +300,8 @@ SLConnection::getRelationNames() {
 };
 
 SLConnection::~SLConnection() {
+  //cached statements must be finalized before sqlite3_close
+  clearStatementCache();
 };
 
 
@@ -205,6 +332,22 @@ SLResult::SLResult(SLConnection* pOwner, sqlite3* pConn, const char* pSql)
     } break;
   };
   mRes.reset(stmt);
+  initColumns();
+};
+
+SLResult::SLResult(SLConnection* pOwner, sqlite3* pConn, const dba::shared_ptr<DbStatement>& pStmt)
+  : mConn(pConn),
+    mStatement(pStmt)
+{
+  setConversionSpecs(pOwner->getConversionSpecs());
+  setParentErrorHandler(pOwner);
+  mStatement->setBusy(true);
+  mRes.reset(((SLStatement*)mStatement.ptr())->mStmt);
+  initColumns();
+};
+
+void
+SLResult::initColumns() {
   for(int i = 0; i < columns(); i++) {
     SLColumn col(sqlite3_column_name(mRes,i),mConvSpecs.mDbCharset);
     mColumns.insert(make_pair(i,col));
@@ -213,6 +356,20 @@ SLResult::SLResult(SLConnection* pOwner, sqlite3* pConn, const char* pSql)
   mRowFetched = false;
 };
 
+void
+SLResult::releaseStatement() {
+  if (!mStatement)
+    return;
+  //cached statement is reset instead of finalized
+  if (mRes.ptr() != NULL) {
+    sqlite3_reset(mRes);
+    sqlite3_clear_bindings(mRes);
+    mRes.release();
+  };
+  mStatement->setBusy(false);
+  mStatement = dba::shared_ptr<DbStatement>();
+};
+
 int 
 SLResult::columns() const {
   return sqlite3_column_count(mRes);
@@ -229,6 +386,9 @@ SLResult::getColumn(int i) const {
 
 bool 
 SLResult::fetchRow() {
+  //cancelled
+  if (mRes.ptr() == NULL)
+    return false;
   int err = sqlite3_step(mRes);
   switch(err) {
     case SQLITE_ROW:
@@ -284,7 +444,22 @@ SLResult::doGetDate(int pField) const {
   if (!mRowFetched) {
     handleError(DBA_DB_ERROR,"row not fetched. Call fetchRow() first.");
   };
-  return parseISODateTime(getString(pField));
+  tm ret;
+  //numeric dates are stored by ConvSpec::DATE_UNIXTIME and DATE_JULIANDAY
+  switch(sqlite3_column_type(mRes,pField)) {
+    case SQLITE_INTEGER:
+      timeToCivil(sqlite3_column_int64(mRes,pField),ret);
+      ret.tm_isdst = -1;
+    break;
+    case SQLITE_FLOAT:
+      timeToCivil(julianDayToTime(sqlite3_column_double(mRes,pField)),ret);
+      ret.tm_isdst = -1;
+    break;
+    default:
+      ret = parseISODateTime(getString(pField));
+    break;
+  };
+  return ret;
 };
 
 bool 
@@ -319,7 +494,15 @@ SLResult::getColumnIndex(const char* pField) const {
   return it->first;
 };
 
+void
+SLResult::cancel() {
+  mRowFetched = false;
+  releaseStatement();
+  mRes.reset();
+};
+
 SLResult::~SLResult() {
+  releaseStatement();
 };
 
 SLColumn::SLColumn(const char* pName, dba::ConvSpec::charset pDbCharset) 
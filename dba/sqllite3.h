@@ -38,6 +38,17 @@ class SLConnFree {
 };
 
 
+/**
+  sqlite3_stmt kept in statement cache of connection. Statement is reset
+  by result after it is destroyed, so it can be executed again.
+*/
+class SLStatement : public dba::DbStatement {
+  public:
+    SLStatement(sqlite3_stmt* pStmt) : mStmt(pStmt) {};
+    virtual ~SLStatement() { sqlite3_finalize(mStmt); };
+    sqlite3_stmt* mStmt;
+};
+
 class SLConnection : public dba::DbConnection {
     friend class Db;
   public:
@@ -51,12 +62,17 @@ class SLConnection : public dba::DbConnection {
     virtual void rollback();
     virtual void disconnect();
     virtual bool isValid() const;
+    virtual bool cancel();
+    virtual param_style getParamStyle() const;
+    virtual bool hasNumericDates() const { return true; };
     virtual ~SLConnection();  
   private:
     SLConnection(Db* pOwner, const char* pParams, const std::map<const char*,collationFunc>& pCols);
     std::string mFileName;
     dba::CHandle<sqlite3*,SLConnFree> mConnHandle;
     bool mAutoCommitFlag;
+    //!true if connection waits for locks of other connections
+    bool mBusyTimeout;
 
     /**
     Send query to server.
@@ -68,6 +84,14 @@ class SLConnection : public dba::DbConnection {
     @returns affected rows
     */
     virtual int execUpdate(const char* pSql);
+    virtual dba::DbStatement* prepare(const char* pSql);
+    virtual dba::DbResult* execPreparedQuery(const dba::shared_ptr<dba::DbStatement>& pStmt, const dba::DbParams& pParams);
+    virtual int execPreparedUpdate(const dba::shared_ptr<dba::DbStatement>& pStmt, const dba::DbParams& pParams);
+    void bindParams(sqlite3_stmt* pStmt, const dba::DbParams& pParams);
+    /**
+      Report error for sqlite result code
+    */
+    void checkError(int pCode, const char* pError);
 };
 
 
@@ -100,9 +124,13 @@ class SLResult : public dba::DbResult {
     virtual int columns() const;
     virtual const dba::DbColumn& getColumn(int i) const;
     virtual bool fetchRow();
+    virtual void cancel();
     virtual ~SLResult();
   private:
     SLResult(SLConnection* pOwner, sqlite3* pConn, const char* pSql);
+    SLResult(SLConnection* pOwner, sqlite3* pConn, const dba::shared_ptr<dba::DbStatement>& pStmt);
+    void initColumns();
+    void releaseStatement();
 
     virtual const char* doGetString(int pField) const;
     virtual long doGetInt(int pField) const;
@@ -114,6 +142,8 @@ class SLResult : public dba::DbResult {
 
     sqlite3* mConn;
     dba::CHandle<sqlite3_stmt*,SLVMFree> mRes;
+    //!cached statement used by result, not finalized when result is destroyed
+    dba::shared_ptr<dba::DbStatement> mStatement;
     std::map<int,SLColumn> mColumns;
     bool mLastRow;
     bool mRowFetched;
@@ -8,39 +8,125 @@
 
 #include <sstream>
 #include <string.h>
+#include <ctype.h>
+#include <typeinfo>
+#include <set>
 
 #include "dba/sqlostream.h"
 #include "dba/sqlutils.h"
 #include "dba/exception.h"
 #include "dba/storeablefilter.h"
 #include "dba/sqlidfetcher.h"
+#include "dba/watchdog.h"
+#include "dba/conversion.h"
+#include "dba/datetime_filter.h"
+#include "dba/double_filter.h"
+#include "dba/thread.h"
+#include "dba/schema.h"
+#include "dba/storemember.h"
 
 namespace dba {
 
 using namespace std;
 
+//!number of ids reserved at once when commands are pipelined
+static const int sIdBlockSize = 64;
+
+//!check if command creates, alters or drops database objects
+static bool
+isSchemaChange(const std::string& pCommand) {
+  static const char* const keywords[] = { "create", "alter", "drop", "rename" };
+  std::string::size_type start = pCommand.find_first_not_of(" \t\r\n(");
+  if (start == std::string::npos)
+    return false;
+  std::string word;
+  for(std::string::size_type i = start; i < pCommand.size() && isalpha(pCommand[i]); i++)
+    word += tolower(pCommand[i]);
+  for(size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+    if (word == keywords[i])
+      return true;
+  };
+  return false;
+};
+
 std::string
 SQLOStream::applyFilter(StoreableFilterBase& pFilter, Database::StoreType pType) {
   if (pFilter.isNull())
     return "NULL";
-  std::string strdata(pFilter.toString(getConversionSpecs()));
+  return formatValue(pFilter.toString(getConversionSpecs()),pType,typeid(pFilter) == typeid(DateTime));
+};
+
+std::string
+SQLOStream::formatValue(const std::string& pData, Database::StoreType pType, bool pDateTime) {
   switch(pType) {
     case Database::STRING:
-      strdata = SQLUtils::setSQLVal(strdata);
-    break;
+      return SQLUtils::setSQLVal(pData);
     case Database::FLOAT:
     break;
     case Database::INTEGER:
     break;
     case Database::DATE:
-      strdata = SQLUtils::setSQLVal(strdata);
-    break;
+      if (getConversionSpecs().mDateStorage != ConvSpec::DATE_TEXT && pDateTime) {
+        if (!mConn->hasNumericDates())
+          throw DataException("Numeric dates are not supported by database driver");
+        //numeric dates are not quoted, so database can store them as numbers
+        break;
+      };
+      return SQLUtils::setSQLVal(pData);
+  };
+  return pData;
+};
+
+std::string
+SQLOStream::applyMember(const mt_member& pMember, const Storeable& pObject) {
+  //members declared by BIND_MEMBER are converted by code generated for their type
+  if (pMember.typed != NULL) {
+    std::string data;
+    if (!pMember.typed->mStore(pObject,getConversionSpecs(),data))
+      return "NULL";
+    return formatValue(data,pMember.typed->mType,pMember.typed->mType == Database::DATE);
+  };
+  const char* data = (const char*)&pObject + pMember.offset;
+  //builtin filters with native data type are inlined here,
+  //result is the same as from applyFilter
+  switch(pMember.kind) {
+    case StoreTableMember::INT_FILTER: {
+      std::string strdata;
+      convert(*(const int*)data,strdata);
+      return strdata;
+    };
+    case StoreTableMember::BOOL_FILTER:
+      return *(const bool*)data ? "1" : "0";
+    case StoreTableMember::STRING_FILTER: {
+      const std::string& str = *(const std::string*)data;
+      if (str.empty())
+        return "NULL";
+      return SQLUtils::setSQLVal(str);
+    };
+    //filters on stack, so floating point members do not need filter lock
+    case StoreTableMember::DOUBLE_FILTER: {
+      Double filter(*(double*)data);
+      return applyFilter(filter,Database::FLOAT);
+    };
+    case StoreTableMember::FLOAT_FILTER: {
+      Float filter(*(float*)data);
+      return applyFilter(filter,Database::FLOAT);
+    };
+    default: {
+      StoreableFilterBase* filter = (StoreableFilterBase*)pMember.func;
+      if (mFilterLock == NULL) {
+        filter->updateRef((char*)data);
+        return applyFilter(*filter,(Database::StoreType)pMember.type);
+      };
+      MutexLocker lock(*mFilterLock);
+      filter->updateRef((char*)data);
+      return applyFilter(*filter,(Database::StoreType)pMember.type);
+    };
   };
-  return strdata;
 };
 
 string
-SQLOStream::createInsert(int id, const Storeable& pObject, mt_class* pTable) {
+SQLOStream::createInsert(int id, const Storeable& pObject, const mt_class* pTable) {
   const char* table = pTable->name;
   if (table == NULL) {
     if (mCurrentTable.size() == 0)
@@ -50,14 +136,10 @@ SQLOStream::createInsert(int id, const Storeable& pObject, mt_class* pTable) {
     mCurrentTable = table;
   };
   string query = "INSERT INTO " + string(table) + " (id";
-  mt_member* current = pTable->firstField;
   //object fields
-  while(current->name != NULL) {
+  for(const mt_member* current = pTable->first; current != pTable->last; current++) {
 //    cerr << current->name << endl;
     query += "," + string(current->name);
-    current = current->next;
-    if (current == NULL)
-      break;
   };
   //binded vars
   for(VarMap::iterator it = mBindings.begin(); it != mBindings.end(); it++) {
@@ -66,14 +148,8 @@ SQLOStream::createInsert(int id, const Storeable& pObject, mt_class* pTable) {
     };
   };
   query += ") VALUES (" + toStr(id);
-  current = pTable->firstField;
-  while(current->name != NULL) {
-    StoreableFilterBase* filter = (StoreableFilterBase*)current->func;
-    filter->updateRef((char*)&pObject + (int)(current->offset));
-    query += "," + applyFilter(*filter,(Database::StoreType)current->type);
-    current = current->next;
-    if (current == NULL)
-      break;
+  for(const mt_member* current = pTable->first; current != pTable->last; current++) {
+    query += "," + applyMember(*current,pObject);
   };
   for(VarMap::iterator it = mBindings.begin(); it != mBindings.end(); it++) {
     if (it->mTable == string(table)) {
@@ -127,14 +203,40 @@ SQLOStream::begin() {
 
 void
 SQLOStream::commit() {
+  TimeoutScope timeout(mConn,mQueryTimeout,mDeadline);
   mConn->commit();
+  invalidateChanged();
 };
 
 void
 SQLOStream::rollback() {
+  //ids allocated in rolled back transaction can be allocated again
+  mConn->clearReservedIds();
+  //other connections never saw changes
+  std::set<std::string> changed;
+  mConn->takeChangedTables(changed);
+  std::set<std::pair<std::string, int> > objects;
+  mConn->takeChangedObjects(objects);
   mConn->rollback();
 };
 
+int
+SQLOStream::fetchId(const char* pRootTable) {
+  if (!mConn->isPipelining())
+    return mFetcher->getNextId(*mConn,pRootTable);
+  //queries of fetcher wait for results of pipelined commands,
+  //so ids are allocated in blocks
+  int id;
+  if (!mConn->takeReservedId(pRootTable,id)) {
+    std::vector<int> ids;
+    mFetcher->getNextIds(*mConn,pRootTable,sIdBlockSize,ids);
+    mConn->reserveIds(pRootTable,ids);
+    if (!mConn->takeReservedId(pRootTable,id))
+      throw DataException("Unable to allocate next object id");
+  };
+  return id;
+};
+
 void
 SQLOStream::close() {
   mIsOpen = false;
@@ -161,7 +263,14 @@ SQLOStream::SQLOStream(DbConnection* pConn,SQLIdFetcher* pFetcher, FilterMapper*
   : OStream(),
     mConn(pConn),
     mFetcher(pFetcher),
-    mFilterMapper(pFilterMapper)
+    mFilterMapper(pFilterMapper),
+    mQueryTimeout(0),
+    mDeadline(0),
+    mObjectCache(NULL),
+    mQueryCache(NULL),
+    mDeferInvalidation(false),
+    mFilterLock(NULL),
+    mKeepNewIds(false)
 {
   mConn->incUsed();
   mIsOpen = false;
@@ -172,7 +281,15 @@ SQLOStream::SQLOStream(const SQLOStream& pStream)
     mConn(pStream.mConn),
     mFetcher(pStream.mFetcher),
     mFilterMapper(pStream.mFilterMapper),
-    mCurrentTable(pStream.mCurrentTable)
+    mCurrentTable(pStream.mCurrentTable),
+    mQueryTimeout(pStream.mQueryTimeout),
+    mDeadline(pStream.mDeadline),
+    mIdentityMap(pStream.mIdentityMap),
+    mObjectCache(pStream.mObjectCache),
+    mQueryCache(pStream.mQueryCache),
+    mDeferInvalidation(pStream.mDeferInvalidation),
+    mFilterLock(pStream.mFilterLock),
+    mKeepNewIds(pStream.mKeepNewIds)
 {
   mConn->incUsed();
 };
@@ -184,6 +301,14 @@ SQLOStream::operator=(const SQLOStream& pStream) {
   mFetcher = pStream.mFetcher;
   mFilterMapper = pStream.mFilterMapper;
   mCurrentTable = pStream.mCurrentTable;
+  mQueryTimeout = pStream.mQueryTimeout;
+  mDeadline = pStream.mDeadline;
+  mIdentityMap = pStream.mIdentityMap;
+  mObjectCache = pStream.mObjectCache;
+  mQueryCache = pStream.mQueryCache;
+  mDeferInvalidation = pStream.mDeferInvalidation;
+  mFilterLock = pStream.mFilterLock;
+  mKeepNewIds = pStream.mKeepNewIds;
   mConn->incUsed();
   return *this;
 };
@@ -196,7 +321,7 @@ SQLOStream::open(const char *const pMainTable) {
 };
 
 string
-SQLOStream::createUpdate(const Storeable& pObject, mt_class* pTable) {
+SQLOStream::createUpdate(const Storeable& pObject, const mt_class* pTable) {
   const char* table = pTable->name;
   if (table == NULL) {
     if (mCurrentTable.size() == 0)
@@ -206,19 +331,13 @@ SQLOStream::createUpdate(const Storeable& pObject, mt_class* pTable) {
     mCurrentTable = table;
   };
   string query = "UPDATE " + string(table) + string(" SET ");
-  mt_member* current = pTable->firstField;
   int i = 0;
-  while(current->name != NULL) {
+  for(const mt_member* current = pTable->first; current != pTable->last; current++) {
     if (i != 0)
       query += ",";
     query += string(current->name) + "=";
-    StoreableFilterBase* filter = (StoreableFilterBase*)current->func;
-    filter->updateRef((char*)&pObject + (int)(current->offset));
-    query += applyFilter(*filter,(Database::StoreType)current->type);
+    query += applyMember(*current,pObject);
     i++;
-    current = current->next;
-    if (current == NULL)
-      break;
   };
 
   VarMap bmap(mBindings);
@@ -238,24 +357,142 @@ SQLOStream::createUpdate(const Storeable& pObject, mt_class* pTable) {
 
 int
 SQLOStream::sendUpdate(const SQL& pCommand) {
-  return mConn->sendUpdate(pCommand.cstring(*mFilterMapper,getConversionSpecs()));
+  TimeoutScope timeout(mConn,mQueryTimeout,mDeadline);
+  std::string command;
+  DbParams params;
+  //raw command can change any object
+  if (mIdentityMap.getCount() != 0)
+    mIdentityMap->clear();
+  if (mQueryCache != NULL) {
+    mQueryCache->clear();
+    mConn->addChangedTable(NULL);
+  };
+  int ret;
+  try {
+    if (pCommand.prepare(*mFilterMapper,getConversionSpecs(),mConn->getParamStyle(),command,params)) {
+      ret = mConn->sendUpdate(command.c_str(),params);
+    } else {
+      command = pCommand.cstring(*mFilterMapper,getConversionSpecs());
+      ret = mConn->sendUpdate(command);
+    };
+    if (isSchemaChange(command))
+      Schema::changed();
+  } catch(...) {
+    if (!mDeferInvalidation)
+      invalidateChanged();
+    throw;
+  };
+  if (!mDeferInvalidation)
+    invalidateChanged();
+  return ret;
+};
+
+void
+SQLOStream::invalidateChanged() {
+  std::set<std::string> changed;
+  bool all = !mConn->takeChangedTables(changed);
+  std::set<std::pair<std::string, int> > objects;
+  mConn->takeChangedObjects(objects);
+  //readers could cache old objects after they were erased in write
+  if (mObjectCache != NULL) {
+    for(std::set<std::pair<std::string, int> >::const_iterator it = objects.begin(); it != objects.end(); it++)
+      mObjectCache->erase(it->first,it->second);
+  };
+  if (mQueryCache == NULL)
+    return;
+  //readers could cache rows that were read before change was visible
+  if (all) {
+    mQueryCache->clear();
+    return;
+  };
+  for(std::set<std::string>::const_iterator it = changed.begin(); it != changed.end(); it++)
+    mQueryCache->invalidate(*it);
+};
+
+void
+SQLOStream::invalidate(Storeable* pObject) {
+  if (mQueryCache != NULL) {
+    if (mRootTable != NULL) {
+      mQueryCache->invalidate(mRootTable);
+      mConn->addChangedTable(mRootTable);
+    };
+    for(const StoreTable* tbl = Stream::getTable(*pObject); tbl != NULL; tbl = tbl->getNextTable()) {
+      if (tbl->getTableName() != NULL) {
+        mQueryCache->invalidate(tbl->getTableName());
+        mConn->addChangedTable(tbl->getTableName());
+      };
+    };
+  };
+  if (mObjectCache != NULL && pObject->getId() != Storeable::InvalidId) {
+    mObjectCache->erase(getRootTableName(*pObject),pObject->getId());
+    if (mDeferInvalidation)
+      mConn->addChangedObject(getRootTableName(*pObject),pObject->getId());
+  };
+  if (!mIdentityMap || mIdentityMap->size() == 0)
+    return;
+  //overridden root table name is used also for children
+  //of stored object, so key of child is not known
+  if (mRootTable != NULL) {
+    mIdentityMap->clear();
+  } else {
+    mIdentityMap->erase(getRootTableName(*pObject),pObject->getId());
+    //written object can be an item of collection of loaded parent
+    mIdentityMap->eraseComposite();
+  };
+};
+
+bool
+SQLOStream::put(Storeable* pObject) {
+  TimeoutScope timeout(mConn,mQueryTimeout,mDeadline);
+  bool ret;
+  try {
+    ret = OStream::put(pObject);
+  } catch(...) {
+    if (!mDeferInvalidation)
+      invalidateChanged();
+    throw;
+  };
+  if (!mDeferInvalidation)
+    invalidateChanged();
+  return ret;
+};
+
+void
+SQLOStream::setQueryTimeout(unsigned long pMillis) {
+  mQueryTimeout = pMillis;
+};
+
+void
+SQLOStream::setDeadline(unsigned long pMillis) {
+  mDeadline = pMillis == 0 ? 0 : Watchdog::now() + pMillis;
+};
+
+void
+SQLOStream::setFilterLock(Mutex* pMutex) {
+  mFilterLock = pMutex;
 };
 
 bool
 SQLOStream::update(Storeable* pObject) {
+  invalidate(pObject);
   string query;
   string data;
   VarMap bmap(mBindings);
   createTree(Stream::getTable(*pObject));
   int storedTables = Stream::getStoredTables(pObject);
   int affectedTables = 0;
-  mt_class* current = mMemberList->mFirst;
-  while(current->name != NULL) {
-    if (storedTables != 0)
+  for(const mt_class* current = mMemberList->begin(); current != mMemberList->end(); current++) {
+    std::stringstream context;
+    int affectedRows;
+    if (storedTables != 0) {
       query = createUpdate(*pObject,current);
-    else
+      context << "update object id=" << pObject->getId() << " data in sql table " << current->name;
+      affectedRows = mConn->queueUpdate(query.c_str(),context.str(),true);
+    } else {
       query = createInsert(pObject->getId(),*pObject,current);
-    int affectedRows = mConn->sendUpdate(query);
+      context << "insert object id=" << pObject->getId() << " into sql table " << current->name;
+      affectedRows = mConn->queueUpdate(query.c_str(),context.str());
+    };
     //if we are doing update then make sure that
     //object was really updated in database
     //It is possible that sendUpdate return 0 rows
@@ -267,11 +504,8 @@ SQLOStream::update(Storeable* pObject) {
       " data in sql table " << current->name << ": SQL UPDATE returned 0 rows affected";
       throw DataException(error.str());
     };
-    current = current->next;
     storedTables--;
     affectedTables++;
-    if (current == NULL)
-      break;
   };
   Stream::setStoredTables(pObject,affectedTables);
   return true;
@@ -280,24 +514,25 @@ SQLOStream::update(Storeable* pObject) {
 
 bool
 SQLOStream::store(Storeable* pObject) {
+  invalidate(pObject);
   string query;
   //create query tree
   createTree(Stream::getTable(*pObject));
   //nothing is binded
-  if (mMemberList->mFirst->name == NULL)
+  if (mMemberList->empty())
     return false;
   //assign new id
-  int id = mFetcher->getNextId(*mConn,Stream::getRootTableName(*pObject));
+  int id = mKeepNewIds ? pObject->getId() : Storeable::InvalidId;
+  if (id == Storeable::InvalidId)
+    id = fetchId(Stream::getRootTableName(*pObject));
   //build and execute queries
   int storedTables = 0;
-  mt_class* current = mMemberList->mFirst;
-  while(current->name != NULL) {
+  for(const mt_class* current = mMemberList->begin(); current != mMemberList->end(); current++) {
     query = createInsert(id,*pObject,current);
-    mConn->sendUpdate(query);
-    current = current->next;
+    std::stringstream context;
+    context << "insert object id=" << id << " into sql table " << current->name;
+    mConn->queueUpdate(query.c_str(),context.str());
     storedTables++;
-    if (current == NULL)
-      break;
   };
   Stream::alterId(pObject,id);
   Stream::setStoredTables(pObject,storedTables);
@@ -306,6 +541,7 @@ SQLOStream::store(Storeable* pObject) {
 
 bool
 SQLOStream::erase(Storeable* pObject) {
+  invalidate(pObject);
   string query;
   const StoreTable* tbl = Stream::getTable(*pObject);
   if (tbl == NULL)
@@ -321,7 +557,7 @@ SQLOStream::erase(Storeable* pObject) {
   do {
     if (table != NULL) {
       query = string("DELETE FROM " + string(table) + " WHERE id = " + toStr(pObject->getId()));
-      mConn->sendUpdate(query);
+      mConn->queueUpdate(query.c_str(),"delete object id=" + toStr(pObject->getId()) + " from sql table " + table);
     };
     tbl = tbl->getNextTable();
     if (tbl != NULL)
@@ -335,10 +571,15 @@ void
 SQLOStream::assignId(Storeable* pObject) throw (Exception) {
   if (pObject->isNew()) {
     createTree(Stream::getTable(*pObject));
-    pObject->setId(mFetcher->getNextId(*mConn,Stream::getRootTableName(*pObject)));
+    pObject->setId(fetchId(Stream::getRootTableName(*pObject)));
   }
 };
 
+void
+SQLOStream::setPipelining(bool pFlag) {
+  mConn->setPipelining(pFlag);
+};
+
 const ConvSpec&
 SQLOStream::getConversionSpecs() const {
   return mConn->getConversionSpecs();
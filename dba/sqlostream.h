@@ -11,10 +11,15 @@
 
 #include "dba/ostream.h"
 #include "dba/sql.h"
+#include "dba/shared_ptr.h"
+#include "dba/identitymap.h"
+#include "dba/objectcache.h"
+#include "dba/querycache.h"
 
 namespace dba {
 
 class SQLIdFetcher;
+class Mutex;
 
 /**
   OStream implementation for %SQL based archives
@@ -23,6 +28,7 @@ class SQLIdFetcher;
 class dbaDLLEXPORT SQLOStream : public OStream {
     friend class SQLArchive;
     friend class Transaction;
+    friend class WriteBehindOStream;
   public:
     /**
       Copy constructor increases internal DbConnection usage
@@ -44,10 +50,56 @@ class dbaDLLEXPORT SQLOStream : public OStream {
     virtual void close();
     virtual void destroy();
     /**
-      Send SQL update query to database and get results
+      Send SQL update query to database and get results. Query params are bound
+      natively if connection supports it. Clears identity map of transaction context
+      and QueryCache because affected objects are not known.
       @param pQuery query to send.
     */
     int sendUpdate(const SQL& pQuery);
+    /**
+      Enable pipelining of INSERT, UPDATE and DELETE commands created by put() on
+      connection used by this stream. Pipelined commands are sent without waiting
+      for result and checked when next query is executed or when transaction is
+      commited, so errors from put() can be reported by commit().
+      Error message contains id and table of object that failed.
+      Only drivers that support pipelining (postgres) use this setting and
+      only inside transactions. Setting is stored in connection, so it is shared
+      by all streams of Transaction and reset when Transaction is finished.
+      When pipelining is enabled ids of new objects are taken from SQLIdFetcher
+      in blocks (SQLIdFetcher::getNextIds()), so queries of fetcher do not wait for
+      every pipelined command. Ids reserved but not used are lost.
+      @note Transaction destructor does not throw, so call Transaction::commit()
+      explicitly to get errors from pipelined commands.
+      @param pFlag true to enable pipelining
+    */
+    void setPipelining(bool pFlag = true);
+    /**
+      Set timeout for every %SQL command sent by this stream. Command that runs
+      longer is cancelled and TimeoutException is thrown.
+      @param pMillis timeout in miliseconds or 0 to disable timeout
+    */
+    void setQueryTimeout(unsigned long pMillis);
+    /**
+      Set deadline for all operations of this stream, including put() of object
+      with all its children and commit(). Command that runs after deadline
+      is cancelled and TimeoutException is thrown.
+      @param pMillis time from now in miliseconds or 0 to disable deadline
+    */
+    void setDeadline(unsigned long pMillis);
+    /**
+      Set mutex that is locked while filters shared by all objects of class
+      convert member values. Builtin filters are not shared and are applied
+      without lock. Needed only if objects of the same class are stored by
+      many threads at once.
+      @param pMutex mutex or NULL to convert without lock
+    */
+    void setFilterLock(Mutex* pMutex);
+    /**
+      Store object applying query timeout and deadline set for this stream.
+      @param pObject object to store
+      @return true if object was stored
+    */
+    virtual bool put(Storeable* pObject);
     /**
       Get conversion specification used by this stream.
       @return conversion specifications
@@ -64,9 +116,14 @@ class dbaDLLEXPORT SQLOStream : public OStream {
   private:
     virtual void assignId(Storeable* pObject) throw (Exception);
     SQLOStream(DbConnection* pConn, SQLIdFetcher* pFetcher, FilterMapper* pMapper);
-    std::string createInsert(int id,const Storeable& pObject,mt_class* pTable);
-    std::string createUpdate(const Storeable& pObject,mt_class* pTable);
+    std::string createInsert(int id,const Storeable& pObject,const mt_class* pTable);
+    std::string createUpdate(const Storeable& pObject,const mt_class* pTable);
     std::string applyFilter(StoreableFilterBase& pFilter, Database::StoreType pType);
+    std::string formatValue(const std::string& pData, Database::StoreType pType, bool pDateTime);
+    std::string applyMember(const mt_member& pMember, const Storeable& pObject);
+    void invalidate(Storeable* pObject);
+    void invalidateChanged();
+    int fetchId(const char* pRootTable);
     
     virtual std::vector<id> loadRefData(const char* pTable, const char* pFkName, id pCollId, id pId);
     virtual bool deleteRefData(const std::vector<id>& pIds, const char* pTableName);
@@ -76,6 +133,17 @@ class dbaDLLEXPORT SQLOStream : public OStream {
     virtual bool store(Storeable* pObject);
     
     std::string mCurrentTable;
+    unsigned long mQueryTimeout;
+    unsigned long mDeadline;
+    shared_ptr<IdentityMap> mIdentityMap;
+    ObjectCache* mObjectCache;
+    QueryCache* mQueryCache;
+    //!true if changed tables are invalidated again by commit() instead of after write
+    bool mDeferInvalidation;
+    //!locked when shared filters are used, see setFilterLock()
+    Mutex* mFilterLock;
+    //!true if store() keeps id assigned to new object before store, used by WriteBehindOStream
+    bool mKeepNewIds;
 };
 
 };//namespace
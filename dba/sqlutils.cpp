@@ -12,20 +12,36 @@
 
 namespace dba {
 
+//special chars and escape prefixes written before them
+static const char* const SQL_DATA_CHARS = "\\'";
+static const char* const SQL_DATA_PREFIXES = "\\'";
+static const char* const SQL_LIKE_CHARS = "\\'!_%";
+static const char* const SQL_LIKE_PREFIXES = "\\'!!!";
+
 std::string
 SQLUtils::escapeSQLData(const std::string& pData) {
-  std::string ret(pData);
-  replaceAll(ret,"\\","\\\\");
-  replaceAll(ret,"'","''");
+  const char* end = pData.data() + pData.size();
+  const char* special = findFirstOf(pData.data(),end,SQL_DATA_CHARS);
+  if (special == end)
+    return pData;
+  std::string ret(pData.data(),special);
+  appendEscaped(ret,special,end,SQL_DATA_CHARS,SQL_DATA_PREFIXES);
   return ret;
 };
 
+void
+SQLUtils::appendSQLData(std::string& pOut, const std::string& pData) {
+  appendEscaped(pOut,pData.data(),pData.data() + pData.size(),SQL_DATA_CHARS,SQL_DATA_PREFIXES);
+};
+
 std::string
 SQLUtils::escapeSQLLike(const std::string& pData) {
-  std::string ret(escapeSQLData(pData));
-  replaceAll(ret,"!","!!");
-  replaceAll(ret,"_","!_");
-  replaceAll(ret,"%","!%");
+  const char* end = pData.data() + pData.size();
+  const char* special = findFirstOf(pData.data(),end,SQL_LIKE_CHARS);
+  if (special == end)
+    return pData;
+  std::string ret(pData.data(),special);
+  appendEscaped(ret,special,end,SQL_LIKE_CHARS,SQL_LIKE_PREFIXES);
   return ret;
 };
 
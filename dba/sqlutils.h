@@ -35,6 +35,13 @@ class dbaDLLEXPORT SQLUtils {
       @return escaped string  
     */
     static std::string escapeSQLData(const std::string& pData);
+    /**
+      Append escaped text string to pOut. Same as escapeSQLData() but
+      without temporary strings.
+      @param pOut string to append to
+      @param pData string to escape
+    */
+    static void appendSQLData(std::string& pOut, const std::string& pData);
     /**
       Escape string used for LIKE clause to conform %SQL standard 
       @param pData string to modify
@@ -114,12 +121,13 @@ class dbaDLLEXPORT SQLUtils {
       @returns pVal with quotes
     */
     static std::string setSQLVal(const std::string& pVal) {
-      std::string str(pVal);
-      if (pVal.size() == 0) {
-        str = "NULL";
-      } else {
-        str = "'" + escapeSQLData(str) + "'";
-      };
+      if (pVal.size() == 0)
+        return "NULL";
+      std::string str;
+      str.reserve(pVal.size() + 2);
+      str += '\'';
+      appendSQLData(str,pVal);
+      str += '\'';
       return str;
     };
     /**
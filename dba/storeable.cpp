@@ -11,6 +11,11 @@
 #include <locale.h>
 #include "dba/idlocker.h"
 #include "dba/collectionfilter.h"
+#include "dba/int_filter.h"
+#include "dba/bool_filter.h"
+#include "dba/double_filter.h"
+#include "dba/string_filter.h"
+#include <typeinfo>
 
 #ifdef _MSC_VER
 #pragma warning (disable:4100)
@@ -60,11 +65,32 @@ MemberEntryBase::getMemberName() const {
   return mMemberName;
 };
 //==================== StoreTableMember ==================
+
+static StoreTableMember::filter_kind
+getBuiltinFilterKind(StoreableFilterBase* pFilter, int pDatabaseType) {
+  if (pFilter == NULL)
+    return StoreTableMember::CUSTOM_FILTER;
+  //derived filters can override conversions, so exact type is checked
+  const std::type_info& type(typeid(*pFilter));
+  if (type == typeid(Int) && pDatabaseType == Database::INTEGER)
+    return StoreTableMember::INT_FILTER;
+  if (type == typeid(Bool) && pDatabaseType == Database::INTEGER)
+    return StoreTableMember::BOOL_FILTER;
+  if (type == typeid(Double) && pDatabaseType == Database::FLOAT)
+    return StoreTableMember::DOUBLE_FILTER;
+  if (type == typeid(Float) && pDatabaseType == Database::FLOAT)
+    return StoreTableMember::FLOAT_FILTER;
+  if (type == typeid(String) && pDatabaseType == Database::STRING)
+    return StoreTableMember::STRING_FILTER;
+  return StoreTableMember::CUSTOM_FILTER;
+};
 StoreTableMember::StoreTableMember(StoreTable* pOwner, const char* pMemberName, int pMemberOffset, StoreableFilterBase* pFilter, int pDatabaseType) 
   : MemberEntryBase(pMemberName,pMemberOffset),
     mFilter(pFilter),
     mFilterOwner(true),
     mDatabaseType(pDatabaseType),
+    mFilterKind(getBuiltinFilterKind(pFilter,pDatabaseType)),
+    mTypedMember(NULL),
     mNextMember(NULL)
 {
   pOwner->addMember(this);
@@ -96,6 +122,21 @@ StoreTableMember::getDatabaseType() {
   return mDatabaseType;
 }
 
+StoreTableMember::filter_kind
+StoreTableMember::getFilterKind() const {
+  return mFilterKind;
+}
+
+void
+StoreTableMember::setTypedMember(const TypedMemberEntry* pEntry) {
+  mTypedMember = pEntry;
+};
+
+const TypedMemberEntry*
+StoreTableMember::getTypedMember() const {
+  return mTypedMember;
+};
+
 StoreTableMember::~StoreTableMember() {
   if (mFilterOwner)
     delete mFilter;
@@ -68,12 +68,25 @@ class MemberTableBase {
 
 class StoreTable;
 class ColTable;
+struct TypedMemberEntry;
 
 /**
   %Single entry in store table
 */
 class dbaDLLEXPORT StoreTableMember : public MemberEntryBase {
   public:
+    /**@internal
+      Builtin filter used with its native archive data type. Streams use it to
+      read and write member directly, without virtual calls to filter.
+    */
+    typedef enum {
+      CUSTOM_FILTER = 0,
+      INT_FILTER,
+      BOOL_FILTER,
+      DOUBLE_FILTER,
+      FLOAT_FILTER,
+      STRING_FILTER
+    } filter_kind;
     /**@internal
       Constructor - used by BIND_* macros - for internal use only
       @param pOwner store table that owns this member
@@ -103,6 +116,22 @@ class dbaDLLEXPORT StoreTableMember : public MemberEntryBase {
       @return one of Database::StoreType enum values
     */
     int getDatabaseType();
+    /**@internal
+      Get kind of builtin filter assigned to member
+      @return CUSTOM_FILTER if filter is not builtin filter or it is used with
+      archive data type other than its native type
+    */
+    filter_kind getFilterKind() const;
+    /**@internal
+      Set load and store functions generated for member by BIND_MEMBER
+      @param pEntry static entry or NULL if member is converted by filter
+    */
+    void setTypedMember(const TypedMemberEntry* pEntry);
+    /**@internal
+      Get load and store functions generated for member by BIND_MEMBER
+      @return static entry or NULL if member is converted by filter
+    */
+    const TypedMemberEntry* getTypedMember() const;
     /**@internal
       Get next member from store table member list
       @return pointer to next member or NULL if not found
@@ -121,6 +150,8 @@ class dbaDLLEXPORT StoreTableMember : public MemberEntryBase {
     StoreableFilterBase* mFilter;
     bool mFilterOwner;
     int mDatabaseType;
+    filter_kind mFilterKind;
+    const TypedMemberEntry* mTypedMember;
     StoreTableMember* mNextMember;
 };
 
@@ -308,6 +339,7 @@ Class::st_createTables() {                            \
       while(entry != NULL) { \
         dba::StoreTableMember* tmp = new dba::StoreTableMember(*entry);                   \
         tmp->setFilterOwner(false); \
+        tmp->setTypedMember(NULL); \
         tmp->setMemberOffset(tmp->getMemberOffset() + ((char*)&(member) - (char*)this)); \
         st_table->addMember(tmp); \
         entry = entry->getNextMember();           \
@@ -332,6 +364,7 @@ Derived classes must provide default constructor and copy constructor.
 */
 class dbaDLLEXPORT Storeable {
     friend class Stream;
+    friend class SQLArchive;
   public:
     /**
       Helper class for locking Storeable data when doing Archive operations. Use it instead of Storeable::lockStid and Storeable::unlockStid. This class should be created on stack.
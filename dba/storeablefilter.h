@@ -12,6 +12,7 @@
 #include "dba/defs.h"
 #include "dba/convspec.h"
 #include "dba/database.h"
+#include "dba/shared_ptr.h"
 
 namespace dba {
 
@@ -30,9 +31,11 @@ class dbaDLLEXPORT StoreableFilterException : public DataException {
 
 /**
 Base class for routines that converts Storeable object members to arguents to Database queries and Database results to members. 
+Filters keep their own reference counter, so filters owned by streams and %SQL queries
+are shared without additional allocations.
 @warning You should not derive from this class - use StoreableFilter instead 
 */
-class dbaDLLEXPORT StoreableFilterBase {
+class dbaDLLEXPORT StoreableFilterBase : public RefCounted {
     //TODO add getPrefferedType for rest of filters in dba and wxdba
     friend class OStream;
   public:
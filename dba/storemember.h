@@ -0,0 +1,212 @@
+// File: storemember.h
+// Purpose: Store table members declared by pointer to class member
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBASTOREMEMBER_H
+#define DBASTOREMEMBER_H
+
+#include "dba/storeable.h"
+#include "dba/int_filter.h"
+#include "dba/double_filter.h"
+#include "dba/string_filter.h"
+#include "dba/bool_filter.h"
+#include "dba/datetime_filter.h"
+#include "dba/conversion.h"
+
+namespace dba {
+
+/**
+  Describes how C++ type is stored in archive: filter class used for conversion
+  by archives that read and write members using filters, archive data type and
+  functions used by SQL streams to read and write value without filter.
+  Specialize this template to use BIND_MEMBER with your own types. Specialization
+  has to define:
+  - filter_type - StoreableFilter class for member
+  - store_type - Database::StoreType value
+  - static void load(T& pValue, DbResult& pRes, int pColumn, const ConvSpec& pSpecs)
+  - static bool store(const T& pValue, const ConvSpec& pSpecs, std::string& pData) -
+    sets text of value and returns false if value is NULL
+  @ingroup store_table
+*/
+template <typename T> struct FieldTraits;
+
+template <> struct FieldTraits<int> {
+  typedef Int filter_type;
+  static const Database::StoreType store_type = Database::INTEGER;
+  static void load(int& pValue, DbResult& pRes, int pColumn, const ConvSpec&) {
+    pValue = pRes.isNull(pColumn) ? 0 : pRes.getInt(pColumn);
+  };
+  static bool store(const int& pValue, const ConvSpec&, std::string& pData) {
+    convert(pValue,pData);
+    return true;
+  };
+};
+
+template <> struct FieldTraits<unsigned int> {
+  typedef Int filter_type;
+  static const Database::StoreType store_type = Database::INTEGER;
+  static void load(unsigned int& pValue, DbResult& pRes, int pColumn, const ConvSpec&) {
+    pValue = pRes.isNull(pColumn) ? 0 : static_cast<unsigned int>(pRes.getInt(pColumn));
+  };
+  static bool store(const unsigned int& pValue, const ConvSpec&, std::string& pData) {
+    convert(static_cast<int>(pValue),pData);
+    return true;
+  };
+};
+
+template <> struct FieldTraits<bool> {
+  typedef Bool filter_type;
+  static const Database::StoreType store_type = Database::INTEGER;
+  static void load(bool& pValue, DbResult& pRes, int pColumn, const ConvSpec&) {
+    pValue = pRes.isNull(pColumn) ? false : pRes.getInt(pColumn) == 1;
+  };
+  static bool store(const bool& pValue, const ConvSpec&, std::string& pData) {
+    pData = pValue ? "1" : "0";
+    return true;
+  };
+};
+
+template <> struct FieldTraits<double> {
+  typedef Double filter_type;
+  static const Database::StoreType store_type = Database::FLOAT;
+  static void load(double& pValue, DbResult& pRes, int pColumn, const ConvSpec&) {
+    pValue = pRes.isNull(pColumn) ? 0 : pRes.getDouble(pColumn);
+  };
+  static bool store(const double& pValue, const ConvSpec& pSpecs, std::string& pData) {
+    //filter on stack, qualified calls are not virtual
+    Double filter(const_cast<double&>(pValue));
+    if (filter.Double::isNull())
+      return false;
+    pData = filter.Double::toString(pSpecs);
+    return true;
+  };
+};
+
+template <> struct FieldTraits<float> {
+  typedef Float filter_type;
+  static const Database::StoreType store_type = Database::FLOAT;
+  static void load(float& pValue, DbResult& pRes, int pColumn, const ConvSpec&) {
+    pValue = pRes.isNull(pColumn) ? 0 : static_cast<float>(pRes.getDouble(pColumn));
+  };
+  static bool store(const float& pValue, const ConvSpec& pSpecs, std::string& pData) {
+    Float filter(const_cast<float&>(pValue));
+    if (filter.Float::isNull())
+      return false;
+    pData = filter.Float::toString(pSpecs);
+    return true;
+  };
+};
+
+template <> struct FieldTraits<std::string> {
+  typedef String filter_type;
+  static const Database::StoreType store_type = Database::STRING;
+  static void load(std::string& pValue, DbResult& pRes, int pColumn, const ConvSpec&) {
+    if (pRes.isNull(pColumn))
+      pValue.erase();
+    else
+      pValue.assign(pRes.getString(pColumn));
+  };
+  static bool store(const std::string& pValue, const ConvSpec&, std::string& pData) {
+    if (pValue.empty())
+      return false;
+    pData = pValue;
+    return true;
+  };
+};
+
+template <> struct FieldTraits<tm> {
+  typedef DateTime filter_type;
+  static const Database::StoreType store_type = Database::DATE;
+  static void load(tm& pValue, DbResult& pRes, int pColumn, const ConvSpec& pSpecs) {
+    DateTime filter(pValue);
+    if (pRes.isNull(pColumn))
+      filter.DateTime::fromNull();
+    else
+      filter.DateTime::fromDate(pSpecs,pRes.getDate(pColumn));
+  };
+  static bool store(const tm& pValue, const ConvSpec& pSpecs, std::string& pData) {
+    DateTime filter(const_cast<tm&>(pValue));
+    if (filter.DateTime::isNull())
+      return false;
+    pData = filter.DateTime::toString(pSpecs);
+    return true;
+  };
+};
+
+/**@internal
+  Load and store functions generated for member declared by BIND_MEMBER.
+  SQL streams call them instead of filter of store table member.
+*/
+struct dbaDLLEXPORT TypedMemberEntry {
+  //!archive data type of member
+  Database::StoreType mType;
+  //!read member of object from column of current row
+  void (*mLoad)(Storeable& pObject, DbResult& pRes, int pColumn, const ConvSpec& pSpecs);
+  //!convert member of object to text, returns false if member is NULL
+  bool (*mStore)(const Storeable& pObject, const ConvSpec& pSpecs, std::string& pData);
+};
+
+/**@internal
+  Member of class C described at compile time. Member is accessed using pointer
+  to member M and converted by FieldTraits<T>, so code is generated for member
+  type. sEntry is initialized statically, there is one entry for every member.
+*/
+template <class C, class T, T C::*M>
+struct TypedMember {
+  static void load(Storeable& pObject, DbResult& pRes, int pColumn, const ConvSpec& pSpecs) {
+    FieldTraits<T>::load(static_cast<C&>(pObject).*M,pRes,pColumn,pSpecs);
+  };
+  static bool store(const Storeable& pObject, const ConvSpec& pSpecs, std::string& pData) {
+    return FieldTraits<T>::store(static_cast<const C&>(pObject).*M,pSpecs,pData);
+  };
+  static const TypedMemberEntry sEntry;
+};
+
+template <class C, class T, T C::*M>
+const TypedMemberEntry TypedMember<C,T,M>::sEntry = {
+  FieldTraits<T>::store_type,
+  &TypedMember<C,T,M>::load,
+  &TypedMember<C,T,M>::store
+};
+
+/**@internal
+  Add member to store table. Filter and archive data type are taken from FieldTraits
+  of member type. Filter is used by archives that do not use typed members.
+  Used by BIND_MEMBER macro.
+  @param pTable store table of class
+  @param pThis object that creates store table
+  @param pMember pointer to member of class
+  @param pField name of column in relation where member should be stored
+  @param pEntry load and store functions of member
+*/
+template <typename C, typename T>
+void
+bindMember(StoreTable* pTable, C* pThis, T C::*pMember, const char* pField, const TypedMemberEntry& pEntry) {
+  T& member = pThis->*pMember;
+  int offset = (char*)&member - (char*)pThis;
+  StoreTableMember* entry = new StoreTableMember(pTable,pField,offset,new typename FieldTraits<T>::filter_type(member),FieldTraits<T>::store_type);
+  entry->setTypedMember(&pEntry);
+};
+
+};//namespace
+
+/**
+  This macro defines class member binded to relation field. Filter class and
+  archive data type are selected by member type using dba::FieldTraits,
+  so it can be used instead of BIND_INT, BIND_STR, BIND_FLT and BIND_DAT for
+  members of builtin types. SQL streams read and write member using code generated
+  for its type, without filter and virtual calls. Objects of class can be mixed
+  with classes that use other BIND_* macros in all archives.
+  @param Class name of class that owns store table. Member has to be declared in this class.
+  @param type type of member
+  @param member name of member, without class name
+  @param field name of column in relation where member should be stored
+  @ingroup store_table
+*/
+#define BIND_MEMBER(Class,type,member,field) \
+  dba::bindMember<Class,type>(st_table,this,&Class::member,field,dba::TypedMember<Class,type,&Class::member>::sEntry);
+
+#endif
@@ -204,39 +204,8 @@ Stream::getRootTableName(Storeable& pObj) {
 
 void
 Stream::createTree(const StoreTable* pRootTable) {
-  const StoreTable* tbl = pRootTable;
-  mMemberList->clear();
-  const char* tableName = NULL;
-  while(tbl != NULL) {
-    //replace root table name with user supilled (if any)
-    if (tbl == pRootTable) {
-      if (mRootTable != NULL) {
-        tableName = mRootTable;     
-      } else {
-        tableName = tbl->getTableName();
-      };
-      //root table cannot have NULL name
-      if ((tableName == NULL)&&(tbl->getTableName() == NULL)) {
-        throw APIException("Root table cannot be NULL");
-      };
-    } else {
-      //if store table defines table name then 
-      //use it as name of table, if not then use parent name
-      if (tbl->getTableName() != NULL) {
-        tableName = tbl->getTableName();
-      };
-    };
-    mMemberList->addClass(tableName);
-//    cerr << "offset correction for class: " << tbl -> tableName << " " << tbl -> classOffset << endl;
-
-    StoreTableMember* member = tbl->getMembers();
-    while (member != NULL) {
-//      cerr << "adding " << member->getMemberName() << " for " << tbl->getTableName() << ",mo:" << member->getMemberOffset() << ",to:" << member->getMemberOffset()  + tbl->classOffset << endl;
-      mMemberList->add(tableName,member->getMemberName(),member->getMemberOffset() + tbl->getClassOffset(),member->getFilter(),member->getDatabaseType());
-      member = member->getNextMember();
-    };
-    tbl = tbl->getNextTable();
-  };
+  //replace root table name with user supilled (if any)
+  mMemberList = mt_mlist::get(pRootTable,mRootTable);
 };
 
 void
@@ -183,7 +183,8 @@ class dbaDLLEXPORT Stream {
     */
     const ColTable* getColTable(Storeable& pObject);
     /**
-      Create member tree from store tables and binded variables
+      Get member list of store tables. List is built once for each
+      store table and root table name and shared between streams
     */
     void createTree(const StoreTable* pRootTable);
 #ifdef _DEBUG
@@ -257,7 +258,7 @@ class dbaDLLEXPORT Stream {
     */
     VarMap mBindings;
     /**
-      List of members from store table
+      List of members from store table, shared and never modified
     */
     shared_ptr<mt_mlist> mMemberList;
     /**
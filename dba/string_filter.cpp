@@ -51,13 +51,13 @@ String::fromString(const ConvSpec& pSpec, const std::string& pData) throw (Store
 
 void 
 String::fromDate(const ConvSpec& pSpec, const tm& pDate) throw (StoreableFilterException) {
-  char buffer[64];
+  char buffer[DATE_BUFFER_SIZE];
   int size;
   #ifdef _WIN32
   if (pDate.tm_year < 0)
     throw StoreableFilterException("Cannot convert struct tm with year < 1970");
   #endif
-  size = strftime(buffer,64,pSpec.mTimestampFormat,&(tm&)pDate);
+  size = formatDateTime(pDate,pSpec.mTimestampFormat,buffer,DATE_BUFFER_SIZE);
   if (size == 0)
     throw StoreableFilterException("Conversion from struct tm to std::string failed");
   *mMember = std::string(buffer,size);
@@ -0,0 +1,284 @@
+// File: thread.cpp
+// Purpose: Portable threads and synchronization primitives
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#include "dba/thread.h"
+#include "dba/exception.h"
+
+#ifdef _WIN32
+  #include <windows.h>
+  #include <process.h>
+#else
+  #include <pthread.h>
+  #include <errno.h>
+  #include <sys/time.h>
+  #include <time.h>
+#endif
+
+namespace dba {
+
+#ifdef _WIN32
+
+/*============================== win32 ============================*/
+
+//win32 before Vista does not have condition variables. Waiting threads
+//are counted and woken up by releasing semaphore. This can produce spurious
+//wakeups when wait times out concurrently with signal.
+class Win32Condition {
+  public:
+    Win32Condition() : mWaiters(0) {
+      InitializeCriticalSection(&mLock);
+      mSem = CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+      if (mSem == NULL)
+        throw APIException("Cannot create semaphore");
+    };
+    ~Win32Condition() {
+      CloseHandle(mSem);
+      DeleteCriticalSection(&mLock);
+    };
+    CRITICAL_SECTION mLock;
+    HANDLE mSem;
+    long mWaiters;
+};
+
+Mutex::Mutex() {
+  CRITICAL_SECTION* cs = new CRITICAL_SECTION;
+  InitializeCriticalSection(cs);
+  mHandle = cs;
+};
+
+void
+Mutex::lock() {
+  EnterCriticalSection((CRITICAL_SECTION*)mHandle);
+};
+
+void
+Mutex::unlock() {
+  LeaveCriticalSection((CRITICAL_SECTION*)mHandle);
+};
+
+Mutex::~Mutex() {
+  DeleteCriticalSection((CRITICAL_SECTION*)mHandle);
+  delete (CRITICAL_SECTION*)mHandle;
+};
+
+Condition::Condition()
+  : mHandle(new Win32Condition())
+{
+};
+
+bool
+Condition::wait(Mutex& pMutex, unsigned long pMillis) {
+  Win32Condition* c = (Win32Condition*)mHandle;
+  EnterCriticalSection(&c->mLock);
+  c->mWaiters++;
+  LeaveCriticalSection(&c->mLock);
+  pMutex.unlock();
+  DWORD res = WaitForSingleObject(c->mSem, pMillis);
+  EnterCriticalSection(&c->mLock);
+  if (res != WAIT_OBJECT_0 && c->mWaiters > 0)
+    c->mWaiters--;
+  LeaveCriticalSection(&c->mLock);
+  pMutex.lock();
+  return res == WAIT_OBJECT_0;
+};
+
+void
+Condition::wait(Mutex& pMutex) {
+  wait(pMutex, INFINITE);
+};
+
+void
+Condition::signal() {
+  Win32Condition* c = (Win32Condition*)mHandle;
+  EnterCriticalSection(&c->mLock);
+  if (c->mWaiters > 0) {
+    c->mWaiters--;
+    ReleaseSemaphore(c->mSem, 1, NULL);
+  };
+  LeaveCriticalSection(&c->mLock);
+};
+
+void
+Condition::broadcast() {
+  Win32Condition* c = (Win32Condition*)mHandle;
+  EnterCriticalSection(&c->mLock);
+  if (c->mWaiters > 0) {
+    ReleaseSemaphore(c->mSem, c->mWaiters, NULL);
+    c->mWaiters = 0;
+  };
+  LeaveCriticalSection(&c->mLock);
+};
+
+Condition::~Condition() {
+  delete (Win32Condition*)mHandle;
+};
+
+static unsigned __stdcall
+win32_thread_entry(void* pThread) {
+  Thread::entry(pThread);
+  return 0;
+};
+
+void
+Thread::start() {
+  if (mHandle != NULL)
+    throw APIException("Thread already started");
+  unsigned tid;
+  uintptr_t h = _beginthreadex(NULL, 0, &win32_thread_entry, this, 0, &tid);
+  if (h == 0)
+    throw APIException("Cannot create thread");
+  mHandle = (void*)h;
+};
+
+void
+Thread::join() {
+  if (mHandle == NULL)
+    return;
+  WaitForSingleObject((HANDLE)mHandle, INFINITE);
+  CloseHandle((HANDLE)mHandle);
+  mHandle = NULL;
+};
+
+void
+Thread::sleep(unsigned long pMillis) {
+  Sleep(pMillis);
+};
+
+#else
+
+/*============================== pthreads ============================*/
+
+Mutex::Mutex() {
+  pthread_mutex_t* m = new pthread_mutex_t;
+  pthread_mutex_init(m, NULL);
+  mHandle = m;
+};
+
+void
+Mutex::lock() {
+  pthread_mutex_lock((pthread_mutex_t*)mHandle);
+};
+
+void
+Mutex::unlock() {
+  pthread_mutex_unlock((pthread_mutex_t*)mHandle);
+};
+
+Mutex::~Mutex() {
+  pthread_mutex_destroy((pthread_mutex_t*)mHandle);
+  delete (pthread_mutex_t*)mHandle;
+};
+
+#if defined(CLOCK_MONOTONIC) && !defined(__APPLE__)
+  #define DBA_MONOTONIC_CONDITION
+#endif
+
+Condition::Condition() {
+  pthread_cond_t* c = new pthread_cond_t;
+#ifdef DBA_MONOTONIC_CONDITION
+  //timed waits are not affected by changes of system time
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(c, &attr);
+  pthread_condattr_destroy(&attr);
+#else
+  pthread_cond_init(c, NULL);
+#endif
+  mHandle = c;
+};
+
+void
+Condition::wait(Mutex& pMutex) {
+  pthread_cond_wait((pthread_cond_t*)mHandle, (pthread_mutex_t*)pMutex.mHandle);
+};
+
+bool
+Condition::wait(Mutex& pMutex, unsigned long pMillis) {
+  struct timespec until;
+#ifdef DBA_MONOTONIC_CONDITION
+  clock_gettime(CLOCK_MONOTONIC, &until);
+#else
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  until.tv_sec = now.tv_sec;
+  until.tv_nsec = now.tv_usec * 1000;
+#endif
+  until.tv_sec += pMillis / 1000;
+  until.tv_nsec += (pMillis % 1000) * 1000000;
+  if (until.tv_nsec >= 1000000000) {
+    until.tv_sec++;
+    until.tv_nsec -= 1000000000;
+  };
+  int res = pthread_cond_timedwait((pthread_cond_t*)mHandle, (pthread_mutex_t*)pMutex.mHandle, &until);
+  return res != ETIMEDOUT;
+};
+
+void
+Condition::signal() {
+  pthread_cond_signal((pthread_cond_t*)mHandle);
+};
+
+void
+Condition::broadcast() {
+  pthread_cond_broadcast((pthread_cond_t*)mHandle);
+};
+
+Condition::~Condition() {
+  pthread_cond_destroy((pthread_cond_t*)mHandle);
+  delete (pthread_cond_t*)mHandle;
+};
+
+void
+Thread::start() {
+  if (mHandle != NULL)
+    throw APIException("Thread already started");
+  pthread_t* t = new pthread_t;
+  if (pthread_create(t, NULL, &Thread::entry, this) != 0) {
+    delete t;
+    throw APIException("Cannot create thread");
+  };
+  mHandle = t;
+};
+
+void
+Thread::join() {
+  if (mHandle == NULL)
+    return;
+  pthread_t* t = (pthread_t*)mHandle;
+  pthread_join(*t, NULL);
+  delete t;
+  mHandle = NULL;
+};
+
+void
+Thread::sleep(unsigned long pMillis) {
+  struct timespec t;
+  t.tv_sec = pMillis / 1000;
+  t.tv_nsec = (pMillis % 1000) * 1000000;
+  while(nanosleep(&t,&t) == -1 && errno == EINTR);
+};
+
+#endif
+
+/*============================== common ============================*/
+
+Thread::Thread()
+  : mHandle(NULL)
+{
+};
+
+void*
+Thread::entry(void* pThread) {
+  ((Thread*)pThread)->run();
+  return NULL;
+};
+
+Thread::~Thread() {
+};
+
+};//namespace
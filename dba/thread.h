@@ -0,0 +1,139 @@
+// File: thread.h
+// Purpose: Portable threads and synchronization primitives
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBATHREAD_H
+#define DBATHREAD_H
+
+#include "dba/defs.h"
+
+namespace dba {
+
+/**
+  Non recursive mutex. Uses pthreads on unix and critical sections on win32.
+*/
+class dbaDLLEXPORT Mutex {
+    friend class Condition;
+  public:
+    Mutex();
+    /**
+      Lock mutex. Blocks if mutex is locked by other thread.
+    */
+    void lock();
+    /**
+      Unlock mutex locked by lock()
+    */
+    void unlock();
+    ~Mutex();
+  private:
+    Mutex(const Mutex&);
+    Mutex& operator=(const Mutex&);
+    void* mHandle;
+};
+
+/**
+  Locks mutex for lifetime of object. This class should be created on stack.
+*/
+class dbaDLLEXPORT MutexLocker {
+  public:
+    /**
+      Constructor. Locks pMutex
+      @param pMutex mutex to lock
+    */
+    MutexLocker(Mutex& pMutex) : mMutex(pMutex) { mMutex.lock(); };
+    /**
+      Destructor. Unlocks mutex
+    */
+    ~MutexLocker() { mMutex.unlock(); };
+  private:
+    MutexLocker(const MutexLocker&);
+    MutexLocker& operator=(const MutexLocker&);
+    Mutex& mMutex;
+};
+
+/**
+  Condition variable. As with pthread conditions spurious wakeups are possible,
+  so callers should always check their predicate in loop.
+*/
+class dbaDLLEXPORT Condition {
+  public:
+    Condition();
+    /**
+      Wait for signal. pMutex must be locked by calling thread,
+      it is unlocked while waiting and locked again before return.
+      @param pMutex mutex that protects condition predicate
+    */
+    void wait(Mutex& pMutex);
+    /**
+      Wait for signal no longer than pMillis miliseconds.
+      @param pMutex mutex that protects condition predicate
+      @param pMillis timeout in miliseconds
+      @return false if timeout expired, true otherwise
+    */
+    bool wait(Mutex& pMutex, unsigned long pMillis);
+    /**
+      Wake up one waiting thread
+    */
+    void signal();
+    /**
+      Wake up all waiting threads
+    */
+    void broadcast();
+    ~Condition();
+  private:
+    Condition(const Condition&);
+    Condition& operator=(const Condition&);
+    void* mHandle;
+};
+
+/**
+  Thread of execution. Derived classes implement run().
+*/
+class dbaDLLEXPORT Thread {
+  public:
+    Thread();
+    /**
+      Start new thread that calls run()
+      @throw APIException if thread is already running
+      @throw APIException if thread cannot be created
+    */
+    void start();
+    /**
+      Wait for thread started by start() to finish. Does nothing if thread
+      was not started.
+    */
+    void join();
+    /**
+      Check if thread was started and not joined yet
+    */
+    bool isRunning() const { return mHandle != NULL; };
+    /**
+      Suspend calling thread
+      @param pMillis time to sleep in miliseconds
+    */
+    static void sleep(unsigned long pMillis);
+    /**
+      Destructor. Thread must be joined before destruction.
+    */
+    virtual ~Thread();
+    /**@internal
+      Entry point passed to system thread creation function
+    */
+    static void* entry(void* pThread);
+  protected:
+    /**
+      Thread body
+    */
+    virtual void run() = 0;
+  private:
+    Thread(const Thread&);
+    Thread& operator=(const Thread&);
+    void* mHandle;
+};
+
+};//namespace
+
+#endif
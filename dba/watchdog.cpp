@@ -0,0 +1,186 @@
+// File: watchdog.cpp
+// Purpose: Cancellation of queries that exceeded their timeout
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#include "dba/watchdog.h"
+#include "dba/database.h"
+#include "dba/exception.h"
+
+#include <vector>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <sys/time.h>
+  #include <time.h>
+#endif
+
+namespace dba {
+
+unsigned long
+Watchdog::now() {
+#ifdef _WIN32
+  return GetTickCount();
+#elif defined(CLOCK_MONOTONIC)
+  //not affected by changes of system time
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000 + tv.tv_usec / 1000;
+#endif
+};
+
+unsigned long
+Watchdog::getTimeout(unsigned long pQueryTimeout, unsigned long pDeadline) {
+  if (pDeadline == 0)
+    return pQueryTimeout;
+  //difference is signed to handle wrap around of now()
+  long left = (long)(pDeadline - now());
+  if (left <= 0)
+    throw TimeoutException("Stream deadline expired");
+  if (pQueryTimeout != 0 && pQueryTimeout < (unsigned long)left)
+    return pQueryTimeout;
+  return left;
+};
+
+Watchdog&
+Watchdog::getInstance() {
+  static Watchdog instance;
+  return instance;
+};
+
+Watchdog::Watchdog()
+  : mStop(false)
+{
+  start();
+};
+
+void
+Watchdog::add(Entry* pEntry, unsigned long pMillis) {
+  MutexLocker lock(mMutex);
+  bool first = mEntries.empty() || now() + pMillis < mEntries.begin()->first;
+  pEntry->mPos = mEntries.insert(std::make_pair(now() + pMillis, pEntry));
+  if (first)
+    mCond.signal();
+};
+
+void
+Watchdog::remove(Entry* pEntry) {
+  MutexLocker lock(mMutex);
+  if (!pEntry->mExpired)
+    mEntries.erase(pEntry->mPos);
+  //Guard destructor cannot return while its connection is cancelled
+  while(pEntry->mCancelling)
+    mCancelCond.wait(mMutex);
+};
+
+void
+Watchdog::run() {
+  MutexLocker lock(mMutex);
+  std::vector<Entry*> expired;
+  while(!mStop) {
+    if (mEntries.empty()) {
+      mCond.wait(mMutex);
+      continue;
+    };
+    unsigned long current = now();
+    long left = (long)(mEntries.begin()->first - current);
+    if (left > 0) {
+      mCond.wait(mMutex, left);
+      continue;
+    };
+    while(!mEntries.empty() && (long)(mEntries.begin()->first - current) <= 0) {
+      Entry* entry = mEntries.begin()->second;
+      mEntries.erase(mEntries.begin());
+      entry->mExpired = true;
+      entry->mCancelling = true;
+      expired.push_back(entry);
+    };
+    //cancel can block on network, other guards are not stopped by it
+    mMutex.unlock();
+    for(std::vector<Entry*>::iterator it = expired.begin(); it != expired.end(); it++) {
+      try {
+        (*it)->mConn->cancel();
+      } catch(...) {};
+    };
+    mMutex.lock();
+    for(std::vector<Entry*>::iterator it = expired.begin(); it != expired.end(); it++)
+      (*it)->mCancelling = false;
+    expired.clear();
+    mCancelCond.broadcast();
+  };
+};
+
+Watchdog::~Watchdog() {
+  {
+    MutexLocker lock(mMutex);
+    mStop = true;
+    mCond.signal();
+  };
+  join();
+};
+
+Watchdog::Guard::Guard(DbConnection* pConn, unsigned long pMillis)
+  : mEntry(NULL)
+{
+  if (pMillis != 0) {
+    mEntry = new Entry(pConn);
+    Watchdog::getInstance().add(mEntry, pMillis);
+  };
+};
+
+bool
+Watchdog::Guard::isExpired() const {
+  if (mEntry == NULL)
+    return false;
+  MutexLocker lock(Watchdog::getInstance().mMutex);
+  return mEntry->mExpired;
+};
+
+Watchdog::Guard::~Guard() {
+  if (mEntry != NULL) {
+    Watchdog::getInstance().remove(mEntry);
+    delete mEntry;
+  };
+};
+
+TimeoutScope::TimeoutScope(DbConnection* pConn, unsigned long pQueryTimeout, unsigned long pDeadline)
+  : mConn(pConn),
+    mPrevTimeout(pConn->getTimeout()),
+    mPrevDeadline(pConn->getDeadline())
+{
+  //throws if deadline already passed
+  Watchdog::getTimeout(pQueryTimeout, pDeadline);
+  mConn->setTimeout(pQueryTimeout);
+  mConn->setDeadline(pDeadline);
+};
+
+bool
+TimeoutScope::fetchRow(DbResult& pResult) {
+  Watchdog::Guard guard(mConn, Watchdog::getTimeout(mConn->getTimeout(), mConn->getDeadline()));
+  bool ret;
+  try {
+    ret = pResult.fetchRow();
+  } catch (const Exception& pEx) {
+    if (guard.isExpired())
+      throw TimeoutException(std::string("Query cancelled after timeout: ") + pEx.what());
+    throw;
+  };
+  //error handler that does not throw
+  if (!ret && guard.isExpired())
+    throw TimeoutException("Query cancelled after timeout");
+  return ret;
+};
+
+TimeoutScope::~TimeoutScope() {
+  mConn->setTimeout(mPrevTimeout);
+  mConn->setDeadline(mPrevDeadline);
+};
+
+};//namespace
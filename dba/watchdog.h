@@ -0,0 +1,137 @@
+// File: watchdog.h
+// Purpose: Cancellation of queries that exceeded their timeout
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBAWATCHDOG_H
+#define DBAWATCHDOG_H
+
+#include <map>
+#include "dba/thread.h"
+
+namespace dba {
+
+class DbConnection;
+class DbResult;
+
+/**
+  Process wide thread that cancels queries running longer than their timeout.
+  Queries are registered using Watchdog::Guard. If guard is not destroyed
+  before its timeout expires then watchdog calls DbConnection::cancel()
+  from its own thread.
+  @ingroup api
+*/
+class dbaDLLEXPORT Watchdog : private Thread {
+    class Entry;
+    typedef std::multimap<unsigned long, Entry*> EntryMap;
+  public:
+    class Guard;
+    friend class Guard;
+    /**
+      Registers connection in watchdog for lifetime of object.
+      This class should be created on stack around driver call.
+    */
+    class dbaDLLEXPORT Guard {
+      public:
+        /**
+          Constructor
+          @param pConn connection that should be cancelled if guard lives too long
+          @param pMillis timeout in miliseconds. If 0 then guard does nothing.
+        */
+        Guard(DbConnection* pConn, unsigned long pMillis);
+        /**
+          Check if watchdog cancelled connection
+        */
+        bool isExpired() const;
+        /**
+          Destructor. Unregisters connection. After destructor returns
+          connection will not be cancelled by watchdog.
+        */
+        ~Guard();
+      private:
+        Guard(const Guard&);
+        Guard& operator=(const Guard&);
+        Entry* mEntry;
+    };
+    /**
+      Get instance of watchdog. Watchdog thread is started on first use.
+    */
+    static Watchdog& getInstance();
+    /**
+      Get time in miliseconds used for deadlines. Time is counted from unspecified point.
+    */
+    static unsigned long now();
+    /**
+      Compute timeout for next query from query timeout and stream deadline.
+      @param pQueryTimeout timeout for single query in miliseconds or 0 if not set
+      @param pDeadline deadline as returned from now() or 0 if not set
+      @return timeout in miliseconds or 0 if there is no timeout
+      @throw TimeoutException if deadline already passed
+    */
+    static unsigned long getTimeout(unsigned long pQueryTimeout, unsigned long pDeadline);
+    /**
+      Destructor. Stops watchdog thread.
+    */
+    virtual ~Watchdog();
+  private:
+    class Entry {
+      public:
+        Entry(DbConnection* pConn) : mConn(pConn), mExpired(false), mCancelling(false) {};
+        DbConnection* mConn;
+        bool mExpired;
+        //!true while watchdog thread cancels connection
+        bool mCancelling;
+        EntryMap::iterator mPos;
+    };
+    Watchdog();
+    void add(Entry* pEntry, unsigned long pMillis);
+    void remove(Entry* pEntry);
+    virtual void run();
+
+    Mutex mMutex;
+    Condition mCond;
+    Condition mCancelCond;
+    EntryMap mEntries;
+    bool mStop;
+};
+
+/**
+  Applies query timeout and stream deadline to connection for lifetime of object.
+  Used by %SQL streams around their public operations. Timeout of every query sent
+  in scope is computed when query is sent, so it never runs past deadline. Previous
+  connection timeout and deadline are restored by destructor.
+*/
+class dbaDLLEXPORT TimeoutScope {
+  public:
+    /**
+      Constructor
+      @param pConn connection used by stream
+      @param pQueryTimeout timeout for single query in miliseconds or 0 if not set
+      @param pDeadline stream deadline as returned from Watchdog::now() or 0 if not set
+      @throw TimeoutException if deadline already passed
+    */
+    TimeoutScope(DbConnection* pConn, unsigned long pQueryTimeout, unsigned long pDeadline);
+    /**
+      Fetch next row from result, cancelling fetch if timeout expires.
+      @param pResult result of query sent on connection passed to constructor
+      @return value of DbResult::fetchRow()
+      @throw TimeoutException if timeout expired
+    */
+    bool fetchRow(DbResult& pResult);
+    /**
+      Destructor. Restores previous timeout of connection.
+    */
+    ~TimeoutScope();
+  private:
+    TimeoutScope(const TimeoutScope&);
+    TimeoutScope& operator=(const TimeoutScope&);
+    DbConnection* mConn;
+    unsigned long mPrevTimeout;
+    unsigned long mPrevDeadline;
+};
+
+};//namespace
+
+#endif
@@ -0,0 +1,374 @@
+// File: writebehindostream.cpp
+// Purpose: Output stream that stores objects in background thread
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#include <iostream>
+#include <memory>
+#include "dba/writebehindostream.h"
+#include "dba/sqlarchive.h"
+#include "dba/sqlidfetcher.h"
+#include "dba/exception.h"
+#include "dba/watchdog.h"
+
+namespace dba {
+
+WriteBehindOStream::Entry::Entry(Storeable* pObject, bool pOwned, unsigned long pSeq)
+  : mObject(pObject),
+    mOwned(pOwned),
+    mDone(false),
+    mResult(false),
+    mSeq(pSeq)
+{
+};
+
+WriteBehindOStream::Entry::~Entry() {
+  if (mOwned)
+    delete mObject;
+};
+
+void
+WriteBehindOStream::Worker::run() {
+  mOwner.work();
+};
+
+WriteBehindOStream::WriteBehindOStream(SQLArchive& pArchive, unsigned int pMaxQueue, unsigned int pBatchSize)
+  : OStream(),
+    mWriter(pArchive.getOStream()),
+    mMaxQueue(pMaxQueue == 0 ? 1 : pMaxQueue),
+    mBatchSize(pBatchSize == 0 ? 1 : pBatchSize),
+    mQueued(0),
+    mInFlight(false),
+    mInFlightFirst(0),
+    mCoalesced(0),
+    mWritten(0),
+    mDelay(0),
+    mFlushing(0),
+    mStop(false),
+    mWorker(*this)
+{
+  mIsOpen = false;
+  //ids of new objects are fetched before they are queued
+  mWriter.mKeepNewIds = true;
+  mWorker.start();
+};
+
+void
+WriteBehindOStream::checkError() {
+  //called with mMutex locked
+  if (!mError.empty()) {
+    std::string error(mError);
+    mError.clear();
+    throw DatabaseException("Background write failed: " + error);
+  };
+};
+
+void
+WriteBehindOStream::waitForSpace() {
+  //called with mMutex locked
+  while(mQueue.size() >= mMaxQueue && !mStop)
+    mDoneCond.wait(mMutex);
+  if (mStop)
+    throw APIException("Write behind stream is destroyed");
+};
+
+void
+WriteBehindOStream::prepare(Storeable* pObject) {
+  {
+    MutexLocker lock(mMutex);
+    if (mStop)
+      throw APIException("Write behind stream is destroyed");
+    checkError();
+  };
+  //object needs its final id before copy is queued
+  if (pObject->isNew() && pObject->getId() == Storeable::InvalidId) {
+    MutexLocker lock(mConnMutex);
+    id newId = mWriter.mFetcher->getNextId(*mWriter.mConn, getRootTableName(*pObject));
+    alterId(pObject, newId);
+  };
+};
+
+void
+WriteBehindOStream::enqueue(Storeable* pSnapshot, Storeable* pObject) {
+  //original object looks like it was already stored
+  if (pObject->isNew() || pObject->isChanged()) {
+    makeOk(pObject);
+    setStoredTables(pObject, countTables(pObject));
+  };
+
+  MutexLocker lock(mMutex);
+  EntryKey key(getRootTableName(*pSnapshot), pSnapshot->getId());
+  EntryIndex::iterator it = mIndex.find(key);
+  if (it != mIndex.end()) {
+    Entry* pending = it->second;
+    Storeable::stState oldState = pending->mObject->getState();
+    mCoalesced++;
+    if (pSnapshot->isDeleted() && oldState == Storeable::NEW) {
+      //object was never written - forget about it
+      mQueue.remove(pending);
+      mIndex.erase(it);
+      delete pending;
+      delete pSnapshot;
+      mDoneCond.broadcast();
+      return;
+    };
+    if (oldState == Storeable::NEW && !pSnapshot->isNew()) {
+      id objId = pSnapshot->getId();
+      pSnapshot->setNew();
+      alterId(pSnapshot, objId);
+    } else if (oldState == Storeable::CHANGED && pSnapshot->isOk()) {
+      pSnapshot->setChanged();
+    };
+    delete pending->mObject;
+    pending->mObject = pSnapshot;
+    return;
+  };
+
+  try {
+    waitForSpace();
+  } catch(...) {
+    delete pSnapshot;
+    throw;
+  };
+  Entry* entry = new Entry(pSnapshot, true, ++mQueued);
+  mQueue.push_back(entry);
+  mIndex[key] = entry;
+  //worker waiting for write delay is woken up only by full batch
+  if (mQueue.size() == 1 || mQueue.size() >= mBatchSize)
+    mWorkCond.signal();
+};
+
+bool
+WriteBehindOStream::put(Storeable* pObject) {
+  prepare(pObject);
+  Entry* entry = NULL;
+  {
+    MutexLocker lock(mMutex);
+    waitForSpace();
+    //later copies must not be merged into entries queued before this one
+    EntryKey key(getRootTableName(*pObject), pObject->getId());
+    mIndex.erase(key);
+    entry = new Entry(pObject, false, ++mQueued);
+    mQueue.push_back(entry);
+    mFlushing++;
+    mWorkCond.signal();
+    while(!entry->mDone)
+      mDoneCond.wait(mMutex);
+    mFlushing--;
+  };
+  std::auto_ptr<Entry> guard(entry);
+  if (!entry->mError.empty())
+    throw DatabaseException(entry->mError);
+  return entry->mResult;
+};
+
+void
+WriteBehindOStream::flush() {
+  MutexLocker lock(mMutex);
+  unsigned long target = mQueued;
+  mFlushing++;
+  mWorkCond.signal();
+  while(true) {
+    bool queued = !mQueue.empty() && mQueue.front()->mSeq <= target;
+    bool writing = mInFlight && mInFlightFirst <= target;
+    if (!queued && !writing)
+      break;
+    mDoneCond.wait(mMutex);
+  };
+  mFlushing--;
+  checkError();
+};
+
+unsigned int
+WriteBehindOStream::getQueueSize() {
+  MutexLocker lock(mMutex);
+  return mQueue.size();
+};
+
+unsigned long
+WriteBehindOStream::getCoalescedCount() {
+  MutexLocker lock(mMutex);
+  return mCoalesced;
+};
+
+unsigned long
+WriteBehindOStream::getWrittenCount() {
+  MutexLocker lock(mMutex);
+  return mWritten;
+};
+
+void
+WriteBehindOStream::setWriteDelay(unsigned long pMillis) {
+  MutexLocker lock(mMutex);
+  mDelay = pMillis;
+};
+
+void
+WriteBehindOStream::work() {
+  MutexLocker lock(mMutex);
+  while(true) {
+    while(mQueue.empty() && !mStop)
+      mWorkCond.wait(mMutex);
+    if (mQueue.empty())
+      break;
+    //updates made during delay are merged with queued copies
+    if (mDelay > 0) {
+      //wait is woken up also by signals that do not end delay
+      unsigned long deadline = Watchdog::now() + mDelay;
+      while(!mStop && mFlushing == 0 && !mQueue.empty() && mQueue.size() < mBatchSize) {
+        unsigned long now = Watchdog::now();
+        if (now >= deadline)
+          break;
+        mWorkCond.wait(mMutex, deadline - now);
+      };
+    };
+    //new object could be deleted from queue during delay
+    if (mQueue.empty())
+      continue;
+    EntryList batch;
+    while(!mQueue.empty() && batch.size() < mBatchSize) {
+      Entry* entry = mQueue.front();
+      mQueue.pop_front();
+      if (entry->mOwned) {
+        EntryIndex::iterator it = mIndex.find(EntryKey(getRootTableName(*entry->mObject), entry->mObject->getId()));
+        if (it != mIndex.end() && it->second == entry)
+          mIndex.erase(it);
+      };
+      batch.push_back(entry);
+    };
+    mInFlight = true;
+    mInFlightFirst = batch.front()->mSeq;
+    //space in queue is available
+    mDoneCond.broadcast();
+
+    mMutex.unlock();
+    unsigned long written;
+    {
+      MutexLocker connLock(mConnMutex);
+      written = writeBatch(batch);
+    };
+    mMutex.lock();
+    mWritten += written;
+
+    for(EntryList::iterator it = batch.begin(); it != batch.end(); it++) {
+      if ((*it)->mOwned) {
+        if (!(*it)->mError.empty() && mError.empty())
+          mError = (*it)->mError;
+        delete *it;
+      } else {
+        //deleted by waiting thread
+        (*it)->mDone = true;
+      };
+    };
+    mInFlight = false;
+    mDoneCond.broadcast();
+  };
+};
+
+unsigned long
+WriteBehindOStream::writeBatch(EntryList& pBatch) {
+  std::string error;
+  try {
+    unsigned long written = 0;
+    mWriter.begin();
+    for(EntryList::iterator it = pBatch.begin(); it != pBatch.end(); it++) {
+      if (!(*it)->mObject->isOk())
+        written++;
+      (*it)->mResult = mWriter.put((*it)->mObject);
+    };
+    mWriter.commit();
+    return written;
+  } catch(const std::exception& pEx) {
+    error = pEx.what();
+  } catch(...) {
+    error = "unknown error";
+  };
+  try {
+    mWriter.rollback();
+  } catch(...) {};
+  for(EntryList::iterator it = pBatch.begin(); it != pBatch.end(); it++)
+    (*it)->mError = error;
+  return 0;
+};
+
+void
+WriteBehindOStream::open(const char* pRootTable) {
+  flush();
+  OStream::open(pRootTable);
+  MutexLocker lock(mConnMutex);
+  mWriter.open(pRootTable);
+};
+
+void
+WriteBehindOStream::begin() {
+};
+
+void
+WriteBehindOStream::commit() {
+  flush();
+};
+
+void
+WriteBehindOStream::rollback() {
+  throw APIException("Rollback is not supported by write behind stream");
+};
+
+void
+WriteBehindOStream::close() {
+  flush();
+  mIsOpen = false;
+  MutexLocker lock(mConnMutex);
+  mWriter.close();
+};
+
+void
+WriteBehindOStream::destroy() {
+  if (!mWorker.isRunning())
+    return;
+  {
+    MutexLocker lock(mMutex);
+    mStop = true;
+    mWorkCond.signal();
+    //wake up threads blocked on full queue
+    mDoneCond.broadcast();
+  };
+  //worker writes all remaining objects before exit
+  mWorker.join();
+  mIsOpen = false;
+  mWriter.destroy();
+  MutexLocker lock(mMutex);
+  checkError();
+};
+
+void
+WriteBehindOStream::assignId(Storeable* pObject) throw (Exception) {
+  MutexLocker lock(mConnMutex);
+  ((OStream&)mWriter).assignId(pObject);
+};
+
+bool
+WriteBehindOStream::erase(Storeable* pObject) {
+  throw APIException("WriteBehindOStream::erase should not be called");
+};
+
+bool
+WriteBehindOStream::update(Storeable* pObject) {
+  throw APIException("WriteBehindOStream::update should not be called");
+};
+
+bool
+WriteBehindOStream::store(Storeable* pObject) {
+  throw APIException("WriteBehindOStream::store should not be called");
+};
+
+WriteBehindOStream::~WriteBehindOStream() {
+  try {
+    destroy();
+  } catch(...) {
+    std::cerr << "Write Behind Output Stream EXCEPTION: cannot write queued objects" << std::endl;
+  };
+};
+
+};//namespace
@@ -0,0 +1,196 @@
+// File: writebehindostream.h
+// Purpose: Output stream that stores objects in background thread
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+#ifndef DBAWRITEBEHINDOSTREAM_H
+#define DBAWRITEBEHINDOSTREAM_H
+
+#include <list>
+#include <map>
+#include <string>
+#include "dba/sqlostream.h"
+#include "dba/thread.h"
+
+namespace dba {
+
+class SQLArchive;
+
+/**
+  Output stream that queues copies of Storeable objects and writes them
+  to %SQL database from background thread.
+
+  Objects are put into queue using putAsync(). putAsync() makes a copy of
+  object using its copy constructor, so object can be modified or destroyed
+  right after call. If queue already holds not yet written copy of object with
+  the same root table and id then this copy is replaced by new one, so many
+  updates of the same object are written as one %SQL query. Replaced copy
+  keeps its position in queue.
+
+  Background thread takes up to batch size objects from queue and stores
+  them in one transaction using SQLOStream. If transaction fails then all
+  objects from batch are lost and error is reported by next call to
+  putAsync(), flush() or put().
+
+  New objects get their id from SQLIdFetcher in putAsync(), so id of object
+  is known immediately after call.
+
+  @note Objects that have BIND_COL collections with new or changed members
+  should be stored using put() - collection members in queued copy
+  get their ids in background thread and these ids are not visible in original object.
+  @note Variables binded to this stream are not used when objects are stored.
+  @ingroup api
+*/
+class dbaDLLEXPORT WriteBehindOStream : public OStream {
+  public:
+    /**
+      Constructor. Takes connection from pArchive and starts background thread.
+      Connection is used by background thread for writes and by putAsync() for
+      assigning ids to new objects, so putAsync() of new object waits until
+      transaction that is currently written is finished.
+      @param pArchive open archive
+      @param pMaxQueue maximum number of objects waiting in queue. If queue is
+      full then putAsync() blocks until background thread makes space for new object.
+      @param pBatchSize maximum number of objects stored in one transaction
+    */
+    WriteBehindOStream(SQLArchive& pArchive, unsigned int pMaxQueue = 1000, unsigned int pBatchSize = 100);
+    /**
+      Queue copy of object to store in database. Object is left in OK state
+      unless it was deleted.
+      @param pObject object to store
+      @throw DatabaseException if previous background write failed
+    */
+    template <typename T> void putAsync(T& pObject);
+    /**
+      Store object synchronously. Waits until all previously queued objects and pObject
+      are written by background thread.
+      @param pObject object to store
+      @return true if object was stored
+    */
+    virtual bool put(Storeable* pObject);
+    /**
+      Wait until all objects queued before call are written to database.
+      @throw DatabaseException if any background write failed since last call to flush()
+    */
+    void flush();
+    /**
+      Get number of objects waiting in queue
+    */
+    unsigned int getQueueSize();
+    /**
+      Get number of object copies that were replaced by newer copy before write
+    */
+    unsigned long getCoalescedCount();
+    /**
+      Get number of objects written to database by background thread
+    */
+    unsigned long getWrittenCount();
+    /**
+      Set time that background thread waits after object is queued before
+      it writes queue, unless batch size objects are queued, flush() or put()
+      is called or stream is destroyed. Updates of queued objects made during
+      this time are merged. Default is 0 - queue is written immediately.
+      @param pMillis delay in miliseconds
+    */
+    void setWriteDelay(unsigned long pMillis);
+    /**
+      Open stream. Must not be called concurrently with putAsync() or put()
+      @param pRootTable custom root table name
+    */
+    virtual void open(const char* pRootTable = NULL);
+    /**
+      Does nothing. Background thread creates its own transactions
+    */
+    virtual void begin();
+    /**
+      Same as flush()
+    */
+    virtual void commit();
+    /**
+      Not supported. Queued objects cannot be rolled back.
+      @throw APIException always
+    */
+    virtual void rollback();
+    virtual void close();
+    /**
+      Write all queued objects, stop background thread and release connection.
+    */
+    virtual void destroy();
+    virtual void assignId(Storeable* pObject) throw (Exception);
+    /**
+      Destructor. Calls destroy()
+    */
+    virtual ~WriteBehindOStream();
+  private:
+    class Entry {
+      public:
+        Entry(Storeable* pObject, bool pOwned, unsigned long pSeq);
+        ~Entry();
+        Storeable* mObject;
+        bool mOwned;
+        bool mDone;
+        bool mResult;
+        unsigned long mSeq;
+        std::string mError;
+    };
+    class Worker : public Thread {
+      public:
+        Worker(WriteBehindOStream& pOwner) : mOwner(pOwner) {};
+      protected:
+        virtual void run();
+      private:
+        WriteBehindOStream& mOwner;
+    };
+    friend class Worker;
+    typedef std::pair<std::string, id> EntryKey;
+    typedef std::list<Entry*> EntryList;
+    typedef std::map<EntryKey, Entry*> EntryIndex;
+
+    WriteBehindOStream(const WriteBehindOStream&);
+    WriteBehindOStream& operator=(const WriteBehindOStream&);
+
+    void prepare(Storeable* pObject);
+    void enqueue(Storeable* pSnapshot, Storeable* pObject);
+    void waitForSpace();
+    void checkError();
+    void work();
+    unsigned long writeBatch(EntryList& pBatch);
+
+    virtual bool erase(Storeable* pObject);
+    virtual bool update(Storeable* pObject);
+    virtual bool store(Storeable* pObject);
+
+    SQLOStream mWriter;
+    unsigned int mMaxQueue;
+    unsigned int mBatchSize;
+    Mutex mMutex;
+    Mutex mConnMutex;
+    Condition mWorkCond;
+    Condition mDoneCond;
+    EntryList mQueue;
+    EntryIndex mIndex;
+    unsigned long mQueued;
+    bool mInFlight;
+    unsigned long mInFlightFirst;
+    unsigned long mCoalesced;
+    unsigned long mWritten;
+    unsigned long mDelay;
+    //!number of threads waiting in flush() or put()
+    unsigned int mFlushing;
+    bool mStop;
+    std::string mError;
+    Worker mWorker;
+};
+
+template <typename T>
+void
+WriteBehindOStream::putAsync(T& pObject) {
+  prepare(&pObject);
+  enqueue(new T(pObject), &pObject);
+};
+
+};//namespace
+
+#endif
@@ -20,7 +20,11 @@ XMLArchive::XMLArchive()
   : Archive(),
     mDocument(NULL),
     mRootNode(NULL),
-    mUseElements(false)
+    mUseElements(false),
+    mStreamingInput(false),
+    mStreaming(false),
+    mStreamingOutput(false),
+    mWriteBufferSize(1024 * 1024)
 {
   mConvSpecs.mTimestampFormat = "%Y-%m-%dT%H:%M:%S";
   mRootNodeName = xmlStrdup((xmlChar*)"dba");
@@ -45,7 +49,7 @@ XMLArchive::open(xmlDocPtr pDocument) {
   xmlDocSetRootElement(mDocument,root);
   if ((mRootNodeName != NULL) && (xmlStrcmp(mRootNodeName,root->name)))
     throw DataException("Wrong root node name");
-  updateEncoding();
+  updateEncoding(mDocument->encoding);
   mRootNode = xmlDocGetRootElement(mDocument);
 };
 
@@ -53,6 +57,21 @@ void
 XMLArchive::open(const char* pOpenStr) {
   mFilename = pOpenStr;
   close();
+  if (mStreamingInput && mStreamingOutput)
+    throw APIException("XMLArchive cannot use streaming input and output at once");
+  if (mStreamingOutput) {
+    mWriter = new XMLStreamWriter(pOpenStr,ConvSpec::getXmlEncodingName(mConvSpecs.mDbCharset),mWriteBufferSize);
+    if (mRootNodeName != NULL)
+      mWriter->setRootElement((const char*)mRootNodeName);
+    return;
+  };
+  if (mStreamingInput && FileUtils::exists(pOpenStr)) {
+    //checks root node and encoding, objects are read by input streams
+    XMLStreamReader reader(pOpenStr,mRootNodeName);
+    updateEncoding(reader.getEncoding());
+    mStreaming = true;
+    return;
+  };
   //must be after close()
   ErrorContext c(this);
   if (FileUtils::exists(pOpenStr)) {
@@ -80,7 +99,7 @@ XMLArchive::open(const char* pOpenStr) {
     };
     xmlDocSetRootElement(mDocument,node);
   };
-  updateEncoding();
+  updateEncoding(mDocument->encoding);
   mRootNode = xmlDocGetRootElement(mDocument);
 };
 
@@ -88,6 +107,12 @@ void
 XMLArchive::addNamespace(const char* pName, const char* pPrefix) {
   if (!isOpen())
     throw APIException("XMLArchive must be open to add namespace to it");
+  if (mStreaming)
+    throw APIException("XMLArchive opened with streaming input is read only");
+  if (mWriter != NULL) {
+    mWriter->addNamespace(pName,pPrefix);
+    return;
+  };
   xmlNsPtr ret = xmlNewNs(mRootNode, (xmlChar*)pName, (xmlChar*)pPrefix);
   if (ret == NULL)
     throw XMLException("Failed to add namespace to archive");
@@ -95,6 +120,12 @@ XMLArchive::addNamespace(const char* pName, const char* pPrefix) {
 
 void
 XMLArchive::close() {
+  mStreaming = false;
+  if (mWriter != NULL) {
+    shared_ptr<XMLStreamWriter> writer(mWriter);
+    mWriter = NULL;
+    writer->close();
+  };
   if (mDocument != NULL) {
     if (!mFilename.empty()) {
       write();
@@ -106,6 +137,10 @@ XMLArchive::close() {
 
 IStream* 
 XMLArchive::getInputStream() {
+  if (mWriter != NULL)
+    throw APIException("XMLArchive opened with streaming output is write only");
+  if (mStreaming)
+    return new XMLIStream(new XMLStreamReader(mFilename.c_str(),mRootNodeName),mConvSpecs,mUseElements);
   xmlNodePtr root = xmlDocGetRootElement(mDocument);
   if (mRootNodeName != NULL)
     root = root->children;
@@ -114,11 +149,19 @@ XMLArchive::getInputStream() {
 
 OStream* 
 XMLArchive::getOutputStream() {
+  if (mStreaming)
+    throw APIException("XMLArchive opened with streaming input is read only");
+  if (mWriter != NULL)
+    return new XMLOStream(mWriter,mConvSpecs,mUseElements);
   return new XMLOStream(mDocument,mRootNode,mRootNodeName != NULL,mConvSpecs,mUseElements);
 };
 
 XMLIStream 
 XMLArchive::getIStream() {
+  if (mWriter != NULL)
+    throw APIException("XMLArchive opened with streaming output is write only");
+  if (mStreaming)
+    return XMLIStream(new XMLStreamReader(mFilename.c_str(),mRootNodeName),mConvSpecs,mUseElements);
   xmlNodePtr root = xmlDocGetRootElement(mDocument);
   if (mRootNodeName != NULL)
     root = root->children;
@@ -127,55 +170,59 @@ XMLArchive::getIStream() {
 
 XMLOStream 
 XMLArchive::getOStream() {
+  if (mStreaming)
+    throw APIException("XMLArchive opened with streaming input is read only");
+  if (mWriter != NULL)
+    return XMLOStream(mWriter,mConvSpecs,mUseElements);
   XMLOStream ret(mDocument,mRootNode,mRootNodeName == NULL,mConvSpecs,mUseElements);
   return ret;
 };
 
 void
-XMLArchive::updateEncoding() {
-  if (mDocument->encoding == NULL)
+XMLArchive::updateEncoding(const xmlChar* pEncoding) {
+  if (pEncoding == NULL)
     return;
-  if (xmlStrcasecmp((xmlChar*)"utf-8",mDocument->encoding) == 0)
+  if (xmlStrcasecmp((xmlChar*)"utf-8",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::UTF8;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-1",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-1",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_1;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-2",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-2",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_2;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-3",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-3",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_3;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-4",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-4",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_4;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-5",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-5",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_5;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-6",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-6",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_6;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-7",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-7",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_7;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-8",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-8",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_8;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-9",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-9",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_9;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-10",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-10",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_10;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-11",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-11",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_11;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-13",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-13",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_13;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-14",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-14",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_14;
-  else if (xmlStrcasecmp((xmlChar*)"iso-8859-15",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"iso-8859-15",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::ISO8859_15;
-  else if (xmlStrcasecmp((xmlChar*)"win-1250",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"win-1250",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::CP1250;
-  else if (xmlStrcasecmp((xmlChar*)"win-1251",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"win-1251",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::CP1251;
-  else if (xmlStrcasecmp((xmlChar*)"win-1252",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"win-1252",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::CP1252;
-  else if (xmlStrcasecmp((xmlChar*)"win-1254",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"win-1254",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::CP1254;
-  else if (xmlStrcasecmp((xmlChar*)"win-1255",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"win-1255",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::CP1255;
-  else if (xmlStrcasecmp((xmlChar*)"win-1256",mDocument->encoding) == 0)
+  else if (xmlStrcasecmp((xmlChar*)"win-1256",pEncoding) == 0)
     mConvSpecs.mDbCharset = ConvSpec::CP1256;
 };
 
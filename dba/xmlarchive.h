@@ -65,8 +65,31 @@ class dbaDLLEXPORT XMLArchive  : public Archive, public ConvSpecContainer, publi
       Close archive and write xml document to file
     */
     void close();
-    virtual bool isOpen() const { return mDocument != NULL; }
+    virtual bool isOpen() const { return mDocument != NULL || mStreaming || mWriter != NULL; }
     void useElements(bool pFlag = true) { mUseElements = pFlag; }
+    /**
+      Read existing file with xmlTextReader instead of loading whole document
+      into memory. Input streams expand one object element (with its
+      collections) at a time, so memory usage is bounded by size of single
+      object. Archive opened in this mode is read only. Files that do not
+      exist are created as usual. Must be called before open().
+      @param pFlag true to read file in streaming mode
+    */
+    void useStreamingInput(bool pFlag = true) { mStreamingInput = pFlag; }
+    /**
+      Write objects directly to file with xmlTextWriter instead of building
+      document in memory. Existing file is overwritten when archive is opened,
+      objects are written in order they are stored and file is completed by
+      close(). Archive opened in this mode is write only. Must be called before
+      open().
+      @param pFlag true to write file in streaming mode
+    */
+    void useStreamingOutput(bool pFlag = true) { mStreamingOutput = pFlag; }
+    /**
+      Set size of output buffer used in streaming output mode. Default is 1MB
+      @param pSize size in bytes
+    */
+    void setWriteBufferSize(size_t pSize) { mWriteBufferSize = pSize; }
     XMLOStream getOStream();
     XMLIStream getIStream();
     virtual IStream* getInputStream();
@@ -93,6 +116,23 @@ class dbaDLLEXPORT XMLArchive  : public Archive, public ConvSpecContainer, publi
       should archive store/load members data from elements or attributes
     */
     bool mUseElements;
+    /**
+      should existing files be read in streaming mode
+    */
+    bool mStreamingInput;
+    /**
+      true if archive is open in streaming mode and has no document
+    */
+    bool mStreaming;
+    /**
+      should file be written in streaming mode
+    */
+    bool mStreamingOutput;
+    size_t mWriteBufferSize;
+    /**
+      writer of file if archive is open in streaming output mode
+    */
+    shared_ptr<XMLStreamWriter> mWriter;
     
     /**
       Write contents of mDocument to file
@@ -109,8 +149,9 @@ class dbaDLLEXPORT XMLArchive  : public Archive, public ConvSpecContainer, publi
     ConvSpec::charset getDebeaEncoding(const char* pLibxmlEncoding);
     /**
       update ConvSpec encoding
+      @param pEncoding libxml2 encoding name of document or NULL
     */
-    void updateEncoding();
+    void updateEncoding(const xmlChar* pEncoding);
 };
 
 } //namespace
@@ -18,6 +18,91 @@
 
 namespace dba {
 
+XMLStreamReader::XMLStreamReader(const char* pFilename, const xmlChar* pRootNodeName)
+  : XMLErrorHandler(),
+    mReader(NULL),
+    mDepth(0),
+    mNode(NULL)
+{
+  ErrorContext c(this);
+  mReader = xmlReaderForFile(pFilename,NULL,0);
+  if (mReader == NULL) {
+    if (c.wasError())
+      throw c.createException();
+    else
+      throw XMLException("Error reading file");
+  };
+  try {
+    init(pRootNodeName,c);
+  } catch(...) {
+    xmlFreeTextReader(mReader);
+    throw;
+  };
+};
+
+void
+XMLStreamReader::init(const xmlChar* pRootNodeName, const ErrorContext& pContext) {
+  //root element is not expanded, it contains all objects
+  int ret = xmlTextReaderRead(mReader);
+  while(ret == 1 && xmlTextReaderNodeType(mReader) != XML_READER_TYPE_ELEMENT)
+    ret = xmlTextReaderNext(mReader);
+  checkError(ret,pContext);
+  if (ret != 1)
+    throw DataException("Root node not found");
+  if (pRootNodeName == NULL) {
+    mNode = findElement(ret,pContext);
+    return;
+  };
+  if (xmlStrcmp(pRootNodeName,xmlTextReaderConstLocalName(mReader)))
+    throw DataException("Wrong root node name");
+  mDepth = 1;
+  if (!xmlTextReaderIsEmptyElement(mReader))
+    mNode = findElement(xmlTextReaderRead(mReader),pContext);
+};
+
+xmlNodePtr
+XMLStreamReader::next() {
+  if (mNode == NULL)
+    return NULL;
+  ErrorContext c(this);
+  //skips subtree of current element, reader frees it
+  mNode = findElement(xmlTextReaderNext(mReader),c);
+  return mNode;
+};
+
+xmlNodePtr
+XMLStreamReader::findElement(int pRet, const ErrorContext& pContext) {
+  while(pRet == 1) {
+    int depth = xmlTextReaderDepth(mReader);
+    //end of root element
+    if (depth < mDepth)
+      return NULL;
+    if (depth == mDepth && xmlTextReaderNodeType(mReader) == XML_READER_TYPE_ELEMENT) {
+      xmlNodePtr node = xmlTextReaderExpand(mReader);
+      if (node == NULL)
+        checkError(-1,pContext);
+      return node;
+    };
+    pRet = xmlTextReaderNext(mReader);
+  };
+  checkError(pRet,pContext);
+  return NULL;
+};
+
+void
+XMLStreamReader::checkError(int pRet, const ErrorContext& pContext) {
+  if (pRet != -1)
+    return;
+  if (pContext.wasError())
+    throw pContext.createException();
+  else
+    throw XMLException("Error reading file");
+};
+
+XMLStreamReader::~XMLStreamReader() {
+  xmlFreeTextReader(mReader);
+};
+
 XMLIStream::XMLIStream(xmlDocPtr pDocument, xmlNodePtr pNode, const ConvSpec& pSpecs, bool pUseElements)
   : IStream(),
     ConvSpecContainer(pSpecs),
@@ -30,6 +115,21 @@ XMLIStream::XMLIStream(xmlDocPtr pDocument, xmlNodePtr pNode, const ConvSpec& pS
   mCurrentNode = findNonTextNode(mParentNode);
 }
 
+XMLIStream::XMLIStream(XMLStreamReader* pReader, const ConvSpec& pSpecs, bool pUseElements)
+  : IStream(),
+    ConvSpecContainer(pSpecs),
+    mDocument(NULL),
+    mReader(pReader),
+    mParentNode(NULL),
+    mIgnoreNonMappedNodes(false),
+    mIgnoreOrder(false),
+    mUseElements(pUseElements)
+{
+  mCurrentNode = mReader->getNode();
+  if (mCurrentNode != NULL)
+    mDocument = mCurrentNode->doc;
+}
+
 xmlNodePtr
 XMLIStream::setNextNode(xmlNodePtr pNode) {
   if (pNode) 
@@ -37,6 +137,16 @@ XMLIStream::setNextNode(xmlNodePtr pNode) {
   return findNonTextNode(pNode);
 };
 
+xmlNodePtr
+XMLIStream::nextObjectNode() {
+  if (mReader == NULL)
+    return setNextNode(mCurrentNode);
+  xmlNodePtr node = mReader->next();
+  if (node != NULL)
+    mDocument = node->doc;
+  return node;
+};
+
 xmlNodePtr
 XMLIStream::findNonTextNode(xmlNodePtr pNode) {
   while(pNode != NULL && (xmlIsBlankNode(pNode) == 1))
@@ -62,6 +172,7 @@ XMLIStream::close() {
 void 
 XMLIStream::destroy() {
   mParentNode = mCurrentNode = NULL;
+  mReader = NULL;
 };
 
 void
@@ -137,7 +248,7 @@ XMLIStream::get(CollectionFilterBase* pFilter, const char* pRootTable) {
   const char* rootTableName = getRootTableName(rootobj);
 
   debug("store table set to %s", rootTableName);
-  mCurrentNode = findNode(mCurrentNode, rootTableName);
+  findCurrentNode(rootTableName);
   while(mCurrentNode != NULL) {
   
     //apply non-collection filters to fetch data from
@@ -192,7 +303,7 @@ XMLIStream::findAttribute(xmlNodePtr pNode, const char* pMemberName) {
 };
 
 xmlNodePtr 
-XMLIStream::findNode(xmlNodePtr pNode, const char* pName) {
+XMLIStream::findNode(xmlNodePtr pNode, const char* pName, bool pSiblings) {
   xmlNsPtr nsptr = getXMLNamespace(pName, pNode);
   xmlChar* name = NULL;
   if (nsptr == NULL) {
@@ -202,7 +313,7 @@ XMLIStream::findNode(xmlNodePtr pNode, const char* pName) {
   };
 
   xmlNodePtr node = NULL;
-  for(node = pNode; node != NULL; node = node->next) {
+  for(node = pNode; node != NULL; node = pSiblings ? node->next : NULL) {
     if (!xmlNodeIsText(node) && !xmlStrcmp(name,node->name))
       break;
     //if (!xmlNodeIsText(node)) debug("findNode: ignoring node %s", node->name != NULL ? (const char*)node->name : "(null)");
@@ -214,10 +325,24 @@ XMLIStream::findNode(xmlNodePtr pNode, const char* pName) {
   return node;
 };
 
+void
+XMLIStream::findCurrentNode(const char* pName) {
+  if (mReader == NULL) {
+    mCurrentNode = findNode(mCurrentNode, pName);
+    return;
+  };
+  //siblings of streamed element are not parsed yet
+  while(mCurrentNode != NULL && findNode(mCurrentNode, pName, false) == NULL)
+    mCurrentNode = nextObjectNode();
+};
+
 void 
 XMLIStream::moveCurrentNode(const char* pName) {
-  mCurrentNode = mCurrentNode->next;
-  mCurrentNode = findNode(mCurrentNode, pName);
+  if (mReader == NULL)
+    mCurrentNode = mCurrentNode->next;
+  else
+    mCurrentNode = nextObjectNode();
+  findCurrentNode(pName);
   if (mCurrentNode == NULL)
     return;
   debug("mCurrentNode moved to %s", mCurrentNode->name != NULL ? (const char*)mCurrentNode->name : "(null)");
@@ -254,6 +379,7 @@ XMLIStream::applyFilters(Storeable* pObject, xmlNodePtr pNode) {
       };
       if (xmldata != NULL) {
         std::string data((const char*)xmldata);
+        xmlFree(xmldata);
         filter->fromString(mConvSpecs, data);
       } else {
         filter->fromNull();
@@ -270,7 +396,7 @@ XMLIStream::getNext(Storeable* pObject) {
   if (mCurrentNode == NULL)
     return false;
   applyFilters(pObject,mCurrentNode);
-  mCurrentNode = setNextNode(mCurrentNode);
+  mCurrentNode = nextObjectNode();
   return true;
 };
 
@@ -288,6 +414,7 @@ XMLIStream::updateVars(xmlNodePtr pNode) {
           filter.fromNull();
         } else {
           std::string data((const char*)xmldata);
+          xmlFree(xmldata);
           filter.fromString(mConvSpecs, data);
         };
       } else {
@@ -13,17 +13,72 @@
 #define DBAXMLISTREAM_H
 
 #include "dba/istream.h"
+#include "dba/shared_ptr.h"
 #include "dba/xmlerrorhandler.h"
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
 
 namespace dba {
 
+/**
+  Reads xml file using libxml2 xmlTextReader. Only current object element
+  is expanded into DOM subtree, it is freed when reader moves to next
+  element, so memory usage does not depend on number of objects in file.
+*/
+class dbaDLLEXPORT XMLStreamReader : public XMLErrorHandler {
+  public:
+    /**
+      Open file and move to first object element
+      @param pFilename name of xml file
+      @param pRootNodeName name of root element that contains objects or
+             NULL if root element is the only object in file
+      @throw XMLException if file cannot be read
+      @throw DataException if root element is missing or has wrong name
+    */
+    XMLStreamReader(const char* pFilename, const xmlChar* pRootNodeName);
+    /**
+      @return encoding of document or NULL if it is not known
+    */
+    const xmlChar* getEncoding() { return xmlTextReaderConstEncoding(mReader); }
+    /**
+      @return current object element with all its children or NULL
+              if there are no more elements
+    */
+    xmlNodePtr getNode() const { return mNode; }
+    /**
+      Free current element and move to next object element
+      @return next object element or NULL if there are no more elements
+      @throw XMLException if file cannot be parsed
+    */
+    xmlNodePtr next();
+    ~XMLStreamReader();
+  private:
+    XMLStreamReader(const XMLStreamReader&);
+    XMLStreamReader& operator=(const XMLStreamReader&);
+    void init(const xmlChar* pRootNodeName, const ErrorContext& pContext);
+    xmlNodePtr findElement(int pRet, const ErrorContext& pContext);
+    void checkError(int pRet, const ErrorContext& pContext);
+
+    xmlTextReaderPtr mReader;
+    //depth of object elements, 0 if root element is object
+    int mDepth;
+    xmlNodePtr mNode;
+};
+
 /**
 Object input stream for XMLArchive
 */
 class dbaDLLEXPORT XMLIStream : public IStream, public XMLErrorHandler, public ConvSpecContainer {
   public:
     XMLIStream(xmlDocPtr pDocument, xmlNodePtr pNode, const ConvSpec& pSpecs, bool pUseElements);
+    /**
+      Create stream that reads objects from file one by one
+      without loading whole document into memory.
+      @param pReader reader of xml file, stream takes ownership of it
+      @param pSpecs conversion specification
+      @param pUseElements if true then members are loaded from subelements first
+    */
+    XMLIStream(XMLStreamReader* pReader, const ConvSpec& pSpecs, bool pUseElements);
     /**
       If set to true, then stream will igore all nodes that are not mapped to class
       members or binded to variables. 
@@ -50,6 +105,8 @@ class dbaDLLEXPORT XMLIStream : public IStream, public XMLErrorHandler, public C
     virtual ~XMLIStream();
   private:
     xmlDocPtr mDocument;
+    //NULL if whole document is loaded
+    shared_ptr<XMLStreamReader> mReader;
     xmlNodePtr mParentNode;
     xmlNodePtr mCurrentNode;
     bool mIgnoreNonMappedNodes;
@@ -60,11 +117,13 @@ class dbaDLLEXPORT XMLIStream : public IStream, public XMLErrorHandler, public C
     void applyFilters(Storeable* pObject, xmlNodePtr pNode);
     bool updateVars(xmlNodePtr pNode);
     xmlNodePtr setNextNode(xmlNodePtr pNode);
+    xmlNodePtr nextObjectNode();
     xmlNodePtr findNonTextNode(xmlNodePtr pNode);
     void getChildren(Storeable* pParent, xmlNodePtr pNode);
     void updateCollection(Storeable* pParent, ColMemberEntry* pEntry, xmlNodePtr pNode);
     xmlAttrPtr findAttribute(xmlNodePtr pNode, const char* pMemberName);
-    xmlNodePtr findNode(xmlNodePtr pNode, const char* pName);
+    xmlNodePtr findNode(xmlNodePtr pNode, const char* pName, bool pSiblings = true);
+    void findCurrentNode(const char* pName);
     void moveCurrentNode(const char* pName);
     xmlNsPtr getXMLNamespace(const char* pName, xmlNodePtr pNode);
 };
@@ -10,6 +10,11 @@
 //
 //
 #include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #include "dba/xmlostream.h"
 #include "dba/conversion.h"
@@ -18,6 +23,263 @@
 
 namespace dba {
 
+/**
+  Escape attribute value the same way as xmlSaveFileEnc does for document with encoding set.
+  xmlTextWriterWriteAttribute writes non-ASCII chars as char references, because writer
+  document has no encoding when declaration is written by hand.
+*/
+static std::string
+escapeAttribute(const char* pContent) {
+  std::string ret;
+  for(const char* c = pContent; *c != 0; c++) {
+    switch(*c) {
+      case '<': ret += "&lt;"; break;
+      case '>': ret += "&gt;"; break;
+      case '&': ret += "&amp;"; break;
+      case '"': ret += "&quot;"; break;
+      case '\n': ret += "&#10;"; break;
+      case '\r': ret += "&#13;"; break;
+      case '\t': ret += "&#9;"; break;
+      default: ret += *c;
+    };
+  };
+  return ret;
+};
+
+XMLStreamWriter::XMLStreamWriter(const char* pFilename, const char* pEncoding, size_t pBufferSize)
+  : XMLErrorHandler(),
+    mFile(NULL),
+    mWriter(NULL),
+    mRootWritten(false),
+    mDepth(0)
+{
+  FILE* file = fopen(pFilename,"wb");
+  if (file == NULL) {
+    std::string err("Cannot create file ");
+    err += pFilename;
+    throw XMLException(err.c_str());
+  };
+  init(file,pEncoding,pBufferSize);
+};
+
+XMLStreamWriter::XMLStreamWriter(int pFd, const char* pEncoding, size_t pBufferSize)
+  : XMLErrorHandler(),
+    mFile(NULL),
+    mWriter(NULL),
+    mRootWritten(false),
+    mDepth(0)
+{
+#ifdef _WIN32
+  int fd = _dup(pFd);
+  FILE* file = fd == -1 ? NULL : _fdopen(fd,"wb");
+  if (file == NULL && fd != -1)
+    _close(fd);
+#else
+  int fd = dup(pFd);
+  FILE* file = fd == -1 ? NULL : fdopen(fd,"wb");
+  if (file == NULL && fd != -1)
+    ::close(fd);
+#endif
+  if (file == NULL) {
+    throw XMLException("Cannot write to file descriptor");
+  };
+  init(file,pEncoding,pBufferSize);
+};
+
+void
+XMLStreamWriter::init(FILE* pFile, const char* pEncoding, size_t pBufferSize) {
+  ErrorContext c(this);
+  mFile = pFile;
+  //libxml2 writes small blocks, stdio buffer joins them
+  mBuffer.resize(pBufferSize == 0 ? 1 : pBufferSize);
+  setvbuf(mFile,&mBuffer[0],_IOFBF,mBuffer.size());
+  //without encoder libxml2 writes UTF-8 as is, UTF-8 encoder would
+  //write every non-ASCII char as char reference
+  xmlCharEncodingHandlerPtr encoder = NULL;
+  if (pEncoding != NULL && xmlParseCharEncoding(pEncoding) != XML_CHAR_ENCODING_UTF8) {
+    encoder = xmlFindCharEncodingHandler(pEncoding);
+    if (encoder == NULL) {
+      fclose(mFile);
+      mFile = NULL;
+      std::string err("Unsupported encoding ");
+      err += pEncoding;
+      throw XMLException(err.c_str());
+    };
+  };
+  xmlOutputBufferPtr out = xmlOutputBufferCreateFile(mFile,encoder);
+  if (out != NULL)
+    mWriter = xmlNewTextWriter(out);
+  if (mWriter == NULL) {
+    if (out != NULL)
+      xmlOutputBufferClose(out);
+    fclose(mFile);
+    mFile = NULL;
+    if (c.wasError())
+      throw c.createException();
+    else
+      throw XMLException("Cannot create xml writer");
+  };
+  xmlTextWriterSetIndent(mWriter,1);
+  xmlTextWriterSetIndentString(mWriter,(const xmlChar*)"  ");
+  //xmlTextWriterStartDocument changes case of encoding name,
+  //declaration is written the same way as xmlSaveFileEnc does
+  std::string decl("<?xml version=\"1.0\" encoding=\"");
+  decl += pEncoding == NULL ? "utf-8" : pEncoding;
+  decl += "\"?>\n";
+  try {
+    checkError(xmlTextWriterWriteRaw(mWriter,(const xmlChar*)decl.c_str()),c);
+  } catch(...) {
+    xmlFreeTextWriter(mWriter);
+    mWriter = NULL;
+    fclose(mFile);
+    mFile = NULL;
+    throw;
+  };
+};
+
+xmlTextWriterPtr
+XMLStreamWriter::getWriter() {
+  if (mWriter == NULL)
+    throw APIException("XMLStreamWriter is closed");
+  return mWriter;
+};
+
+void
+XMLStreamWriter::setRootElement(const char* pName) {
+  if (mRootWritten)
+    throw APIException("Root element already written");
+  mRootName = pName == NULL ? "" : pName;
+};
+
+void
+XMLStreamWriter::addNamespace(const char* pName, const char* pPrefix) {
+  if (mRootWritten)
+    throw APIException("Namespaces have to be added before first object is stored");
+  mNamespaces.push_back(std::pair<std::string, std::string>(pPrefix,pName));
+};
+
+void
+XMLStreamWriter::checkNamespace(const char* pName) {
+  char* ns = XMLUtils::getNsFromName(pName);
+  if (ns == NULL)
+    return;
+  std::list<std::pair<std::string, std::string> >::const_iterator it = mNamespaces.begin();
+  while(it != mNamespaces.end() && it->first != ns)
+    it++;
+  delete [] ns;
+  if (it == mNamespaces.end()) {
+    std::string err("Error writing '");
+    err += pName;
+    err += "'. Namespace not added, call addNamespace on XMLArchive first";
+    throw APIException(err.c_str());
+  };
+};
+
+void
+XMLStreamWriter::startRoot() {
+  ErrorContext c(this);
+  mRootWritten = true;
+  if (!mRootName.empty()) {
+    checkError(xmlTextWriterStartElement(getWriter(),(const xmlChar*)mRootName.c_str()),c);
+    writeNamespaces();
+  };
+};
+
+void
+XMLStreamWriter::writeNamespaces() {
+  ErrorContext c(this);
+  for(std::list<std::pair<std::string, std::string> >::const_iterator it = mNamespaces.begin(); it != mNamespaces.end(); it++) {
+    std::string attr("xmlns:" + it->first);
+    checkError(xmlTextWriterWriteAttribute(mWriter,(const xmlChar*)attr.c_str(),(const xmlChar*)it->second.c_str()),c);
+  };
+};
+
+void
+XMLStreamWriter::startElement(const char* pName) {
+  checkNamespace(pName);
+  //object element is root of document, second one would make it not well-formed
+  if (mRootWritten && mRootName.empty() && mDepth == 0)
+    throw APIException("Only one object can be written to xml file without root element");
+  bool root = !mRootWritten;
+  if (root)
+    startRoot();
+  ErrorContext c(this);
+  checkError(xmlTextWriterStartElement(getWriter(),(const xmlChar*)pName),c);
+  mDepth++;
+  //object element is root of document
+  if (root && mRootName.empty())
+    writeNamespaces();
+};
+
+void
+XMLStreamWriter::writeAttribute(const char* pName, const char* pContent) {
+  checkNamespace(pName);
+  ErrorContext c(this);
+  checkError(xmlTextWriterStartAttribute(getWriter(),(const xmlChar*)pName),c);
+  checkError(xmlTextWriterWriteRaw(mWriter,(const xmlChar*)escapeAttribute(pContent).c_str()),c);
+  checkError(xmlTextWriterEndAttribute(mWriter),c);
+};
+
+void
+XMLStreamWriter::writeElement(const char* pName, const char* pContent) {
+  checkNamespace(pName);
+  ErrorContext c(this);
+  checkError(xmlTextWriterWriteElement(getWriter(),(const xmlChar*)pName,(const xmlChar*)pContent),c);
+};
+
+void
+XMLStreamWriter::endElement() {
+  ErrorContext c(this);
+  checkError(xmlTextWriterEndElement(getWriter()),c);
+  mDepth--;
+};
+
+void
+XMLStreamWriter::close() {
+  if (mWriter == NULL)
+    return;
+  FILE* file = mFile;
+  try {
+    if (!mRootWritten)
+      startRoot();
+    //ends all open elements
+    ErrorContext c(this);
+    checkError(xmlTextWriterEndDocument(mWriter),c);
+  } catch(...) {
+    release();
+    fclose(file);
+    throw;
+  };
+  //writer flushes its buffers to file when freed
+  release();
+  if (fclose(file) != 0)
+    throw XMLException("Error writing xml file");
+};
+
+void
+XMLStreamWriter::release() {
+  xmlFreeTextWriter(mWriter);
+  mWriter = NULL;
+  mFile = NULL;
+  mDepth = 0;
+};
+
+void
+XMLStreamWriter::checkError(int pRet, const ErrorContext& pContext) {
+  if (pRet != -1)
+    return;
+  if (pContext.wasError())
+    throw pContext.createException();
+  else
+    throw XMLException("Error writing xml file");
+};
+
+XMLStreamWriter::~XMLStreamWriter() {
+  try {
+    close();
+  } catch(...) {};
+};
+
 XMLOStream::XMLOStream(xmlDocPtr pDocument, xmlNodePtr pNode, bool pReplaceParentNode, const ConvSpec& pSpecs, bool pUseElements)
   : OStream(),
     ConvSpecContainer(pSpecs),
@@ -28,6 +290,41 @@ XMLOStream::XMLOStream(xmlDocPtr pDocument, xmlNodePtr pNode, bool pReplaceParen
 {
 }
 
+XMLOStream::XMLOStream(const shared_ptr<XMLStreamWriter>& pWriter, const ConvSpec& pSpecs, bool pUseElements)
+  : OStream(),
+    ConvSpecContainer(pSpecs),
+    mDocument(NULL),
+    mWriter(pWriter),
+    mParentNode(NULL),
+    mLastAddedNode(NULL),
+    mReplaceParentNode(false),
+    mUseElements(pUseElements)
+{
+}
+
+bool
+XMLOStream::put(Storeable* pObject) {
+  if (mWriter == NULL)
+    return OStream::put(pObject);
+  int depth = mWriter->getDepth();
+  bool ret;
+  try {
+    ret = OStream::put(pObject);
+  } catch(...) {
+    //close elements of failed object, so next object is not written inside them,
+    //members written before error stay in file
+    try {
+      while(mWriter->getDepth() > depth)
+        mWriter->endElement();
+    } catch(...) {};
+    throw;
+  };
+  //element of object is open until its collections are written
+  while(mWriter->getDepth() > depth)
+    mWriter->endElement();
+  return ret;
+};
+
 void 
 XMLOStream::close() {
   //no implementation needed, document is managed by XMLArchive
@@ -36,6 +333,7 @@ XMLOStream::close() {
 void 
 XMLOStream::destroy() {
   mDocument = NULL;
+  mWriter = NULL;
   mParentNode = mLastAddedNode = NULL;
 };
 
@@ -101,9 +399,8 @@ XMLOStream::createNode(const char* pName) {
 };
 
 void
-XMLOStream::updateNodeFromObject(xmlNodePtr pNode, const Storeable& pObject, mt_class* pTable) {
-  mt_member* member = pTable->firstField;
-  while(member->name != NULL) {
+XMLOStream::updateNodeFromObject(xmlNodePtr pNode, const Storeable& pObject, const mt_class* pTable) {
+  for(const mt_member* member = pTable->first; member != pTable->last; member++) {
     void* member_ptr = (char*)&pObject + (int)(member->offset);
     StoreableFilterBase& filter = *(StoreableFilterBase*)member->func;
     filter.updateRef(member_ptr);
@@ -111,14 +408,11 @@ XMLOStream::updateNodeFromObject(xmlNodePtr pNode, const Storeable& pObject, mt_
       std::string strdata(filter.toString(getConversionSpecs()));
       updateNodeData(pNode,member->name,strdata.c_str());
     };
-    member = member->next;
-    if (member == NULL)
-      break;
   };
 };
 
 void
-XMLOStream::updateNodeFromVars(xmlNodePtr pNode, mt_class* pTable) {
+XMLOStream::updateNodeFromVars(xmlNodePtr pNode, const mt_class* pTable) {
   for (VarMap::const_iterator it = mBindings.begin(); it != mBindings.end(); it++) {
     if (!strcmp(it->mTable,pTable->name)) {
       dba::StoreableFilterBase& filter = *(it->mFilter);
@@ -132,7 +426,12 @@ XMLOStream::updateNodeFromVars(xmlNodePtr pNode, mt_class* pTable) {
 
 void
 XMLOStream::updateNodeData(xmlNodePtr pNode, const char* pName, const char* pContent) {
-  if (mUseElements) {
+  if (mWriter != NULL) {
+    if (mUseElements)
+      mWriter->writeElement(pName,pContent);
+    else
+      mWriter->writeAttribute(pName,pContent);
+  } else if (mUseElements) {
     xmlNodePtr node(createNode(pName));
     xmlChar* encoded_data = xmlEncodeEntitiesReentrant(NULL,(xmlChar*)pContent);
     xmlNodeSetContent(node,encoded_data);
@@ -146,15 +445,24 @@ XMLOStream::updateNodeData(xmlNodePtr pNode, const char* pName, const char* pCon
 
 bool 
 XMLOStream::store(Storeable* pObject) {
-  if (mDocument == NULL)
+  if (mDocument == NULL && mWriter == NULL)
     throw APIException("XMLOStream destroyed, cannot store");
 
   createTree(Stream::getTable(*pObject));
-  if (mMemberList->mFirst->name == NULL)
+  if (mMemberList->empty())
     return false;
 
-  mt_class* current = mMemberList->mFirst;
-  xmlNodePtr node = createNode(current->name);
+  if (mWriter != NULL) {
+    //element is closed in put() after collections are written
+    mWriter->startElement(mMemberList->begin()->name);
+    for(const mt_class* current = mMemberList->begin(); current != mMemberList->end(); current++) {
+      updateNodeFromObject(NULL,*pObject,current);
+      updateNodeFromVars(NULL,current);
+    };
+    return true;
+  };
+
+  xmlNodePtr node = createNode(mMemberList->begin()->name);
   if (!mReplaceParentNode) {
     debug("Adding child node '%s' to '%s'", getRootTableName(*pObject), (const char*)mParentNode->name);
     //store table is readed from last element to first
@@ -174,12 +482,9 @@ XMLOStream::store(Storeable* pObject) {
   };
   //FIXME add configuration for storing id?
   //xmlNewProp(node,(xmlChar*)"id",(xmlChar*)(toStr(id).c_str()));
-  while(current->name != NULL) {
+  for(const mt_class* current = mMemberList->begin(); current != mMemberList->end(); current++) {
     updateNodeFromObject(node,*pObject,current);
     updateNodeFromVars(node,current);
-    current = current->next;
-    if (current == NULL)
-      break;
   };
   return true;
 };
@@ -187,6 +492,8 @@ XMLOStream::store(Storeable* pObject) {
 void 
 XMLOStream::initMemberChildrenStore(const Storeable& pObject, const ColMemberEntry& pMember) {
   //set new parent node for storing subobjects
+  if (mWriter != NULL)
+    return;
   if (mParentNode != NULL) {
     debug("going down to last added child '%s' of mParent '%s'", (const char*)mLastAddedNode->name, (const char*)mParentNode->name);
     mParentNode = mLastAddedNode;
@@ -201,6 +508,8 @@ XMLOStream::endMemberChildrenStore(const Storeable& pObject, const ColMemberEntr
   //parent node was set to point to valid parent object
   //in hierarchy. After storing all children we have to reset it back to
   //parent of pObject node
+  if (mWriter != NULL)
+    return;
   if (mParentNode != xmlDocGetRootElement(mDocument)) {
     debug("up from mParent '%s'", (const char*)mParentNode->name);
     mLastAddedNode = mParentNode;
@@ -239,7 +548,10 @@ XMLOStream::putMemberChildren(Storeable* pObject, ColMemberEntry& pMember, Colle
     //do not create fkey node if list is empty
     if (iterator->hasNext()) {
       if (pMember.getFKeyName() != NULL) {
-        mParentNode = xmlAddChild(mParentNode, createNode(pMember.getFKeyName()));
+        if (mWriter != NULL)
+          mWriter->startElement(pMember.getFKeyName());
+        else
+          mParentNode = xmlAddChild(mParentNode, createNode(pMember.getFKeyName()));
       };
       while(iterator->hasNext()) {
         Storeable& toStore = (Storeable&)(iterator->get());
@@ -250,7 +562,10 @@ XMLOStream::putMemberChildren(Storeable* pObject, ColMemberEntry& pMember, Colle
         iterator->moveForward();
       };
       if (pMember.getFKeyName() != NULL) {
-        mParentNode = mParentNode->parent;
+        if (mWriter != NULL)
+          mWriter->endElement();
+        else
+          mParentNode = mParentNode->parent;
       };
     };
 /*    if (mParentNode != xmlDocGetRootElement(mDocument)) {
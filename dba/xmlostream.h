@@ -12,18 +12,128 @@
 #ifndef DBAXMLOSTREAM_H
 #define DBAXMLOSTREAM_H
 
+#include <stdio.h>
+#include <list>
+#include <string>
+#include <vector>
 #include "dba/ostream.h"
+#include "dba/shared_ptr.h"
 #include "dba/xmlerrorhandler.h"
 #include <libxml/tree.h>
+#include <libxml/xmlwriter.h>
 
 namespace dba {
 
+/**
+  Writes xml file using libxml2 xmlTextWriter. Elements are written to
+  file as soon as they are created, output is collected in large memory
+  buffer and written to file in blocks, so memory usage does not depend
+  on number of objects written.
+*/
+class dbaDLLEXPORT XMLStreamWriter : public XMLErrorHandler {
+  public:
+    /**
+      Create new file or truncate existing one
+      @param pFilename name of file
+      @param pEncoding encoding of document or NULL for utf-8
+      @param pBufferSize size of output buffer
+      @throw XMLException if file cannot be created
+    */
+    XMLStreamWriter(const char* pFilename, const char* pEncoding = NULL, size_t pBufferSize = 1024 * 1024);
+    /**
+      Write document to already open file descriptor. Descriptor is
+      duplicated, caller still has to close it.
+      @param pFd file descriptor
+      @param pEncoding encoding of document or NULL for utf-8
+      @param pBufferSize size of output buffer
+      @throw XMLException if descriptor cannot be used
+    */
+    XMLStreamWriter(int pFd, const char* pEncoding = NULL, size_t pBufferSize = 1024 * 1024);
+    /**
+      Set name of root element that contains all objects. If not set then
+      first written element is root of document and only one object can be written.
+    */
+    void setRootElement(const char* pName);
+    /**
+      Declare namespace on root element.
+      @throw APIException if root element was already written
+    */
+    void addNamespace(const char* pName, const char* pPrefix);
+    /**
+      Start new element. Element name can contain namespace prefix
+      @throw APIException if prefix was not added with addNamespace() or if
+      root element is not set and first element was already closed
+    */
+    void startElement(const char* pName);
+    /**
+      Write attribute of current element
+    */
+    void writeAttribute(const char* pName, const char* pContent);
+    /**
+      Write element with text content
+    */
+    void writeElement(const char* pName, const char* pContent);
+    /**
+      End current element
+    */
+    void endElement();
+    /**
+      @return number of open elements, root element is not counted
+    */
+    int getDepth() const { return mDepth; }
+    /**
+      End all open elements, write buffered data and close file.
+      @throw XMLException if write failed
+    */
+    void close();
+    /**
+      Destructor. Closes file, errors are ignored
+    */
+    ~XMLStreamWriter();
+  private:
+    XMLStreamWriter(const XMLStreamWriter&);
+    XMLStreamWriter& operator=(const XMLStreamWriter&);
+    void init(FILE* pFile, const char* pEncoding, size_t pBufferSize);
+    void startRoot();
+    void writeNamespaces();
+    void release();
+    void checkNamespace(const char* pName);
+    void checkError(int pRet, const ErrorContext& pContext);
+    xmlTextWriterPtr getWriter();
+
+    FILE* mFile;
+    std::vector<char> mBuffer;
+    xmlTextWriterPtr mWriter;
+    std::string mRootName;
+    //prefix and name of namespaces
+    std::list<std::pair<std::string, std::string> > mNamespaces;
+    bool mRootWritten;
+    int mDepth;
+};
+
 /**
 Object output stream for XMLArchive
 */
 class dbaDLLEXPORT XMLOStream  : public OStream, public XMLErrorHandler, public ConvSpecContainer {
   public:
     XMLOStream(xmlDocPtr pDocument, xmlNodePtr pNode, bool pReplaceParentNode, const ConvSpec& pSpecs, bool pUseElements);
+    /**
+      Create stream that writes objects directly to file. Objects and
+      their collections are written in order they are put into stream.
+      @param pWriter writer of xml file
+      @param pSpecs conversion specification
+      @param pUseElements if true then members are stored as subelements instead of attributes
+    */
+    XMLOStream(const shared_ptr<XMLStreamWriter>& pWriter, const ConvSpec& pSpecs, bool pUseElements);
+    /**
+      Write object. When stream writes to file and conversion of member fails, then
+      element of object is closed and exception is rethrown. Members that were converted
+      before failed one are already in file, so element of failed object stays partially
+      written.
+      @param pObject object to write
+      @return true if object was written
+    */
+    virtual bool put(Storeable* pObject);
     virtual void close();
     virtual void destroy();
     virtual void begin() { throw APIException("begin() not supported for XML format"); }
@@ -43,13 +153,15 @@ class dbaDLLEXPORT XMLOStream  : public OStream, public XMLErrorHandler, public
     virtual void endMemberChildrenStore(const Storeable& pObject, const ColMemberEntry& pMember);
   private:
     xmlDocPtr mDocument;
+    //NULL if objects are added to document
+    shared_ptr<XMLStreamWriter> mWriter;
     xmlNodePtr mParentNode;
     xmlNodePtr mLastAddedNode;
     bool mReplaceParentNode;
     bool mUseElements;
     
-    void updateNodeFromVars(xmlNodePtr pNode, mt_class* pTable);
-    void updateNodeFromObject(xmlNodePtr pNode, const Storeable& pObject, mt_class* pTable);
+    void updateNodeFromVars(xmlNodePtr pNode, const mt_class* pTable);
+    void updateNodeFromObject(xmlNodePtr pNode, const Storeable& pObject, const mt_class* pTable);
     void setAttribute(xmlNodePtr pNode, const char* pName, const xmlChar* pData);
     xmlNodePtr createNode(const char* pName);
     void updateNodeData(xmlNodePtr pNode, const char* pName, const char* pContent);
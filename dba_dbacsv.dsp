@@ -142,6 +142,14 @@ LIB32=link.exe -lib
 
 SOURCE=.\dba\csv.cpp
 # End Source File
+# Begin Source File
+
+SOURCE=.\dba\csvimport.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\dba\csvwriter.cpp
+# End Source File
 # End Group
 # Begin Group "Header Files"
 
@@ -150,6 +158,14 @@ SOURCE=.\dba\csv.cpp
 
 SOURCE=.\dba\csv.h
 # End Source File
+# Begin Source File
+
+SOURCE=.\dba\csvimport.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\dba\csvwriter.h
+# End Source File
 # End Group
 # End Target
 # End Project
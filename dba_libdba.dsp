@@ -144,10 +144,18 @@ SOURCE=.\dba\archive.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\atomiccounter.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\bindedvar.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\civiltime.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\bool_filter.cpp
 # End Source File
 # Begin Source File
@@ -212,6 +220,10 @@ SOURCE=.\dba\genericfetcher.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\identitymap.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\idlocker.cpp
 # End Source File
 # Begin Source File
@@ -236,10 +248,22 @@ SOURCE=.\dba\membertree.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\objectcache.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\ostream.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\querycache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\dba\schema.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\sharedsqlarchive.cpp
 # End Source File
 # Begin Source File
@@ -276,6 +300,18 @@ SOURCE=.\dba\stream.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\thread.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\dba\watchdog.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\dba\writebehindostream.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\string_filter.cpp
 # End Source File
 # End Group
@@ -292,6 +328,10 @@ SOURCE=.\dba\archiveexception.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\atomiccounter.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\bindedvar.h
 # End Source File
 # Begin Source File
@@ -300,6 +340,10 @@ SOURCE=.\dba\bool_filter.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\civiltime.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\collectionfilter.h
 # End Source File
 # Begin Source File
@@ -324,6 +368,14 @@ SOURCE=.\dba\csv.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\csvimport.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\dba\csvwriter.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\database.h
 # End Source File
 # Begin Source File
@@ -372,6 +424,10 @@ SOURCE=.\dba\genericfetcher.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\identitymap.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\idlocker.h
 # End Source File
 # Begin Source File
@@ -396,6 +452,10 @@ SOURCE=.\dba\membertree.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\objectcache.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\ostream.h
 # End Source File
 # Begin Source File
@@ -404,6 +464,14 @@ SOURCE=.\dba\plugininfo.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\querycache.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\dba\schema.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\shared_ptr.h
 # End Source File
 # Begin Source File
@@ -480,14 +548,30 @@ SOURCE=.\dba\storeablelist.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\storemember.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\stream.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\thread.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\dba\watchdog.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\string_filter.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\dba\writebehindostream.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\dba\xmlarchive.h
 # End Source File
 # Begin Source File
@@ -0,0 +1,99 @@
+// File: csv_import.cpp
+// Purpose: Example of parallel import of csv file into SQL database
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+
+/**
+@file csv_import.cpp
+*/
+
+#include <sstream> //for ostringstream
+#include <iostream>
+#include <stdio.h> //for remove()
+#include "dba/dba.h"
+#include "dba/csv.h"
+#include "dba/csvimport.h"
+
+class Person : public dba::Storeable {
+    DECLARE_STORE_TABLE();
+  public:
+    std::string mName;
+    std::string mSurname;
+    int mAge;
+};
+
+//Store table for Person class
+BEGIN_STORE_TABLE(Person, dba::Storeable, "person_table")
+  BIND_STR(Person::mName,dba::String,"name")
+  BIND_STR(Person::mSurname,dba::String,"surname")
+  BIND_INT(Person::mAge,dba::Int,"age")
+END_STORE_TABLE()
+
+//begin of SQL schema
+dba::SQL counter_create(
+"CREATE TABLE debea_object_count ("
+"  id INT"
+")");
+
+dba::SQL person_create(
+"CREATE TABLE person_table ("
+"  id INT PRIMARY KEY,"
+"  name VARCHAR,"
+"  surname VARCHAR,"
+"  age INT"
+")");
+//end of SQL schema
+
+int
+main (int argc, char** argv) {
+  try {
+    //create csv file with column names in first row
+    remove("persons.csv");
+    dba::CSVArchive csv;
+    csv.hasColumnNames(true);
+    csv.open("persons.csv");
+    dba::CSVOStream ostream = csv.getOStream();
+    ostream.open();
+    for(int i = 0; i < 100000; i++) {
+      Person p;
+      std::ostringstream name;
+      name << "Name_" << i;
+      p.mName = name.str();
+      std::ostringstream surname;
+      surname << "Surname_" << i;
+      p.mSurname = surname.str();
+      p.mAge = i % 100;
+      ostream.put(&p);
+    };
+    ostream.destroy();
+
+    //SharedSQLArchive gives each writer thread its own connection
+    remove("persons.sqt3");
+    dba::SharedSQLArchive db;
+    db.setIdFetcher(new dba::GenericFetcher());
+    db.open("dbasqlite3-static", "dbname=persons.sqt3");
+    db.getOStream().sendUpdate(counter_create);
+    db.getOStream().sendUpdate(person_create);
+    db.getOStream().sendUpdate(dba::SQL("INSERT INTO debea_object_count VALUES (:d)") << 1);
+
+    //file is read by this thread and split into chunks of complete
+    //lines, chunks are parsed by workers and stored by writers
+    dba::CSVImport import(csv,db);
+    import.setWorkers(4);
+    //SQLite allows only one writer at once, use more writers
+    //for server databases
+    import.setWriters(1);
+    import.setChunkSize(256 * 1024);
+    import.setBatchSize(5000);
+    //store persons in the same order as they are in file
+    import.preserveOrder();
+    unsigned long count = import.run<Person>();
+    std::cout << count << " persons imported" << std::endl;
+    return 0;
+  } catch (const dba::Exception& pEx) {
+    std::cout << "Error: " << pEx.what() << std::endl;
+    return -1;
+  };
+};
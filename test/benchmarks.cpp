@@ -0,0 +1,319 @@
+// File: benchmarks.cpp
+// Purpose: Performance tests for hot paths of library
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+//
+//
+#include <iostream>
+#include "benchmarks.h"
+#include "dba/memarchive.h"
+#include "dba/stdfilters.h"
+#include "dba/filtermapper.h"
+#include "dba/sql.h"
+#include "dba/sqlutils.h"
+#include "dba/conversion.h"
+#include "dba/civiltime.h"
+#include "dba/watchdog.h"
+#if defined(TEST_SQLITE3) || defined(TEST_CSV)
+#include "utils.h"
+#include "testobject.h"
+#endif
+#ifdef TEST_SQLITE3
+#include <string.h>
+#include <memory>
+#endif
+#ifdef TEST_CSV
+#include <stdio.h>
+#include <fstream>
+#include "dba/csv.h"
+#endif
+
+namespace dba_tests {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Benchmarks);
+
+Benchmarks::Timer::Timer(const char* pName, long pIterations)
+  : mName(pName),
+    mIterations(pIterations),
+    mStart(dba::Watchdog::now())
+{
+};
+
+Benchmarks::Timer::~Timer() {
+  double secs = (double)(dba::Watchdog::now() - mStart) / 1000;
+  std::cerr << std::endl << mName << ": " << mIterations << " iterations in " << secs << "s";
+  if (secs > 0)
+    std::cerr << " (" << (long)(mIterations / secs) << "/s)";
+  std::cerr << std::endl;
+};
+
+void
+Benchmarks::bindUnbind() {
+  const long iterations = 200000;
+  dba::MemOStream stream;
+  int a = 0;
+  std::string s;
+  double d = 0;
+  {
+    Timer t("bind/unbind", iterations);
+    for(long i = 0; i < iterations; i++) {
+      stream.bind("test","a",new dba::Int(a),dba::Database::INTEGER);
+      stream.bind("test","s",new dba::String(s),dba::Database::STRING);
+      stream.bind("test","d",new dba::Double(d),dba::Database::FLOAT);
+      //copy of stream shares filters with original
+      dba::MemOStream copy(stream);
+      copy.unbind("test","s");
+      stream.unbindAll();
+    };
+  };
+};
+
+void
+Benchmarks::sqlParams() {
+  const long iterations = 100000;
+  dba::FilterMapper mapper;
+  dba::ConvSpec specs;
+  std::string s("abc");
+  std::string query;
+  {
+    Timer t("SQL with 3 params", iterations);
+    for(long i = 0; i < iterations; i++) {
+      dba::SQL sql("SELECT * FROM test WHERE a = :d AND b = ':s' AND c = :d");
+      sql << (int)i << s << 1;
+      query = sql.cstring(mapper,specs);
+    };
+  };
+  CPPUNIT_ASSERT(query == "SELECT * FROM test WHERE a = " + dba::toStr(iterations - 1) + " AND b = 'abc' AND c = 1");
+};
+
+void
+Benchmarks::sqlTemplates() {
+  const long iterations = 100000;
+  dba::FilterMapper mapper;
+  dba::ConvSpec specs;
+  std::string s("a'b");
+  std::string query;
+  dba::SQL::clearTemplateCache();
+  {
+    Timer t("SQL construct and render from cached template", iterations);
+    for(long i = 0; i < iterations; i++) {
+      dba::SQL sql("UPDATE test SET a = :d, b = :s, c = :f WHERE t = '::' AND id = :d AND s LIKE ':s%'");
+      sql << (int)i << s << 1.5 << 2 << s;
+      query = sql.cstring(mapper,specs);
+    };
+  };
+  //all SQL objects used one parsed template
+  CPPUNIT_ASSERT_EQUAL((size_t)1,dba::SQL::getTemplateCacheSize());
+  CPPUNIT_ASSERT(query == "UPDATE test SET a = " + dba::toStr(iterations - 1) 
+    + ", b = 'a''b', c = 1.5 WHERE t = ':' AND id = 2 AND s LIKE 'a''b%' ESCAPE '!'");
+};
+
+void
+Benchmarks::sqlManyParams() {
+  const long iterations = 50000;
+  dba::FilterMapper mapper;
+  dba::ConvSpec specs;
+  std::string s("abc");
+  std::string text("INSERT INTO test VALUES (");
+  std::string expected(text);
+  for(int p = 0; p < 20; p++) {
+    if (p != 0) {
+      text += ",";
+      expected += ",";
+    };
+    switch(p % 4) {
+      case 0: text += ":d"; expected += dba::toStr(p); break;
+      case 1: text += ":s"; expected += "'abc'"; break;
+      case 2: text += ":f"; expected += "0.5"; break;
+      case 3: text += ":d"; expected += "1"; break;
+    };
+  };
+  text += ")";
+  expected += ")";
+  std::string query;
+  {
+    //filter for every param is found by type key resolved in operator<<
+    Timer t("SQL with 20 params", iterations);
+    for(long i = 0; i < iterations; i++) {
+      dba::SQL sql(text);
+      for(int p = 0; p < 20; p += 4)
+        sql << p << s << 0.5 << true;
+      query = sql.cstring(mapper,specs);
+    };
+  };
+  CPPUNIT_ASSERT(query == expected);
+};
+
+void
+Benchmarks::numberConversion() {
+  const long iterations = 1000000;
+  char buf[dba::NUMBER_BUFFER_SIZE];
+  {
+    Timer t("double format/parse", iterations);
+    for(long i = 0; i < iterations; i++) {
+      double d = i * 1.37;
+      int len = dba::formatDouble(d,buf);
+      double parsed;
+      CPPUNIT_ASSERT(dba::parseDouble(buf,buf + len,parsed));
+      CPPUNIT_ASSERT(parsed == d);
+    };
+  };
+  {
+    Timer t("int format/parse", iterations);
+    for(long i = 0; i < iterations; i++) {
+      long l = (i - iterations / 2) * 7919;
+      int len = dba::formatInt(l,buf);
+      long parsed;
+      CPPUNIT_ASSERT(dba::parseInt(buf,buf + len,parsed));
+      CPPUNIT_ASSERT(parsed == l);
+    };
+  };
+};
+
+void
+Benchmarks::dateConversion() {
+  const long iterations = 10000000;
+  dba::ConvSpec specs;
+  specs.mGMTOffset = 2*60*60;
+  tm date;
+  tm parsed;
+  dba::DateTime filter(date);
+  dba::DateTime parser(parsed);
+  {
+    //every iteration moves date by about 11 hours, so all days of year
+    //and daylight saving time changes are covered
+    Timer t("DateTime toString/fromString with GMT offset", iterations);
+    for(long i = 0; i < iterations; i++) {
+      dba::timeToCivil(i * 40009L,date);
+      parser.fromString(specs,filter.toString(specs));
+      CPPUNIT_ASSERT(dba::civilToTime(parsed) == i * 40009L);
+    };
+  };
+};
+
+void
+Benchmarks::escaping() {
+  const long iterations = 1000000;
+  //special chars at different positions of 16 char blocks
+  std::string plain("The quick brown fox jumps over the lazy dog near river bank");
+  std::string quoted("It's a \\path\\ with 100% of O'Reilly_books and more text after it");
+  std::string escaped;
+  {
+    Timer t("setSQLVal without special chars", iterations);
+    for(long i = 0; i < iterations; i++)
+      escaped = dba::SQLUtils::setSQLVal(plain);
+  };
+  CPPUNIT_ASSERT(escaped == "'" + plain + "'");
+  {
+    Timer t("setSQLVal with special chars", iterations);
+    for(long i = 0; i < iterations; i++)
+      escaped = dba::SQLUtils::setSQLVal(quoted);
+  };
+  CPPUNIT_ASSERT(escaped == "'It''s a \\\\path\\\\ with 100% of O''Reilly_books and more text after it'");
+  {
+    Timer t("escapeSQLLike with special chars", iterations);
+    for(long i = 0; i < iterations; i++)
+      escaped = dba::SQLUtils::escapeSQLLike(quoted);
+  };
+  CPPUNIT_ASSERT(escaped == "It''s a \\\\path\\\\ with 100!% of O''Reilly!_books and more text after it");
+};
+
+#ifdef TEST_SQLITE3
+
+#if !defined(DEBEA_USINGDLL)
+  #define TEST_PL_SUFFIX "-static"
+#else
+  #define TEST_PL_SUFFIX 
+#endif
+
+static void
+setDateStorage(dba::SharedSQLArchive& pArchive, dba::ConvSpec::date_storage pStorage) {
+  dba::ConvSpec specs(pArchive.getConversionSpecs());
+  specs.mDateStorage = pStorage;
+  pArchive.setConversionSpecs(specs);
+};
+
+void
+Benchmarks::mixedTypesRead() {
+  const char* params = "dbname=libdbabenchmarks.sqt3";
+  const long rows = 2000;
+  const long passes = 50;
+  std::auto_ptr<dba::SharedSQLArchive> ar(Utils::initSharedSQLArchive("dbasqlite3"TEST_PL_SUFFIX,params));
+  {
+    dba::SQLOStream ostream = ar->getOStream();
+    Utils::prepareSharedSQLArchiveSchema(ostream,params);
+  };
+  //SQLite can store dates as text or as numbers
+  for(int numeric = 0; numeric < 2; numeric++) {
+    setDateStorage(*ar,numeric ? dba::ConvSpec::DATE_UNIXTIME : dba::ConvSpec::DATE_TEXT);
+    {
+      dba::Transaction t(ar->createTransaction());
+      dba::SQLOStream ostream = t.getOStream();
+      ostream.sendUpdate("DELETE FROM test_objects");
+      ostream.open();
+      for(int i = 0; i < rows; i++) {
+        TestObject obj(i,i * 0.5,"row " + dba::toStr(i),Utils::getDate(2010,1 + i % 12,1 + i % 28,i % 24,i % 60,i % 60));
+        ostream.put(&obj);
+      };
+      ostream.destroy();
+      t.commit();
+    };
+    dba::SQLIStream istream = ar->getIStream();
+    long sum = 0;
+    {
+      Timer t(numeric ? "mixed type rows with numeric dates" : "mixed type rows with text dates", rows * passes);
+      for(int pass = 0; pass < passes; pass++) {
+        std::auto_ptr<dba::DbResult> res(istream.sendQuery(dba::SQL("SELECT i_value, f_value, s_value, d_value FROM test_objects WHERE i_value >= :d") << 0));
+        while(res->fetchRow()) {
+          tm date(res->getDate(3));
+          sum += res->getInt(0) + (long)res->getDouble(1) + strlen(res->getString(2)) + date.tm_mday;
+        };
+      };
+    };
+    CPPUNIT_ASSERT(sum > 0);
+    istream.destroy();
+  };
+};
+
+#endif
+
+#ifdef TEST_CSV
+void
+Benchmarks::csvWrite() {
+  const long rows = 10000000;
+  dba::CSVWriter::compression methods[] = { dba::CSVWriter::NO_COMPRESSION, dba::CSVWriter::GZIP };
+  const char* names[] = { "csv write plain", "csv write gzip" };
+  for(int m = 0; m < 2; m++) {
+    if (!dba::CSVWriter::isSupported(methods[m]))
+      continue;
+    remove("csv-benchmark.csv");
+    dba::CSVArchive ar;
+    ar.hasColumnNames(true);
+    ar.setWriteBufferSize(4 * 1024 * 1024);
+    ar.setCompression(methods[m],1);
+    ar.dropWrittenData(true);
+    ar.open("csv-benchmark.csv");
+    {
+      Timer t(names[m], rows);
+      dba::CSVOStream ostream = ar.getOStream();
+      ostream.open();
+      TestObject obj(0,0.5,"benchmark row",Utils::getDate(2010,1,1,12,0,0));
+      for(long i = 0; i < rows; i++) {
+        obj.i = i;
+        obj.setNew();
+        ostream.put(&obj);
+      };
+      ostream.close();
+    };
+    std::ifstream s("csv-benchmark.csv", std::ios::in | std::ios::binary);
+    s.seekg(0,std::ios::end);
+    std::cerr << names[m] << ": " << (long)s.tellg() / (1024 * 1024) << "MB written" << std::endl;
+    s.close();
+    remove("csv-benchmark.csv");
+  };
+};
+#endif
+
+} //namespace
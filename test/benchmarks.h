@@ -0,0 +1,66 @@
+// File: benchmarks.h
+// Purpose: Performance tests for hot paths of library
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+//
+//
+#ifndef DBA_TESTSBENCHMARKS_H
+#define DBA_TESTSBENCHMARKS_H
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace dba_tests {
+
+/**
+  Measures wall time of operations that are repeated for every row or every query.
+  Results are written to stderr, tests fail only if operation results are wrong.
+*/
+class Benchmarks : public CppUnit::TestCase {
+    CPPUNIT_TEST_SUITE(Benchmarks);
+      CPPUNIT_TEST(bindUnbind);
+      CPPUNIT_TEST(sqlParams);
+      CPPUNIT_TEST(sqlTemplates);
+      CPPUNIT_TEST(sqlManyParams);
+      CPPUNIT_TEST(numberConversion);
+      CPPUNIT_TEST(dateConversion);
+      CPPUNIT_TEST(escaping);
+#ifdef TEST_SQLITE3
+      CPPUNIT_TEST(mixedTypesRead);
+#endif
+#ifdef TEST_CSV
+      CPPUNIT_TEST(csvWrite);
+#endif
+    CPPUNIT_TEST_SUITE_END();
+  public:
+    void bindUnbind();
+    void sqlParams();
+    void sqlTemplates();
+    void sqlManyParams();
+    void numberConversion();
+    void dateConversion();
+    void escaping();
+#ifdef TEST_SQLITE3
+    void mixedTypesRead();
+#endif
+#ifdef TEST_CSV
+    void csvWrite();
+#endif
+  private:
+    class Timer {
+      public:
+        Timer(const char* pName, long pIterations);
+        ~Timer();
+      private:
+        const char* mName;
+        long mIterations;
+        //!start time in miliseconds
+        unsigned long mStart;
+    };
+};
+
+} //namespace
+
+#endif
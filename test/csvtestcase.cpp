@@ -9,9 +9,13 @@
 
 #include <fstream>
 #include <iostream>
+#ifdef DBA_ZLIB
+#include <zlib.h>
+#endif
 #include "csvtestcase.h"
 #include "dba/storeable.h"
 #include "dba/stdfilters.h"
+#include "dba/conversion.h"
 
 namespace dba_tests {
 
@@ -515,6 +519,177 @@ CSVTestCase::invalidPos() {
   };
 };
 
+void
+CSVTestCase::parserBlocks() {
+  //lines and fields cross boundaries of blocks read by parser
+  const int lines = 50000;
+  const std::string longField(3 * 1024 * 1024,'x');
+  {
+    unlink("csv-blocks.csv");
+    std::ofstream file("csv-blocks.csv");
+    for(int i = 0; i < lines; i++) {
+      file << i << ",\"quoted \"\"" << i << "\"\"\nnext line\",plain " << i << "\r\n";
+      if (i == lines / 2)
+        file << "\"" << longField << "\"\n";
+    };
+  };
+  std::ifstream stream("csv-blocks.csv");
+  dba::CSVParser parser(stream);
+  for(int i = 0; i < lines; i++) {
+    CPPUNIT_ASSERT(parser.parseLine());
+    CPPUNIT_ASSERT_EQUAL((size_t)3,parser.getFieldCount());
+    const dba::CSVField& quoted(parser.getField(1));
+    const dba::CSVField& plain(parser.getField(2));
+    CPPUNIT_ASSERT_EQUAL(dba::toStr(i),std::string(parser.getField(0).data,parser.getField(0).size));
+    CPPUNIT_ASSERT_EQUAL("quoted \"" + dba::toStr(i) + "\"\nnext line",std::string(quoted.data,quoted.size));
+    CPPUNIT_ASSERT_EQUAL("plain " + dba::toStr(i),std::string(plain.data,plain.size));
+    if (i == lines / 2) {
+      CPPUNIT_ASSERT(parser.parseLine());
+      CPPUNIT_ASSERT_EQUAL((size_t)1,parser.getFieldCount());
+      CPPUNIT_ASSERT(longField == std::string(parser.getField(0).data,parser.getField(0).size));
+    };
+  };
+  CPPUNIT_ASSERT(!parser.parseLine());
+  CPPUNIT_ASSERT(parser.eof());
+  stream.close();
+  unlink("csv-blocks.csv");
+};
+
+void
+CSVTestCase::mappingHoles() {
+  unlink("csv-holes.csv");
+  dba::CSVArchive ar;
+  ar.hasColumnNames(false);
+  //column 1 is not mapped and should be written as empty field
+  ar.addMapping(0,"test","a");
+  ar.addMapping(3,"test","b");
+  ar.addMapping(2,"test","str");
+  ar.open("csv-holes.csv");
+  {
+    dba::CSVOStream ostream = ar.getOStream();
+    ostream.open();
+    CSVTester t(1,2,"x");
+    ostream.put(&t);
+    for(std::list<CSVTester>::iterator it = mResults.begin(); it != mResults.end(); it++)
+      ostream.put(&(*it));
+    ostream.close();
+  };
+  std::string data(readFile("csv-holes.csv"));
+  CPPUNIT_ASSERT_EQUAL(std::string("1,,x,2\n"),data.substr(0,data.find('\n') + 1));
+
+  std::list<CSVTester> lst;
+  {
+    CSVTester t;
+    dba::CSVIStream istream = ar.getIStream();
+    istream.open(t);
+    CPPUNIT_ASSERT(istream.getNext(&t));
+    CPPUNIT_ASSERT(t == CSVTester(1,2,"x"));
+    while(istream.getNext(&t))
+      lst.push_back(t);
+    istream.close();
+  };
+  unlink("csv-holes.csv");
+  CPPUNIT_ASSERT(mResults == lst);
+};
+
+void
+CSVTestCase::bufferedWrite() {
+  unlink("csv-buffered.csv");
+  dba::CSVArchive ar;
+  ar.hasColumnNames(true);
+  //lines are longer than buffer
+  ar.setWriteBufferSize(7);
+  ar.open("csv-buffered.csv");
+  {
+    dba::CSVOStream ostream = ar.getOStream();
+    ostream.open();
+    CSVTester t(1,2,"x");
+    ostream.put(&t);
+    ostream.flush();
+    //flushed data can be read before stream is closed
+    std::string data(readFile("csv-buffered.csv"));
+    CPPUNIT_ASSERT_EQUAL(std::string("a,b,str\n1,2,x\n"),data.substr(0,data.size() - 1));
+    for(std::list<CSVTester>::iterator it = mResults.begin(); it != mResults.end(); it++)
+      ostream.put(&(*it));
+    ostream.close();
+  };
+
+  std::list<CSVTester> lst;
+  {
+    CSVTester t;
+    dba::CSVIStream istream = ar.getIStream();
+    istream.open(t);
+    CPPUNIT_ASSERT(istream.getNext(&t));
+    CPPUNIT_ASSERT(t == CSVTester(1,2,"x"));
+    while(istream.getNext(&t))
+      lst.push_back(t);
+    istream.close();
+  };
+  unlink("csv-buffered.csv");
+  CPPUNIT_ASSERT(mResults == lst);
+};
+
+static std::string
+readBinaryFile(const char* pName) {
+  std::ifstream s(pName, std::ios::in | std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(s)),std::istreambuf_iterator<char>());
+};
+
+void
+CSVTestCase::compressedWrite() {
+  dba::CSVArchive ar;
+  if (!dba::CSVWriter::isSupported(dba::CSVWriter::GZIP)) {
+    try {
+      ar.setCompression(dba::CSVWriter::GZIP);
+      CPPUNIT_FAIL("setCompression() should throw");
+    } catch (const dba::APIException&) {
+      //
+    };
+    return;
+  };
+  //the same rows are written with and without compression
+  dba::CSVArchive plain;
+  dba::CSVArchive* archives[] = { &ar, &plain };
+  dba::CSVWriter::compression methods[] = { dba::CSVWriter::GZIP, dba::CSVWriter::NO_COMPRESSION };
+  const char* files[] = { "csv-compressed.csv.gz", "csv-compressed.csv" };
+  for(int m = 0; m < 2; m++) {
+    unlink(files[m]);
+    archives[m]->hasColumnNames(true);
+    archives[m]->setCompression(methods[m],1);
+    archives[m]->open(files[m]);
+    dba::CSVOStream ostream = archives[m]->getOStream();
+    ostream.open();
+    for(int i = 0; i < 10000; i++) {
+      CSVTester t(i,i,"compressed");
+      ostream.put(&t);
+    };
+    ostream.close();
+  };
+  std::string data(readBinaryFile("csv-compressed.csv.gz"));
+  std::string expected(readBinaryFile("csv-compressed.csv"));
+  unlink("csv-compressed.csv");
+  //gzip magic and deflate method
+  CPPUNIT_ASSERT(data.size() > 10);
+  CPPUNIT_ASSERT_EQUAL('\x1f',data[0]);
+  CPPUNIT_ASSERT_EQUAL('\x8b',data[1]);
+  CPPUNIT_ASSERT_EQUAL('\x08',data[2]);
+  //10000 similar lines are compressed at least twice
+  CPPUNIT_ASSERT(data.size() < 10000 * 8);
+#ifdef DBA_ZLIB
+  gzFile file = gzopen("csv-compressed.csv.gz","rb");
+  CPPUNIT_ASSERT(file != NULL);
+  std::string unpacked;
+  char buf[4096];
+  int size;
+  while((size = gzread(file,buf,sizeof(buf))) > 0)
+    unpacked.append(buf,size);
+  gzclose(file);
+  CPPUNIT_ASSERT(size == 0);
+  CPPUNIT_ASSERT(unpacked == expected);
+#endif
+  unlink("csv-compressed.csv.gz");
+};
+
 };//namespace
 
 #endif //TEST_CSV
@@ -51,6 +51,10 @@ class CSVTestCase : public CppUnit::TestCase {
       CPPUNIT_TEST(sepTest);
       CPPUNIT_TEST(autoBindedVars);
       CPPUNIT_TEST(invalidPos);
+      CPPUNIT_TEST(parserBlocks);
+      CPPUNIT_TEST(mappingHoles);
+      CPPUNIT_TEST(bufferedWrite);
+      CPPUNIT_TEST(compressedWrite);
   CPPUNIT_TEST_SUITE_END();
 
   public:
@@ -68,6 +72,10 @@ class CSVTestCase : public CppUnit::TestCase {
     void openNonCSVFileForWriteTest2();
     void spaceSeparator();
     void invalidPos();
+    void parserBlocks();
+    void mappingHoles();
+    void bufferedWrite();
+    void compressedWrite();
   private:
     class CSVTester : public dba::Storeable {
         DECLARE_STORE_TABLE();
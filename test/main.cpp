@@ -30,6 +30,8 @@
 #include "csvtestcase.h"
 #include "stdfilters_test.h"
 #include "sqlparamparsertestcase.h"
+#include "sharedptrtestcase.h"
+#include "benchmarks.h"
 
 #if !defined(DEBEA_USINGDLL)
   #define TEST_PL_SUFFIX "-static"
@@ -0,0 +1,116 @@
+// File: sharedptrtestcase.cpp
+// Purpose: Regression tests for shared_ptr
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+//
+//
+#include "sharedptrtestcase.h"
+#include "dba/shared_ptr.h"
+
+namespace dba_tests {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SharedPtrTestCase);
+
+class Tracked {
+  public:
+    Tracked(int& pDestroyed) : mDestroyed(pDestroyed) {};
+    ~Tracked() { mDestroyed++; };
+  private:
+    int& mDestroyed;
+};
+
+class TrackedRef : public dba::RefCounted {
+  public:
+    TrackedRef(int& pDestroyed) : mDestroyed(pDestroyed) {};
+    ~TrackedRef() { mDestroyed++; };
+  private:
+    int& mDestroyed;
+};
+
+void
+SharedPtrTestCase::copy() {
+  int destroyed = 0;
+  {
+    dba::shared_ptr<Tracked> a(new Tracked(destroyed));
+    CPPUNIT_ASSERT(a.getCount() == 1);
+    {
+      dba::shared_ptr<Tracked> b(a);
+      CPPUNIT_ASSERT(a.getCount() == 2);
+      CPPUNIT_ASSERT(a == b);
+    };
+    CPPUNIT_ASSERT(a.getCount() == 1);
+    CPPUNIT_ASSERT(destroyed == 0);
+  };
+  CPPUNIT_ASSERT(destroyed == 1);
+};
+
+void
+SharedPtrTestCase::assign() {
+  int destroyed = 0;
+  dba::shared_ptr<Tracked> a(new Tracked(destroyed));
+  dba::shared_ptr<Tracked> b(new Tracked(destroyed));
+  b = a;
+  CPPUNIT_ASSERT(destroyed == 1);
+  CPPUNIT_ASSERT(a.getCount() == 2);
+  a = NULL;
+  CPPUNIT_ASSERT(a == NULL);
+  CPPUNIT_ASSERT(b.getCount() == 1);
+  b = NULL;
+  CPPUNIT_ASSERT(destroyed == 2);
+};
+
+void
+SharedPtrTestCase::selfAssign() {
+  int destroyed = 0;
+  dba::shared_ptr<Tracked> a(new Tracked(destroyed));
+  dba::shared_ptr<Tracked>& b(a);
+  a = b;
+  CPPUNIT_ASSERT(destroyed == 0);
+  CPPUNIT_ASSERT(a.getCount() == 1);
+};
+
+void
+SharedPtrTestCase::swap() {
+  int destroyed = 0;
+  Tracked* obj = new Tracked(destroyed);
+  dba::shared_ptr<Tracked> a(obj);
+  dba::shared_ptr<Tracked> b;
+  b.swap(a);
+  CPPUNIT_ASSERT(a == NULL);
+  CPPUNIT_ASSERT(b == obj);
+  CPPUNIT_ASSERT(b.getCount() == 1);
+  b = NULL;
+  CPPUNIT_ASSERT(destroyed == 1);
+};
+
+void
+SharedPtrTestCase::intrusive() {
+  int destroyed = 0;
+  {
+    dba::shared_ptr<TrackedRef> a(new TrackedRef(destroyed));
+    dba::shared_ptr<TrackedRef> b(a);
+    CPPUNIT_ASSERT(b.getCount() == 2);
+    TrackedRef copy(*a);
+    dba::shared_ptr<TrackedRef> c(new TrackedRef(copy));
+    CPPUNIT_ASSERT(c.getCount() == 1);
+  };
+  //two objects owned by pointers and one local copy
+  CPPUNIT_ASSERT(destroyed == 3);
+};
+
+void
+SharedPtrTestCase::intrusiveFromRaw() {
+  int destroyed = 0;
+  TrackedRef* obj = new TrackedRef(destroyed);
+  {
+    dba::shared_ptr<TrackedRef> a(obj);
+    //counter lives in object, so both pointers share it
+    dba::shared_ptr<TrackedRef> b(obj);
+    CPPUNIT_ASSERT(a.getCount() == 2);
+  };
+  CPPUNIT_ASSERT(destroyed == 1);
+};
+
+}
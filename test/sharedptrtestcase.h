@@ -0,0 +1,37 @@
+// File: sharedptrtestcase.h
+// Purpose: Regression tests for shared_ptr
+// Author: Lukasz Michalski <lm at zork.pl>, Copyright 2010
+// License: See COPYING file that comes with this distribution
+//
+// This file is a part of debea library (http://debea.net)
+//
+//
+#ifndef DBA_TESTSSHAREDPTRTESTCASE_H
+#define DBA_TESTSSHAREDPTRTESTCASE_H
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace dba_tests {
+
+class SharedPtrTestCase : public CppUnit::TestCase {
+    CPPUNIT_TEST_SUITE(SharedPtrTestCase);
+      CPPUNIT_TEST(copy);
+      CPPUNIT_TEST(assign);
+      CPPUNIT_TEST(selfAssign);
+      CPPUNIT_TEST(swap);
+      CPPUNIT_TEST(intrusive);
+      CPPUNIT_TEST(intrusiveFromRaw);
+    CPPUNIT_TEST_SUITE_END();
+  public:
+    void copy();
+    void assign();
+    void selfAssign();
+    void swap();
+    void intrusive();
+    void intrusiveFromRaw();
+};
+
+} //namespace
+
+#endif
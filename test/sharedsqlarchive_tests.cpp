@@ -7,6 +7,18 @@
 //
 //
 #include "sharedsqlarchive_tests.h"
+#include "dba/writebehindostream.h"
+#include "dba/watchdog.h"
+#include "dba/datetime_filter.h"
+#ifdef TEST_CSV
+#include "dba/csvimport.h"
+#include "dba/atomiccounter.h"
+#include "dba/sqlidfetcher.h"
+#include "dba/storemember.h"
+#endif
+#include <stdio.h>
+#include <map>
+#include <set>
 
 namespace dba_tests {
 
@@ -335,4 +347,941 @@ SharedSQLArchive_Tests::transactions_rollback() {
   };
 };
 
+void
+SharedSQLArchive_Tests::writeBehind_coalesce() {
+  tm date(Utils::getNow());
+  TestObject out(1,1.1,"str1",date);
+  {
+    dba::WriteBehindOStream ostream(*mSQLArchive,10,5);
+    //queue is written by flush()
+    ostream.setWriteDelay(60000);
+    ostream.open();
+    ostream.putAsync(out);
+    //id is assigned before object is written
+    CPPUNIT_ASSERT(out.getId() != dba::Storeable::InvalidId);
+    CPPUNIT_ASSERT(out.isOk());
+    for(int i = 2; i < 50; i++) {
+      out.i = i;
+      out.setChanged();
+      ostream.putAsync(out);
+    };
+    CPPUNIT_ASSERT(ostream.getWrittenCount() == 0);
+    ostream.flush();
+    CPPUNIT_ASSERT(ostream.getQueueSize() == 0);
+    //all updates were merged into one INSERT
+    CPPUNIT_ASSERT_EQUAL(48ul, ostream.getCoalescedCount());
+    CPPUNIT_ASSERT_EQUAL(1ul, ostream.getWrittenCount());
+
+    //updates of written object are merged into one UPDATE
+    for(int i = 50; i < 60; i++) {
+      out.i = i;
+      out.setChanged();
+      ostream.putAsync(out);
+    };
+    ostream.flush();
+    CPPUNIT_ASSERT_EQUAL(57ul, ostream.getCoalescedCount());
+    CPPUNIT_ASSERT_EQUAL(2ul, ostream.getWrittenCount());
+  };
+  TestObject in;
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  istream.open(in);
+  CPPUNIT_ASSERT(istream.getNext(&in));
+  CPPUNIT_ASSERT(in.getId() == out.getId());
+  CPPUNIT_ASSERT(out == in);
+  CPPUNIT_ASSERT(istream.getNext(&in) == false);
+};
+
+void
+SharedSQLArchive_Tests::writeBehind_deleteNew() {
+  tm date(Utils::getNow());
+  TestObject first(1,1.1,"str1",date);
+  TestObject second(2,2.2,"str2",date);
+  {
+    dba::WriteBehindOStream ostream(*mSQLArchive);
+    ostream.open();
+    ostream.putAsync(first);
+    ostream.putAsync(second);
+    first.setDeleted();
+    ostream.putAsync(first);
+  };
+  TestObject in;
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  istream.open(in);
+  CPPUNIT_ASSERT(istream.getNext(&in));
+  CPPUNIT_ASSERT(second == in);
+  CPPUNIT_ASSERT(istream.getNext(&in) == false);
+};
+
+void
+SharedSQLArchive_Tests::pipelined_put() {
+  tm date(Utils::getNow());
+  std::vector<TestObject> objects;
+  for(int i = 0; i < 20; i++)
+    objects.push_back(TestObject(i,1.1,"str",date));
+  {
+    dba::Transaction t(mSQLArchive->createTransaction());
+    dba::SQLOStream ostream = t.getOStream();
+    ostream.setPipelining();
+    for(std::vector<TestObject>::iterator it = objects.begin(); it != objects.end(); it++)
+      ostream.put(&(*it));
+    objects[5].i = 100;
+    objects[5].setChanged();
+    ostream.put(&objects[5]);
+    t.commit();
+  };
+  TestObject in;
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  istream.open(in);
+  int count = 0;
+  while(istream.getNext(&in)) {
+    if (in.getId() == objects[5].getId())
+      CPPUNIT_ASSERT(in.i == 100);
+    count++;
+  };
+  CPPUNIT_ASSERT(count == 20);
+};
+
+void
+SharedSQLArchive_Tests::pipelined_error() {
+  tm date(Utils::getNow());
+  TestObject stored(1,1.1,"str1",date);
+  TestObject missing(2,2.2,"str2",date);
+  missing.setId(12345);
+  dba::Transaction t(mSQLArchive->createTransaction());
+  dba::SQLOStream ostream = t.getOStream();
+  ostream.setPipelining();
+  bool thrown = false;
+  try {
+    ostream.put(&stored);
+    //update of object that is not in database fails in put()
+    //or in commit() if driver pipelines commands
+    ostream.put(&missing);
+    t.commit();
+  } catch (const dba::DataException& pEx) {
+    thrown = true;
+    CPPUNIT_ASSERT(std::string(pEx.what()).find("id=12345") != std::string::npos);
+  };
+  CPPUNIT_ASSERT(thrown);
+  t.rollback();
+};
+
+void
+SharedSQLArchive_Tests::pipelined_roundTrips() {
+  tm date(Utils::getNow());
+  std::vector<TestObject> objects;
+  for(int i = 0; i < 20; i++)
+    objects.push_back(TestObject(i,1.1,"str",date));
+  {
+    dba::Transaction t(mSQLArchive->createTransaction());
+    dba::DbConnection* conn = t.getConnection();
+    dba::SQLOStream ostream = t.getOStream();
+    ostream.setPipelining();
+    unsigned long trips = conn->getRoundTrips();
+    unsigned long pipelined = conn->getPipelinedCount();
+    for(std::vector<TestObject>::iterator it = objects.begin(); it != objects.end(); it++)
+      ostream.put(&(*it));
+    pipelined = conn->getPipelinedCount() - pipelined;
+    //ids are allocated by one query and one update of GenericFetcher,
+    //commands that driver does not pipeline are sent one by one
+    CPPUNIT_ASSERT_EQUAL(2 + 20 - pipelined, conn->getRoundTrips() - trips);
+    t.commit();
+  };
+  std::set<dba::id> ids;
+  TestObject in;
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  istream.open(in);
+  while(istream.getNext(&in))
+    ids.insert(in.getId());
+  CPPUNIT_ASSERT_EQUAL((size_t)20, ids.size());
+};
+
+void
+SharedSQLArchive_Tests::timeout_query() {
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  istream.setQueryTimeout(100);
+  unsigned long start = dba::Watchdog::now();
+  bool thrown = false;
+  try {
+    std::auto_ptr<dba::DbResult> res(istream.sendQuery(
+      "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x+1 FROM c WHERE x < 1000000000) SELECT count(*) FROM c"
+    ));
+    res->fetchRow();
+  } catch (const dba::TimeoutException&) {
+    thrown = true;
+  };
+  CPPUNIT_ASSERT(thrown);
+  CPPUNIT_ASSERT(dba::Watchdog::now() - start < 10000);
+  //connection is usable after cancel
+  std::auto_ptr<dba::DbResult> res(istream.sendQuery("SELECT 1"));
+  CPPUNIT_ASSERT(res->fetchRow());
+};
+
+void
+SharedSQLArchive_Tests::timeout_deadline() {
+  tm date(Utils::getNow());
+  TestObject obj(1,1.1,"str1",date);
+  dba::SQLOStream ostream = mSQLArchive->getOStream();
+  ostream.setDeadline(1);
+  dba::Thread::sleep(20);
+  bool thrown = false;
+  try {
+    ostream.open();
+    ostream.put(&obj);
+  } catch (const dba::TimeoutException&) {
+    thrown = true;
+  };
+  CPPUNIT_ASSERT(thrown);
+  CPPUNIT_ASSERT(obj.isNew());
+  ostream.setDeadline(0);
+  ostream.put(&obj);
+  CPPUNIT_ASSERT(obj.isOk());
+  ostream.destroy();
+};
+
+void
+SharedSQLArchive_Tests::timeout_perStatement() {
+  std::auto_ptr<dba::DbConnection> conn(mSQLArchive->getConnection());
+  {
+    dba::TimeoutScope scope(conn.get(), 0, dba::Watchdog::now() + 50);
+    std::auto_ptr<dba::DbResult> res(conn->sendQuery("SELECT 1"));
+    dba::Thread::sleep(100);
+    //deadline passed after scope was entered
+    bool thrown = false;
+    try {
+      std::auto_ptr<dba::DbResult> res2(conn->sendQuery("SELECT 1"));
+    } catch (const dba::TimeoutException&) {
+      thrown = true;
+    };
+    CPPUNIT_ASSERT(thrown);
+  };
+  CPPUNIT_ASSERT_EQUAL(0UL, conn->getDeadline());
+  std::auto_ptr<dba::DbResult> res(conn->sendQuery("SELECT 1"));
+  conn->disconnect();
+};
+
+void
+SharedSQLArchive_Tests::replica_routing() {
+  tm date(Utils::getNow());
+  TestObject obj(1,1.1,"str1",date);
+  {
+    dba::SQLOStream ostream = mSQLArchive->getOStream();
+    ostream.open();
+    ostream.put(&obj);
+    ostream.destroy();
+  };
+  //the same database is used as replica
+  mSQLArchive->addReplica(mDbParams);
+  mSQLArchive->addReplica(mDbParams);
+  mSQLArchive->setReplicaSelection(dba::SharedSQLArchive::REPLICA_LEAST_USED);
+  CPPUNIT_ASSERT(mSQLArchive->getReplicaCount() == 2);
+  {
+    dba::SQLIStream istream1 = mSQLArchive->getIStream();
+    dba::SQLIStream istream2 = mSQLArchive->getIStream();
+    CPPUNIT_ASSERT(mSQLArchive->getUsedConnections() == 0);
+    CPPUNIT_ASSERT(mSQLArchive->getUsedReplicaConnections() == 2);
+    TestObject loaded;
+    istream1.setWhereId(obj.getId());
+    istream1.open(loaded);
+    CPPUNIT_ASSERT(istream1.getNext(&loaded));
+    CPPUNIT_ASSERT(loaded.getId() == obj.getId());
+    istream1.destroy();
+    istream2.destroy();
+  };
+  CPPUNIT_ASSERT(mSQLArchive->getUsedReplicaConnections() == 0);
+  //writes stay on primary
+  {
+    dba::Transaction t(mSQLArchive->createTransaction());
+    CPPUNIT_ASSERT(mSQLArchive->getUsedConnections() == 1);
+    CPPUNIT_ASSERT(mSQLArchive->getUsedReplicaConnections() == 0);
+  };
+};
+
+void
+SharedSQLArchive_Tests::replica_readOnlyTransaction() {
+  mSQLArchive->addReplica(mDbParams);
+  dba::Transaction t(mSQLArchive->createTransaction(dba::Transaction::TRANS_READ_ONLY));
+  CPPUNIT_ASSERT(t.isReadOnly());
+  CPPUNIT_ASSERT(mSQLArchive->getUsedReplicaConnections() == 1);
+  CPPUNIT_ASSERT(mSQLArchive->getUsedConnections() == 0);
+  bool thrown = false;
+  try {
+    t.getOStream();
+  } catch (const dba::APIException&) {
+    thrown = true;
+  };
+  CPPUNIT_ASSERT(thrown);
+  dba::SQLIStream istream = t.getIStream();
+  std::auto_ptr<dba::DbResult> res(istream.sendQuery("SELECT 1"));
+  CPPUNIT_ASSERT(res->fetchRow());
+};
+
+void
+SharedSQLArchive_Tests::identityMap_load() {
+  tm date(Utils::getNow());
+  TestObject obj(1,1.1,"str1",date);
+  dba::Transaction t(mSQLArchive->createTransaction());
+  t.setIdentityMap();
+  dba::SQLOStream ostream = t.getOStream();
+  ostream.put(&obj);
+  dba::SQLIStream istream = t.getIStream();
+  TestObject loaded;
+  CPPUNIT_ASSERT(istream.load(loaded,obj.getId()));
+  CPPUNIT_ASSERT(t.getIdentityMap().getMisses() == 1);
+  TestObject cached;
+  CPPUNIT_ASSERT(istream.load(cached,obj.getId()));
+  CPPUNIT_ASSERT(t.getIdentityMap().getHits() == 1);
+  CPPUNIT_ASSERT(cached.getId() == obj.getId());
+  CPPUNIT_ASSERT(cached.s == "str1");
+  //store removes object from map
+  cached.s = "str2";
+  cached.setChanged();
+  ostream.put(&cached);
+  CPPUNIT_ASSERT(t.getIdentityMap().size() == 0);
+  TestObject reloaded;
+  CPPUNIT_ASSERT(istream.load(reloaded,obj.getId()));
+  CPPUNIT_ASSERT(t.getIdentityMap().getMisses() == 2);
+  CPPUNIT_ASSERT(reloaded.s == "str2");
+  //raw update clears map
+  ostream.sendUpdate(dba::SQL("UPDATE test_objects SET s_value = 'changed' WHERE id = :d") << obj.getId());
+  CPPUNIT_ASSERT(t.getIdentityMap().size() == 0);
+  CPPUNIT_ASSERT(istream.load(reloaded,obj.getId()));
+  CPPUNIT_ASSERT(t.getIdentityMap().getMisses() == 3);
+  CPPUNIT_ASSERT(reloaded.s == "changed");
+  t.commit();
+  CPPUNIT_ASSERT(t.getIdentityMap().size() == 0);
+};
+
+void
+SharedSQLArchive_Tests::identityMap_childUpdate() {
+  ObjWithList obj("parent",3);
+  dba::Transaction t(mSQLArchive->createTransaction());
+  t.setIdentityMap();
+  dba::SQLOStream ostream = t.getOStream();
+  ostream.put(&obj);
+  dba::SQLIStream istream = t.getIStream();
+  ObjWithList loaded;
+  CPPUNIT_ASSERT(istream.load(loaded,obj.getId()));
+  CPPUNIT_ASSERT(loaded.mList.size() == 3);
+  CPPUNIT_ASSERT(istream.load(loaded,obj.getId()));
+  CPPUNIT_ASSERT(t.getIdentityMap().getHits() == 1);
+  //update item of collection without touching parent
+  TestObject& child = loaded.mList.front();
+  child.s = "changed";
+  child.setChanged();
+  ostream.put(&child);
+  ObjWithList reloaded;
+  CPPUNIT_ASSERT(istream.load(reloaded,obj.getId()));
+  CPPUNIT_ASSERT(t.getIdentityMap().getHits() == 1);
+  int found = 0;
+  for(std::list<TestObject>::iterator it = reloaded.mList.begin(); it != reloaded.mList.end(); it++)
+    if (it->getId() == child.getId() && it->s == "changed")
+      found++;
+  CPPUNIT_ASSERT_EQUAL(1, found);
+  //child written through parent collection
+  reloaded.mList.push_back(TestObject(10,10,"new_child",Utils::getNow()));
+  reloaded.setChanged();
+  ostream.put(&reloaded);
+  CPPUNIT_ASSERT(istream.load(loaded,obj.getId()));
+  CPPUNIT_ASSERT(loaded.mList.size() == 4);
+  t.commit();
+};
+
+void
+SharedSQLArchive_Tests::objectCache_get() {
+  tm date(Utils::getNow());
+  TestObject obj1(1,1.1,"str1",date);
+  TestObject obj2(2,2.2,"str2",date);
+  dba::ObjectCache& cache(mSQLArchive->getObjectCache());
+  cache.enableClass<TestObject>();
+  dba::SQLOStream ostream = mSQLArchive->getOStream();
+  ostream.open();
+  ostream.put(&obj1);
+  ostream.put(&obj2);
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  TestObject loaded;
+  CPPUNIT_ASSERT(istream.load(loaded,obj1.getId()));
+  CPPUNIT_ASSERT(cache.getMisses() == 1);
+  CPPUNIT_ASSERT(cache.size() == 1);
+  //change object behind cache
+  ostream.sendUpdate(dba::SQL("UPDATE test_objects SET s_value = 'changed' WHERE id = :d") << obj1.getId());
+  TestObject cached;
+  CPPUNIT_ASSERT(istream.load(cached,obj1.getId()));
+  CPPUNIT_ASSERT(cache.getHits() == 1);
+  CPPUNIT_ASSERT(cached.getId() == obj1.getId());
+  CPPUNIT_ASSERT(cached.isOk());
+  CPPUNIT_ASSERT(cached.s == "str1");
+  //store removes object from cache
+  cached.s = "str3";
+  cached.setChanged();
+  ostream.put(&cached);
+  CPPUNIT_ASSERT(cache.size() == 0);
+  TestObject reloaded;
+  CPPUNIT_ASSERT(istream.load(reloaded,obj1.getId()));
+  CPPUNIT_ASSERT(reloaded.s == "str3");
+  //least recently used object is evicted
+  cache.setMaxSize(1);
+  CPPUNIT_ASSERT(istream.load(loaded,obj2.getId()));
+  CPPUNIT_ASSERT(cache.size() == 1);
+  CPPUNIT_ASSERT(cache.getEvictions() == 1);
+  ostream.destroy();
+  istream.destroy();
+};
+
+void
+SharedSQLArchive_Tests::objectCache_ttl() {
+  tm date(Utils::getNow());
+  TestObject obj(1,1.1,"str1",date);
+  dba::ObjectCache& cache(mSQLArchive->getObjectCache());
+  cache.enableClass<TestObject>(1);
+  dba::SQLOStream ostream = mSQLArchive->getOStream();
+  ostream.open();
+  ostream.put(&obj);
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  TestObject loaded;
+  CPPUNIT_ASSERT(istream.load(loaded,obj.getId()));
+  CPPUNIT_ASSERT(cache.size() == 1);
+  dba::Thread::sleep(20);
+  CPPUNIT_ASSERT(istream.load(loaded,obj.getId()));
+  CPPUNIT_ASSERT(cache.getHits() == 0);
+  CPPUNIT_ASSERT(cache.getEvictions() == 1);
+  cache.disableClass<TestObject>();
+  CPPUNIT_ASSERT(cache.size() == 0);
+  ostream.destroy();
+  istream.destroy();
+};
+
+void
+SharedSQLArchive_Tests::objectCache_generation() {
+  tm date(Utils::getNow());
+  TestObject obj(1,1.1,"str1",date);
+  dba::ObjectCache& cache(mSQLArchive->getObjectCache());
+  cache.enableClass<TestObject>();
+  dba::SQLOStream ostream = mSQLArchive->getOStream();
+  ostream.open();
+  ostream.put(&obj);
+  //reader takes generation before query, writer erases object before reader puts it
+  unsigned long generation = cache.getGeneration("test_objects");
+  obj.s = "str2";
+  obj.setChanged();
+  ostream.put(&obj);
+  CPPUNIT_ASSERT(cache.getGeneration("test_objects") != generation);
+  cache.put(obj,"test_objects",generation);
+  CPPUNIT_ASSERT(cache.size() == 0);
+  //other tables are not affected
+  TestObject other(2,2.2,"str3",date);
+  cache.put(other,"other_objects",cache.getGeneration("other_objects"));
+  CPPUNIT_ASSERT(cache.size() == 1);
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  TestObject loaded;
+  CPPUNIT_ASSERT(istream.load(loaded,obj.getId()));
+  CPPUNIT_ASSERT(loaded.s == "str2");
+  CPPUNIT_ASSERT(cache.size() == 2);
+  ostream.destroy();
+  istream.destroy();
+};
+
+void
+SharedSQLArchive_Tests::objectCache_commit() {
+  tm date(Utils::getNow());
+  TestObject obj(1,1.1,"str1",date);
+  dba::ObjectCache& cache(mSQLArchive->getObjectCache());
+  cache.enableClass<TestObject>();
+  {
+    dba::SQLOStream ostream = mSQLArchive->getOStream();
+    ostream.open();
+    ostream.put(&obj);
+    ostream.destroy();
+  };
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  TestObject loaded;
+  {
+    dba::Transaction t(mSQLArchive->createTransaction());
+    dba::SQLOStream ostream = t.getOStream();
+    obj.s = "str2";
+    obj.setChanged();
+    ostream.put(&obj);
+    CPPUNIT_ASSERT(cache.size() == 0);
+    //other connection loads and caches object that is not commited yet
+    CPPUNIT_ASSERT(istream.load(loaded,obj.getId()));
+    CPPUNIT_ASSERT(loaded.s == "str1");
+    CPPUNIT_ASSERT(cache.size() == 1);
+  };
+  //commit removes changed objects again
+  CPPUNIT_ASSERT(cache.size() == 0);
+  TestObject reloaded;
+  CPPUNIT_ASSERT(istream.load(reloaded,obj.getId()));
+  CPPUNIT_ASSERT(reloaded.s == "str2");
+  istream.destroy();
+};
+
+void
+SharedSQLArchive_Tests::queryCache_invalidate() {
+  tm date(Utils::getNow());
+  TestObject obj(1,1.1,"str1",date);
+  dba::QueryCache& cache(mSQLArchive->getQueryCache());
+  dba::SQLOStream ostream = mSQLArchive->getOStream();
+  ostream.open();
+  ostream.put(&obj);
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  dba::SQL query("SELECT s_value, i_value, d_value FROM test_objects WHERE id = :d");
+  query << obj.getId();
+  {
+    std::auto_ptr<dba::DbResult> res(istream.sendCachedQuery(query,"test_objects"));
+    CPPUNIT_ASSERT(res->fetchRow());
+    CPPUNIT_ASSERT(std::string(res->getString(0)) == "str1");
+    CPPUNIT_ASSERT(!res->fetchRow());
+  };
+  CPPUNIT_ASSERT(cache.getMisses() == 1);
+  CPPUNIT_ASSERT(cache.size() == 1);
+  {
+    std::auto_ptr<dba::DbResult> res(istream.sendCachedQuery(query,"test_objects"));
+    CPPUNIT_ASSERT(res->fetchRow());
+    CPPUNIT_ASSERT(std::string(res->getString("s_value")) == "str1");
+    CPPUNIT_ASSERT(res->getInt(1) == 1);
+    tm loaded(res->getDate(2));
+    CPPUNIT_ASSERT(loaded.tm_year == date.tm_year);
+    CPPUNIT_ASSERT(loaded.tm_mday == date.tm_mday);
+    CPPUNIT_ASSERT(loaded.tm_sec == date.tm_sec);
+    CPPUNIT_ASSERT(!res->fetchRow());
+  };
+  CPPUNIT_ASSERT(cache.getHits() == 1);
+  //raw update clears cache
+  ostream.sendUpdate(dba::SQL("UPDATE test_objects SET s_value = 'changed' WHERE id = :d") << obj.getId());
+  CPPUNIT_ASSERT(cache.size() == 0);
+  {
+    std::auto_ptr<dba::DbResult> res(istream.sendCachedQuery(query,"test_objects"));
+    CPPUNIT_ASSERT(res->fetchRow());
+    CPPUNIT_ASSERT(std::string(res->getString(0)) == "changed");
+  };
+  CPPUNIT_ASSERT(cache.getMisses() == 2);
+  CPPUNIT_ASSERT(cache.size() == 1);
+  //store invalidates query
+  obj.s = "str2";
+  obj.setChanged();
+  ostream.put(&obj);
+  CPPUNIT_ASSERT(cache.size() == 0);
+  CPPUNIT_ASSERT(cache.getInvalidations() == 1);
+  {
+    std::auto_ptr<dba::DbResult> res(istream.sendCachedQuery(query,"test_objects"));
+    CPPUNIT_ASSERT(res->fetchRow());
+    CPPUNIT_ASSERT(std::string(res->getString(0)) == "str2");
+  };
+  //result larger than cache is not stored
+  cache.setMaxBytes(1);
+  CPPUNIT_ASSERT(cache.size() == 0);
+  CPPUNIT_ASSERT(cache.getEvictions() == 1);
+  //generation is kept for each table
+  unsigned long generation = cache.getGeneration("other_table");
+  cache.invalidate("test_objects");
+  CPPUNIT_ASSERT(cache.getGeneration("other_table") == generation);
+  CPPUNIT_ASSERT(cache.getGeneration("other_table, test_objects") != generation);
+  ostream.destroy();
+  istream.destroy();
+};
+
+void
+SharedSQLArchive_Tests::queryCache_commit() {
+  tm date(Utils::getNow());
+  TestObject obj(1,1.1,"str1",date);
+  dba::QueryCache& cache(mSQLArchive->getQueryCache());
+  {
+    dba::SQLOStream ostream = mSQLArchive->getOStream();
+    ostream.open();
+    ostream.put(&obj);
+    ostream.destroy();
+  };
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  dba::SQL query("SELECT s_value FROM test_objects WHERE id = :d");
+  query << obj.getId();
+  {
+    dba::Transaction t(mSQLArchive->createTransaction());
+    dba::SQLOStream ostream = t.getOStream();
+    obj.s = "str2";
+    obj.setChanged();
+    ostream.put(&obj);
+    //other connection reads and caches row that is not commited yet
+    {
+      std::auto_ptr<dba::DbResult> res(istream.sendCachedQuery(query,"test_objects"));
+      CPPUNIT_ASSERT(res->fetchRow());
+      CPPUNIT_ASSERT(std::string(res->getString(0)) == "str1");
+    };
+    CPPUNIT_ASSERT(cache.size() == 1);
+  };
+  //commit invalidates changed tables again
+  CPPUNIT_ASSERT(cache.size() == 0);
+  {
+    std::auto_ptr<dba::DbResult> res(istream.sendCachedQuery(query,"test_objects"));
+    CPPUNIT_ASSERT(res->fetchRow());
+    CPPUNIT_ASSERT(std::string(res->getString(0)) == "str2");
+  };
+  istream.destroy();
+};
+
+void
+SharedSQLArchive_Tests::preparedStatements() {
+  TestObject obj(1,1.1,"str1",Utils::getNow());
+  dba::SQLOStream ostream = mSQLArchive->getOStream();
+  ostream.open();
+  ostream.put(&obj);
+  //params are bound natively if driver supports it
+  int rows = ostream.sendUpdate(dba::SQL("UPDATE test_objects SET i_value = :d, s_value = :s WHERE id = :d") << 5 << std::string("a'b") << obj.getId());
+  CPPUNIT_ASSERT(rows == 1);
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  int i = 0;
+  std::string s;
+  {
+    dba::SQL query("SELECT i_value, s_value FROM test_objects WHERE id = :d AND s_value = :s");
+    query.into(i).into(s) << obj.getId() << std::string("a'b");
+    std::auto_ptr<dba::DbResult> res(istream.sendQuery(query));
+    CPPUNIT_ASSERT(res->fetchRow());
+    CPPUNIT_ASSERT(i == 5);
+    CPPUNIT_ASSERT(s == "a'b");
+    CPPUNIT_ASSERT(!res->fetchRow());
+  };
+  ostream.destroy();
+  istream.destroy();
+
+  std::auto_ptr<dba::DbConnection> conn(mSQLArchive->getConnection());
+  if (conn->getParamStyle() == dba::DbConnection::PARAMS_NONE)
+    return;
+  const char* sql = "SELECT s_value FROM test_objects WHERE id = ?";
+  if (conn->getParamStyle() == dba::DbConnection::PARAMS_NUMBERED)
+    sql = "SELECT s_value FROM test_objects WHERE id = $1";
+  dba::DbParams params(1,dba::DbParam(dba::DbParam::INTEGER));
+  params[0].mIsNull = false;
+  params[0].mValue = dba::toStr(obj.getId());
+  //connection could be already used by streams
+  size_t cached = conn->getCachedStatements();
+  unsigned long hits = conn->getStatementHits();
+  unsigned long misses = conn->getStatementMisses();
+  for(int n = 0; n < 3; n++) {
+    std::auto_ptr<dba::DbResult> res(conn->sendQuery(sql,params));
+    //statement used by open result can be executed again
+    std::auto_ptr<dba::DbResult> nested(conn->sendQuery(sql,params));
+    CPPUNIT_ASSERT(res->fetchRow());
+    CPPUNIT_ASSERT(std::string(res->getString(0)) == "a'b");
+    CPPUNIT_ASSERT(nested->fetchRow());
+    CPPUNIT_ASSERT(std::string(nested->getString(0)) == "a'b");
+  };
+  CPPUNIT_ASSERT(conn->getCachedStatements() == cached + 1);
+  CPPUNIT_ASSERT(conn->getStatementHits() - hits >= 2);
+  CPPUNIT_ASSERT(conn->getStatementHits() - hits + conn->getStatementMisses() - misses == 6);
+  conn->setStatementCacheSize(0);
+  CPPUNIT_ASSERT(conn->getCachedStatements() == 0);
+};
+
+void
+SharedSQLArchive_Tests::memberList() {
+  MIAdvObject obj(1,"a",2,"b",3,"c",4,"d");
+  const dba::StoreTable* table = obj.st_getTable();
+  dba::shared_ptr<dba::mt_mlist> list(dba::mt_mlist::get(table,NULL));
+  //list is built once and shared by all streams
+  CPPUNIT_ASSERT(list.ptr() == dba::mt_mlist::get(table,NULL).ptr());
+  CPPUNIT_ASSERT(list->end() - list->begin() == 2);
+  CPPUNIT_ASSERT(std::string(list->begin()->name) == "mi_object");
+  CPPUNIT_ASSERT(std::string((list->end() - 1)->name) == "mi_advobject");
+  CPPUNIT_ASSERT(list->findMember("mi_advobject","c1") != NULL);
+  CPPUNIT_ASSERT(list->findMember("mi_object","c1") == NULL);
+  //overridden root table name gets its own list
+  dba::shared_ptr<dba::mt_mlist> renamed(dba::mt_mlist::get(table,"mi_renamed"));
+  CPPUNIT_ASSERT(renamed.ptr() != list.ptr());
+  CPPUNIT_ASSERT(std::string((renamed->end() - 1)->name) == "mi_renamed");
+  CPPUNIT_ASSERT(renamed->findMember("mi_renamed","c1") != NULL);
+};
+
+void
+SharedSQLArchive_Tests::typedStoreTable() {
+  TypedObject typed;
+  TestObject plain;
+  //BIND_MEMBER selects the same filters and store types as BIND_* macros
+  dba::shared_ptr<dba::mt_mlist> typedList(dba::mt_mlist::get(typed.st_getTable(),NULL));
+  dba::shared_ptr<dba::mt_mlist> plainList(dba::mt_mlist::get(plain.st_getTable(),NULL));
+  CPPUNIT_ASSERT(typedList->end() - typedList->begin() == 1);
+  const dba::mt_class& typedTable(*typedList->begin());
+  const dba::mt_class& plainTable(*plainList->begin());
+  CPPUNIT_ASSERT(typedTable.last - typedTable.first == plainTable.last - plainTable.first);
+  for(const dba::mt_member* m = typedTable.first; m != typedTable.last; m++) {
+    const dba::mt_member* p = dba::mt_mlist::findMember(plainTable,m->name);
+    CPPUNIT_ASSERT(p != NULL);
+    CPPUNIT_ASSERT(p->type == m->type);
+    CPPUNIT_ASSERT(typeid(*(dba::StoreableFilterBase*)p->func) == typeid(*(dba::StoreableFilterBase*)m->func));
+    //SQL streams use code generated for member type
+    CPPUNIT_ASSERT(m->typed != NULL);
+    CPPUNIT_ASSERT(m->typed->mType == m->type);
+    CPPUNIT_ASSERT(p->typed == NULL);
+  };
+
+  typed.i = 12;
+  typed.d = 1.5;
+  typed.s = "typed";
+  typed.date = Utils::getNow();
+  dba::SQLOStream ostream = mSQLArchive->getOStream();
+  ostream.open();
+  ostream.put(&typed);
+  typed.s = "typed_update";
+  typed.setChanged();
+  ostream.put(&typed);
+  ostream.destroy();
+
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  CPPUNIT_ASSERT(istream.load(plain,typed.getId()));
+  CPPUNIT_ASSERT(plain == TestObject(12,1.5,"typed_update",typed.date));
+  TypedObject loaded;
+  CPPUNIT_ASSERT(istream.load(loaded,typed.getId()));
+  CPPUNIT_ASSERT(loaded.isOk());
+  CPPUNIT_ASSERT(loaded.i == 12 && loaded.d == 1.5 && loaded.s == "typed_update");
+  CPPUNIT_ASSERT(TestObject(12,1.5,"typed_update",loaded.date) == plain);
+
+  //typed and filter members in one hierarchy
+  TypedInheritedObject inherited;
+  inherited.i = 13;
+  inherited.d = 2.5;
+  inherited.date = Utils::getNow();
+  inherited.mName = "inherited";
+  ostream = mSQLArchive->getOStream();
+  ostream.open();
+  ostream.put(&inherited);
+  ostream.destroy();
+  TypedInheritedObject loadedInherited;
+  CPPUNIT_ASSERT(istream.load(loadedInherited,inherited.getId()));
+  CPPUNIT_ASSERT(loadedInherited.i == 13 && loadedInherited.d == 2.5);
+  CPPUNIT_ASSERT(loadedInherited.mName == "inherited");
+  //empty string is stored as NULL
+  CPPUNIT_ASSERT(loadedInherited.s.empty());
+  std::auto_ptr<dba::DbResult> res(istream.sendQuery(dba::SQL("SELECT s_value FROM test_objects WHERE id = :d") << inherited.getId()));
+  CPPUNIT_ASSERT(res->fetchRow());
+  CPPUNIT_ASSERT(res->isNull(0));
+  res.reset();
+  istream.destroy();
+};
+
+void
+SharedSQLArchive_Tests::builtinFilters() {
+  TestObject obj(-7,2.25,"it's",Utils::getNow());
+  dba::shared_ptr<dba::mt_mlist> list(dba::mt_mlist::get(obj.st_getTable(),NULL));
+  const dba::mt_class& table(*list->begin());
+  //builtin filters are applied by streams without filter calls
+  CPPUNIT_ASSERT(dba::mt_mlist::findMember(table,"i_value")->kind == dba::StoreTableMember::INT_FILTER);
+  CPPUNIT_ASSERT(dba::mt_mlist::findMember(table,"f_value")->kind == dba::StoreTableMember::DOUBLE_FILTER);
+  CPPUNIT_ASSERT(dba::mt_mlist::findMember(table,"s_value")->kind == dba::StoreTableMember::STRING_FILTER);
+  CPPUNIT_ASSERT(dba::mt_mlist::findMember(table,"d_value")->kind == dba::StoreTableMember::CUSTOM_FILTER);
+
+  dba::SQLOStream ostream = mSQLArchive->getOStream();
+  ostream.open();
+  ostream.put(&obj);
+  TestObject empty(0,0,"",obj.date);
+  ostream.put(&empty);
+  ostream.destroy();
+
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  TestObject loaded;
+  CPPUNIT_ASSERT(istream.load(loaded,obj.getId()));
+  CPPUNIT_ASSERT(loaded == obj);
+  //empty string is stored as NULL and loaded back as empty
+  loaded.s = "not empty";
+  CPPUNIT_ASSERT(istream.load(loaded,empty.getId()));
+  CPPUNIT_ASSERT(loaded == empty);
+  istream.destroy();
+};
+
+void
+SharedSQLArchive_Tests::schemaSnapshot() {
+  dba::shared_ptr<dba::Schema> schema(mSQLArchive->getSchema());
+  //snapshot is read once
+  CPPUNIT_ASSERT(schema.ptr() == mSQLArchive->getSchema().ptr());
+  CPPUNIT_ASSERT(mSQLArchive->getTableNames() == schema->getRelationNames());
+  CPPUNIT_ASSERT(schema->hasRelation("test_objects"));
+  CPPUNIT_ASSERT(schema->hasColumn("TEST_OBJECTS","i_value"));
+  CPPUNIT_ASSERT(!schema->hasColumn("test_objects","no_such_column"));
+  CPPUNIT_ASSERT(schema->getColumns("no_such_table").empty());
+
+  TestObject obj;
+  mSQLArchive->checkSchema(obj);
+  std::list<std::string> missing(schema->getMissing(obj.st_getTable(),"no_such_table"));
+  CPPUNIT_ASSERT(missing.size() == 1 && missing.front() == "no_such_table");
+  try {
+    mSQLArchive->checkSchema(obj,"no_such_table");
+    CPPUNIT_FAIL("DataException expected");
+  } catch (const dba::DataException&) {};
+
+  {
+    dba::SQLOStream ostream = mSQLArchive->getOStream();
+    ostream.sendUpdate("CREATE TABLE \"Schema_Snapshot\" (val INTEGER)");
+  };
+  //schema changed by stream is read again
+  CPPUNIT_ASSERT(schema->isOutdated());
+  CPPUNIT_ASSERT(!schema->hasRelation("schema_snapshot"));
+  CPPUNIT_ASSERT(mSQLArchive->getSchema().ptr() != schema.ptr());
+  CPPUNIT_ASSERT(mSQLArchive->getSchema()->hasColumn("schema_snapshot","val"));
+  CPPUNIT_ASSERT(mSQLArchive->getSchema()->hasColumnInfo("Schema_Snapshot"));
+  CPPUNIT_ASSERT(mSQLArchive->getTableNames() == mSQLArchive->getSchema()->getRelationNames());
+  //dropped snapshot does not query database
+  CPPUNIT_ASSERT(schema->hasColumn("test_objects","i_value"));
+  CPPUNIT_ASSERT(schema->hasRelation("obj_with_list"));
+  CPPUNIT_ASSERT(!schema->hasColumnInfo("obj_with_list"));
+  {
+    dba::SQLOStream ostream = mSQLArchive->getOStream();
+    ostream.sendUpdate("DROP TABLE \"Schema_Snapshot\"");
+  };
+  CPPUNIT_ASSERT(!mSQLArchive->getSchema()->hasRelation("schema_snapshot"));
+};
+
+static void
+setDateStorage(dba::SharedSQLArchive& pArchive, dba::ConvSpec::date_storage pStorage) {
+  dba::ConvSpec specs(pArchive.getConversionSpecs());
+  specs.mDateStorage = pStorage;
+  pArchive.setConversionSpecs(specs);
+};
+
+void
+SharedSQLArchive_Tests::numericDates() {
+  //numeric dates are stored in columns with numeric affinity by SQLite only
+  if (std::string(mPluginName).find("sqlite") == std::string::npos) {
+    setDateStorage(*mSQLArchive,dba::ConvSpec::DATE_UNIXTIME);
+    TestObject obj(1,1.5,"numeric",Utils::getDate(1815,12,12,23,12,48));
+    dba::SQLOStream ostream = mSQLArchive->getOStream();
+    ostream.open();
+    CPPUNIT_ASSERT_THROW(ostream.put(&obj),dba::DataException);
+    ostream.destroy();
+    setDateStorage(*mSQLArchive,dba::ConvSpec::DATE_TEXT);
+    return;
+  };
+  dba::ConvSpec::date_storage storage[] = { dba::ConvSpec::DATE_UNIXTIME, dba::ConvSpec::DATE_JULIANDAY };
+  for(int i = 0; i < 2; i++) {
+    setDateStorage(*mSQLArchive,storage[i]);
+    TestObject obj(i,1.5,"numeric",Utils::getDate(1815,12,12,23,12,48));
+    dba::SQLOStream ostream = mSQLArchive->getOStream();
+    ostream.open();
+    ostream.put(&obj);
+    ostream.destroy();
+
+    dba::SQLIStream istream = mSQLArchive->getIStream();
+    TestObject loaded;
+    CPPUNIT_ASSERT(istream.load(loaded,obj.getId()));
+    CPPUNIT_ASSERT(loaded == obj);
+    std::auto_ptr<dba::DbResult> res(istream.sendQuery(dba::SQL("SELECT typeof(d_value) FROM test_objects WHERE id = :d") << obj.getId()));
+    CPPUNIT_ASSERT(res->fetchRow());
+    CPPUNIT_ASSERT(std::string(res->getString(0)) == (i == 0 ? "integer" : "real"));
+    res.reset();
+    istream.destroy();
+  };
+  //numbers read by DateTime filter are UTC like stored numeric dates
+  setDateStorage(*mSQLArchive,dba::ConvSpec::DATE_UNIXTIME);
+  tm date;
+  dba::DateTime filter(date);
+  filter.fromInt(mSQLArchive->getConversionSpecs(),86400 + 3600);
+  CPPUNIT_ASSERT(date.tm_year == 70 && date.tm_mon == 0 && date.tm_mday == 2 && date.tm_hour == 1);
+  setDateStorage(*mSQLArchive,dba::ConvSpec::DATE_TEXT);
+};
+
+#ifdef TEST_CSV
+void
+SharedSQLArchive_Tests::csvImport() {
+  const int rows = 5000;
+  remove("csv-import.csv");
+  std::map<int,TestObject> objects;
+  {
+    dba::CSVArchive csv;
+    csv.open("csv-import.csv");
+    dba::CSVOStream ostream = csv.getOStream();
+    ostream.open();
+    for(int i = 0; i < rows; i++) {
+      //quotes and line ends inside fields must not split chunks
+      std::string str("row " + dba::toStr(i));
+      if (i % 7 == 0)
+        str += "\n\"quoted\",\nline";
+      TestObject obj(i,i * 0.25,str,Utils::getDate(2010,1 + i % 12,1 + i % 28,i % 24,i % 60,0));
+      ostream.put(&obj);
+      objects[i] = obj;
+    };
+    ostream.close();
+  };
+  mSQLArchive->getOStream().sendUpdate("DELETE FROM test_objects");
+
+  dba::CSVArchive csv;
+  csv.open("csv-import.csv");
+  dba::CSVImport import(csv,*mSQLArchive);
+  import.setWorkers(3);
+  import.setChunkSize(4096);
+  import.setBatchSize(100);
+  import.setQueueSize(4);
+  import.preserveOrder();
+  CPPUNIT_ASSERT_EQUAL(rows,(int)import.run<TestObject>());
+  remove("csv-import.csv");
+
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  TestObject obj;
+  istream.open(obj);
+  std::map<int,int> ids;
+  while(istream.getNext(&obj)) {
+    CPPUNIT_ASSERT(objects[obj.i] == obj);
+    ids[obj.getId()] = obj.i;
+  };
+  istream.destroy();
+  CPPUNIT_ASSERT_EQUAL(rows,(int)ids.size());
+  //one writer stores chunks in order of file
+  int last = -1;
+  for(std::map<int,int>::const_iterator it = ids.begin(); it != ids.end(); it++) {
+    CPPUNIT_ASSERT(it->second > last);
+    last = it->second;
+  };
+};
+
+//ids are allocated without queries, so they are unique in concurrent transactions
+class CounterFetcher : public dba::SQLIdFetcher {
+  public:
+    virtual int getNextId(dba::DbConnection&, const char*) { return mNext.inc(); };
+  private:
+    dba::AtomicCounter mNext;
+};
+
+void
+SharedSQLArchive_Tests::csvImport_writers() {
+  const int rows = 3000;
+  remove("csv-import.csv");
+  std::map<int,TestObject> objects;
+  {
+    dba::CSVArchive csv;
+    csv.open("csv-import.csv");
+    dba::CSVOStream ostream = csv.getOStream();
+    ostream.open();
+    for(int i = 0; i < rows; i++) {
+      TestObject obj(i,i * 0.25,"row " + dba::toStr(i),Utils::getDate(2010,1 + i % 12,1 + i % 28,i % 24,i % 60,0));
+      ostream.put(&obj);
+      objects[i] = obj;
+    };
+    ostream.close();
+  };
+  mSQLArchive->getOStream().sendUpdate("DELETE FROM test_objects");
+
+  std::string params(mDbParams);
+  //SQLite writers wait for database lock of other writers
+  if (std::string(mPluginName).find("sqlite") != std::string::npos)
+    params += " timeout=10000";
+  dba::SharedSQLArchive target;
+  target.open(mPluginName,params.c_str());
+  target.setIdFetcher(new CounterFetcher);
+  dba::CSVArchive csv;
+  csv.open("csv-import.csv");
+  dba::CSVImport import(csv,target);
+  import.setWorkers(2);
+  import.setWriters(3);
+  import.setChunkSize(2048);
+  import.setBatchSize(50);
+  CPPUNIT_ASSERT_EQUAL(rows,(int)import.run<TestObject>());
+  remove("csv-import.csv");
+
+  dba::SQLIStream istream = mSQLArchive->getIStream();
+  TestObject obj;
+  istream.open(obj);
+  std::set<int> rowsRead;
+  while(istream.getNext(&obj)) {
+    CPPUNIT_ASSERT(objects[obj.i] == obj);
+    rowsRead.insert(obj.i);
+  };
+  istream.destroy();
+  CPPUNIT_ASSERT_EQUAL(rows,(int)rowsRead.size());
+};
+#endif
+
 } //namespace
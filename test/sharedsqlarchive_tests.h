@@ -32,6 +32,34 @@ class SharedSQLArchive_Tests : public SQLArchive_Lists {
       CPPUNIT_TEST(transactions_shared_rollback);  
       CPPUNIT_TEST(transactions_store_after_store);  
       CPPUNIT_TEST(transactions_rollback);  
+      CPPUNIT_TEST(writeBehind_coalesce);  
+      CPPUNIT_TEST(writeBehind_deleteNew);  
+      CPPUNIT_TEST(pipelined_put);  
+      CPPUNIT_TEST(pipelined_error);  
+      CPPUNIT_TEST(pipelined_roundTrips);  
+      CPPUNIT_TEST(timeout_query);  
+      CPPUNIT_TEST(timeout_deadline);  
+      CPPUNIT_TEST(timeout_perStatement);
+      CPPUNIT_TEST(replica_routing);  
+      CPPUNIT_TEST(replica_readOnlyTransaction);  
+      CPPUNIT_TEST(identityMap_load);  
+      CPPUNIT_TEST(identityMap_childUpdate);
+      CPPUNIT_TEST(objectCache_get);  
+      CPPUNIT_TEST(objectCache_ttl);  
+      CPPUNIT_TEST(objectCache_generation);
+      CPPUNIT_TEST(objectCache_commit);
+      CPPUNIT_TEST(queryCache_invalidate);  
+      CPPUNIT_TEST(queryCache_commit);
+      CPPUNIT_TEST(preparedStatements);  
+      CPPUNIT_TEST(memberList);
+      CPPUNIT_TEST(typedStoreTable);
+      CPPUNIT_TEST(builtinFilters);
+      CPPUNIT_TEST(schemaSnapshot);
+      CPPUNIT_TEST(numericDates);
+#ifdef TEST_CSV
+      CPPUNIT_TEST(csvImport);
+      CPPUNIT_TEST(csvImport_writers);
+#endif
     CPPUNIT_TEST_SUITE_END();  
   public:
     SharedSQLArchive_Tests() {};
@@ -53,6 +81,34 @@ class SharedSQLArchive_Tests : public SQLArchive_Lists {
     void transactions_bad_begin();
     void transactions_store_after_store();
     void transactions_rollback();
+    void writeBehind_coalesce();
+    void writeBehind_deleteNew();
+    void pipelined_put();
+    void pipelined_error();
+    void pipelined_roundTrips();
+    void timeout_query();
+    void timeout_deadline();
+    void timeout_perStatement();
+    void replica_routing();
+    void replica_readOnlyTransaction();
+    void identityMap_load();
+    void identityMap_childUpdate();
+    void objectCache_get();
+    void objectCache_ttl();
+    void objectCache_generation();
+    void objectCache_commit();
+    void queryCache_invalidate();
+    void queryCache_commit();
+    void preparedStatements();
+    void memberList();
+    void typedStoreTable();
+    void builtinFilters();
+    void schemaSnapshot();
+    void numericDates();
+#ifdef TEST_CSV
+    void csvImport();
+    void csvImport_writers();
+#endif
 };
 
 }
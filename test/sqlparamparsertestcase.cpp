@@ -13,6 +13,7 @@
 
 #define private public //for access to tested dba::SQL::SQLParamParser
 #include "dba/sql.h"
+#include "dba/filtermapper.h"
 
 namespace dba_tests {
 
@@ -280,4 +281,32 @@ SQLParamParserTestCase::quotes() {
   CPPUNIT_ASSERT(h.size() == 0);
 }
 
+void 
+SQLParamParserTestCase::nativeQuoted() {
+  dba::FilterMapper mapper;
+  dba::ConvSpec specs;
+  std::string stmt;
+  dba::DbParams params;
+  //quoted placeholder that is whole literal is bound natively
+  dba::SQL q1("INSERT INTO t(a,b) VALUES (':s',':s')");
+  q1 << std::string("a'b") << 2;
+  CPPUNIT_ASSERT(q1.prepare(mapper,specs,dba::DbConnection::PARAMS_NUMBERED,stmt,params));
+  CPPUNIT_ASSERT_EQUAL(std::string("INSERT INTO t(a,b) VALUES ($1,$2)"), stmt);
+  CPPUNIT_ASSERT(params.size() == 2);
+  CPPUNIT_ASSERT_EQUAL(std::string("a'b"), params[0].mValue);
+  CPPUNIT_ASSERT_EQUAL(std::string("2"), params[1].mValue);
+  //text generated for drivers without native params is not changed
+  CPPUNIT_ASSERT_EQUAL(std::string("INSERT INTO t(a,b) VALUES ('a''b','2')"), q1.cstring(mapper,specs));
+  //placeholder that is part of longer literal is not
+  dba::SQL q2("SELECT * FROM t WHERE a = 'x:s'");
+  q2 << std::string("a");
+  CPPUNIT_ASSERT(!q2.prepare(mapper,specs,dba::DbConnection::PARAMS_QUESTION_MARK,stmt,params));
+  dba::SQL q3("SELECT * FROM t WHERE a = ''':s'");
+  q3 << std::string("a");
+  CPPUNIT_ASSERT(!q3.prepare(mapper,specs,dba::DbConnection::PARAMS_QUESTION_MARK,stmt,params));
+  dba::SQL q4("SELECT * FROM t WHERE a = ':s'''");
+  q4 << std::string("a");
+  CPPUNIT_ASSERT(!q4.prepare(mapper,specs,dba::DbConnection::PARAMS_QUESTION_MARK,stmt,params));
+}
+
 } //namespace
@@ -41,6 +41,7 @@ class SQLParamParserTestCase : public CppUnit::TestCase {
       CPPUNIT_TEST(likeEscape1);
       CPPUNIT_TEST(likeEscape2);
       CPPUNIT_TEST(quotes);
+      CPPUNIT_TEST(nativeQuoted);
     CPPUNIT_TEST_SUITE_END();
   public:
     void noParams();
@@ -64,6 +65,7 @@ class SQLParamParserTestCase : public CppUnit::TestCase {
     void paramAndEscape();
     void likeNoLike();
     void quotes();
+    void nativeQuoted();
 };
 
 } //namespace
@@ -33,6 +33,12 @@ class DoubleFilter : public FiltersTestCase<double, dba::Double> {
       CPPUNIT_TEST(test15);
       CPPUNIT_TEST(test16);
       CPPUNIT_TEST(test17);
+      CPPUNIT_TEST(test18);
+      CPPUNIT_TEST(test19);
+      CPPUNIT_TEST(test20);
+      CPPUNIT_TEST(test21);
+      CPPUNIT_TEST(test22);
+      CPPUNIT_TEST(test23);
     CPPUNIT_TEST_SUITE_END();
   public:
     void test1() { notNull(0.0); };
@@ -52,6 +58,12 @@ class DoubleFilter : public FiltersTestCase<double, dba::Double> {
     void test15() { fromInt(1,1); };
     void test16() { exceptionFrom("a"); };
     void test17() { exceptionFrom(""); };
+    void test18() { toString(0.1,"0.1"); };
+    void test19() { toString(1e-7,"1e-7"); };
+    void test20() { testString(0.1 + 0.2); };
+    void test21() { dba::ConvSpec spec; spec.mDecimalPoint = ','; toString(1.5,"1,5",spec); };
+    void test22() { dba::ConvSpec spec; spec.mDecimalPoint = ','; fromString("1,5",1.5,spec); };
+    void test23() { exceptionFrom("1e400"); };
 };
 
 class StringFilter : public FiltersTestCase<std::string,dba::String> {
@@ -136,11 +148,12 @@ class DateTimeFilter : public FiltersTestCase<struct tm,dba::DateTime> {
 class DateTimeGMTOffset : public FiltersTestCase<struct tm,dba::DateTime> {
     CPPUNIT_TEST_SUITE(DateTimeGMTOffset);
       CPPUNIT_TEST(test1);
-//      CPPUNIT_TEST(test2);
-//      CPPUNIT_TEST(test3);
+      CPPUNIT_TEST(test2);
+      CPPUNIT_TEST(test3);
       CPPUNIT_TEST(test4);
-//      CPPUNIT_TEST(test5);
-//      CPPUNIT_TEST(test6);
+      CPPUNIT_TEST(test5);
+      CPPUNIT_TEST(test6);
+      CPPUNIT_TEST(test7);
     CPPUNIT_TEST_SUITE_END();
   public:    
     virtual void setUp() {
@@ -149,11 +162,18 @@ class DateTimeGMTOffset : public FiltersTestCase<struct tm,dba::DateTime> {
       sDefaultSpecs.mTimestampFormat="%Y-%m-%d %H:%M:%S";
     };
     void test1() { toString(date_2000,"2007-05-17 08:00:45"); };
-//    void test2() { toString(date_1815,"1815-12-12 23:12:48"); };
-//    void test3() { toString(date_2212,"2212-08-09 20:16:23"); };
+    //offsets are added without mktime(), so dates out of time_t range work
+    void test2() { toString(date_1815,"1815-12-13 04:12:48"); };
+    void test3() { toString(date_2212,"2212-08-09 20:16:23"); };
     void test4() { fromString("2007-05-17 08:00:45",date_2000); };
-//    void test5() { fromString("1815-12-12 23:12:48",date_1815); };
-//    void test6() { fromString("2212-08-09 10:16:23",date_2212); };
+    void test5() { fromString("1815-12-13 04:12:48",date_1815); };
+    void test6() { fromString("2212-08-09 20:16:23",date_2212); };
+    void test7() {
+      tm moved(date_1815);
+      moved.tm_mday = 13;
+      moved.tm_hour = 4;
+      fromDate(moved,date_1815);
+    };
 }; 
  
 }
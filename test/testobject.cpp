@@ -14,6 +14,7 @@
 #include "dba/stdmultiset.h"
 #include "dba/stdfilters.h"
 #include "dba/single.h"
+#include "dba/storemember.h"
 
 namespace dba_tests {
 
@@ -63,6 +64,17 @@ BEGIN_STORE_TABLE(TestObject,TestStoreable,"test_objects")
   BIND_DAT(TestObject::date,dba::DateTime,"d_value")
 END_STORE_TABLE()
 
+BEGIN_STORE_TABLE(TypedObject,TestStoreable,"test_objects")
+  BIND_MEMBER(TypedObject,int,i,"i_value")
+  BIND_MEMBER(TypedObject,double,d,"f_value")
+  BIND_MEMBER(TypedObject,std::string,s,"s_value")
+  BIND_MEMBER(TypedObject,tm,date,"d_value")
+END_STORE_TABLE()
+
+BEGIN_STORE_TABLE(TypedInheritedObject,TypedObject,"test_inherited")
+  BIND_STR(TypedInheritedObject::mName,dba::String,"name")
+END_STORE_TABLE()
+
 BEGIN_STORE_TABLE(InheritedObject,TestObject,"test_inherited")
   BIND_STR(InheritedObject::mName,dba::String,"name")
 END_STORE_TABLE()
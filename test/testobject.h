@@ -179,6 +179,32 @@ class TestObject : public TestStoreable {
     };
 };
 
+/**
+  Same table as TestObject, but store table is declared using BIND_MEMBER
+*/
+class TypedObject : public TestStoreable {
+    DECLARE_STORE_TABLE();
+  public:
+    TypedObject()
+      : i(-1),
+        d(-1),
+        date(dba::DbResult::sInvalidTm)
+    {};
+    int i;
+    double d;
+    std::string s;
+    ::tm date;
+};
+
+/**
+  TypedObject with parent table declared using BIND_MEMBER and child table using BIND_STR
+*/
+class TypedInheritedObject : public TypedObject {
+    DECLARE_STORE_TABLE();
+  public:
+    std::string mName;
+};
+
 class InheritedObject : public TestObject {
     DECLARE_STORE_TABLE();
   public:
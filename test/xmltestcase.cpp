@@ -1132,6 +1132,297 @@ XMLTestCase::storeBug4() {
   CPPUNIT_ASSERT(compareXML("storebug4.xml",result));
 };
 
+void
+XMLTestCase::streamLoad() {
+  const int count = 1000;
+  {
+    dba::XMLArchive ar;
+    unlink("stream_load.xml");
+    ar.open("stream_load.xml");
+    dba::XMLOStream stream(ar.getOStream());
+    for(int i = 0; i < count; i++) {
+      ObjWithList obj("obj_" + dba::toStr(i),i % 4);
+      stream.put(&obj);
+    };
+  };
+  std::list<ObjWithList> expected;
+  {
+    dba::XMLArchive ar;
+    ar.open("stream_load.xml");
+    dba::stdList<ObjWithList> filter(expected);
+    dba::XMLIStream stream(ar.getIStream());
+    stream.get(&filter);
+  };
+  {
+    dba::XMLArchive ar;
+    ar.useStreamingInput();
+    ar.open("stream_load.xml");
+    std::list<ObjWithList> loaded;
+    dba::stdList<ObjWithList> filter(loaded);
+    dba::XMLIStream stream(ar.getIStream());
+    stream.get(&filter);
+    CPPUNIT_ASSERT_EQUAL((size_t)count,loaded.size());
+    //objects are loaded in file order with their collections
+    CPPUNIT_ASSERT(loaded == expected);
+    try {
+      ar.getOStream();
+      CPPUNIT_FAIL("archive opened with streaming input should be read only");
+    } catch (const dba::APIException&) {
+      //
+    };
+  };
+  unlink("stream_load.xml");
+};
+
+void
+XMLTestCase::streamGetNext() {
+  const char* data = 
+"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+"<dba xmlns:ns=\"http://bogus_ns_namespace\">\n"
+"  <!-- comments and text between objects are skipped -->\n"
+"  <nsobject ns:name=\"first\"/>\n"
+"  text\n"
+"  <nsobject ns:name=\"second\"></nsobject>\n"
+"</dba>\n"
+;
+  {
+    std::ofstream file("stream_getnext.xml");
+    file << data;
+  };
+  {
+    dba::XMLArchive ar;
+    ar.useStreamingInput();
+    ar.open("stream_getnext.xml");
+    NsObject obj;
+    dba::XMLIStream stream(ar.getIStream());
+    stream.open(obj);
+    CPPUNIT_ASSERT(stream.getNext(&obj));
+    CPPUNIT_ASSERT(obj == NsObject("first"));
+    CPPUNIT_ASSERT(stream.getNext(&obj));
+    CPPUNIT_ASSERT(obj == NsObject("second"));
+    CPPUNIT_ASSERT(!stream.getNext(&obj));
+  };
+  {
+    dba::XMLArchive ar;
+    ar.useStreamingInput();
+    ar.setRootNodeName("objects");
+    try {
+      ar.open("stream_getnext.xml");
+      CPPUNIT_FAIL("open should throw");
+    } catch (const dba::DataException&) {
+      //
+    };
+  };
+  unlink("stream_getnext.xml");
+};
+
+void
+XMLTestCase::streamStore() {
+  const char* tree = 
+"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+"<dba>\n"
+"  <test_objects i_value=\"1\" f_value=\"1\" s_value=\"1\" d_value=\"2008-01-01T00:00:00\">\n"
+"    <fk_owner>\n"
+"      <test_objects i_value=\"2\" f_value=\"2\" s_value=\"2\" d_value=\"2008-01-01T00:00:00\">\n"
+"        <fk_owner>\n"
+"          <test_objects i_value=\"3\" f_value=\"3\" s_value=\"3\" d_value=\"2008-01-01T00:00:00\"/>\n"
+"        </fk_owner>\n"
+"      </test_objects>\n"
+"    </fk_owner>\n"
+"  </test_objects>\n"
+"  <obj_with_list name=\"sub\">\n"
+"    <fk_owner>\n"
+"      <test_objects i_value=\"0\" f_value=\"0\" s_value=\"test_object\" d_value=\"2008-01-01T00:00:00\"/>\n"
+"      <test_objects i_value=\"1\" f_value=\"1\" s_value=\"test_object\" d_value=\"2008-01-02T00:00:00\"/>\n"
+"    </fk_owner>\n"
+"  </obj_with_list>\n"
+"</dba>\n";
+  {
+    dba::XMLArchive ar;
+    ar.useStreamingOutput();
+    ar.open("stream_store.xml");
+    TreeObject root(1,1,"1");
+    TreeObject middle(2,2,"2");
+    TreeObject last(3,3,"3");
+    middle.mLeafs.push_back(last);
+    root.mLeafs.push_back(middle);
+    ObjWithList obj("sub",2);
+
+    dba::XMLOStream stream(ar.getOStream());
+    stream.open();
+    stream.put(&root);
+    //collections and objects are written in order
+    stream.put(&obj);
+    try {
+      ar.getIStream();
+      CPPUNIT_FAIL("archive opened with streaming output should be write only");
+    } catch (const dba::APIException&) {
+      //
+    };
+  }
+  CPPUNIT_ASSERT(compareXML("stream_store.xml",tree));
+
+  const char* nsdata = 
+"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+"<dba xmlns:ns=\"http://bogus_ns_namespace\">\n"
+"  <nsobject ns:name=\"namespace\"/>\n"
+"</dba>\n"
+;
+  {
+    dba::XMLArchive ar;
+    ar.useStreamingOutput();
+    ar.open("stream_store.xml");
+    ar.addNamespace("http://bogus_ns_namespace","ns");
+    NsObject obj("namespace");
+    dba::XMLOStream stream(ar.getOStream());
+    stream.put(&obj);
+  };
+  CPPUNIT_ASSERT(compareXML("stream_store.xml",nsdata));
+
+  const char* elements = 
+"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+"<test_objects>\n"
+"  <i_value>1</i_value>\n"
+"  <f_value>1.1</f_value>\n"
+"  <s_value>test</s_value>\n"
+"  <d_value>2008-01-01T00:00:00</d_value>\n"
+"</test_objects>\n"
+;
+  {
+    dba::XMLArchive ar;
+    ar.setRootNodeName(NULL);
+    ar.useElements();
+    ar.useStreamingOutput();
+    ar.open("stream_store.xml");
+    TestObject obj1(1,1.1,"test",Utils::getDate(2008,1,1,0,0,0));
+    dba::XMLOStream stream(ar.getOStream());
+    stream.open();
+    stream.put(&obj1);
+  }
+  CPPUNIT_ASSERT(compareXML("stream_store.xml",elements));
+  unlink("stream_store.xml");
+};
+
+void
+XMLTestCase::streamStoreMany() {
+  const int count = 1000;
+  std::list<ObjWithList> expected;
+  {
+    dba::XMLArchive ar;
+    ar.useStreamingOutput();
+    ar.setWriteBufferSize(4096);
+    ar.open("stream_store_many.xml");
+    dba::XMLOStream stream(ar.getOStream());
+    for(int i = 0; i < count; i++) {
+      ObjWithList obj("obj_" + dba::toStr(i),i % 4);
+      stream.put(&obj);
+      expected.push_back(obj);
+    };
+  };
+  {
+    dba::XMLArchive ar;
+    ar.open("stream_store_many.xml");
+    std::list<ObjWithList> loaded;
+    dba::stdList<ObjWithList> filter(loaded);
+    dba::XMLIStream stream(ar.getIStream());
+    stream.get(&filter);
+    CPPUNIT_ASSERT_EQUAL((size_t)count,loaded.size());
+    CPPUNIT_ASSERT(loaded == expected);
+  };
+  unlink("stream_store_many.xml");
+};
+
+void
+XMLTestCase::streamStoreUtf8() {
+  //"zażółć" in UTF-8
+  const char* text = "za\xc5\xbc\xc3\xb3\xc5\x82\xc4\x87";
+  {
+    dba::XMLArchive ar;
+    ar.useStreamingOutput();
+    ar.open("stream_utf8.xml");
+    TestObject obj(1,1,text,Utils::getDate(2008,1,1,0,0,0));
+    dba::XMLOStream stream(ar.getOStream());
+    stream.put(&obj);
+  };
+  std::ifstream file("stream_utf8.xml", std::ios::in | std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(file)),std::istreambuf_iterator<char>());
+  file.close();
+  unlink("stream_utf8.xml");
+  //non-ASCII chars are not written as char references
+  CPPUNIT_ASSERT(data.find(std::string("s_value=\"") + text + "\"") != std::string::npos);
+  CPPUNIT_ASSERT(data.find("&#") == std::string::npos);
+};
+
+//filter that cannot store negative values
+class PositiveInt : public dba::Int {
+  public:
+    PositiveInt(int& pData) : dba::Int(pData) {};
+    virtual std::string toString(const dba::ConvSpec& pSpec) const throw (dba::StoreableFilterException) {
+      if (*mMember < 0)
+        throw dba::StoreableFilterException("negative value");
+      return dba::Int::toString(pSpec);
+    };
+};
+
+class PositiveObject : public dba::Storeable {
+  DECLARE_STORE_TABLE();
+public:
+  PositiveObject(int pA = 0, int pB = 0) : a(pA), b(pB) {};
+  int a;
+  int b;
+};
+
+BEGIN_STORE_TABLE(PositiveObject, dba::Storeable, "positive")
+  BIND_INT(PositiveObject::a, dba::Int, "a")
+  BIND_INT(PositiveObject::b, PositiveInt, "b")
+END_STORE_TABLE();
+
+void
+XMLTestCase::streamStoreError() {
+  const char* tree = 
+"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+"<dba>\n"
+"  <positive a=\"1\" b=\"1\"/>\n"
+"  <positive a=\"2\"/>\n"
+"  <positive a=\"3\" b=\"3\"/>\n"
+"</dba>\n";
+  {
+    dba::XMLArchive ar;
+    ar.useStreamingOutput();
+    ar.open("stream_error.xml");
+    PositiveObject first(1,1);
+    PositiveObject failed(2,-2);
+    PositiveObject last(3,3);
+    dba::XMLOStream stream(ar.getOStream());
+    stream.put(&first);
+    CPPUNIT_ASSERT_THROW(stream.put(&failed),dba::StoreableFilterException);
+    //element of failed object is closed, converted members stay in file
+    stream.put(&last);
+  };
+  CPPUNIT_ASSERT(compareXML("stream_error.xml",tree));
+  unlink("stream_error.xml");
+};
+
+void
+XMLTestCase::streamStoreNoRoot() {
+  const char* tree = 
+"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+"<positive a=\"1\" b=\"1\"/>\n";
+  {
+    dba::XMLArchive ar;
+    ar.setRootNodeName(NULL);
+    ar.useStreamingOutput();
+    ar.open("stream_noroot.xml");
+    PositiveObject first(1,1);
+    PositiveObject second(2,2);
+    dba::XMLOStream stream(ar.getOStream());
+    stream.put(&first);
+    //second top level element is not allowed
+    CPPUNIT_ASSERT_THROW(stream.put(&second),dba::APIException);
+  };
+  CPPUNIT_ASSERT(compareXML("stream_noroot.xml",tree));
+  unlink("stream_noroot.xml");
+};
 
 } //namespace
 
@@ -55,6 +55,13 @@ class XMLTestCase : public CppUnit::TestCase, public dba::XMLErrorHandler {
       CPPUNIT_TEST(storeBug2);
       CPPUNIT_TEST(storeBug3);
       CPPUNIT_TEST(storeBug4);
+      CPPUNIT_TEST(streamLoad);
+      CPPUNIT_TEST(streamGetNext);
+      CPPUNIT_TEST(streamStore);
+      CPPUNIT_TEST(streamStoreMany);
+      CPPUNIT_TEST(streamStoreUtf8);
+      CPPUNIT_TEST(streamStoreError);
+      CPPUNIT_TEST(streamStoreNoRoot);
     CPPUNIT_TEST_SUITE_END();
   public:
     virtual void setUp();
@@ -95,6 +102,13 @@ class XMLTestCase : public CppUnit::TestCase, public dba::XMLErrorHandler {
     void storeBug2();
     void storeBug3();
     void storeBug4();
+    void streamLoad();
+    void streamGetNext();
+    void streamStore();
+    void streamStoreMany();
+    void streamStoreUtf8();
+    void streamStoreError();
+    void streamStoreNoRoot();
   private:
     bool compareXML(const char* pFilename, const char* pData);
 };